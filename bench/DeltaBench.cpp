@@ -0,0 +1,307 @@
+/**
+ * Program Name: FTP Server
+ * File Name: DeltaBench.cpp
+ * Author: Taylor Jones
+ * Last Modified: 10/16/26
+ * Description: DeltaBench measures delta downloads (the delta=1 request
+ *  option). It writes a scratch file, then makes old copies of it with 1%,
+ *  10% and 50% of the bytes changed, in short runs that are overwritten
+ *  and, now and then, inserted or deleted (which moves everything after
+ *  them off the block boundaries). For each old copy, the server's
+ *  DataTransfer offers the file and sends it as a delta over a loopback
+ *  TCP connection, while another thread plays the client: it sends the
+ *  old copy's signatures, rebuilds the file from the literals and block
+ *  copies that come back, and checks the result. It reports the size of
+ *  the signatures, the bytes the server sent back (also as a share of the
+ *  file's size), the frames they took, and how fast the download went.
+ *
+ *  Usage: deltabench [file-MiB] [block-size] [runs]
+ */
+
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <iomanip>
+#include <iostream>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "../server/DataTransfer.hpp"
+#include "../server/DeltaEncoder.hpp"
+#include "../server/Framing.hpp"
+#include "../server/Util.hpp"
+
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+
+
+/**
+ * What the client saw of one delta download.
+ */
+struct DeltaResult {
+    bool matched = false;       // true if the rebuilt file is the server's file
+    uint64_t signatureBytes = 0;    // the SIGNATURES frame the client sent
+    uint64_t wireBytes = 0;     // every byte the server sent, frame headers included
+    uint64_t literalFrames = 0;
+    uint64_t literalBytes = 0;
+    uint64_t copyFrames = 0;
+    double seconds = 0;         // from sending the signatures to the END frame
+};
+
+
+
+/**
+ * Connects a pair of loopback TCP sockets.
+ * @param client - holds the connecting end.
+ * @param server - holds the accepted end.
+ */
+void connectLoopback(int &client, int &server) {
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in address;
+    socklen_t length = sizeof(address);
+
+    address.sin_family = AF_INET;
+    address.sin_port = 0;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (listener < 0 || bind(listener, (struct sockaddr *) &address, sizeof(address)) < 0 || listen(listener, 1) < 0 ||
+        getsockname(listener, (struct sockaddr *) &address, &length) < 0) {
+        perror("listen");
+        exit(1);
+    }
+
+    client = socket(AF_INET, SOCK_STREAM, 0);
+    if (client < 0 || connect(client, (struct sockaddr *) &address, sizeof(address)) < 0) {
+        perror("connect");
+        exit(1);
+    }
+    server = accept(listener, nullptr, nullptr);
+    close(listener);
+
+    int on = 1;
+    setsockopt(server, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+}
+
+
+
+/**
+ * Reads one frame.
+ * @param sock - the socket to read from.
+ * @param type - holds the frame type.
+ * @param payload - holds the payload.
+ * @return bool - false if the connection failed or the header was malformed.
+ */
+bool readFrame(int sock, FrameType &type, string &payload) {
+    char header[FRAME_HEADER_SIZE];
+    uint64_t length;
+
+    if (!recvAll(sock, header, FRAME_HEADER_SIZE) || !decodeFrameHeader(header, type, length)) {
+        return false;
+    }
+    payload.resize(length);
+    return length == 0 || recvAll(sock, &payload[0], length);
+}
+
+
+
+/**
+ * Plays the client of a delta download: waits for the GOOD frame, sends
+ * the old copy's signatures, and rebuilds the file from what comes back.
+ * @param sock - the client's end of the data connection.
+ * @param old - the client's old copy.
+ * @param current - the server's file, to check the rebuilt file against.
+ * @param blockSize - the block size to sign the old copy with.
+ * @return DeltaResult - what the download took.
+ */
+DeltaResult receiveDelta(int sock, const string &old, const string &current, uint32_t blockSize) {
+    DeltaResult result;
+    FrameType type;
+    string payload, rebuilt;
+
+    if (!readFrame(sock, type, payload) || type != FRAME_GOOD) {
+        return result;
+    }
+    result.wireBytes += FRAME_HEADER_SIZE + payload.size();
+
+    auto start = std::chrono::steady_clock::now();
+    const string signatures = DeltaEncoder::buildSignatures(old.data(), old.size(), blockSize);
+    const string header = encodeFrameHeader(FRAME_SIGNATURES, signatures.size());
+    result.signatureBytes = header.size() + signatures.size();
+    if (!sendAll(sock, header.data(), header.size()) || !sendAll(sock, signatures.data(), signatures.size())) {
+        return result;
+    }
+
+    rebuilt.reserve(current.size());
+    while (readFrame(sock, type, payload) && type != FRAME_END) {
+        result.wireBytes += FRAME_HEADER_SIZE + payload.size();
+
+        if (type == FRAME_DATA) {
+            rebuilt.append(payload);
+            result.literalFrames++;
+            result.literalBytes += payload.size();
+        } else if (type == FRAME_COPY && payload.size() == 16) {
+            const uint64_t offset = readUint64(payload.data()) * blockSize;
+            const uint64_t length = readUint64(payload.data() + 8) * blockSize;
+            rebuilt.append(old, offset, length);
+            result.copyFrames++;
+        } else {
+            return result;
+        }
+    }
+    result.wireBytes += FRAME_HEADER_SIZE;
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    result.matched = (rebuilt == current);
+    return result;
+}
+
+
+
+/**
+ * Offers a file and sends it as a delta, the way a worker answers a delta=1
+ * download, while another thread receives it.
+ * @param path - the server's file.
+ * @param old - the client's old copy.
+ * @param current - the server's file's contents.
+ * @param blockSize - the block size the client signs its old copy with.
+ * @return DeltaResult - what the client saw.
+ */
+DeltaResult downloadDelta(const string &path, const string &old, const string &current, uint32_t blockSize) {
+    int client, server;
+    connectLoopback(client, server);
+
+    DeltaResult result;
+    std::thread receiver([&]() {
+        result = receiveDelta(client, old, current, blockSize);
+    });
+
+    DataTransfer transfer(server, FRAME_VERSION);
+    OfferedFile file;
+    if (transfer.offerFile(path, file, true) != TRANSFER_OK || transfer.sendDelta(file) != TRANSFER_OK) {
+        cerr << "delta transfer of " << path << " failed" << endl;
+        exit(1);
+    }
+
+    receiver.join();
+    close(server);
+    close(client);
+    return result;
+}
+
+
+
+/**
+ * Makes random-looking bytes.
+ * @param size - the number of bytes.
+ * @param state - the generator's state, which carries on from call to call.
+ * @return string - the bytes.
+ */
+string randomBytes(size_t size, unsigned &state) {
+    string data(size, '\0');
+    for (auto &byte : data) {
+        state = state * 1103515245 + 12345;
+        byte = (char) (state >> 16);
+    }
+    return data;
+}
+
+
+
+/**
+ * Makes an old copy of a file with about a given share of its bytes changed,
+ * in runs of up to 4KiB at random places. One run in eight is inserted or
+ * deleted rather than overwritten.
+ * @param current - the file.
+ * @param churn - the share of the bytes to change, from 0 to 1.
+ * @return string - the old copy.
+ */
+string makeOldCopy(const string &current, double churn) {
+    const size_t MAX_RUN = 4096;
+    unsigned state = 777;
+    size_t changed = 0;
+    const size_t target = current.size() * churn;
+    string old = current;
+
+    while (changed < target && !old.empty()) {
+        state = state * 1103515245 + 12345;
+        const size_t run = 1 + (state >> 8) % MAX_RUN;
+        state = state * 1103515245 + 12345;
+        const size_t position = (state >> 4) % old.size();
+        const int kind = (state >> 28) % 8;
+
+        if (kind == 0) {
+            old.insert(position, randomBytes(run, state));
+        } else if (kind == 1) {
+            old.erase(position, run);
+        } else {
+            const size_t length = std::min(run, old.size() - position);
+            old.replace(position, length, randomBytes(length, state));
+        }
+        changed += run;
+    }
+
+    return old;
+}
+
+
+
+int main(int argc, char* argv[]) {
+    const int megabytes = argc > 1 ? atoi(argv[1]) : 32;
+    const int blockSize = argc > 2 ? atoi(argv[2]) : 2048;
+    const int runs = argc > 3 ? atoi(argv[3]) : 3;
+
+    if (megabytes <= 0 || blockSize < (int) DeltaEncoder::MIN_BLOCK_SIZE || blockSize > (int) DeltaEncoder::MAX_BLOCK_SIZE ||
+        runs <= 0) {
+        cerr << "Usage: deltabench [file-MiB] [block-size] [runs]" << endl;
+        return 1;
+    }
+
+    char path[] = "/tmp/deltabench.XXXXXX";
+    int fd = mkstemp(path);
+    unsigned state = 12345;
+    const string current = randomBytes((size_t) megabytes * 1024 * 1024, state);
+    if (fd < 0 || write(fd, current.data(), current.size()) != (ssize_t) current.size()) {
+        perror("write");
+        return 1;
+    }
+    close(fd);
+
+    cout << "churn\tblock_size\tsignature_bytes\twire_bytes\twire_pct\tliteral_frames\tcopy_frames\tseconds\tMB_per_s" << endl;
+
+    for (double churn : { 0.01, 0.10, 0.50 }) {
+        const string old = makeOldCopy(current, churn);
+
+        DeltaResult best;
+        for (int run = 0; run < runs; run++) {
+            DeltaResult result = downloadDelta(path, old, current, blockSize);
+            if (!result.matched) {
+                cerr << "the rebuilt file doesn't match at " << churn * 100 << "% churn" << endl;
+                unlink(path);
+                return 1;
+            }
+            if (run == 0 || result.seconds < best.seconds) {
+                best = result;
+            }
+        }
+
+        cout << std::fixed << std::setprecision(0) << churn * 100 << "%\t" << blockSize << "\t" << best.signatureBytes << "\t" << best.wireBytes << "\t"
+        << std::setprecision(1) << 100.0 * best.wireBytes / current.size() << "\t"
+        << best.literalFrames << "\t" << best.copyFrames << "\t"
+        << std::setprecision(3) << best.seconds << "\t"
+        << std::setprecision(1) << current.size() / best.seconds / 1e6 << endl;
+    }
+
+    unlink(path);
+    return 0;
+}
@@ -0,0 +1,489 @@
+/**
+ * Program Name: FTP Server
+ * File Name: EndToEndBench.cpp
+ * Author: Taylor Jones
+ * Last Modified: 10/16/26
+ * Description: EndToEndBench measures whole requests, the way a client sees
+ *  them: it runs the server (in a child process, serving a scratch
+ *  directory) and sends it requests over loopback TCP, on one control
+ *  connection, in passive mode. Each request is timed from sending it to
+ *  the end of its data connection.
+ *    -l, -ll, -lr   on flat directories of 1k, 100k and 1M empty files
+ *    -g             (in binary mode) of files from 1 KiB to 10 GiB
+ *    -l             of a small directory, many times in passive and in
+ *                   active mode, where setting up the data connection is
+ *                   most of the time a request takes
+ *  The files are sparse, so the benchmark needs no disk space for them and
+ *  measures the server and the network path rather than the disk. Each
+ *  listing and download is run several times; the first run (with the
+ *  server's caches empty) and the fastest are reported, as JSON on stdout
+ *  (see JsonReport), so that runs from before and after a change can be
+ *  compared. Smaller files are downloaded many times per run.
+ *
+ *  Usage: e2ebench [max-entries] [max-file-MiB] [runs]
+ */
+
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <iostream>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <signal.h>
+#include <string>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "JsonReport.hpp"
+#include "../server/ServerConfig.hpp"
+#include "../server/SocketServer.hpp"
+
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::string;
+using std::to_string;
+using std::vector;
+
+
+static const off_t MiB = 1024 * 1024;
+static const off_t BYTES_PER_RUN = 256 * MiB;   // small files are downloaded until about this much is sent...
+static const int MAX_TRANSFERS = 1000;          // ...or this many times per run
+
+
+/**
+ * What one request took, as the client saw it.
+ */
+struct RequestCost {
+    double seconds = 0;     // from sending the request to the end of the data connection
+    uint64_t bytes = 0;     // the bytes received on the data connection
+    uint64_t lines = 0;     // the lines received on the data connection
+};
+
+
+/**
+ * A server running in a child process.
+ */
+struct ServerProcess {
+    pid_t pid;
+    int port;
+    int control;            // the control connection to it
+};
+
+
+
+/**
+ * @return int - a TCP port that nothing is using right now.
+ */
+int findFreePort() {
+    struct sockaddr_in address = {};
+    socklen_t size = sizeof(address);
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    int sock = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (sock < 0 || bind(sock, (struct sockaddr*) &address, sizeof(address)) < 0 ||
+        getsockname(sock, (struct sockaddr*) &address, &size) < 0) {
+        perror("bind");
+        exit(1);
+    }
+    close(sock);
+
+    return ntohs(address.sin_port);
+}
+
+
+
+/**
+ * Connects to a port on the loopback address.
+ * @param port - the port.
+ * @return int - the connected socket, or -1 if nothing is listening.
+ */
+int connectTo(int port) {
+    struct sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    int sock = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (sock >= 0 && connect(sock, (struct sockaddr*) &address, sizeof(address)) < 0) {
+        close(sock);
+        return -1;
+    }
+    return sock;
+}
+
+
+
+/**
+ * Opens a listening socket on the loopback address, the way a client
+ * opens its data port in active mode.
+ * @param port - set to the port it listens on.
+ * @return int - the listening socket.
+ */
+int listenOnLoopback(int &port) {
+    struct sockaddr_in address = {};
+    socklen_t size = sizeof(address);
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    int sock = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (sock < 0 || bind(sock, (struct sockaddr*) &address, sizeof(address)) < 0 || listen(sock, 16) < 0 ||
+        getsockname(sock, (struct sockaddr*) &address, &size) < 0) {
+        perror("listen");
+        exit(1);
+    }
+
+    port = ntohs(address.sin_port);
+    return sock;
+}
+
+
+
+/**
+ * Reads one line, a byte at a time so nothing past it is taken from the socket.
+ * @param sock - the socket.
+ * @param line - set to the line, without its newline.
+ * @return bool - false if the connection ended first.
+ */
+bool readLine(int sock, string &line) {
+    char c;
+    line.clear();
+
+    while (recv(sock, &c, 1, 0) == 1) {
+        if (c == '\n') {
+            return true;
+        }
+        line += c;
+    }
+    return false;
+}
+
+
+
+/**
+ * Reads everything that arrives on a connection until the server closes it.
+ * @param sock - the connection.
+ * @param cost - what was received is added to it.
+ */
+void readToEnd(int sock, RequestCost &cost) {
+    static vector<char> buffer(1 << 20);
+    ssize_t received;
+
+    while ((received = recv(sock, buffer.data(), buffer.size(), 0)) > 0) {
+        cost.bytes += received;
+        cost.lines += std::count(buffer.begin(), buffer.begin() + received, '\n');
+    }
+}
+
+
+
+/**
+ * Starts a server that serves a directory, and connects to it.
+ * @param directory - the directory to serve.
+ * @return ServerProcess - the running server.
+ */
+ServerProcess startServer(const string &directory) {
+    ServerProcess server;
+    server.port = findFreePort();
+    server.pid = fork();
+
+    if (server.pid == 0) {
+        if (chdir(directory.c_str()) < 0) {
+            perror("chdir");
+            _exit(1);
+        }
+        signal(SIGPIPE, SIG_IGN);
+
+        ServerConfig config;
+        config.port = server.port;
+        config.hashIndexPath = "";
+        config.logLevel = LOG_WARN;     // keep stdout for the report
+        SocketServer(config).start();
+        _exit(0);
+    }
+
+    for (int attempt = 0; attempt < 500; attempt++) {
+        server.control = connectTo(server.port);
+        if (server.control >= 0) {
+            // \ready gets no reply, so with Nagle's algorithm the next request would wait for the server's delayed ACK.
+            int noDelay = 1;
+            setsockopt(server.control, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+            return server;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    cerr << "The server didn't start" << endl;
+    kill(server.pid, SIGKILL);
+    exit(1);
+}
+
+
+
+/**
+ * Stops a server started by startServer().
+ * @param server - the server.
+ */
+void stopServer(ServerProcess &server) {
+    close(server.control);
+    kill(server.pid, SIGKILL);
+    waitpid(server.pid, nullptr, 0);
+}
+
+
+
+/**
+ * Sends a request and receives the response.
+ * @param server - the server.
+ * @param request - the request, without the data port.
+ * @param download - true for -g: the data connection starts with a \good line, which is answered with \ready.
+ * @param passive - true to connect to the server's data port, false to have the server connect to ours.
+ * @return RequestCost - what the request took.
+ */
+RequestCost runRequest(ServerProcess &server, const string &request, bool download, bool passive = true) {
+    RequestCost cost;
+    string line;
+    int listener = -1;
+    int port = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    if (!passive) {
+        listener = listenOnLoopback(port);
+    }
+
+    const string text = request + (passive ? " pasv" : " " + to_string(port)) + (download ? " mode=binary" : "") + "\n";
+    if (send(server.control, text.data(), text.size(), 0) < 0 || !readLine(server.control, line) ||
+        line.compare(0, 5, "\\good") != 0) {
+        cerr << "\"" << request << "\" failed: " << line << endl;
+        exit(1);
+    }
+
+    int data;
+    if (passive) {
+        data = connectTo(atoi(line.c_str() + 6));
+    } else {
+        send(server.control, "\\ready\n", 7, 0);
+        data = accept(listener, nullptr, nullptr);
+        close(listener);
+    }
+    if (data < 0) {
+        perror(passive ? "connect" : "accept");
+        exit(1);
+    }
+    if (download) {
+        if (!readLine(data, line) || line.compare(0, 5, "\\good") != 0) {
+            cerr << "\"" << request << "\" failed: " << line << endl;
+            exit(1);
+        }
+        send(server.control, "\\ready\n", 7, 0);
+    }
+    readToEnd(data, cost);
+    close(data);
+
+    cost.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return cost;
+}
+
+
+
+/**
+ * Creates a directory of empty files.
+ * @param path - the directory to create.
+ * @param entries - the number of files to put in it.
+ */
+void makeTree(const string &path, int entries) {
+    char name[32];
+
+    if (mkdir(path.c_str(), 0755) < 0) {
+        perror("mkdir");
+        exit(1);
+    }
+    for (int i = 0; i < entries; i++) {
+        snprintf(name, sizeof(name), "/entry-%07d.txt", i);
+        int fd = open((path + name).c_str(), O_CREAT | O_WRONLY | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            perror("open");
+            exit(1);
+        }
+        close(fd);
+    }
+}
+
+
+
+/**
+ * Deletes a directory made by makeTree().
+ * @param path - the directory.
+ * @param entries - the number of files in it.
+ */
+void removeTree(const string &path, int entries) {
+    char name[32];
+
+    for (int i = 0; i < entries; i++) {
+        snprintf(name, sizeof(name), "/entry-%07d.txt", i);
+        unlink((path + name).c_str());
+    }
+    rmdir(path.c_str());
+}
+
+
+
+/**
+ * @param bytes - a size.
+ * @return string - the size, in KiB, MiB or GiB.
+ */
+string sizeName(off_t bytes) {
+    if (bytes >= 1024 * MiB) {
+        return to_string(bytes / (1024 * MiB)) + "GiB";
+    }
+    return bytes >= MiB ? to_string(bytes / MiB) + "MiB" : to_string(bytes / 1024) + "KiB";
+}
+
+
+
+int main(int argc, char* argv[]) {
+    const int maxEntries = argc > 1 ? atoi(argv[1]) : 1000000;
+    const long maxFileMiB = argc > 2 ? atol(argv[2]) : 10240;
+    const int runs = argc > 3 ? atoi(argv[3]) : 3;
+
+    if (maxEntries <= 0 || maxFileMiB <= 0 || runs <= 0) {
+        cerr << "Usage: e2ebench [max-entries] [max-file-MiB] [runs]" << endl;
+        return 1;
+    }
+
+    char scratch[] = "/tmp/e2ebench.XXXXXX";
+    if (mkdtemp(scratch) == nullptr) {
+        perror("mkdtemp");
+        return 1;
+    }
+    signal(SIGPIPE, SIG_IGN);
+
+    JsonReport report("end-to-end");
+    report.addSetting("max_entries", to_string(maxEntries));
+    report.addSetting("max_file_mib", to_string(maxFileMiB));
+    report.addSetting("runs", to_string(runs));
+
+    // listings: the first run renders the listing, the rest can be answered from the server's listing cache.
+    for (int entries : { 1000, 100000, 1000000 }) {
+        if (entries > maxEntries) {
+            continue;
+        }
+        const string tree = string(scratch) + "/tree-" + to_string(entries);
+        makeTree(tree, entries);
+        ServerProcess server = startServer(tree);
+
+        for (const string command : { "-l", "-ll", "-lr" }) {
+            RequestCost first, best;
+            for (int run = 0; run < runs; run++) {
+                RequestCost cost = runRequest(server, command, false);
+                if (run == 0) {
+                    first = cost;
+                }
+                if (run == 0 || cost.seconds < best.seconds) {
+                    best = cost;
+                }
+            }
+
+            report.add(command, to_string(entries) + "-entries", {
+                { "first_ms", first.seconds * 1e3 }, { "best_ms", best.seconds * 1e3 },
+                { "entries_per_s", (best.lines - 1) / best.seconds }, { "bytes", (double) best.bytes }
+            });
+        }
+
+        stopServer(server);
+        removeTree(tree, entries);
+    }
+
+    // downloads.
+    const string files = string(scratch) + "/files";
+    vector<off_t> sizes;
+    for (off_t size : { (off_t) 1024, MiB, 100 * MiB, 1024 * MiB, 10240 * MiB }) {
+        if (size <= 1024 || size <= maxFileMiB * MiB) {
+            sizes.push_back(size);
+        }
+    }
+    mkdir(files.c_str(), 0755);
+    for (off_t size : sizes) {
+        int fd = open((files + "/" + sizeName(size) + ".bin").c_str(), O_CREAT | O_WRONLY | O_CLOEXEC, 0644);
+        if (fd < 0 || ftruncate(fd, size) < 0) {
+            perror("ftruncate");
+            return 1;
+        }
+        close(fd);
+    }
+
+    ServerProcess server = startServer(files);
+    for (off_t size : sizes) {
+        const string request = "-g " + sizeName(size) + ".bin";
+        const int transfers = (int) std::max<off_t>(1, std::min<off_t>(MAX_TRANSFERS, BYTES_PER_RUN / size));
+        double first = 0, best = 0;
+
+        for (int run = 0; run < runs; run++) {
+            double seconds = 0;
+            for (int i = 0; i < transfers; i++) {
+                RequestCost cost = runRequest(server, request, true);
+                if (cost.bytes != (uint64_t) size) {
+                    cerr << "\"" << request << "\" sent " << cost.bytes << " bytes" << endl;
+                    return 1;
+                }
+                seconds += cost.seconds;
+            }
+
+            seconds /= transfers;
+            if (run == 0) {
+                first = seconds;
+            }
+            if (run == 0 || seconds < best) {
+                best = seconds;
+            }
+        }
+
+        report.add("-g", sizeName(size), {
+            { "first_ms", first * 1e3 }, { "best_ms", best * 1e3 }, { "mib_per_s", size / best / MiB },
+            { "transfers_per_run", (double) transfers }
+        });
+    }
+
+    // data connection setup: listing the few files above is quick, so the time is mostly the connection.
+    for (bool passive : { true, false }) {
+        double first = 0, best = 0;
+
+        for (int run = 0; run < runs; run++) {
+            double seconds = 0;
+            for (int i = 0; i < MAX_TRANSFERS; i++) {
+                seconds += runRequest(server, "-l", false, passive).seconds;
+            }
+
+            seconds /= MAX_TRANSFERS;
+            if (run == 0) {
+                first = seconds;
+            }
+            if (run == 0 || seconds < best) {
+                best = seconds;
+            }
+        }
+
+        report.add("-l", passive ? "small-dir-pasv" : "small-dir-active", {
+            { "first_ms", first * 1e3 }, { "best_ms", best * 1e3 }, { "requests_per_run", (double) MAX_TRANSFERS }
+        });
+    }
+    stopServer(server);
+
+    for (off_t size : sizes) {
+        unlink((files + "/" + sizeName(size) + ".bin").c_str());
+    }
+    rmdir(files.c_str());
+    rmdir(scratch);
+
+    report.write(cout);
+    return 0;
+}
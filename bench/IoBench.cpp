@@ -0,0 +1,241 @@
+/**
+ * Program Name: FTP Server
+ * File Name: IoBench.cpp
+ * Author: Taylor Jones
+ * Last Modified: 10/16/26
+ * Description: IoBench compares the server's ways of sending files:
+ *  sendfile() on blocking sockets, chains of reads and sends through an
+ *  io_uring ring (the --io-uring option), sends from the mappings of the
+ *  MappedFileCache, and sends from the contents held by the ContentCache
+ *  (which repeat downloads use, for large and small files). It writes scratch files of a
+ *  few sizes, then has the server's DataTransfer offer and send each one
+ *  many times over a loopback TCP connection, with another thread reading
+ *  the other end. For each size and backend it reports the transfers per
+ *  second, the throughput, and the CPU time per transfer (for the whole
+ *  process, so the reading thread's share is included in both).
+ *
+ *  Usage: iobench [small-transfers] [runs]
+ */
+
+
+#include <arpa/inet.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <iomanip>
+#include <iostream>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <string>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "../server/ContentCache.hpp"
+#include "../server/DataTransfer.hpp"
+#include "../server/IoRing.hpp"
+#include "../server/MappedFileCache.hpp"
+
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::string;
+using std::to_string;
+using std::vector;
+
+
+/**
+ * What a batch of transfers took.
+ */
+struct TransferCost {
+    double seconds = 0;     // the wall-clock time
+    double cpuSeconds = 0;  // the user and system time of the whole process
+};
+
+
+
+/**
+ * @return double - the process's user and system time so far, in seconds.
+ */
+double cpuTime() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+
+
+/**
+ * Connects a pair of loopback TCP sockets.
+ * @param client - holds the connecting end.
+ * @param server - holds the accepted end.
+ */
+void connectLoopback(int &client, int &server) {
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in address;
+    socklen_t length = sizeof(address);
+
+    address.sin_family = AF_INET;
+    address.sin_port = 0;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (listener < 0 || bind(listener, (struct sockaddr *) &address, sizeof(address)) < 0 || listen(listener, 1) < 0 ||
+        getsockname(listener, (struct sockaddr *) &address, &length) < 0) {
+        perror("listen");
+        exit(1);
+    }
+
+    client = socket(AF_INET, SOCK_STREAM, 0);
+    if (client < 0 || connect(client, (struct sockaddr *) &address, sizeof(address)) < 0) {
+        perror("connect");
+        exit(1);
+    }
+    server = accept(listener, nullptr, nullptr);
+    close(listener);
+
+    int on = 1;
+    setsockopt(server, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+}
+
+
+
+/**
+ * Offers and sends a file over and over, the way a worker answers a binary-mode
+ * download, through one backend or the other.
+ * @param filename - the file to send.
+ * @param transfers - the number of times to send it.
+ * @param ring - the ring to send through, or null to use sendfile().
+ * @param cache - the mappings to send from, or null to open the file every time.
+ * @param contents - the cached contents to send, or null to read the file every time.
+ * @return TransferCost - what the transfers took.
+ */
+TransferCost sendRepeatedly(const string &filename, int transfers, IoRing *ring, MappedFileCache *cache,
+    ContentCache *contents) {
+    int client, server;
+    connectLoopback(client, server);
+
+    std::thread reader([client]() {
+        static char buffer[1024 * 1024];
+        while (read(client, buffer, sizeof(buffer)) > 0) {
+        }
+    });
+
+    TransferCost cost;
+    const double cpuStart = cpuTime();
+    auto start = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < transfers; i++) {
+        DataTransfer transfer(server);
+        transfer.setIoRing(ring, 60);
+
+        OfferedFile file;
+        if (transfer.offerFile(filename, file, true, cache, contents) != TRANSFER_OK || transfer.sendFile(file, true) != TRANSFER_OK) {
+            cerr << "transfer of " << filename << " failed" << endl;
+            exit(1);
+        }
+    }
+
+    shutdown(server, SHUT_WR);
+    reader.join();
+    cost.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    cost.cpuSeconds = cpuTime() - cpuStart;
+
+    close(server);
+    close(client);
+    return cost;
+}
+
+
+
+/**
+ * Writes a scratch file of random-looking bytes.
+ * @param path - the file to write.
+ * @param size - its size in bytes.
+ */
+void writeScratchFile(const string &path, size_t size) {
+    vector<char> data(size);
+    unsigned state = 12345;
+    for (auto &byte : data) {
+        state = state * 1103515245 + 12345;
+        byte = (char) (state >> 16);
+    }
+
+    int fd = open(path.c_str(), O_CREAT | O_TRUNC | O_WRONLY | O_CLOEXEC, 0644);
+    if (fd < 0 || write(fd, data.data(), data.size()) != (ssize_t) data.size()) {
+        perror("write");
+        exit(1);
+    }
+    close(fd);
+}
+
+
+
+int main(int argc, char* argv[]) {
+    const int smallTransfers = argc > 1 ? atoi(argv[1]) : 20000;
+    const int runs = argc > 2 ? atoi(argv[2]) : 3;
+
+    if (smallTransfers <= 0 || runs <= 0) {
+        cerr << "Usage: iobench [small-transfers] [runs]" << endl;
+        return 1;
+    }
+
+    IoRing *ring = IoRing::forThread();
+    if (ring == nullptr) {
+        cerr << "io_uring is not available on this kernel" << endl;
+        return 1;
+    }
+
+    char directory[] = "/tmp/iobench.XXXXXX";
+    if (mkdtemp(directory) == nullptr) {
+        perror("mkdtemp");
+        return 1;
+    }
+
+    // the larger the file, the fewer times it is sent, so every size moves a similar amount of data.
+    struct Size { string name; size_t bytes; int transfers; };
+    const vector<Size> sizes = {
+        { "4KiB", 4 * 1024, smallTransfers },
+        { "64KiB", 64 * 1024, std::max(1, smallTransfers / 4) },
+        { "256KiB", 256 * 1024, std::max(1, smallTransfers / 16) },
+        { "64MiB", 64 * 1024 * 1024, std::max(1, smallTransfers / 2000) }
+    };
+
+    // every size fits in the caches at once, as the server's default budgets would allow
+    // (except that the content cache, like the server's, leaves the 64MiB file to be sent with sendfile()).
+    MappedFileCache cache(256 * 1024 * 1024);
+    ContentCache contents(64 * 1024 * 1024);
+    const vector<string> backends = { "sendfile", "io_uring", "mmap-cache", "content-cache" };
+
+    cout << "size\tbackend\ttransfers\ttransfers_per_s\tMB_per_s\tcpu_us_per_transfer" << endl;
+
+    for (const auto &size : sizes) {
+        const string path = string(directory) + "/" + size.name;
+        writeScratchFile(path, size.bytes);
+
+        for (const auto &backend : backends) {
+            IoRing *backendRing = backend == "io_uring" ? ring : nullptr;
+            MappedFileCache *backendCache = backend == "mmap-cache" ? &cache : nullptr;
+            ContentCache *backendContents = backend == "content-cache" ? &contents : nullptr;
+
+            TransferCost best;
+            for (int run = 0; run < runs; run++) {
+                TransferCost cost = sendRepeatedly(path, size.transfers, backendRing, backendCache, backendContents);
+                if (run == 0 || cost.seconds < best.seconds) {
+                    best = cost;
+                }
+            }
+
+            cout << size.name << "\t" << backend << "\t" << size.transfers << "\t"
+            << std::fixed << std::setprecision(0) << size.transfers / best.seconds << "\t"
+            << std::setprecision(1) << size.bytes * (double) size.transfers / best.seconds / 1e6 << "\t"
+            << best.cpuSeconds / size.transfers * 1e6 << endl;
+        }
+
+        unlink(path.c_str());
+    }
+
+    rmdir(directory);
+    return 0;
+}
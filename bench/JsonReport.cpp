@@ -0,0 +1,142 @@
+/**
+ * Program Name: FTP Server
+ * File Name: JsonReport.cpp
+ * Author: Taylor Jones
+ * Last Modified: 10/16/26
+ * Description: JsonReport.cpp is the class implementation
+ *  file for the JsonReport class.
+ *
+ *  A JsonReport collects a benchmark suite's results and writes them out
+ *  as one JSON document: the suite's name, when and where it ran, its
+ *  settings, and the results in the order they were measured. Each result
+ *  is written on a line of its own, with its keys always in the same order,
+ *  so two runs' reports can be compared with diff as well as with a script.
+ */
+
+
+#include <cmath>
+#include <cstdio>
+#include <ctime>
+#include <unistd.h>
+
+#include "JsonReport.hpp"
+
+
+
+/**
+ * Starts an empty report.
+ * @param suite - the name of the benchmark suite.
+ */
+JsonReport::JsonReport(const string &suite) {
+    this->suite = suite;
+}
+
+
+
+/**
+ * Records a setting the suite ran with.
+ * @param name - the setting's name.
+ * @param value - its value.
+ */
+void JsonReport::addSetting(const string &name, const string &value) {
+    this->settings.push_back({ name, value });
+}
+
+
+
+/**
+ * Records a result.
+ * @param name - what was measured.
+ * @param variant - what it was measured on (an input, a size, ...).
+ * @param values - the numbers, each with its name (and unit, as in "ns_per_op").
+ */
+void JsonReport::add(const string &name, const string &variant, const vector<pair<string, double>> &values) {
+    this->results.push_back({ name, variant, values });
+}
+
+
+
+/**
+ * Writes the report.
+ * @param out - where to write it.
+ */
+void JsonReport::write(ostream &out) const {
+    char date[32] = "";
+    char host[256] = "";
+    time_t now = time(nullptr);
+    struct tm utc;
+    strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", gmtime_r(&now, &utc));
+    gethostname(host, sizeof(host) - 1);
+
+    out << "{\n";
+    out << "  \"suite\": " << quote(this->suite) << ",\n";
+    out << "  \"date\": " << quote(date) << ",\n";
+    out << "  \"host\": " << quote(host) << ",\n";
+    out << "  \"cpus\": " << sysconf(_SC_NPROCESSORS_ONLN) << ",\n";
+
+    out << "  \"settings\": {";
+    for (size_t i = 0; i < this->settings.size(); i++) {
+        out << (i > 0 ? ", " : "") << quote(this->settings[i].first) << ": " << quote(this->settings[i].second);
+    }
+    out << "},\n";
+
+    out << "  \"results\": [\n";
+    for (size_t i = 0; i < this->results.size(); i++) {
+        const Result &result = this->results[i];
+        out << "    {\"name\": " << quote(result.name) << ", \"variant\": " << quote(result.variant);
+        for (const auto &value : result.values) {
+            out << ", " << quote(value.first) << ": " << number(value.second);
+        }
+        out << "}" << (i + 1 < this->results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n";
+    out << "}\n";
+    out.flush();
+}
+
+
+
+/**
+ * @param text - some text.
+ * @return string - the text as a JSON string, quotes included.
+ */
+string JsonReport::quote(const string &text) {
+    string quoted = "\"";
+
+    for (unsigned char c : text) {
+        if (c == '"' || c == '\\') {
+            quoted += '\\';
+            quoted += (char) c;
+        } else if (c < 0x20) {
+            char escape[8];
+            snprintf(escape, sizeof(escape), "\\u%04x", c);
+            quoted += escape;
+        } else {
+            quoted += (char) c;
+        }
+    }
+
+    return quoted + "\"";
+}
+
+
+
+/**
+ * @param value - a number.
+ * @return string - the number as JSON: whole numbers without a fraction, others to 6 significant
+ *  digits, or null if it isn't finite.
+ */
+string JsonReport::number(double value) {
+    char text[32];
+
+    if (!std::isfinite(value)) {
+        return "null";
+    }
+    if (value == std::floor(value) && std::fabs(value) < 1e15) {
+        snprintf(text, sizeof(text), "%.0f", value);
+    } else {
+        snprintf(text, sizeof(text), "%.6g", value);
+    }
+
+    return text;
+}
@@ -0,0 +1,56 @@
+/**
+ * Program Name: FTP Server
+ * File Name: JsonReport.hpp
+ * Author: Taylor Jones
+ * Last Modified: 10/16/26
+ * Description: JsonReport.hpp is the class specification
+ *  file for the JsonReport class. This file contains declarations
+ *  for the member functions of the JsonReport class.
+ */
+
+
+#ifndef JsonReport_hpp
+#define JsonReport_hpp
+
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+using std::ostream;
+using std::pair;
+using std::string;
+using std::vector;
+
+
+class JsonReport {
+  // Member Variables
+  private:
+    /**
+     * One measurement: what was measured, on what, and the numbers it gave.
+     */
+    struct Result {
+        string name;
+        string variant;
+        vector<pair<string, double>> values;
+    };
+
+    string suite;
+    vector<pair<string, string>> settings;
+    vector<Result> results;
+
+  // Member Functions
+  private:
+    static string quote(const string &text);
+    static string number(double value);
+
+  public:
+    explicit JsonReport(const string &suite);
+
+    void addSetting(const string &name, const string &value);
+    void add(const string &name, const string &variant, const vector<pair<string, double>> &values);
+    void write(ostream &out) const;
+};
+
+
+#endif /* JsonReport_hpp */
@@ -0,0 +1,267 @@
+/**
+ * Program Name: FTP Server
+ * File Name: ListBench.cpp
+ * Author: Taylor Jones
+ * Last Modified: 10/16/26
+ * Description: ListBench measures how many system calls the server makes
+ *  to send a directory listing, and how long it takes. It fills a scratch
+ *  directory with empty files, then sends its listing over a socket pair
+ *  (with another thread reading the other end) three ways:
+ *    per-entry   one write per entry, the way listings used to be sent
+ *    rendered    the server's DataTransfer, building the listing
+ *    cached      the server's DataTransfer, answering from the ListingCache
+ *  The system calls are counted by running each listing in a child process
+ *  under ptrace, and counting only those the sending thread makes between
+ *  two marker calls. The times come from separate, untraced runs.
+ *
+ *  Usage: listbench [entries] [chunk-bytes] [flush-bytes] [runs]
+ */
+
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <signal.h>
+#include <string>
+#include <sys/ptrace.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "../server/DataTransfer.hpp"
+#include "../server/ListingCache.hpp"
+#include "../server/Util.hpp"
+
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::function;
+using std::string;
+using std::to_string;
+using std::vector;
+
+
+/**
+ * What one listing cost the sending thread.
+ */
+struct SyscallCount {
+    long total = 0;     // every system call
+    long writes = 0;    // the calls that put data on the socket
+};
+
+
+
+/**
+ * Sends the listing the way the server used to: one write per entry.
+ * @param sock - the socket to send on.
+ */
+void sendPerEntry(int sock) {
+    for (auto item : getListItems(".", false, false)) {
+        string line = item + "\n";
+        if (write(sock, line.data(), line.size()) < 0) {
+            return;
+        }
+    }
+    write(sock, "\\done\n", 6);
+}
+
+
+
+/**
+ * Runs a listing over a new socket pair, with a thread reading and
+ * discarding everything that arrives at the other end.
+ * @param listing - sends the listing over the socket it is given.
+ * @param traced - true to mark the start and end of the listing for the tracer.
+ */
+void runListing(const function<void(int)> &listing, bool traced) {
+    int pair[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, pair) < 0) {
+        perror("socketpair");
+        exit(1);
+    }
+
+    std::thread reader([&pair]() {
+        char buffer[256 * 1024];
+        while (read(pair[1], buffer, sizeof(buffer)) > 0) {
+        }
+    });
+
+    if (traced) {
+        syscall(SYS_getppid);
+    }
+    listing(pair[0]);
+    if (traced) {
+        syscall(SYS_getppid);
+    }
+
+    shutdown(pair[0], SHUT_WR);
+    reader.join();
+    close(pair[0]);
+    close(pair[1]);
+}
+
+
+
+/**
+ * Counts the system calls a listing makes, by running it in a traced child.
+ * Only the child's main thread is traced, so the reader thread isn't counted.
+ * @param listing - sends the listing over the socket it is given.
+ * @return SyscallCount - the calls made between the two markers.
+ */
+SyscallCount countSyscalls(const function<void(int)> &listing) {
+    SyscallCount count;
+    pid_t child = fork();
+
+    if (child == 0) {
+        ptrace(PTRACE_TRACEME, 0, nullptr, nullptr);
+        raise(SIGSTOP);
+        runListing(listing, true);
+        _exit(0);
+    }
+
+    int status;
+    waitpid(child, &status, 0);
+    ptrace(PTRACE_SETOPTIONS, child, nullptr, PTRACE_O_TRACESYSGOOD | PTRACE_O_EXITKILL);
+
+    int markers = 0;
+    while (ptrace(PTRACE_SYSCALL, child, nullptr, nullptr) == 0 && waitpid(child, &status, 0) == child) {
+        if (WIFEXITED(status) || WIFSIGNALED(status)) {
+            break;
+        }
+
+        struct __ptrace_syscall_info info;
+        if (WSTOPSIG(status) != (SIGTRAP | 0x80) ||
+            ptrace(PTRACE_GET_SYSCALL_INFO, child, (void *) sizeof(info), &info) <= 0 ||
+            info.op != PTRACE_SYSCALL_INFO_ENTRY) {
+            continue;
+        }
+
+        long nr = info.entry.nr;
+        if (nr == SYS_getppid) {
+            markers++;
+        } else if (markers == 1) {
+            count.total++;
+            if (nr == SYS_write || nr == SYS_writev || nr == SYS_sendto || nr == SYS_sendmsg || nr == SYS_sendfile) {
+                count.writes++;
+            }
+        }
+    }
+
+    waitpid(child, &status, 0);
+    return count;
+}
+
+
+
+/**
+ * Times a listing, keeping the best of several untraced runs.
+ * @param listing - sends the listing over the socket it is given.
+ * @param runs - the number of runs.
+ * @return double - the fastest run, in milliseconds.
+ */
+double timeListing(const function<void(int)> &listing, int runs) {
+    double best = -1;
+
+    for (int run = 0; run < runs; run++) {
+        auto start = std::chrono::steady_clock::now();
+        runListing(listing, false);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        if (best < 0 || ms < best) {
+            best = ms;
+        }
+    }
+
+    return best;
+}
+
+
+
+/**
+ * Fills a new scratch directory with empty files and moves into it.
+ * @param entries - the number of files to create.
+ * @return string - the directory's path.
+ */
+string makeScratchDirectory(int entries) {
+    char path[] = "/tmp/listbench.XXXXXX";
+    if (mkdtemp(path) == nullptr || chdir(path) < 0) {
+        perror("mkdtemp");
+        exit(1);
+    }
+
+    for (int i = 0; i < entries; i++) {
+        int fd = open(("file-" + to_string(i) + ".txt").c_str(), O_CREAT | O_WRONLY | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            perror("open");
+            exit(1);
+        }
+        close(fd);
+    }
+
+    return path;
+}
+
+
+
+int main(int argc, char* argv[]) {
+    const int entries = argc > 1 ? atoi(argv[1]) : 100000;
+    const size_t chunkSize = argc > 2 ? atol(argv[2]) : 64 * 1024;
+    const size_t flushSize = argc > 3 ? atol(argv[3]) : 1024 * 1024;
+    const int runs = argc > 4 ? atoi(argv[4]) : 5;
+
+    if (entries <= 0 || chunkSize == 0 || flushSize == 0 || runs <= 0) {
+        cerr << "Usage: listbench [entries] [chunk-bytes] [flush-bytes] [runs]" << endl;
+        return 1;
+    }
+
+    const string scratch = makeScratchDirectory(entries);
+    ThreadPool pool(1);
+    ListingCache cache(pool);
+
+    auto rendered = [chunkSize, flushSize](int sock) {
+        DataTransfer transfer(sock);
+        transfer.setListBatching(chunkSize, flushSize);
+        transfer.sendDirectoryList(false, false, false);
+    };
+    auto cached = [chunkSize, flushSize, &cache](int sock) {
+        DataTransfer transfer(sock);
+        transfer.setListBatching(chunkSize, flushSize);
+        transfer.sendDirectoryList(false, false, false, &cache);
+    };
+
+    // fill the cache, so the cached runs (including the traced ones, which fork from here) find it.
+    runListing(cached, false);
+
+    const vector<std::pair<string, function<void(int)>>> methods = {
+        { "per-entry", sendPerEntry },
+        { "rendered", rendered },
+        { "cached", cached }
+    };
+
+    cout << "entries: " << entries << "\tchunk: " << chunkSize << "\tflush: " << flushSize << endl;
+    cout << "method\tsyscalls\twrites\tbest_ms" << endl;
+
+    for (const auto &method : methods) {
+        SyscallCount count = countSyscalls(method.second);
+        double ms = timeListing(method.second, runs);
+
+        cout << method.first << "\t" << count.total << "\t" << count.writes << "\t"
+        << std::fixed << std::setprecision(2) << ms << endl;
+    }
+
+    // clean up the scratch directory.
+    for (int i = 0; i < entries; i++) {
+        unlink((scratch + "/file-" + to_string(i) + ".txt").c_str());
+    }
+    rmdir(scratch.c_str());
+
+    return 0;
+}
@@ -0,0 +1,204 @@
+/**
+ * Program Name: FTP Server
+ * File Name: LogBench.cpp
+ * Author: Taylor Jones
+ * Last Modified: 10/16/26
+ * Description: LogBench measures what logging costs the thread that logs.
+ *  It logs the kinds of messages a Session logs (one with a file name, a
+ *  host and a port, and one with only a number) from 1 and from 4 threads,
+ *  and reports the time per message and the share of messages dropped.
+ *  Messages are logged in bursts that fit in a thread's buffer, waiting for
+ *  the flusher between bursts (the server's case: the flusher keeps up),
+ *  and flat out, with each policy for full buffers (the flusher can't keep
+ *  up, so the drop policy drops most of them and the block policy runs at
+ *  the flusher's pace). It also times a message at a level that is switched
+ *  off, and, for reference, the same message printed the way the server
+ *  used to (cout << ... << endl). The console output goes to /dev/null
+ *  while the benchmark runs.
+ *
+ *  Usage: logbench [messages-per-thread] [runs]
+ */
+
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fcntl.h>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "../server/Logger.hpp"
+
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+
+
+static const LogEvent FILE_READY = {
+    LOG_INFO, "file_ready", "File \"{}\" ready to send to {}:{}.", { "file", "client", "data_port" }
+};
+static const LogEvent PORTS_OPEN = {
+    LOG_INFO, "passive_ports_open", "Passive data ports open: {}", { "count" }
+};
+static const LogEvent REQUEST_RECEIVED = {
+    LOG_DEBUG, "request_received", "Request from {}: {}", { "client", "request" }
+};
+
+static const int BURST_SIZE = 256;      // a quarter of a thread's buffer
+
+
+/**
+ * What a batch of messages cost.
+ */
+struct LogCost {
+    double nanoseconds = 0;     // per message, on the logging thread
+    double droppedShare = 0;    // the share of the messages that were dropped
+};
+
+
+
+/**
+ * Sends stdout and stderr to /dev/null, or back to where they were.
+ * @param quiet - true to silence them.
+ */
+void silenceConsole(bool quiet) {
+    static int savedOut = -1, savedErr = -1;
+
+    cout.flush();
+    if (quiet) {
+        int devNull = open("/dev/null", O_WRONLY);
+        savedOut = dup(STDOUT_FILENO);
+        savedErr = dup(STDERR_FILENO);
+        dup2(devNull, STDOUT_FILENO);
+        dup2(devNull, STDERR_FILENO);
+        close(devNull);
+    } else {
+        dup2(savedOut, STDOUT_FILENO);
+        dup2(savedErr, STDERR_FILENO);
+        close(savedOut);
+        close(savedErr);
+    }
+}
+
+
+
+/**
+ * Logs messages from several threads at once, and measures it. The logger
+ * is created for each run, and stopped (so everything is written out)
+ * before the next one. Only the time spent logging is counted.
+ * @param threads - the number of threads logging.
+ * @param messages - the number of messages each thread logs.
+ * @param runs - the number of runs to keep the fastest of.
+ * @param policy - what a thread does when its buffer is full.
+ * @param burst - the messages to log before waiting for them to be written out, or 0 to never wait.
+ * @param logOne - logs one message.
+ * @return LogCost - the fastest run's cost per message.
+ */
+template <typename LogOne>
+LogCost measure(int threads, int messages, int runs, LogFullPolicy policy, int burst, LogOne logOne) {
+    LogCost best;
+
+    for (int run = 0; run < runs; run++) {
+        Logger log(LOG_INFO, policy, "");
+        vector<double> seconds(threads);
+        vector<std::thread> workers;
+
+        for (int t = 0; t < threads; t++) {
+            workers.push_back(std::thread([&, t]() {
+                for (int done = 0; done < messages;) {
+                    const int count = burst > 0 ? std::min(burst, messages - done) : messages;
+                    auto start = std::chrono::steady_clock::now();
+                    for (int i = done; i < done + count; i++) {
+                        logOne(log, i);
+                    }
+                    seconds[t] += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+                    done += count;
+                    if (burst > 0) {
+                        log.flush();
+                    }
+                }
+            }));
+        }
+        for (auto &worker : workers) {
+            worker.join();
+        }
+        log.stop();
+
+        LogCost cost;
+        for (double time : seconds) {
+            cost.nanoseconds += time * 1e9 / messages / threads;
+        }
+        cost.droppedShare = (double) log.getDropped() / ((double) messages * threads);
+        if (run == 0 || cost.nanoseconds < best.nanoseconds) {
+            best = cost;
+        }
+    }
+
+    return best;
+}
+
+
+
+int main(int argc, char* argv[]) {
+    const int messages = argc > 1 ? atoi(argv[1]) : 200000;
+    const int runs = argc > 2 ? atoi(argv[2]) : 3;
+
+    if (messages <= 0 || runs <= 0) {
+        cerr << "Usage: logbench [messages-per-thread] [runs]" << endl;
+        return 1;
+    }
+
+    const string filename = "reports/2026/quarterly-summary.txt";
+    const string host = "192.168.10.24";
+    auto logFile = [&](Logger &log, int i) { log.log(FILE_READY, filename, host, 5001 + (i & 7)); };
+    auto logNumber = [&](Logger &log, int i) { log.log(PORTS_OPEN, i); };
+    auto logDisabled = [&](Logger &log, int i) { log.log(REQUEST_RECEIVED, host, filename); };
+
+    struct Case { string name; int threads; string mode; std::function<LogCost()> run; };
+    vector<Case> cases;
+    for (int threads : { 1, 4 }) {
+        cases.push_back({ "file", threads, "burst", [=]() { return measure(threads, messages, runs, LOG_DROP, BURST_SIZE, logFile); } });
+        cases.push_back({ "number", threads, "burst", [=]() { return measure(threads, messages, runs, LOG_DROP, BURST_SIZE, logNumber); } });
+        cases.push_back({ "file", threads, "drop", [=]() { return measure(threads, messages, runs, LOG_DROP, 0, logFile); } });
+        cases.push_back({ "file", threads, "block", [=]() { return measure(threads, messages, runs, LOG_BLOCK, 0, logFile); } });
+    }
+    cases.push_back({ "disabled", 1, "burst", [=]() { return measure(1, messages, runs, LOG_DROP, BURST_SIZE, logDisabled); } });
+
+    vector<LogCost> costs;
+    silenceConsole(true);
+    for (auto &test : cases) {
+        costs.push_back(test.run());
+    }
+
+    // the old way: format and flush each line on the calling thread.
+    double coutSeconds = 0;
+    for (int run = 0; run < runs; run++) {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < messages; i++) {
+            cout << "File \"" << filename << "\" ready to send to " << host << ":" << 5001 + (i & 7) << "." << endl;
+        }
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (run == 0 || seconds < coutSeconds) {
+            coutSeconds = seconds;
+        }
+    }
+    silenceConsole(false);
+
+    cout << "message\tthreads\tmode\tns_per_op\tdropped_pct" << endl;
+    for (size_t i = 0; i < cases.size(); i++) {
+        cout << cases[i].name << "\t" << cases[i].threads << "\t" << cases[i].mode << "\t"
+        << std::fixed << std::setprecision(1) << costs[i].nanoseconds << "\t"
+        << std::setprecision(2) << costs[i].droppedShare * 100 << endl;
+    }
+    cout << "cout-endl\t1\t-\t" << std::setprecision(1) << coutSeconds * 1e9 / messages << "\t0.00" << endl;
+
+    return 0;
+}
@@ -0,0 +1,197 @@
+/**
+ * Program Name: FTP Server
+ * File Name: MicroBench.cpp
+ * Author: Taylor Jones
+ * Last Modified: 10/16/26
+ * Description: MicroBench times the server's small helpers, the ones each
+ *  request or each listed entry goes through: split() and join(), isInt(),
+ *  inColor() and coloredListEntry(), getListItems() (on a scratch directory
+ *  of empty files), and ParsedRequest parsing (reused, as a Session does).
+ *  Each is run over and over in batches, and the fastest batch's time per
+ *  call is reported, as JSON on stdout (see JsonReport), so that runs from
+ *  before and after a change can be compared.
+ *
+ *  Usage: microbench [iterations] [runs]
+ */
+
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <dirent.h>
+#include <fcntl.h>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "JsonReport.hpp"
+#include "../server/ParsedRequest.hpp"
+#include "../server/Util.hpp"
+
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::string;
+using std::to_string;
+using std::vector;
+
+
+static const int LIST_ENTRIES = 1000;       // the files in the scratch directory getListItems() lists
+
+
+
+/**
+ * Runs a call over and over, and measures it.
+ * @param iterations - the number of times to run it in each batch.
+ * @param runs - the number of batches to keep the fastest of.
+ * @param call - the call to run; returns something that depends on the result, so it isn't optimized away.
+ * @return double - the fastest batch's time per call, in ns.
+ */
+template <typename Call>
+double measure(int iterations, int runs, Call call) {
+    double best = 0;
+    volatile size_t sink = 0;
+
+    for (int run = 0; run < runs; run++) {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; i++) {
+            sink = sink + call();
+        }
+
+        const double nanoseconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1e9 / iterations;
+        if (run == 0 || nanoseconds < best) {
+            best = nanoseconds;
+        }
+    }
+
+    return best;
+}
+
+
+
+/**
+ * Fills a new scratch directory with empty files.
+ * @param entries - the number of files to create.
+ * @return string - the directory's path.
+ */
+string makeScratchDirectory(int entries) {
+    char path[] = "/tmp/microbench.XXXXXX";
+    if (mkdtemp(path) == nullptr) {
+        perror("mkdtemp");
+        exit(1);
+    }
+
+    for (int i = 0; i < entries; i++) {
+        const string file = string(path) + "/file-" + to_string(i) + ".txt";
+        int fd = open(file.c_str(), O_CREAT | O_WRONLY | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            perror("open");
+            exit(1);
+        }
+        close(fd);
+    }
+
+    return path;
+}
+
+
+
+int main(int argc, char* argv[]) {
+    const int iterations = argc > 1 ? atoi(argv[1]) : 1000000;
+    const int runs = argc > 2 ? atoi(argv[2]) : 5;
+    const int COMMAND_PORT = 5000;
+
+    if (iterations <= 0 || runs <= 0) {
+        cerr << "Usage: microbench [iterations] [runs]" << endl;
+        return 1;
+    }
+
+    JsonReport report("micro");
+    report.addSetting("iterations", to_string(iterations));
+    report.addSetting("runs", to_string(runs));
+
+    auto add = [&report](const string &name, const string &variant, int calls, double nanoseconds) {
+        report.add(name, variant, { { "ns_per_op", nanoseconds }, { "ops_per_s", 1e9 / nanoseconds }, { "calls", (double) calls } });
+    };
+
+    // requests, as they arrive on the control connection.
+    struct Text { string variant; string text; };
+    const vector<Text> requests = {
+        { "list", "-l 5001" },
+        { "get", "-g reports/2026/quarterly-summary.txt 5001" },
+        { "get-options", "-g reports/2026/quarterly-summary.txt pasv framing=1 compress=6 offset=4096 length=65536" },
+        { "bad-command", "-x 5001" }
+    };
+
+    for (const auto &request : requests) {
+        double ns = measure(iterations, runs, [&]() {
+            string text = request.text;
+            return split(text).size();
+        });
+        add("split", request.variant, iterations, ns);
+    }
+
+    for (size_t words : { 4, 64 }) {
+        vector<string> items;
+        for (size_t i = 0; i < words; i++) {
+            items.push_back("file-" + to_string(i) + ".txt");
+        }
+        double ns = measure(iterations, runs, [&]() { return join(items, "\n").size(); });
+        add("join", to_string(words) + "-items", iterations, ns);
+    }
+
+    const vector<Text> numbers = { { "port", "5001" }, { "long", "2147483647" }, { "not-a-number", "50x1" } };
+    for (const auto &number : numbers) {
+        double ns = measure(iterations, runs, [&]() { return (size_t) isInt(number.text); });
+        add("isInt", number.variant + "-string", iterations, ns);
+
+        ns = measure(iterations, runs, [&]() {
+            int value = 0;
+            return (size_t) isInt(string_view(number.text), value) + value;
+        });
+        add("isInt", number.variant + "-view", iterations, ns);
+    }
+
+    double ns = measure(iterations, runs, [&]() { return inColor("reports", BLUE, DEFAULT_COLOR, BOLD).size(); });
+    add("inColor", "bold-blue", iterations, ns);
+    ns = measure(iterations, runs, [&]() { return inColor("notes.txt").size(); });
+    add("inColor", "default", iterations, ns);
+
+    struct Entry { string variant; string name; unsigned char type; };
+    const vector<Entry> entries = {
+        { "directory", "reports", DT_DIR }, { "file", "notes.txt", DT_REG }, { "hidden", ".profile", DT_REG },
+        { "link", "latest", DT_LNK }
+    };
+    for (const auto &entry : entries) {
+        ns = measure(iterations, runs, [&]() { return coloredListEntry(entry.name.c_str(), entry.type).size(); });
+        add("coloredListEntry", entry.variant, iterations, ns);
+    }
+
+    // listing a directory reads it from the system, so it gets far fewer calls.
+    const string scratch = makeScratchDirectory(LIST_ENTRIES);
+    const int listings = std::max(1, iterations / 10000);
+    ns = measure(listings, runs, [&]() { return getListItems(scratch).size(); });
+    add("getListItems", to_string(LIST_ENTRIES) + "-entries", listings, ns);
+    ns = measure(listings, runs, [&]() { return getListItems(scratch, true, true).size(); });
+    add("getListItems", to_string(LIST_ENTRIES) + "-entries-with-size", listings, ns);
+
+    for (const auto &request : requests) {
+        ParsedRequest reused(request.text, COMMAND_PORT);
+        ns = measure(iterations, runs, [&]() {
+            reused.parse(request.text);
+            return (size_t) reused.dataPort + reused.filename.size();
+        });
+        add("ParsedRequest", request.variant, iterations, ns);
+    }
+
+    // clean up the scratch directory.
+    for (int i = 0; i < LIST_ENTRIES; i++) {
+        unlink((scratch + "/file-" + to_string(i) + ".txt").c_str());
+    }
+    rmdir(scratch.c_str());
+
+    report.write(cout);
+    return 0;
+}
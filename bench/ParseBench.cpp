@@ -0,0 +1,162 @@
+/**
+ * Program Name: FTP Server
+ * File Name: ParseBench.cpp
+ * Author: Taylor Jones
+ * Last Modified: 10/16/26
+ * Description: ParseBench measures the server's request parser. It parses
+ *  a few typical requests (and two invalid ones) over and over, the way a
+ *  Session does (one ParsedRequest, reused for every request), and with a
+ *  new ParsedRequest each time, and reports the time and the heap
+ *  allocations per parse. Allocations are counted by replacing the global
+ *  operator new. For reference, it also times split(), the general-purpose
+ *  tokenizer that copies every word of a request into a vector of strings.
+ *
+ *  Usage: parsebench [iterations] [runs]
+ */
+
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "../server/ParsedRequest.hpp"
+#include "../server/Util.hpp"
+
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+
+
+static unsigned long long allocations = 0;   // every call of the global operator new so far
+
+
+void *operator new(size_t size) {
+    allocations++;
+    void *memory = malloc(size ? size : 1);
+    if (memory == nullptr) {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+void *operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void *memory) noexcept {
+    free(memory);
+}
+
+void operator delete[](void *memory) noexcept {
+    free(memory);
+}
+
+void operator delete(void *memory, size_t) noexcept {
+    free(memory);
+}
+
+void operator delete[](void *memory, size_t) noexcept {
+    free(memory);
+}
+
+
+
+/**
+ * What a batch of parses took.
+ */
+struct ParseCost {
+    double nanoseconds = 0;     // per parse
+    double allocations = 0;     // per parse
+};
+
+
+
+/**
+ * Runs a parse over and over, and measures it.
+ * @param iterations - the number of times to run it.
+ * @param runs - the number of batches to keep the fastest of.
+ * @param parse - the parse to run; returns something that depends on the result, so it isn't optimized away.
+ * @return ParseCost - the fastest batch's cost per parse.
+ */
+template <typename Parse>
+ParseCost measure(int iterations, int runs, Parse parse) {
+    ParseCost best;
+    volatile size_t sink = 0;
+
+    for (int run = 0; run < runs; run++) {
+        const unsigned long long allocationsBefore = allocations;
+        auto start = std::chrono::steady_clock::now();
+
+        for (int i = 0; i < iterations; i++) {
+            sink = sink + parse();
+        }
+
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        ParseCost cost;
+        cost.nanoseconds = seconds * 1e9 / iterations;
+        cost.allocations = (double) (allocations - allocationsBefore) / iterations;
+        if (run == 0 || cost.nanoseconds < best.nanoseconds) {
+            best = cost;
+        }
+    }
+
+    return best;
+}
+
+
+
+int main(int argc, char* argv[]) {
+    const int iterations = argc > 1 ? atoi(argv[1]) : 1000000;
+    const int runs = argc > 2 ? atoi(argv[2]) : 3;
+    const int COMMAND_PORT = 5000;
+
+    if (iterations <= 0 || runs <= 0) {
+        cerr << "Usage: parsebench [iterations] [runs]" << endl;
+        return 1;
+    }
+
+    struct Request { string name; string text; };
+    const vector<Request> requests = {
+        { "list", "-l 5001" },
+        { "get", "-g reports/2026/quarterly-summary.txt 5001" },
+        { "get-options", "-g reports/2026/quarterly-summary.txt pasv framing=1 compress=6 offset=4096 length=65536" },
+        { "hash-tree", "-hr pasv framing=1" },
+        { "bad-command", "-x 5001" },
+        { "bad-option", "-g notes.txt 5001 framing=1 streams=99" }
+    };
+
+    cout << "request\tparser\tns_per_op\tallocs_per_op" << endl;
+
+    for (const auto &request : requests) {
+        ParsedRequest reused(request.text, COMMAND_PORT);
+        ParseCost costs[3];
+
+        costs[0] = measure(iterations, runs, [&]() {
+            reused.parse(request.text);
+            return (size_t) reused.dataPort + reused.filename.size();
+        });
+        costs[1] = measure(iterations, runs, [&]() {
+            ParsedRequest fresh(request.text, COMMAND_PORT);
+            return (size_t) fresh.dataPort + fresh.filename.size();
+        });
+        costs[2] = measure(iterations, runs, [&]() {
+            string text = request.text;
+            return split(text).size();
+        });
+
+        const char *parsers[3] = { "reused", "fresh", "split" };
+        for (int i = 0; i < 3; i++) {
+            cout << request.name << "\t" << parsers[i] << "\t"
+            << std::fixed << std::setprecision(1) << costs[i].nanoseconds << "\t"
+            << std::setprecision(2) << costs[i].allocations << endl;
+        }
+    }
+
+    return 0;
+}
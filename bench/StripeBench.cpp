@@ -0,0 +1,277 @@
+/**
+ * Program Name: FTP Server
+ * File Name: StripeBench.cpp
+ * Author: Taylor Jones
+ * Last Modified: 10/16/26
+ * Description: StripeBench measures how the throughput of a striped -g
+ *  download changes with the number of streams. For each stream count
+ *  (1, 2, 4, ... up to the maximum), it downloads the same file from a
+ *  running FTP server in passive mode, reading every stream on its own
+ *  thread, and reports the best aggregate throughput of a few runs.
+ *
+ *  Usage: stripebench <host> <port> <file> [max-streams] [runs]
+ */
+
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "../server/Framing.hpp"
+
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::string;
+using std::to_string;
+using std::vector;
+
+
+/**
+ * What one run of a download has seen so far, shared by the stream threads.
+ */
+struct Download {
+    std::mutex lock;
+    std::condition_variable offered;
+    bool answered = false;      // true once the GOOD or BAD frame has arrived
+    bool good = false;
+    uint64_t size = 0;          // the size announced in the GOOD frame
+    uint64_t received = 0;      // file bytes received over every stream
+    bool failed = false;
+};
+
+
+
+/**
+ * Connects to a server.
+ * @param host - the server's host name or address.
+ * @param port - the port to connect to.
+ * @return int - the connected socket, or -1 if the connection failed.
+ */
+int connectTo(const string &host, int port) {
+    struct addrinfo hints, *found;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    if (getaddrinfo(host.c_str(), to_string(port).c_str(), &hints, &found) != 0) {
+        return -1;
+    }
+
+    int sock = socket(found->ai_family, found->ai_socktype, found->ai_protocol);
+    if (sock >= 0 && connect(sock, found->ai_addr, found->ai_addrlen) < 0) {
+        close(sock);
+        sock = -1;
+    }
+
+    freeaddrinfo(found);
+    return sock;
+}
+
+
+
+/**
+ * Reads exactly the requested number of bytes.
+ * @param sock - the socket to read from.
+ * @param buffer - where to put the bytes.
+ * @param length - the number of bytes to read.
+ * @return bool - false if the connection ended first.
+ */
+bool readFully(int sock, char *buffer, size_t length) {
+    while (length > 0) {
+        ssize_t received = recv(sock, buffer, length, 0);
+        if (received <= 0) {
+            return false;
+        }
+        buffer += received;
+        length -= received;
+    }
+    return true;
+}
+
+
+
+/**
+ * Reads and discards a frame payload, counting it as file data.
+ * @param sock - the socket to read from.
+ * @param length - the payload length.
+ * @param download - the download to count the bytes toward.
+ * @return bool - false if the connection ended first.
+ */
+bool skipPayload(int sock, uint64_t length, Download &download) {
+    static thread_local vector<char> scratch(1 << 20);
+
+    while (length > 0) {
+        size_t part = std::min<uint64_t>(length, scratch.size());
+        if (!readFully(sock, scratch.data(), part)) {
+            return false;
+        }
+        length -= part;
+
+        std::lock_guard<std::mutex> guard(download.lock);
+        download.received += part;
+    }
+    return true;
+}
+
+
+
+/**
+ * Reads one stream of a download until its END frame.
+ * @param sock - the stream's data connection.
+ * @param download - the download the stream belongs to.
+ */
+void readStream(int sock, Download &download) {
+    char header[FRAME_HEADER_SIZE];
+    char chunkHeader[CHUNK_HEADER_SIZE];
+    FrameType type;
+    uint64_t length;
+    bool ok = true;
+
+    while (ok && readFully(sock, header, sizeof(header)) && decodeFrameHeader(header, type, length)) {
+        if (type == FRAME_END) {
+            return;
+        }
+
+        if (type == FRAME_GOOD || type == FRAME_BAD) {
+            string payload(length, '\0');
+            ok = readFully(sock, &payload[0], length);
+
+            std::lock_guard<std::mutex> guard(download.lock);
+            download.answered = true;
+            download.good = ok && type == FRAME_GOOD && length == 8;
+            download.size = download.good ? readUint64(payload.data()) : 0;
+            download.offered.notify_all();
+        } else if (type == FRAME_CHUNK) {
+            ok = length >= CHUNK_HEADER_SIZE && readFully(sock, chunkHeader, sizeof(chunkHeader)) &&
+                skipPayload(sock, length - CHUNK_HEADER_SIZE, download);
+        } else {
+            ok = skipPayload(sock, length, download);
+        }
+    }
+
+    std::lock_guard<std::mutex> guard(download.lock);
+    download.failed = true;
+    download.answered = true;
+    download.offered.notify_all();
+}
+
+
+
+/**
+ * Downloads a file once over the given number of streams.
+ * @param host - the server's host.
+ * @param port - the server's control port.
+ * @param file - the file to download.
+ * @param streams - the number of data connections to use.
+ * @param bytes - holds the number of file bytes received.
+ * @return double - the seconds from \ready to the last byte, or -1 if the download failed.
+ */
+double runDownload(const string &host, int port, const string &file, int streams, uint64_t &bytes) {
+    int control = connectTo(host, port);
+    if (control < 0) {
+        return -1;
+    }
+
+    string request = "-g " + file + " pasv framing=1 streams=" + to_string(streams) + "\n";
+    char reply[256];
+    size_t replyLength = 0;
+
+    send(control, request.data(), request.size(), 0);
+    while (replyLength < sizeof(reply) - 1 && recv(control, reply + replyLength, 1, 0) == 1 && reply[replyLength] != '\n') {
+        replyLength++;
+    }
+    reply[replyLength] = '\0';
+
+    int dataPort = 0;
+    if (sscanf(reply, "\\good %d", &dataPort) != 1) {
+        cerr << "Request refused: " << reply << endl;
+        close(control);
+        return -1;
+    }
+
+    Download download;
+    vector<int> socks;
+    vector<std::thread> readers;
+    for (int i = 0; i < streams; i++) {
+        int sock = connectTo(host, dataPort);
+        if (sock >= 0) {
+            socks.push_back(sock);
+            readers.emplace_back(readStream, sock, std::ref(download));
+        }
+    }
+
+    bool good;
+    {
+        std::unique_lock<std::mutex> guard(download.lock);
+        download.offered.wait(guard, [&download]() { return download.answered; });
+        good = download.good && !download.failed;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    const string answer = good ? "\\ready\n" : "\\cancel\n";
+    send(control, answer.data(), answer.size(), 0);
+
+    for (auto &reader : readers) {
+        reader.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    send(control, "\\quit\n", 6, 0);
+    close(control);
+    for (int sock : socks) {
+        close(sock);
+    }
+
+    bytes = download.received;
+    return (good && !download.failed && download.received == download.size) ? seconds : -1;
+}
+
+
+
+int main(int argc, char* argv[]) {
+    if (argc < 4) {
+        cerr << "Usage: stripebench <host> <port> <file> [max-streams] [runs]" << endl;
+        return 1;
+    }
+
+    const string host = argv[1];
+    const int port = atoi(argv[2]);
+    const string file = argv[3];
+    const int maxStreams = argc > 4 ? atoi(argv[4]) : 8;
+    const int runs = argc > 5 ? atoi(argv[5]) : 3;
+
+    cout << "streams\tbytes\tbest_seconds\tMiB/s" << endl;
+
+    for (int streams = 1; streams <= maxStreams; streams *= 2) {
+        double best = -1;
+        uint64_t bytes = 0;
+
+        for (int run = 0; run < runs; run++) {
+            double seconds = runDownload(host, port, file, streams, bytes);
+            if (seconds < 0) {
+                cerr << "Download with " << streams << " streams failed." << endl;
+                return 1;
+            }
+            if (best < 0 || seconds < best) {
+                best = seconds;
+            }
+        }
+
+        cout << streams << "\t" << bytes << "\t" << std::fixed << std::setprecision(4) << best << "\t"
+        << std::setprecision(1) << (bytes / (1024.0 * 1024.0)) / best << endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,103 @@
+/**
+ * Program Name: FTP Load Generator
+ * File Name: LatencyHistogram.cpp
+ * Author: Taylor Jones
+ * Last Modified: 10/16/26
+ * Description: LatencyHistogram.cpp is the class implementation
+ *  file for the LatencyHistogram class.
+ *
+ *  An HDR-style histogram of request times: exact below 32 ns, and 32
+ *  log-linear buckets per power of two above, so any quantile (p50 or
+ *  p99.9 alike) can be read back to within about 3% in fixed space, and
+ *  histograms from several threads can be merged by adding them up. The
+ *  bucket layout is the server's (see server/HistogramBuckets.hpp); only
+ *  the counting differs, since a worker's histogram is read after it stops.
+ */
+
+
+#include "LatencyHistogram.hpp"
+
+
+
+/**
+ * Creates an empty histogram.
+ */
+LatencyHistogram::LatencyHistogram() :
+    buckets(Buckets::COUNT, 0) {
+    this->count = 0;
+    this->max = 0;
+}
+
+
+
+/**
+ * Counts a time.
+ * @param nanoseconds - the time.
+ */
+void LatencyHistogram::record(uint64_t nanoseconds) {
+    this->buckets[Buckets::bucketOf(nanoseconds)]++;
+    this->count++;
+    if (nanoseconds > this->max) {
+        this->max = nanoseconds;
+    }
+}
+
+
+
+/**
+ * Adds another histogram's times to this one.
+ * @param other - the other histogram.
+ */
+void LatencyHistogram::merge(const LatencyHistogram &other) {
+    for (size_t i = 0; i < this->buckets.size(); i++) {
+        this->buckets[i] += other.buckets[i];
+    }
+    this->count += other.count;
+    if (other.max > this->max) {
+        this->max = other.max;
+    }
+}
+
+
+
+/**
+ * @param quantile - a quantile, from 0 to 1 (0.99 for p99).
+ * @return uint64_t - the time (in ns) that share of the times is at or under, or 0 if there are none.
+ */
+uint64_t LatencyHistogram::quantile(double quantile) const {
+    if (this->count == 0) {
+        return 0;
+    }
+
+    uint64_t rank = (uint64_t) (quantile * this->count + 0.999999);
+    if (rank == 0) {
+        rank = 1;
+    }
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < this->buckets.size(); i++) {
+        seen += this->buckets[i];
+        if (seen >= rank) {
+            return Buckets::bucketLimit(i) < this->max ? Buckets::bucketLimit(i) : this->max;
+        }
+    }
+    return this->max;
+}
+
+
+
+/**
+ * @return uint64_t - the number of times counted.
+ */
+uint64_t LatencyHistogram::getCount() const {
+    return this->count;
+}
+
+
+
+/**
+ * @return uint64_t - the longest time counted, in ns.
+ */
+uint64_t LatencyHistogram::getMax() const {
+    return this->max;
+}
@@ -0,0 +1,47 @@
+/**
+ * Program Name: FTP Load Generator
+ * File Name: LatencyHistogram.hpp
+ * Author: Taylor Jones
+ * Last Modified: 10/16/26
+ * Description: LatencyHistogram.hpp is the class specification
+ *  file for the LatencyHistogram class. This file contains declarations
+ *  for the member functions of the LatencyHistogram class.
+ */
+
+
+#ifndef LatencyHistogram_hpp
+#define LatencyHistogram_hpp
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "../server/HistogramBuckets.hpp"
+
+using std::vector;
+
+
+class LatencyHistogram {
+  // Member Variables
+  private:
+    // 32 buckets per power of two, so a time is known to within about 3%, for times
+    // up to 2^44 ns (almost 5 hours); longer ones count as that.
+    typedef HistogramBuckets<5, 44> Buckets;
+
+    vector<uint64_t> buckets;
+    uint64_t count;
+    uint64_t max;
+
+  // Member Functions
+  public:
+    LatencyHistogram();
+
+    void record(uint64_t nanoseconds);
+    void merge(const LatencyHistogram &other);
+    uint64_t quantile(double quantile) const;
+    uint64_t getCount() const;
+    uint64_t getMax() const;
+};
+
+
+#endif /* LatencyHistogram_hpp */
@@ -0,0 +1,74 @@
+/**
+ * Program Name: FTP Load Generator
+ * File Name: LoadConfig.hpp
+ * Author: Taylor Jones
+ * Last Modified: 10/16/26
+ * Description: LoadConfig.hpp contains the settings that the load
+ *  generator is started with. Every setting has a default, and
+ *  main.cpp overrides them from the command-line options.
+ */
+
+
+#ifndef LoadConfig_hpp
+#define LoadConfig_hpp
+
+#include <string>
+#include <sys/types.h>
+#include <utility>
+#include <vector>
+
+
+/**
+ * The commands a virtual client can send, in the order they are counted.
+ */
+static const char *const LOAD_COMMANDS[] = { "-l", "-la", "-ll", "-lr", "-g" };
+static const size_t LOAD_COMMAND_COUNT = sizeof(LOAD_COMMANDS) / sizeof(LOAD_COMMANDS[0]);
+static const size_t LOAD_GET_COMMAND = LOAD_COMMAND_COUNT - 1;
+
+
+/**
+ * A file that -g requests download, and how often it is picked.
+ */
+struct LoadFile {
+    std::string name;       // the file's name on the server
+    off_t size;             // its size in bytes (for --create)
+    double weight;
+};
+
+
+struct LoadConfig {
+    std::string host;       // the server's address
+    int port;               // the server's control port
+    int clients;            // the number of virtual clients, each with its own control connection
+    unsigned threads;       // the number of threads the clients are spread over
+    double duration;        // the seconds to send requests for
+    double rate;            // open loop: the requests per second (arriving at random), or 0 for a closed loop
+    double thinkTime;       // closed loop: the seconds each client waits between its requests
+    double timeout;         // the seconds a request may take before it counts as failed
+    bool passive;           // true to have the clients connect to the server's data port
+    bool binaryMode;        // true to download files in binary mode
+    double mix[LOAD_COMMAND_COUNT];     // how often each command is picked
+    std::vector<LoadFile> files;        // the files -g downloads
+    std::string createPath;             // if set, the directory to create the files in (and then exit)
+
+    LoadConfig() {
+        this->port = -1;
+        this->clients = 100;
+        this->threads = 1;
+        this->duration = 10;
+        this->rate = 0;
+        this->thinkTime = 0;
+        this->timeout = 30;
+        this->passive = false;
+        this->binaryMode = false;
+        for (size_t i = 0; i < LOAD_COMMAND_COUNT; i++) {
+            this->mix[i] = 0;
+        }
+        this->mix[0] = 3;
+        this->mix[2] = 1;
+        this->mix[LOAD_GET_COMMAND] = 6;
+    }
+};
+
+
+#endif /* LoadConfig_hpp */
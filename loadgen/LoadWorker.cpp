@@ -0,0 +1,603 @@
+/**
+ * Program Name: FTP Load Generator
+ * File Name: LoadWorker.cpp
+ * Author: Taylor Jones
+ * Last Modified: 10/16/26
+ * Description: LoadWorker.cpp is the class implementation
+ *  file for the LoadWorker class.
+ *
+ *  A LoadWorker drives its share of the virtual clients from one thread,
+ *  with non-blocking sockets and epoll, so a few threads can keep
+ *  thousands of clients busy. Each client speaks the protocol the way the
+ *  Java client does: it sends a request on its control connection, waits
+ *  for \good, says it is \ready and waits for the server to connect to its
+ *  data port (or, in passive mode, connects to the port the server gave),
+ *  answers a file's \good line with \ready, and reads the response until
+ *  the server closes the data connection. Its control connection is kept
+ *  open for its next request.
+ *
+ *  In a closed loop, each client sends its next request as soon as (or a
+ *  think time after) the last one is answered. In an open loop, requests
+ *  arrive at random (a Poisson process) at a fixed rate, whether or not
+ *  earlier ones have been answered, and are handed to idle clients; a
+ *  request's time is counted from when it arrived, so time spent waiting
+ *  for a client is included rather than hidden.
+ */
+
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "LoadWorker.hpp"
+
+
+
+/**
+ * Creates a worker and its clients. The clients connect when run() starts.
+ * @param config - the settings the load generator was started with.
+ * @param serverAddress - the server's control port.
+ * @param clientCount - the number of clients this worker drives.
+ * @param seed - seeds the worker's random choices.
+ * @param rate - open loop: this worker's share of the requests per second.
+ */
+LoadWorker::LoadWorker(const LoadConfig &config, const struct sockaddr_in &serverAddress, int clientCount, uint64_t seed,
+                       double rate) :
+    config(config), clients(clientCount), random(seed), buffer(READ_SIZE) {
+    this->serverAddress = serverAddress;
+    this->rate = rate;
+    this->nextArrival = 0;
+    this->connectFailures = 0;
+    this->unfinished = 0;
+    this->backlog = 0;
+
+    this->commandChoice = std::discrete_distribution<size_t>(config.mix, config.mix + LOAD_COMMAND_COUNT);
+    vector<double> weights;
+    for (const auto &file : config.files) {
+        weights.push_back(file.weight);
+    }
+    this->fileChoice = std::discrete_distribution<size_t>(weights.begin(), weights.end());
+
+    this->epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (this->epollFd < 0) {
+        perror("epoll_create1");
+        exit(1);
+    }
+}
+
+
+
+/**
+ * Closes every client's sockets.
+ */
+LoadWorker::~LoadWorker() {
+    for (auto &client : this->clients) {
+        this->closeSocket(client.data);
+        this->closeSocket(client.listener);
+        this->closeSocket(client.control);
+    }
+    close(this->epollFd);
+}
+
+
+
+/**
+ * Runs the clients from start until end, and then abandons the requests
+ * that are still running.
+ * @param start - when to start (steady clock, in ns).
+ * @param end - when to stop.
+ */
+void LoadWorker::run(int64_t start, int64_t end) {
+    struct epoll_event events[256];
+    std::exponential_distribution<double> gap(this->rate > 0 ? this->rate : 1);
+
+    for (size_t i = 0; i < this->clients.size(); i++) {
+        this->connectControl(i);
+    }
+    this->nextArrival = start + (int64_t) (gap(this->random) * 1e9);
+
+    int64_t now = LoadWorker::now();
+    while (now < end) {
+        int ready = epoll_wait(this->epollFd, events, 256, POLL_INTERVAL_MS);
+        for (int i = 0; i < ready; i++) {
+            this->handleEvent(events[i].data.u64 >> 2, (SocketKind) (events[i].data.u64 & 3), events[i].events);
+        }
+
+        now = LoadWorker::now();
+        if (this->rate > 0) {
+            while (this->nextArrival <= now && this->nextArrival < end) {
+                this->arrivals.push_back(this->nextArrival);
+                this->nextArrival += (int64_t) (gap(this->random) * 1e9);
+            }
+            while (!this->arrivals.empty() && !this->idleClients.empty()) {
+                const size_t index = this->idleClients.front();
+                this->idleClients.pop_front();
+                if (this->clients[index].state == CLIENT_IDLE) {
+                    this->issueRequest(index, this->arrivals.front());
+                    this->arrivals.pop_front();
+                }
+            }
+        }
+        this->checkTimers(now, end);
+    }
+
+    for (const auto &client : this->clients) {
+        if (client.state >= CLIENT_AWAITING_REPLY) {
+            this->unfinished++;
+        }
+    }
+    this->backlog = this->arrivals.size();
+}
+
+
+
+/**
+ * Starts (or changes) watching one of a client's sockets.
+ * @param fd - the socket.
+ * @param index - the client.
+ * @param kind - which of the client's sockets it is.
+ * @param events - the epoll events to wait for.
+ * @param added - true if the socket is already being watched.
+ */
+void LoadWorker::watch(int fd, size_t index, SocketKind kind, uint32_t events, bool added) {
+    struct epoll_event event = {};
+    event.events = events;
+    event.data.u64 = (index << 2) | kind;
+
+    if (epoll_ctl(this->epollFd, added ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, fd, &event) < 0) {
+        perror("epoll_ctl");
+        exit(1);
+    }
+}
+
+
+
+/**
+ * Starts a client's control connection and, in active mode, opens its data port.
+ * @param index - the client.
+ */
+void LoadWorker::connectControl(size_t index) {
+    VirtualClient &client = this->clients[index];
+    client.controlIn.clear();
+
+    client.control = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (client.control < 0 ||
+        (connect(client.control, (struct sockaddr*) &this->serverAddress, sizeof(this->serverAddress)) < 0 && errno != EINPROGRESS)) {
+        this->connectFailures++;
+        this->dropClient(index);
+        return;
+    }
+    // \ready gets no reply, so with Nagle's algorithm the next request would wait for the server's delayed ACK.
+    int noDelay = 1;
+    setsockopt(client.control, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+    this->watch(client.control, index, CONTROL_SOCKET, EPOLLOUT, false);
+    client.state = CLIENT_CONNECTING;
+
+    if (!this->config.passive && client.listener < 0) {
+        struct sockaddr_in address = {};
+        socklen_t size = sizeof(address);
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_ANY);
+
+        client.listener = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (client.listener < 0 || bind(client.listener, (struct sockaddr*) &address, sizeof(address)) < 0 ||
+            listen(client.listener, 4) < 0 || getsockname(client.listener, (struct sockaddr*) &address, &size) < 0) {
+            perror("Data port creation failed");
+            exit(1);
+        }
+        client.listenPort = ntohs(address.sin_port);
+        this->watch(client.listener, index, LISTEN_SOCKET, EPOLLIN, false);
+    }
+}
+
+
+
+/**
+ * Sends a client's next request, picking its command (and file) at random.
+ * @param index - the client.
+ * @param due - when the request was due, in ns.
+ */
+void LoadWorker::issueRequest(size_t index, int64_t due) {
+    VirtualClient &client = this->clients[index];
+    client.command = this->commandChoice(this->random);
+    client.due = due;
+    client.sentAt = LoadWorker::now();
+    client.bytes = 0;
+    client.refused = false;
+    client.offer.clear();
+
+    string request = LOAD_COMMANDS[client.command];
+    if (client.command == LOAD_GET_COMMAND) {
+        request += " " + this->config.files[this->fileChoice(this->random)].name;
+    }
+    request += this->config.passive ? " pasv" : " " + std::to_string(client.listenPort);
+    if (client.command == LOAD_GET_COMMAND && this->config.binaryMode) {
+        request += " mode=binary";
+    }
+
+    client.state = CLIENT_AWAITING_REPLY;
+    this->sendControl(index, request + "\n");
+}
+
+
+
+/**
+ * Moves a client along after activity on one of its sockets.
+ * @param index - the client.
+ * @param kind - which of its sockets had activity.
+ * @param events - the epoll events that occurred.
+ */
+void LoadWorker::handleEvent(size_t index, SocketKind kind, uint32_t events) {
+    VirtualClient &client = this->clients[index];
+    if ((kind == CONTROL_SOCKET && client.control < 0) || (kind == DATA_SOCKET && client.data < 0)) {
+        return;     // closed while handling an earlier event of the same batch
+    }
+
+    if (kind == CONTROL_SOCKET) {
+        if (client.state == CLIENT_CONNECTING) {
+            int error = 0;
+            socklen_t size = sizeof(error);
+            getsockopt(client.control, SOL_SOCKET, SO_ERROR, &error, &size);
+            if (error != 0 || (events & (EPOLLERR | EPOLLHUP))) {
+                this->connectFailures++;
+                this->dropClient(index);
+                return;
+            }
+            this->watch(client.control, index, CONTROL_SOCKET, EPOLLIN, true);
+            this->becomeIdle(index);
+        } else {
+            this->readControl(index);
+        }
+    } else if (kind == LISTEN_SOCKET) {
+        this->acceptData(index);
+    } else if (client.state == CLIENT_AWAITING_DATA) {
+        // passive mode: our connection to the server's data port is made (or failed).
+        int error = 0;
+        socklen_t size = sizeof(error);
+        getsockopt(client.data, SOL_SOCKET, SO_ERROR, &error, &size);
+        if (error != 0) {
+            this->finishRequest(index, false);
+            return;
+        }
+        this->watch(client.data, index, DATA_SOCKET, EPOLLIN, true);
+        this->startData(index);
+    } else {
+        this->readData(index);
+    }
+}
+
+
+
+/**
+ * Reads what the server sent on a client's control connection, and handles each whole line.
+ * @param index - the client.
+ */
+void LoadWorker::readControl(size_t index) {
+    VirtualClient &client = this->clients[index];
+    char input[4096];
+
+    while (true) {
+        ssize_t received = recv(client.control, input, sizeof(input), 0);
+        if (received > 0) {
+            client.controlIn.append(input, received);
+            continue;
+        }
+        if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        }
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+
+        // the server hung up.
+        this->dropClient(index);
+        return;
+    }
+
+    size_t newline;
+    while (client.state != CLIENT_DISCONNECTED && (newline = client.controlIn.find('\n')) != string::npos) {
+        const string line = client.controlIn.substr(0, newline);
+        client.controlIn.erase(0, newline + 1);
+        if (!line.empty()) {
+            this->handleReply(index, line);
+        }
+    }
+}
+
+
+
+/**
+ * Handles the server's answer to a client's request.
+ * @param index - the client.
+ * @param line - a line from the control connection.
+ */
+void LoadWorker::handleReply(size_t index, const string &line) {
+    VirtualClient &client = this->clients[index];
+    if (client.state == CLIENT_AWAITING_DATA) {
+        // the server couldn't connect to our data port (or ours didn't reach it in time), and says so.
+        this->finishRequest(index, false);
+        return;
+    }
+    if (client.state != CLIENT_AWAITING_REPLY) {
+        return;
+    }
+
+    if (line.compare(0, 5, "\\good") != 0) {
+        this->finishRequest(index, false);
+        return;
+    }
+
+    client.state = CLIENT_AWAITING_DATA;
+    if (!this->config.passive) {
+        this->sendControl(index, "\\ready\n");
+        return;
+    }
+
+    struct sockaddr_in address = this->serverAddress;
+    address.sin_port = htons(atoi(line.c_str() + 5));
+    client.data = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (client.data < 0 || (connect(client.data, (struct sockaddr*) &address, sizeof(address)) < 0 && errno != EINPROGRESS)) {
+        this->finishRequest(index, false);
+        return;
+    }
+    this->watch(client.data, index, DATA_SOCKET, EPOLLOUT, false);
+}
+
+
+
+/**
+ * Accepts the server's connection to a client's data port.
+ * @param index - the client.
+ */
+void LoadWorker::acceptData(size_t index) {
+    VirtualClient &client = this->clients[index];
+
+    int sock = accept4(client.listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (sock < 0) {
+        return;
+    }
+    if (client.state != CLIENT_AWAITING_DATA || client.data >= 0) {
+        close(sock);    // left over from a request that was given up on
+        return;
+    }
+
+    client.data = sock;
+    this->watch(client.data, index, DATA_SOCKET, EPOLLIN, false);
+    this->startData(index);
+}
+
+
+
+/**
+ * Starts reading the response once a client's data connection is open.
+ * @param index - the client.
+ */
+void LoadWorker::startData(size_t index) {
+    VirtualClient &client = this->clients[index];
+    client.state = client.command == LOAD_GET_COMMAND ? CLIENT_READING_OFFER : CLIENT_READING_DATA;
+}
+
+
+
+/**
+ * Reads the response on a client's data connection. A file's response starts
+ * with a \good line (answered with \ready), or with an error message if
+ * the file can't be sent. The response ends when the server closes the connection.
+ * @param index - the client.
+ */
+void LoadWorker::readData(size_t index) {
+    VirtualClient &client = this->clients[index];
+
+    while (client.state == CLIENT_READING_OFFER || client.state == CLIENT_READING_DATA) {
+        ssize_t received = recv(client.data, this->buffer.data(), this->buffer.size(), 0);
+        if (received < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                this->finishRequest(index, false);
+            }
+            return;
+        }
+        if (received == 0) {
+            this->finishRequest(index, client.state == CLIENT_READING_DATA && !client.refused);
+            return;
+        }
+
+        size_t used = 0;
+        if (client.state == CLIENT_READING_OFFER) {
+            const char *newline = (const char *) memchr(this->buffer.data(), '\n', received);
+            used = newline == nullptr ? received : newline - this->buffer.data() + 1;
+            client.offer.append(this->buffer.data(), used);
+            if (newline == nullptr) {
+                continue;
+            }
+
+            client.refused = client.offer.compare(0, 5, "\\good") != 0;
+            client.state = CLIENT_READING_DATA;
+            if (!client.refused && !this->sendControl(index, "\\ready\n")) {
+                return;
+            }
+        }
+        client.bytes += received - used;
+    }
+}
+
+
+
+/**
+ * Counts a client's request, and makes the client ready for its next one.
+ * @param index - the client.
+ * @param ok - true if the request was answered as asked.
+ */
+void LoadWorker::finishRequest(size_t index, bool ok) {
+    VirtualClient &client = this->clients[index];
+    CommandStats &stats = this->stats[client.command];
+
+    this->closeSocket(client.data);
+    if (ok) {
+        stats.completed++;
+        stats.bytes += client.bytes;
+        stats.latency.record(LoadWorker::now() - client.due);
+    } else {
+        stats.errors++;
+    }
+
+    this->becomeIdle(index);
+}
+
+
+
+/**
+ * Makes a client idle. In a closed loop, it sends its next request at
+ * once, or after its think time; in an open loop, it takes the next
+ * request that has arrived, or waits for one.
+ * @param index - the client.
+ */
+void LoadWorker::becomeIdle(size_t index) {
+    VirtualClient &client = this->clients[index];
+    client.state = CLIENT_IDLE;
+
+    if (this->rate > 0) {
+        if (!this->arrivals.empty()) {
+            const int64_t due = this->arrivals.front();
+            this->arrivals.pop_front();
+            this->issueRequest(index, due);
+        } else {
+            this->idleClients.push_back(index);
+        }
+    } else if (this->config.thinkTime > 0) {
+        client.wakeAt = LoadWorker::now() + (int64_t) (this->config.thinkTime * 1e9);
+    } else {
+        this->issueRequest(index, LoadWorker::now());
+    }
+}
+
+
+
+/**
+ * Closes a client's connections after the server hung up, a connection
+ * failed or a request timed out, and has it reconnect shortly. A request
+ * that was running counts as failed.
+ * @param index - the client.
+ */
+void LoadWorker::dropClient(size_t index) {
+    VirtualClient &client = this->clients[index];
+
+    if (client.state >= CLIENT_AWAITING_REPLY) {
+        this->stats[client.command].errors++;
+    }
+    this->closeSocket(client.data);
+    this->closeSocket(client.control);
+    client.state = CLIENT_DISCONNECTED;
+    client.wakeAt = LoadWorker::now() + RECONNECT_DELAY_NS;
+}
+
+
+
+/**
+ * Closes a socket (which also stops epoll watching it), if it is open.
+ * @param fd - the socket, set to -1.
+ */
+void LoadWorker::closeSocket(int &fd) {
+    if (fd >= 0) {
+        close(fd);
+        fd = -1;
+    }
+}
+
+
+
+/**
+ * Sends a message on a client's control connection. Control messages are
+ * small, so the socket's buffer always has room for them.
+ * @param index - the client.
+ * @param message - the message, with its newline.
+ * @return bool - false if the connection failed (and the client was dropped).
+ */
+bool LoadWorker::sendControl(size_t index, const string &message) {
+    VirtualClient &client = this->clients[index];
+
+    if (send(client.control, message.data(), message.size(), MSG_NOSIGNAL) != (ssize_t) message.size()) {
+        this->dropClient(index);
+        return false;
+    }
+    return true;
+}
+
+
+
+/**
+ * Reconnects dropped clients, sends closed-loop clients' requests once
+ * their think time is up, and gives up on requests that take too long.
+ * @param now - the time, in ns.
+ * @param end - when the run ends; no request is sent after it.
+ */
+void LoadWorker::checkTimers(int64_t now, int64_t end) {
+    const int64_t timeout = (int64_t) (this->config.timeout * 1e9);
+
+    for (size_t i = 0; i < this->clients.size(); i++) {
+        VirtualClient &client = this->clients[i];
+
+        if (client.state == CLIENT_DISCONNECTED && client.wakeAt <= now && now < end) {
+            this->connectControl(i);
+        } else if (client.state == CLIENT_IDLE && this->rate == 0 && this->config.thinkTime > 0 && client.wakeAt <= now) {
+            this->issueRequest(i, now);
+        } else if (client.state >= CLIENT_AWAITING_REPLY && now - client.sentAt > timeout) {
+            this->dropClient(i);
+        }
+    }
+}
+
+
+
+/**
+ * @param command - a command, as an index into LOAD_COMMANDS.
+ * @return const CommandStats& - what the command's requests did.
+ */
+const CommandStats &LoadWorker::getStats(size_t command) const {
+    return this->stats[command];
+}
+
+
+
+/**
+ * @return uint64_t - the control connections that couldn't be made.
+ */
+uint64_t LoadWorker::getConnectFailures() const {
+    return this->connectFailures;
+}
+
+
+
+/**
+ * @return uint64_t - the requests still running when the time was up.
+ */
+uint64_t LoadWorker::getUnfinished() const {
+    return this->unfinished;
+}
+
+
+
+/**
+ * @return uint64_t - open loop: the requests that had arrived but that no client had taken when the time was up.
+ */
+uint64_t LoadWorker::getBacklog() const {
+    return this->backlog;
+}
+
+
+
+/**
+ * @return int64_t - the steady clock's time, in ns.
+ */
+int64_t LoadWorker::now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
@@ -0,0 +1,134 @@
+/**
+ * Program Name: FTP Load Generator
+ * File Name: LoadWorker.hpp
+ * Author: Taylor Jones
+ * Last Modified: 10/16/26
+ * Description: LoadWorker.hpp is the class specification
+ *  file for the LoadWorker class. This file contains declarations
+ *  for the member functions of the LoadWorker class.
+ */
+
+
+#ifndef LoadWorker_hpp
+#define LoadWorker_hpp
+
+#include <cstdint>
+#include <deque>
+#include <netinet/in.h>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "LatencyHistogram.hpp"
+#include "LoadConfig.hpp"
+
+using std::string;
+using std::vector;
+
+
+/**
+ * The steps a virtual client moves through for each request.
+ */
+enum ClientState {
+    CLIENT_DISCONNECTED,        // waiting to (re)connect to the server
+    CLIENT_CONNECTING,          // the control connection is being made
+    CLIENT_IDLE,                // connected, with no request
+    CLIENT_AWAITING_REPLY,      // the request is sent, waiting for \good (or an error) on the control connection
+    CLIENT_AWAITING_DATA,       // waiting for the data connection: the server's (active) or ours (passive)
+    CLIENT_READING_OFFER,       // -g only: reading the \good line that starts the data connection
+    CLIENT_READING_DATA         // reading the response until the server closes the data connection
+};
+
+
+/**
+ * What the requests of one command did.
+ */
+struct CommandStats {
+    uint64_t completed = 0;     // requests answered as asked
+    uint64_t errors = 0;        // requests refused, failed or timed out
+    uint64_t bytes = 0;         // the bytes received on the data connections of completed requests
+    LatencyHistogram latency;   // the times of completed requests
+};
+
+
+/**
+ * One simulated client, with its own control connection (kept open from
+ * request to request) and, in active mode, its own data port.
+ */
+struct VirtualClient {
+    ClientState state = CLIENT_DISCONNECTED;
+    int control = -1;
+    int listener = -1;          // active mode: the data port the server connects to
+    int data = -1;
+    int listenPort = 0;
+    string controlIn;           // control input that isn't a whole line yet
+    string offer;               // -g only: the data connection's first line so far
+    size_t command = 0;
+    int64_t due = 0;            // when the request was due (open loop) or sent (closed loop), in ns
+    int64_t sentAt = 0;         // when the request was sent, in ns
+    int64_t wakeAt = 0;         // when to reconnect, or (closed loop) to send the next request, in ns
+    uint64_t bytes = 0;
+    bool refused = false;       // true if the server answered with an error
+};
+
+
+class LoadWorker {
+  // Member Variables
+  private:
+    enum SocketKind { CONTROL_SOCKET, LISTEN_SOCKET, DATA_SOCKET };
+
+    static const int64_t RECONNECT_DELAY_NS = 100 * 1000 * 1000;
+    static const int POLL_INTERVAL_MS = 1;          // how often timers are checked when nothing happens
+    static const size_t READ_SIZE = 256 * 1024;
+
+    const LoadConfig &config;
+    struct sockaddr_in serverAddress;
+    int epollFd;
+    vector<VirtualClient> clients;
+    std::deque<size_t> idleClients;     // open loop: connected clients with nothing to do
+    std::deque<int64_t> arrivals;       // open loop: the due times of requests no client has taken yet
+    double rate;                        // open loop: this worker's share of the requests per second
+    int64_t nextArrival;
+    std::mt19937_64 random;
+    std::discrete_distribution<size_t> commandChoice;
+    std::discrete_distribution<size_t> fileChoice;
+    CommandStats stats[LOAD_COMMAND_COUNT];
+    uint64_t connectFailures;
+    uint64_t unfinished;                // requests still running when the time was up
+    uint64_t backlog;                   // open loop: requests no client had taken when the time was up
+    vector<char> buffer;
+
+  // Member Functions
+  private:
+    void watch(int fd, size_t index, SocketKind kind, uint32_t events, bool added);
+    void connectControl(size_t index);
+    void issueRequest(size_t index, int64_t due);
+    void handleEvent(size_t index, SocketKind kind, uint32_t events);
+    void readControl(size_t index);
+    void handleReply(size_t index, const string &line);
+    void acceptData(size_t index);
+    void startData(size_t index);
+    void readData(size_t index);
+    void finishRequest(size_t index, bool ok);
+    void becomeIdle(size_t index);
+    void dropClient(size_t index);
+    void closeSocket(int &fd);
+    bool sendControl(size_t index, const string &message);
+    void checkTimers(int64_t now, int64_t end);
+
+  public:
+    LoadWorker(const LoadConfig &config, const struct sockaddr_in &serverAddress, int clientCount, uint64_t seed, double rate);
+    ~LoadWorker();
+
+    void run(int64_t start, int64_t end);
+
+    const CommandStats &getStats(size_t command) const;
+    uint64_t getConnectFailures() const;
+    uint64_t getUnfinished() const;
+    uint64_t getBacklog() const;
+
+    static int64_t now();
+};
+
+
+#endif /* LoadWorker_hpp */
@@ -0,0 +1,376 @@
+/**
+ * Program Name: FTP Load Generator
+ * File Name: main.cpp
+ * Author: Taylor Jones
+ * Last Modified: 10/16/26
+ * Description: This program puts an FTP server under load, the way many
+ *  clients at once would. It runs a number of virtual clients (spread over
+ *  a few threads, each driving its clients with epoll) that send a mix of
+ *  -l, -la, -ll, -lr and -g requests, in a closed loop (each client sends
+ *  its next request when the last is answered) or an open loop (requests
+ *  arrive at a fixed rate), and downloads files of a chosen mix of sizes.
+ *  At the end it reports each command's throughput and its latency
+ *  percentiles.
+ *
+ *  Usage: loadgen <host> <port> [options]   (see printUsage())
+ */
+
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <netdb.h>
+#include <sstream>
+#include <string>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "LoadConfig.hpp"
+#include "LoadWorker.hpp"
+
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+
+static const char *const USAGE =
+    "Usage: loadgen <host> <port> [--clients <count>] [--threads <count>] [--duration <seconds>]\n"
+    "               [--rate <requests-per-second>] [--think <seconds>] [--timeout <seconds>] [--pasv] [--binary]\n"
+    "               [--mix <command>=<weight>,...] [--sizes <size>=<weight>,...] [--files <name>=<weight>,...]\n"
+    "               [--create <directory>]\n"
+    "  --mix      how often each of -l, -la, -ll, -lr and -g is sent (default -l=3,-ll=1,-g=6)\n"
+    "  --sizes    the sizes of the files -g downloads, named load-<size>.bin (default 1K=40,64K=40,1M=15,16M=5)\n"
+    "  --files    the files -g downloads, instead of --sizes\n"
+    "  --create   create the --sizes files in a directory (for the server to serve), and exit\n"
+    "  --rate     send requests at this rate (an open loop), instead of as fast as the clients can (a closed loop)";
+
+
+
+/**
+ * Prints the usage and exits.
+ */
+void printUsage() {
+    cerr << USAGE << endl;
+    exit(1);
+}
+
+
+
+/**
+ * Parses a number, the whole of a string.
+ * @param text - the text.
+ * @param value - set to the number.
+ * @return bool - true if the text was a number, not below 0.
+ */
+bool parseNumber(const string &text, double &value) {
+    char *end = nullptr;
+    value = strtod(text.c_str(), &end);
+    return !text.empty() && *end == '\0' && value >= 0;
+}
+
+
+
+/**
+ * Parses a size, such as 512, 64K, 16M or 1G.
+ * @param text - the text.
+ * @param size - set to the size in bytes.
+ * @return bool - true if the text was a size.
+ */
+bool parseSize(const string &text, off_t &size) {
+    char *end = nullptr;
+    const long long value = strtoll(text.c_str(), &end, 10);
+    const string unit = end;
+
+    if (text.empty() || end == text.c_str() || value < 0) {
+        return false;
+    }
+    if (unit.empty()) {
+        size = value;
+    } else if (unit == "K" || unit == "k") {
+        size = value << 10;
+    } else if (unit == "M" || unit == "m") {
+        size = value << 20;
+    } else if (unit == "G" || unit == "g") {
+        size = value << 30;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+
+
+/**
+ * Parses a list of weighted choices: <name>=<weight>,...
+ * @param text - the list.
+ * @param choices - set to the names and weights.
+ * @return bool - true if the list was well formed.
+ */
+bool parseWeights(const string &text, vector<std::pair<string, double>> &choices) {
+    std::istringstream list(text);
+    string item;
+    choices.clear();
+
+    while (std::getline(list, item, ',')) {
+        const size_t equals = item.rfind('=');
+        double weight;
+        if (equals == string::npos || equals == 0 || !parseNumber(item.substr(equals + 1), weight)) {
+            return false;
+        }
+        choices.push_back({ item.substr(0, equals), weight });
+    }
+    return !choices.empty();
+}
+
+
+
+/**
+ * Applies the options that follow the host and port to the configuration.
+ * If an option is unknown or its value is invalid, the usage is printed
+ * and the program exits.
+ * @param count - the # of arguments provided to the "main" function.
+ * @param args - the arguments provided to the "main" function
+ * @param config - the configuration to update.
+ */
+void applyOptions(int count, char* args[], LoadConfig &config) {
+    string sizes = "1K=40,64K=40,1M=15,16M=5";
+    string files;
+
+    for (int i = 3; i < count; i++) {
+        const string option = args[i];
+        const bool hasValue = i + 1 < count;
+        const string text = hasValue ? args[i + 1] : "";
+        double value = 0;
+        const bool hasNumber = hasValue && parseNumber(text, value);
+        vector<std::pair<string, double>> choices;
+
+        if (option == "--clients" && hasNumber && value >= 1) {
+            config.clients = (int) value;
+        } else if (option == "--threads" && hasNumber && value >= 1) {
+            config.threads = (unsigned) value;
+        } else if (option == "--duration" && hasNumber && value > 0) {
+            config.duration = value;
+        } else if (option == "--rate" && hasNumber) {
+            config.rate = value;
+        } else if (option == "--think" && hasNumber) {
+            config.thinkTime = value;
+        } else if (option == "--timeout" && hasNumber && value > 0) {
+            config.timeout = value;
+        } else if (option == "--pasv") {
+            config.passive = true;
+            continue;
+        } else if (option == "--binary") {
+            config.binaryMode = true;
+            continue;
+        } else if (option == "--mix" && hasValue && parseWeights(text, choices)) {
+            std::fill(config.mix, config.mix + LOAD_COMMAND_COUNT, 0);
+            for (const auto &choice : choices) {
+                auto command = std::find(LOAD_COMMANDS, LOAD_COMMANDS + LOAD_COMMAND_COUNT, choice.first);
+                if (command == LOAD_COMMANDS + LOAD_COMMAND_COUNT) {
+                    printUsage();
+                }
+                config.mix[command - LOAD_COMMANDS] = choice.second;
+            }
+        } else if (option == "--sizes" && hasValue) {
+            sizes = text;
+        } else if (option == "--files" && hasValue) {
+            files = text;
+        } else if (option == "--create" && hasValue) {
+            config.createPath = text;
+        } else {
+            printUsage();
+        }
+        i++;
+    }
+
+    vector<std::pair<string, double>> choices;
+    if (!parseWeights(files.empty() ? sizes : files, choices)) {
+        printUsage();
+    }
+    for (const auto &choice : choices) {
+        LoadFile file = { choice.first, 0, choice.second };
+        if (files.empty()) {
+            if (!parseSize(choice.first, file.size)) {
+                printUsage();
+            }
+            file.name = "load-" + choice.first + ".bin";
+        }
+        config.files.push_back(file);
+    }
+
+    double total = 0;
+    for (double weight : config.mix) {
+        total += weight;
+    }
+    if (total <= 0 || (!config.createPath.empty() && !files.empty())) {
+        printUsage();
+    }
+}
+
+
+
+/**
+ * Creates the files that -g downloads, for the server to serve. They are
+ * sparse, so they take no disk space.
+ * @param config - the configuration, with the files and the directory to create them in.
+ */
+void createFiles(const LoadConfig &config) {
+    mkdir(config.createPath.c_str(), 0755);
+
+    for (const auto &file : config.files) {
+        const string path = config.createPath + "/" + file.name;
+        int fd = open(path.c_str(), O_CREAT | O_TRUNC | O_WRONLY | O_CLOEXEC, 0644);
+        if (fd < 0 || ftruncate(fd, file.size) < 0) {
+            perror(path.c_str());
+            exit(1);
+        }
+        close(fd);
+        cout << "Created " << path << " (" << file.size << " bytes)" << endl;
+    }
+}
+
+
+
+/**
+ * Looks up the server's address.
+ * @param config - the configuration, with the host and port.
+ * @return sockaddr_in - the server's control port.
+ */
+struct sockaddr_in resolveServer(const LoadConfig &config) {
+    struct addrinfo hints = {}, *found = nullptr;
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+
+    if (getaddrinfo(config.host.c_str(), std::to_string(config.port).c_str(), &hints, &found) != 0 || found == nullptr) {
+        cerr << "Unknown host: " << config.host << endl;
+        exit(1);
+    }
+    struct sockaddr_in address = *(struct sockaddr_in *) found->ai_addr;
+    freeaddrinfo(found);
+
+    return address;
+}
+
+
+
+/**
+ * Allows as many open files as the system permits: each client can have three sockets open.
+ */
+void raiseOpenFileLimit() {
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+
+
+/**
+ * Prints a line of the report.
+ * @param name - the command, or "all".
+ * @param stats - what its requests did.
+ * @param seconds - the length of the run.
+ */
+void printStats(const string &name, const CommandStats &stats, double seconds) {
+    const LatencyHistogram &latency = stats.latency;
+
+    cout << std::left << std::setw(6) << name << std::right << std::fixed
+    << std::setw(10) << stats.completed << std::setw(8) << stats.errors
+    << std::setprecision(1) << std::setw(11) << stats.completed / seconds
+    << std::setprecision(2) << std::setw(11) << stats.bytes / seconds / (1024 * 1024)
+    << std::setprecision(3) << std::setw(10) << latency.quantile(0.5) / 1e6
+    << std::setw(10) << latency.quantile(0.99) / 1e6 << std::setw(10) << latency.quantile(0.999) / 1e6
+    << std::setw(10) << latency.getMax() / 1e6 << endl;
+}
+
+
+
+int main(int argc, char* argv[]) {
+    LoadConfig config;
+    double port = 0;
+
+    if (argc < 3 || !parseNumber(argv[2], port) || port < 1 || port > 65535) {
+        printUsage();
+    }
+    config.host = argv[1];
+    config.port = (int) port;
+    applyOptions(argc, argv, config);
+
+    if (!config.createPath.empty()) {
+        createFiles(config);
+        return 0;
+    }
+
+    raiseOpenFileLimit();
+    const struct sockaddr_in server = resolveServer(config);
+    config.threads = std::min<unsigned>(config.threads, config.clients);
+
+    // spread the clients (and the open loop's rate) evenly over the threads.
+    vector<unique_ptr<LoadWorker>> workers;
+    for (unsigned t = 0; t < config.threads; t++) {
+        const int clients = config.clients / config.threads + (t < config.clients % config.threads ? 1 : 0);
+        const double rate = config.rate * clients / config.clients;
+        workers.push_back(unique_ptr<LoadWorker>(new LoadWorker(config, server, clients, 0x5eed + t, rate)));
+    }
+
+    const int64_t start = LoadWorker::now();
+    const int64_t end = start + (int64_t) (config.duration * 1e9);
+    vector<std::thread> threads;
+    for (auto &worker : workers) {
+        LoadWorker *running = worker.get();
+        threads.push_back(std::thread([running, start, end]() { running->run(start, end); }));
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    const double seconds = (LoadWorker::now() - start) / 1e9;
+
+    // add up the workers' counts.
+    CommandStats totals[LOAD_COMMAND_COUNT], all;
+    uint64_t connectFailures = 0, unfinished = 0, backlog = 0;
+    for (auto &worker : workers) {
+        for (size_t c = 0; c < LOAD_COMMAND_COUNT; c++) {
+            const CommandStats &stats = worker->getStats(c);
+            for (CommandStats *total : { &totals[c], &all }) {
+                total->completed += stats.completed;
+                total->errors += stats.errors;
+                total->bytes += stats.bytes;
+                total->latency.merge(stats.latency);
+            }
+        }
+        connectFailures += worker->getConnectFailures();
+        unfinished += worker->getUnfinished();
+        backlog += worker->getBacklog();
+    }
+
+    cout << "clients: " << config.clients << "  threads: " << config.threads << "  duration: "
+    << std::fixed << std::setprecision(1) << seconds << " s  "
+    << (config.rate > 0 ? "open loop at " + std::to_string((long) config.rate) + " requests/s" : "closed loop")
+    << "  data connections: " << (config.passive ? "passive" : "active") << endl;
+    cout << "command   requests  errors  req_per_s  MiB_per_s    p50_ms    p99_ms   p999_ms    max_ms" << endl;
+    for (size_t c = 0; c < LOAD_COMMAND_COUNT; c++) {
+        if (config.mix[c] > 0) {
+            printStats(LOAD_COMMANDS[c], totals[c], seconds);
+        }
+    }
+    printStats("all", all, seconds);
+    cout << "unfinished: " << unfinished << "  connect failures: " << connectFailures;
+    if (config.rate > 0) {
+        cout << "  backlog: " << backlog;
+    }
+    cout << endl;
+
+    return 0;
+}
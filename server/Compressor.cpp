@@ -0,0 +1,69 @@
+/**
+ * Program Name: FTP Server
+ * File Name: Compressor.cpp
+ * Author: Taylor Jones
+ * Last Modified: 10/16/26
+ * Description: Compressor.cpp is the class implementation
+ *  file for the Compressor class.
+ *
+ *  A Compressor packs the payloads of DATA and LIST frames for clients
+ *  that ask for compression (with the compress=<level> request option).
+ *  Every payload is a complete zlib stream of its own, so a frame that
+ *  doesn't shrink can be sent as it is without upsetting the client's
+ *  decompressor, and the one deflate state is reset and reused for every
+ *  frame of a transfer rather than set up again.
+ */
+
+
+#include "Compressor.hpp"
+
+
+/**
+ * Sets up a compressor.
+ * @param level - the zlib compression level, from 1 (fastest) to 9 (smallest).
+ */
+Compressor::Compressor(int level) {
+    this->stream.zalloc = Z_NULL;
+    this->stream.zfree = Z_NULL;
+    this->stream.opaque = Z_NULL;
+    this->ready = deflateInit(&this->stream, level) == Z_OK;
+}
+
+
+
+/**
+ * Frees zlib's state.
+ */
+Compressor::~Compressor() {
+    if (this->ready) {
+        deflateEnd(&this->stream);
+    }
+}
+
+
+
+/**
+ * Compresses a block of data into a zlib stream of its own.
+ * @param data - the data.
+ * @param length - the number of bytes of data.
+ * @param packed - holds the compressed data.
+ * @return bool - true if the compressed data is smaller than the data, false if the data should be sent as it is.
+ */
+bool Compressor::compress(const char *data, size_t length, string &packed) {
+    if (!this->ready || length == 0 || deflateReset(&this->stream) != Z_OK) {
+        return false;
+    }
+
+    packed.resize(deflateBound(&this->stream, length));
+    this->stream.next_in = (Bytef *) data;
+    this->stream.avail_in = length;
+    this->stream.next_out = (Bytef *) &packed[0];
+    this->stream.avail_out = packed.size();
+
+    if (deflate(&this->stream, Z_FINISH) != Z_STREAM_END) {
+        return false;
+    }
+
+    packed.resize(this->stream.total_out);
+    return packed.size() < length;
+}
@@ -0,0 +1,39 @@
+/**
+ * Program Name: FTP Server
+ * File Name: Compressor.hpp
+ * Author: Taylor Jones
+ * Last Modified: 10/16/26
+ * Description: Compressor.hpp is the class specification
+ *  file for the Compressor class. This file contains declarations
+ *  for the member functions of the Compressor class.
+ */
+
+
+#ifndef Compressor_hpp
+#define Compressor_hpp
+
+#include <cstddef>
+#include <string>
+#include <zlib.h>
+
+using std::string;
+
+
+class Compressor {
+  // Member Variables
+  private:
+    z_stream stream;
+    bool ready;             // false if zlib couldn't be set up, so nothing is compressed
+
+  // Member Functions
+  public:
+    explicit Compressor(int level);
+    ~Compressor();
+    Compressor(const Compressor &) = delete;
+    Compressor &operator=(const Compressor &) = delete;
+
+    bool compress(const char *data, size_t length, string &packed);
+};
+
+
+#endif /* Compressor_hpp */
@@ -0,0 +1,300 @@
+/**
+ * Program Name: FTP Server
+ * File Name: ContentCache.cpp
+ * Author: Taylor Jones
+ * Last Modified: 10/16/26
+ * Description: ContentCache.cpp is the class implementation
+ *  file for the ContentCache class.
+ *
+ *  The cache keeps the contents of small, popular files in memory, so
+ *  downloading them doesn't touch the file system beyond one stat(), which
+ *  shows whether the file still has the size and modification time it was
+ *  read with. That matters most when the served directory is on a network
+ *  file system, where every read is a round trip to the file server.
+ *
+ *  Files are evicted with S3-FIFO, so one pass over many files (a client
+ *  syncing the whole tree after a -lr, say) can't flush the popular ones.
+ *  A file is admitted into a small queue that holds a tenth of the budget.
+ *  If it is downloaded again before it reaches the end of that queue, it
+ *  moves to the main queue; if not, it is dropped, and only its key is
+ *  remembered, in the ghost queue. A file that is read again while its key
+ *  is remembered goes straight to the main queue. Files at the end of the
+ *  main queue that have been downloaded since they last got there go back
+ *  to the front (once for each download, up to MAX_FREQUENCY), and the
+ *  rest are dropped.
+ */
+
+
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "ContentCache.hpp"
+
+
+/**
+ * Creates a cache.
+ * @param budget - the most bytes to cache, or 0 to cache nothing.
+ */
+ContentCache::ContentCache(size_t budget) {
+    this->budget = budget;
+    this->smallBudget = budget / 10;
+    this->maxFileSize = this->smallBudget < MAX_FILE_SIZE ? this->smallBudget : MAX_FILE_SIZE;
+    this->smallBytes = 0;
+    this->mainBytes = 0;
+    this->stats.hits = 0;
+    this->stats.misses = 0;
+    this->stats.evictions = 0;
+    this->stats.entries = 0;
+    this->stats.bytes = 0;
+}
+
+
+
+/**
+ * Gets the contents of a file, reading (and caching) them if they aren't
+ * cached already (or the file has changed since they were). Empty files,
+ * files that aren't regular files, and large files aren't cached.
+ * @param path - the file, relative to the served directory.
+ * @param info - what stat() just said about the file.
+ * @return shared_ptr<const string> - the file's contents, or null if the file should be sent some other way.
+ */
+shared_ptr<const string> ContentCache::acquire(const string &path, const struct stat &info) {
+    if (this->budget == 0 || !S_ISREG(info.st_mode) || info.st_size == 0 || (size_t) info.st_size > this->maxFileSize) {
+        return nullptr;
+    }
+
+    const FileKey key(info.st_dev, info.st_ino);
+    {
+        std::lock_guard<std::mutex> guard(this->lock);
+        auto found = this->entries.find(key);
+
+        if (found != this->entries.end()) {
+            Entry &entry = found->second;
+            if ((off_t) entry.contents->size() == info.st_size && entry.mtime.tv_sec == info.st_mtim.tv_sec &&
+                entry.mtime.tv_nsec == info.st_mtim.tv_nsec) {
+                if (entry.frequency < MAX_FREQUENCY) {
+                    entry.frequency++;
+                }
+                this->stats.hits++;
+                return entry.contents;
+            }
+
+            // the file has changed since it was read.
+            this->remove(found);
+        }
+
+        this->stats.misses++;
+    }
+
+    // read the file without holding the lock, so other transfers aren't held up by the disk.
+    shared_ptr<const string> contents = readFile(path, info);
+    if (contents) {
+        std::lock_guard<std::mutex> guard(this->lock);
+        this->insert(key, contents, info.st_mtim);
+    }
+
+    return contents;
+}
+
+
+
+/**
+ * Reads a whole file, as long as it is still the file that stat() described.
+ * @param path - the file.
+ * @param info - what stat() said about the file.
+ * @return shared_ptr<const string> - the file's contents, or null if it couldn't be read or has changed.
+ */
+shared_ptr<const string> ContentCache::readFile(const string &path, const struct stat &info) {
+    struct stat opened;
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+
+    if (fd < 0) {
+        return nullptr;
+    }
+
+    shared_ptr<string> contents;
+    if (fstat(fd, &opened) == 0 && opened.st_dev == info.st_dev && opened.st_ino == info.st_ino &&
+        opened.st_size == info.st_size && opened.st_mtim.tv_sec == info.st_mtim.tv_sec &&
+        opened.st_mtim.tv_nsec == info.st_mtim.tv_nsec) {
+        contents = shared_ptr<string>(new string(info.st_size, '\0'));
+
+        size_t done = 0;
+        while (done < contents->size()) {
+            ssize_t count = pread(fd, &(*contents)[done], contents->size() - done, done);
+            if (count < 0 && errno == EINTR) {
+                continue;
+            }
+            if (count <= 0) {
+                contents.reset();
+                break;
+            }
+            done += count;
+        }
+    }
+
+    close(fd);
+    return contents;
+}
+
+
+
+/**
+ * Adds a file that was just read: to the main queue if its key was still
+ * remembered from an earlier eviction, and to the small queue otherwise.
+ * The caller must hold the lock.
+ * @param key - the file's device and inode.
+ * @param contents - the file's contents.
+ * @param mtime - the file's modification time when it was read.
+ */
+void ContentCache::insert(const FileKey &key, shared_ptr<const string> contents, const struct timespec &mtime) {
+    // another worker may have read the same file at the same time.
+    auto found = this->entries.find(key);
+    if (found != this->entries.end()) {
+        this->remove(found);
+    }
+
+    auto ghost = this->ghosts.find(key);
+    const bool returning = ghost != this->ghosts.end();
+    if (returning) {
+        this->ghostQueue.erase(ghost->second);
+        this->ghosts.erase(ghost);
+    }
+
+    Entry entry;
+    entry.contents = contents;
+    entry.mtime = mtime;
+    entry.frequency = 0;
+    entry.inMain = returning;
+    if (returning) {
+        this->mainQueue.push_front(key);
+        entry.position = this->mainQueue.begin();
+        this->mainBytes += contents->size();
+    } else {
+        this->smallQueue.push_front(key);
+        entry.position = this->smallQueue.begin();
+        this->smallBytes += contents->size();
+    }
+    this->entries[key] = entry;
+
+    this->evict();
+}
+
+
+
+/**
+ * Drops a file that has changed since it was read.
+ * The caller must hold the lock.
+ * @param entry - the file's entry.
+ */
+void ContentCache::remove(map<FileKey, Entry>::iterator entry) {
+    if (entry->second.inMain) {
+        this->mainBytes -= entry->second.contents->size();
+        this->mainQueue.erase(entry->second.position);
+    } else {
+        this->smallBytes -= entry->second.contents->size();
+        this->smallQueue.erase(entry->second.position);
+    }
+
+    this->entries.erase(entry);
+}
+
+
+
+/**
+ * Evicts files until the cache is within its budget, from the small queue
+ * while it holds more than its share, and from the main queue otherwise.
+ * The caller must hold the lock.
+ */
+void ContentCache::evict() {
+    while (this->smallBytes + this->mainBytes > this->budget) {
+        if (this->smallBytes > this->smallBudget || this->mainQueue.empty()) {
+            this->evictSmall();
+        } else {
+            this->evictMain();
+        }
+    }
+}
+
+
+
+/**
+ * Takes the oldest file of the small queue, and moves it to the main queue
+ * if it was downloaded again while in the small queue, or drops it otherwise.
+ * The caller must hold the lock.
+ */
+void ContentCache::evictSmall() {
+    const FileKey key = this->smallQueue.back();
+    Entry &entry = this->entries[key];
+    const size_t size = entry.contents->size();
+
+    this->smallQueue.pop_back();
+    this->smallBytes -= size;
+
+    if (entry.frequency > 0) {
+        entry.frequency = 0;
+        entry.inMain = true;
+        this->mainQueue.push_front(key);
+        entry.position = this->mainQueue.begin();
+        this->mainBytes += size;
+    } else {
+        this->entries.erase(key);
+        this->addGhost(key);
+        this->stats.evictions++;
+    }
+}
+
+
+
+/**
+ * Takes the oldest file of the main queue, and gives it another pass through
+ * the queue if it was downloaded since its last one, or drops it otherwise.
+ * The caller must hold the lock.
+ */
+void ContentCache::evictMain() {
+    const FileKey key = this->mainQueue.back();
+    Entry &entry = this->entries[key];
+
+    if (entry.frequency > 0) {
+        entry.frequency--;
+        this->mainQueue.splice(this->mainQueue.begin(), this->mainQueue, entry.position);
+    } else {
+        this->mainBytes -= entry.contents->size();
+        this->mainQueue.pop_back();
+        this->entries.erase(key);
+        this->stats.evictions++;
+    }
+}
+
+
+
+/**
+ * Remembers the key of a file dropped from the small queue, forgetting the
+ * oldest keys once there are more of them than files in the cache.
+ * The caller must hold the lock.
+ * @param key - the file's device and inode.
+ */
+void ContentCache::addGhost(const FileKey &key) {
+    this->ghostQueue.push_front(key);
+    this->ghosts[key] = this->ghostQueue.begin();
+
+    const size_t limit = this->entries.size() > MIN_GHOSTS ? this->entries.size() : MIN_GHOSTS;
+    while (this->ghostQueue.size() > limit) {
+        this->ghosts.erase(this->ghostQueue.back());
+        this->ghostQueue.pop_back();
+    }
+}
+
+
+
+/**
+ * @return ContentCacheStats - the cache's counters, and what it holds now.
+ */
+ContentCacheStats ContentCache::getStats() {
+    std::lock_guard<std::mutex> guard(this->lock);
+    ContentCacheStats stats = this->stats;
+
+    stats.entries = this->entries.size();
+    stats.bytes = this->smallBytes + this->mainBytes;
+    return stats;
+}
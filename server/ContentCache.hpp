@@ -0,0 +1,92 @@
+/**
+ * Program Name: FTP Server
+ * File Name: ContentCache.hpp
+ * Author: Taylor Jones
+ * Last Modified: 10/16/26
+ * Description: ContentCache.hpp is the class specification
+ *  file for the ContentCache class. This file contains declarations
+ *  for the member functions of the ContentCache class.
+ */
+
+
+#ifndef ContentCache_hpp
+#define ContentCache_hpp
+
+#include <cstdint>
+#include <ctime>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <utility>
+
+using std::list;
+using std::map;
+using std::shared_ptr;
+using std::string;
+
+
+/**
+ * How the cache has been doing since the server started.
+ */
+struct ContentCacheStats {
+    uint64_t hits;          // requests answered from the cache
+    uint64_t misses;        // requests for small enough files that had to be read
+    uint64_t evictions;     // files dropped to make room
+    size_t entries;         // the files cached now
+    size_t bytes;           // the bytes cached now
+};
+
+
+class ContentCache {
+  // Member Variables
+  private:
+    typedef std::pair<dev_t, ino_t> FileKey;
+
+    struct Entry {
+        shared_ptr<const string> contents;
+        struct timespec mtime;          // the file's modification time when it was read
+        int frequency;                  // the hits since it was last moved, up to MAX_FREQUENCY
+        bool inMain;                    // true once it has moved from the small queue to the main one
+        list<FileKey>::iterator position;
+    };
+
+    static const int MAX_FREQUENCY = 3;
+    static const size_t MAX_FILE_SIZE = 1024 * 1024;   // larger files are never cached
+    static const size_t MIN_GHOSTS = 64;
+
+    std::mutex lock;                    // guards everything below; workers share the cache
+    size_t budget;                      // the most bytes to cache, or 0 to cache nothing
+    size_t smallBudget;                 // the part of the budget that new files are admitted into
+    size_t maxFileSize;
+    size_t smallBytes;
+    size_t mainBytes;
+    list<FileKey> smallQueue;           // files seen once lately, newest first
+    list<FileKey> mainQueue;            // files that have proved popular, newest first
+    list<FileKey> ghostQueue;           // files recently dropped from the small queue, newest first
+    map<FileKey, list<FileKey>::iterator> ghosts;
+    map<FileKey, Entry> entries;
+    ContentCacheStats stats;
+
+  // Member Functions
+  private:
+    void insert(const FileKey &key, shared_ptr<const string> contents, const struct timespec &mtime);
+    void remove(map<FileKey, Entry>::iterator entry);
+    void evict();
+    void evictSmall();
+    void evictMain();
+    void addGhost(const FileKey &key);
+    static shared_ptr<const string> readFile(const string &path, const struct stat &info);
+
+  public:
+    explicit ContentCache(size_t budget);
+
+    shared_ptr<const string> acquire(const string &path, const struct stat &info);
+    ContentCacheStats getStats();
+};
+
+
+#endif /* ContentCache_hpp */
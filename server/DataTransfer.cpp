@@ -0,0 +1,924 @@
+/**
+ * Program Name: FTP Server
+ * File Name: DataTransfer.cpp
+ * Author: Taylor Jones
+ * Last Modified: 10/16/26
+ * Description: DataTransfer.cpp is the class implementation
+ *  file for the DataTransfer class.
+ *
+ *  A DataTransfer sends one response over a client's data connection.
+ *  It runs on a ThreadPool worker rather than on the event loop, so it
+ *  uses plain blocking writes (bounded by the socket's send timeout).
+ *  It never prints anything: the Session reports the outcome from the
+ *  event loop's thread, which keeps the console output in order.
+ */
+
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+#include "Util.hpp"
+#include "DeltaEncoder.hpp"
+#include "DirectoryWalker.hpp"
+#include "ThreadPool.hpp"
+#include "Xxh64.hpp"
+#include "DataTransfer.hpp"
+
+using std::to_string;
+using std::vector;
+
+
+/**
+ * Creates an offered file that has not been opened yet.
+ * @param offset - the first byte the client asked for.
+ * @param length - the number of bytes the client asked for, or -1 for the rest of the file.
+ */
+OfferedFile::OfferedFile(off_t offset, off_t length) {
+    this->fd = -1;
+    this->sidecarFd = -1;
+    this->sidecarSize = 0;
+    this->offset = offset;
+    this->size = length;
+    this->toEnd = (length < 0);
+}
+
+
+
+/**
+ * Closes the file (and its precompressed copy), if it was opened.
+ */
+OfferedFile::~OfferedFile() {
+    if (this->fd >= 0) {
+        close(this->fd);
+    }
+    if (this->sidecarFd >= 0) {
+        close(this->sidecarFd);
+    }
+}
+
+
+
+/**
+ * @return int - the descriptor to read the file from: its own, or its mapping's (or -1 if its contents are cached).
+ */
+int OfferedFile::getFd() const {
+    return this->mapped ? this->mapped->fd : this->fd;
+}
+
+
+
+/**
+ * @return const char * - the file's cached contents or mapping, or null if it has neither.
+ */
+const char *OfferedFile::getData() const {
+    if (this->contents) {
+        return this->contents->data();
+    }
+    return this->mapped ? this->mapped->data : nullptr;
+}
+
+
+
+/**
+ * Splits an offered file into chunks for a striped download.
+ * @param size - the number of bytes offered.
+ * @param chunkSize - the size of every chunk but the last.
+ */
+StripePlan::StripePlan(off_t size, off_t chunkSize) : nextChunk(0) {
+    this->chunkSize = chunkSize;
+    this->chunkCount = (size + chunkSize - 1) / chunkSize;
+}
+
+
+
+/**
+ * Creates a transfer over a data connection.
+ * @param sock - a connected, blocking data socket.
+ * @param framing - the framing version the client negotiated, or 0 for text.
+ */
+DataTransfer::DataTransfer(int sock, int framing) {
+    this->sock = sock;
+    this->framing = framing;
+    this->failed = false;
+    this->ring = nullptr;
+    this->ringTimeout = 0;
+    this->compressionLevel = 0;
+    this->meter = nullptr;
+    this->listChunkSize = LIST_CHUNK_SIZE;
+    this->listFlushSize = LIST_FLUSH_SIZE;
+    this->listUnsent = 0;
+    this->listUnsentBytes = 0;
+    this->listBytes = 0;
+    this->listKeepLimit = 0;
+}
+
+
+
+/**
+ * Sets how a directory listing is batched into buffers and writes.
+ * @param chunkSize - the size each listing buffer (and LIST frame) is filled to.
+ * @param flushSize - how much of the listing to collect before each write.
+ */
+void DataTransfer::setListBatching(size_t chunkSize, size_t flushSize) {
+    this->listChunkSize = chunkSize;
+    this->listFlushSize = flushSize;
+}
+
+
+
+/**
+ * Has everything the transfer writes counted.
+ * @param meter - the counts to add to, or null to count nothing.
+ */
+void DataTransfer::setMeter(TransferMeter *meter) {
+    this->meter = meter;
+}
+
+
+
+/**
+ * Adds bytes that were just written to the meter, noting the time of the
+ * response's first byte.
+ * @param bytes - the number of bytes written.
+ */
+void DataTransfer::countSent(uint64_t bytes) {
+    if (this->meter == nullptr || bytes == 0) {
+        return;
+    }
+
+    if (this->meter->bytes.fetch_add(bytes, std::memory_order_relaxed) == 0) {
+        int64_t none = 0;
+        const int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+        this->meter->firstByte.compare_exchange_strong(none, now, std::memory_order_relaxed);
+    }
+}
+
+
+
+/**
+ * Has files sent through an io_uring ring instead of with sendfile().
+ * @param ring - the calling worker's ring, or null to keep using sendfile().
+ * @param timeoutSeconds - how long each send may wait on the client (the ring ignores the socket's timeout).
+ */
+void DataTransfer::setIoRing(IoRing *ring, int timeoutSeconds) {
+    this->ring = ring;
+    this->ringTimeout = timeoutSeconds;
+}
+
+
+
+/**
+ * Has the payloads of DATA and LIST frames compressed, each one on its own.
+ * @param level - the zlib compression level the client asked for, or 0 to send them as they are.
+ */
+void DataTransfer::setCompression(int level) {
+    this->compressionLevel = level;
+    this->compressor.reset(level > 0 ? new Compressor(level) : nullptr);
+}
+
+
+
+/**
+ * Queues a single protocol line, writing the queued output
+ * once there is enough of it.
+ * @param line - the line to send.
+ */
+void DataTransfer::sendLine(const string &line) {
+    this->batch.append(line);
+    this->batch.push_back('\n');
+
+    if (this->batch.size() >= BATCH_SIZE) {
+        this->flush();
+    }
+}
+
+
+
+/**
+ * Queues a complete frame, writing the queued output
+ * once there is enough of it.
+ * @param type - the frame type.
+ * @param payload - the frame payload.
+ */
+void DataTransfer::sendFrame(FrameType type, const string &payload) {
+    this->batch.append(encodeFrameHeader(type, payload.size()));
+    this->batch.append(payload);
+
+    if (this->batch.size() >= BATCH_SIZE) {
+        this->flush();
+    }
+}
+
+
+
+/**
+ * Writes everything that has been queued.
+ * @param more - true if more data will be written right away, so the
+ *  kernel can hold the queued bytes back and send them with it.
+ * @return bool - false if this or any earlier write failed.
+ */
+bool DataTransfer::flush(bool more) {
+    if (!this->failed && !this->batch.empty()) {
+        this->failed = !sendAll(this->sock, this->batch.data(), this->batch.size(), more ? MSG_MORE : 0);
+        if (!this->failed) {
+            this->countSent(this->batch.size());
+        }
+    }
+
+    this->batch.clear();
+    return !this->failed;
+}
+
+
+
+/**
+ * Writes everything that has been queued, then a range of a file. A file
+ * whose contents are cached, and a small range of a mapped file, are sent
+ * from memory, with the queued output in the same write; a larger range of a mapped file is cheaper to send with sendfile(), which
+ * doesn't copy it. Otherwise, with a ring, the queued output goes in the
+ * same submission as the file's reads and sends; without one, it is written
+ * first, and the file is sent with sendfile().
+ * @param file - the file.
+ * @param offset - the first byte to send.
+ * @param length - the number of bytes to send.
+ * @return bool - false if this or any earlier write failed.
+ */
+bool DataTransfer::sendRange(const OfferedFile &file, off_t offset, off_t length) {
+    if (this->failed) {
+        return false;
+    }
+
+    if (file.contents || (file.mapped && length <= MAX_MAPPED_SEND)) {
+        vector<struct iovec> parts;
+        struct iovec part;
+        if (!this->batch.empty()) {
+            part.iov_base = (void *) this->batch.data();
+            part.iov_len = this->batch.size();
+            parts.push_back(part);
+        }
+        part.iov_base = (void *) (file.getData() + offset);
+        part.iov_len = length;
+        parts.push_back(part);
+
+        this->failed = !sendAllv(this->sock, parts);
+    } else if (this->ring != nullptr) {
+        this->failed = !this->ring->sendFile(this->sock, file.getFd(), offset, length, this->batch, this->ringTimeout);
+    } else {
+        if (!this->flush(true) || !sendFileRange(this->sock, file.getFd(), offset, length)) {
+            return false;
+        }
+        this->countSent(length);
+        return true;
+    }
+
+    if (!this->failed) {
+        this->countSent(this->batch.size() + length);
+    }
+    this->batch.clear();
+    return !this->failed;
+}
+
+
+
+/**
+ * Sends a listing of the current files in the directory,
+ * followed by the end of the response. A listing that is in the
+ * cache is sent as is; otherwise it is built and then cached.
+ *
+ * A listing is built in large buffers (each a whole LIST frame, when
+ * framed) that are written several at a time with one vectored write,
+ * so even a listing of many thousands of entries takes only a few writes.
+ * The entries are streamed from a DirectoryWalker as the buffers are
+ * written, so the first of them go out right away. Once the listing has
+ * grown too large to cache, written buffers are reused instead of kept,
+ * so the memory a listing takes doesn't grow with the directory tree.
+ * @param cache - the rendered listings to reuse, or null.
+ */
+TransferResult DataTransfer::sendDirectoryList(bool showHidden, bool showSize, bool showRecursive, ListingCache *cache) {
+    const string key = ListingCache::keyFor(showHidden, showSize, showRecursive, this->framing, this->compressionLevel);
+    uint64_t fillEpoch = 0;
+
+    if (cache != nullptr) {
+        shared_ptr<const ListingBody> body = cache->find(key, fillEpoch);
+        if (body) {
+            return this->sendBuffers(*body, 0, 0) ? TRANSFER_OK : TRANSFER_FAILED;
+        }
+    }
+
+    DirectoryWalker walker(".", showRecursive, showHidden, showSize, ThreadPool::current());
+    string item;
+
+    // add each of the directory items as it is read, writing them as the buffers fill up.
+    this->startList(cache != nullptr ? cache->getMaxEntrySize() : 0);
+    while (walker.next(item)) {
+        if (this->failed) {
+            return TRANSFER_FAILED;
+        }
+        this->addListEntry(item);
+    }
+
+    if (!this->finishList()) {
+        return TRANSFER_FAILED;
+    }
+
+    if (cache != nullptr && this->listBytes <= this->listKeepLimit) {
+        cache->insert(key, fillEpoch, std::make_shared<const ListingBody>(std::move(this->listChunks)), showRecursive, showSize);
+    }
+    return TRANSFER_OK;
+}
+
+
+
+/**
+ * Sends the XXH64 hash of a file or, for -hr, of every file in the
+ * directory tree, followed by the end of the response. Each hash is sent
+ * as an entry of a listing: a line in text mode, or an entry of a LIST
+ * frame when framed, that reads "<hash> <size> <path>". If a single file
+ * can't be hashed, the client is told so (as for -g) instead.
+ * @param filename - the file to hash, or an empty string to hash the whole tree.
+ * @param index - the hashes that are already known, and where new ones go.
+ */
+TransferResult DataTransfer::sendHashes(const string &filename, HashIndex &index) {
+    uint64_t hash;
+    off_t size;
+
+    if (!filename.empty()) {
+        if (!index.hashFile(AT_FDCWD, filename.c_str(), hash, size)) {
+            return this->refuseFile("Response: Error - \"" + filename + "\" not found", TRANSFER_NOT_FOUND);
+        }
+
+        this->startList(0);
+        this->addListEntry(Xxh64::toHex(hash) + " " + to_string(size) + " " + filename);
+        return this->finishList() ? TRANSFER_OK : TRANSFER_FAILED;
+    }
+
+    // add each file's hash as soon as it is known, writing them as the buffers fill up.
+    this->startList(0);
+    index.hashTree(".", [this](const string &path, uint64_t hash, off_t size) {
+        this->addListEntry(Xxh64::toHex(hash) + " " + to_string(size) + " " + path);
+        return !this->failed;
+    });
+
+    return this->finishList() ? TRANSFER_OK : TRANSFER_FAILED;
+}
+
+
+
+/**
+ * Starts a listing with an empty buffer.
+ * @param keepLimit - how large the listing can grow with its written buffers still kept (for the cache).
+ */
+void DataTransfer::startList(size_t keepLimit) {
+    this->listKeepLimit = keepLimit;
+    this->listChunk.clear();
+    this->listChunk.resize(this->framing ? FRAME_HEADER_SIZE : 0);
+}
+
+
+
+/**
+ * Ends a listing with the end of the response, and writes whatever of it
+ * hasn't been written yet.
+ * @return bool - false if this or any earlier write failed.
+ */
+bool DataTransfer::finishList() {
+    this->closeListChunk();
+    this->listChunks.push_back(this->endMessage());
+    this->listUnsentBytes += this->listChunks.back().size();
+
+    return this->flushList(false);
+}
+
+
+
+/**
+ * Adds one directory entry to the listing: a line in text mode or, when
+ * framed, a length-prefixed entry of the LIST frame being filled.
+ * @param entry - the directory entry.
+ */
+void DataTransfer::addListEntry(const string &entry) {
+    if (this->framing) {
+        appendUint32(this->listChunk, entry.size());
+        this->listChunk.append(entry);
+    } else {
+        this->listChunk.append(entry);
+        this->listChunk.push_back('\n');
+    }
+
+    if (this->listChunk.size() >= this->listChunkSize) {
+        this->closeListChunk();
+
+        if (this->listUnsentBytes >= this->listFlushSize) {
+            this->flushList(true);
+        }
+    }
+}
+
+
+
+/**
+ * Closes the listing buffer being filled (filling in its LIST frame header,
+ * when framed, and compressing its entries if that makes them smaller) and
+ * starts a new one, unless the buffer has no entries yet.
+ */
+void DataTransfer::closeListChunk() {
+    const size_t start = this->framing ? FRAME_HEADER_SIZE : 0;
+    if (this->listChunk.size() == start) {
+        return;
+    }
+
+    if (this->framing) {
+        uint16_t flags = 0;
+        if (this->compressor && this->compressor->compress(this->listChunk.data() + start, this->listChunk.size() - start, this->packed)) {
+            this->listChunk.replace(start, string::npos, this->packed);
+            flags = FRAME_COMPRESSED;
+        }
+        this->listChunk.replace(0, FRAME_HEADER_SIZE, encodeFrameHeader(FRAME_LIST, this->listChunk.size() - start, flags));
+    }
+
+    this->listUnsentBytes += this->listChunk.size();
+    this->listBytes += this->listChunk.size();
+    this->listChunks.push_back(string());
+    this->listChunks.back().swap(this->listChunk);
+
+    if (!this->spareChunks.empty()) {
+        this->listChunk.swap(this->spareChunks.back());
+        this->spareChunks.pop_back();
+    } else {
+        this->listChunk.reserve(this->listChunkSize + 256);
+    }
+    this->listChunk.assign(start, '\0');
+}
+
+
+
+/**
+ * Writes every closed listing buffer that hasn't been written yet. The
+ * written buffers are kept for the cache, or, once the listing is too
+ * large to cache, set aside to be filled again.
+ * @param more - true if more of the listing will follow, so the kernel
+ *  can hold back a partly filled packet until it does.
+ * @return bool - false if this or any earlier write failed.
+ */
+bool DataTransfer::flushList(bool more) {
+    if (!this->failed && this->listUnsent < this->listChunks.size()) {
+        this->failed = !this->sendBuffers(this->listChunks, this->listUnsent, more ? MSG_MORE : 0);
+    }
+
+    if (this->listBytes > this->listKeepLimit) {
+        for (auto &chunk : this->listChunks) {
+            if (this->spareChunks.size() * this->listChunkSize < this->listFlushSize) {
+                this->spareChunks.push_back(string());
+                this->spareChunks.back().swap(chunk);
+            }
+        }
+        this->listChunks.clear();
+    }
+
+    this->listUnsent = this->listChunks.size();
+    this->listUnsentBytes = 0;
+    return !this->failed;
+}
+
+
+
+/**
+ * Sends a range of a file as DATA frames of compressed blocks. A block that
+ * doesn't shrink is sent as it is, and once several blocks in a row barely
+ * shrink, the file is taken to be incompressible (already compressed, say),
+ * and the caller sends the rest of it as it is, without spending any more
+ * time on it.
+ * @param file - the file.
+ * @param offset - the first byte to send.
+ * @param end - the byte after the last one to send.
+ * @return off_t - where the caller should carry on sending from (end, if everything was sent), or -1 if a write or read failed.
+ */
+off_t DataTransfer::sendCompressed(const OfferedFile &file, off_t offset, off_t end) {
+    int incompressible = 0;
+
+    while (offset < end && incompressible < MAX_INCOMPRESSIBLE_BLOCKS) {
+        const off_t length = std::min(end - offset, COMPRESS_BLOCK_SIZE);
+        const char *block;
+
+        // the compressor only reads private copies: a shared mapping would fault
+        // (SIGBUS) if the file were truncated while a block was being compressed.
+        if (file.contents) {
+            block = file.contents->data() + offset;
+        } else {
+            this->unpacked.resize(length);
+            if (!readFileRange(file.getFd(), &this->unpacked[0], offset, length)) {
+                return -1;
+            }
+            block = this->unpacked.data();
+        }
+
+        const bool shrunk = this->compressor->compress(block, length, this->packed);
+        if (shrunk) {
+            this->batch.append(encodeFrameHeader(FRAME_DATA, this->packed.size(), FRAME_COMPRESSED));
+            this->batch.append(this->packed);
+        } else {
+            this->batch.append(encodeFrameHeader(FRAME_DATA, length));
+            this->batch.append(block, length);
+        }
+
+        // a block that saves less than an eighth isn't worth the time it took.
+        const bool worthwhile = shrunk && this->packed.size() <= (size_t) (length - length / 8);
+        incompressible = worthwhile ? 0 : incompressible + 1;
+        offset += length;
+
+        if (this->batch.size() >= BATCH_SIZE && !this->flush(true)) {
+            return -1;
+        }
+    }
+
+    return offset;
+}
+
+
+
+/**
+ * Sends a range of a file as DATA frames of up to MAX_DATA_FRAME bytes
+ * each, or as compressed DATA frames when compressing (as long as it compresses).
+ * @param file - the file.
+ * @param offset - the first byte to send.
+ * @param end - the byte after the last one to send.
+ * @return bool - false if a write or read failed.
+ */
+bool DataTransfer::sendDataFrames(const OfferedFile &file, off_t offset, off_t end) {
+    if (this->compressor && (offset = this->sendCompressed(file, offset, end)) < 0) {
+        return false;
+    }
+
+    for (; offset < end; offset += MAX_DATA_FRAME) {
+        off_t length = std::min(end - offset, MAX_DATA_FRAME);
+        this->batch.append(encodeFrameHeader(FRAME_DATA, length));
+
+        if (!this->sendRange(file, offset, length)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+
+/**
+ * Looks for a precompressed copy of a file (the file's name with
+ * SIDECAR_SUFFIX added), which is sent in place of the whole file when the
+ * client asked for compression, if it is at least as new as the file.
+ * @param filename - the requested file.
+ * @param file - the offered file, which holds the copy if there is a fresh one.
+ */
+void DataTransfer::offerSidecar(const string &filename, OfferedFile &file) {
+    struct stat source, sidecar;
+    if (stat(filename.c_str(), &source) != 0 || source.st_size != file.size) {
+        return;
+    }
+
+    int fd = open((filename + SIDECAR_SUFFIX).c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return;
+    }
+
+    if (fstat(fd, &sidecar) == 0 && S_ISREG(sidecar.st_mode) && sidecar.st_size > 0 && sidecar.st_size < source.st_size &&
+        (sidecar.st_mtim.tv_sec > source.st_mtim.tv_sec ||
+         (sidecar.st_mtim.tv_sec == source.st_mtim.tv_sec && sidecar.st_mtim.tv_nsec >= source.st_mtim.tv_nsec))) {
+        file.sidecarFd = fd;
+        file.sidecarSize = sidecar.st_size;
+    } else {
+        close(fd);
+    }
+}
+
+
+
+/**
+ * Writes a list of buffers with as few vectored writes as possible.
+ * @param buffers - the buffers to write.
+ * @param first - the first buffer to write; the rest follow it.
+ * @param flags - any extra send flags, such as MSG_MORE.
+ * @return bool - false if the write failed.
+ */
+bool DataTransfer::sendBuffers(const ListingBody &buffers, size_t first, int flags) {
+    vector<struct iovec> parts;
+    uint64_t total = 0;
+    parts.reserve(buffers.size() - first);
+
+    for (size_t i = first; i < buffers.size(); i++) {
+        if (!buffers[i].empty()) {
+            struct iovec part;
+            part.iov_base = (void *) buffers[i].data();
+            part.iov_len = buffers[i].size();
+            parts.push_back(part);
+            total += part.iov_len;
+        }
+    }
+
+    if (!sendAllv(this->sock, parts, flags)) {
+        return false;
+    }
+    this->countSent(total);
+    return true;
+}
+
+
+
+/**
+ * Opens the requested file and tells the client whether it can be sent.
+ * In binary mode, the GOOD message also carries the number of bytes that
+ * will be sent (as does the GOOD frame, when framed): the whole file, or
+ * just the requested range of it. If the file can't be sent, the error
+ * message and the end of the response are sent as well.
+ * @param filename - the requested file.
+ * @param file - the requested range, which holds the opened file until it is sent.
+ * @param binaryMode - true if the client asked for the binary transfer mode.
+ * @param cache - the mappings of popular files to send from, or null to always open the file.
+ * @param contents - the contents of small popular files to send, or null to always read the file.
+ */
+TransferResult DataTransfer::offerFile(const string &filename, OfferedFile &file, bool binaryMode, MappedFileCache *cache,
+    ContentCache *contents) {
+    off_t fileSize = -1;
+    struct stat info;
+
+    // one stat() tells both caches whether what they hold is still the file at this path.
+    if ((cache != nullptr || contents != nullptr) && stat(filename.c_str(), &info) == 0) {
+        if (contents != nullptr) {
+            file.contents = contents->acquire(filename, info);
+        }
+        if (!file.contents && cache != nullptr) {
+            file.mapped = cache->acquire(filename, info);
+        }
+    }
+
+    if (file.contents) {
+        fileSize = file.contents->size();
+    } else if (file.mapped) {
+        fileSize = file.mapped->size;
+    } else {
+        file.fd = open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+        if (file.fd >= 0 && fstat(file.fd, &info) == 0 && S_ISREG(info.st_mode)) {
+            fileSize = info.st_size;
+        }
+    }
+
+    if (fileSize >= 0) {
+        if (file.offset > fileSize) {
+            return this->refuseFile("Response: Error - offset " + to_string(file.offset) + " is past the end of \"" +
+                filename + "\" (" + to_string(fileSize) + " bytes)", TRANSFER_BAD_RANGE);
+        }
+
+        off_t remaining = fileSize - file.offset;
+        file.size = file.toEnd ? remaining : std::min(file.size, remaining);
+
+        if (this->compressor && file.offset == 0 && file.toEnd) {
+            this->offerSidecar(filename, file);
+        }
+
+        if (this->framing) {
+            string size;
+            appendUint64(size, file.size);
+            this->sendFrame(FRAME_GOOD, size);
+        } else {
+            this->sendLine(binaryMode ? GOOD_MSG + " " + to_string(file.size) : GOOD_MSG);
+        }
+        return this->flush() ? TRANSFER_OK : TRANSFER_FAILED;
+    }
+
+    // the file couldn't be accessed, so send an error message.
+    return this->refuseFile("Response: Error - \"" + filename + "\" not found", TRANSFER_NOT_FOUND);
+}
+
+
+
+/**
+ * Tells the client that the requested file can't be sent, and ends the response.
+ * @param message - the reason the file can't be sent.
+ * @param reason - the result to report if the client was told.
+ * @return TransferResult - the reason, or TRANSFER_FAILED if the client couldn't be told.
+ */
+TransferResult DataTransfer::refuseFile(const string &message, TransferResult reason) {
+    if (this->framing) {
+        this->sendFrame(FRAME_BAD, message);
+    } else {
+        this->sendLine(BAD_MSG);
+        this->sendLine(message);
+    }
+
+    return this->sendEnd() == TRANSFER_OK ? reason : TRANSFER_FAILED;
+}
+
+
+
+/**
+ * Sends the contents of an offered file (or the offered part of it)
+ * straight from the kernel (or from its cached contents or mapping, or
+ * through the worker's io_uring ring), starting at the offered offset.
+ *
+ * When framed, the announced bytes are sent as DATA frames of up to
+ * MAX_DATA_FRAME bytes each, followed by an END frame. When compressing,
+ * the file is sent as compressed DATA frames instead (as long as it
+ * compresses), or, if it has a fresh precompressed copy, as a single
+ * compressed DATA frame that holds the copy.
+ *
+ * In binary mode, exactly the announced number of bytes is sent, and
+ * nothing else: the client already knows where the file ends.
+ *
+ * In text mode, the output matches what the line-by-line transfer has
+ * always produced: the file as it is now (unless a length was given), with
+ * a newline added if the last line doesn't have one, followed by the DONE message.
+ * @param file - a file opened by offerFile().
+ * @param binaryMode - true if the client asked for the binary transfer mode.
+ */
+TransferResult DataTransfer::sendFile(OfferedFile &file, bool binaryMode) {
+    if (this->framing) {
+        const off_t end = file.offset + file.size;
+        const off_t offset = file.offset;
+
+        if (file.sidecarFd >= 0) {
+            this->batch.append(encodeFrameHeader(FRAME_DATA, file.sidecarSize, FRAME_COMPRESSED));
+            if (!this->flush(true) || !sendFileRange(this->sock, file.sidecarFd, 0, file.sidecarSize)) {
+                return TRANSFER_FAILED;
+            }
+            this->countSent(file.sidecarSize);
+            return this->sendEnd();
+        }
+
+        if (!this->sendDataFrames(file, offset, end)) {
+            return TRANSFER_FAILED;
+        }
+
+        return this->sendEnd();
+    }
+
+    // cached contents and mappings are sent as they were cached, which was checked to be the file as it is now when it was offered.
+    if (!binaryMode && file.toEnd && file.getData() == nullptr) {
+        struct stat info;
+        if (fstat(file.fd, &info) == 0 && info.st_size >= file.offset) {
+            file.size = info.st_size - file.offset;
+        }
+    }
+
+    if (!this->sendRange(file, file.offset, file.size)) {
+        return TRANSFER_FAILED;
+    }
+
+    if (binaryMode) {
+        return TRANSFER_OK;
+    }
+
+    char last = '\n';
+    if (file.size > 0 && file.contents) {
+        last = (*file.contents)[file.offset + file.size - 1];
+    } else if (file.size > 0 && pread(file.getFd(), &last, 1, file.offset + file.size - 1) != 1) {
+        last = '\n';
+    }
+    if (last != '\n') {
+        this->sendLine("");
+    }
+
+    return this->sendEnd();
+}
+
+
+
+/**
+ * Sends chunks of a striped file until none are left, each as a CHUNK frame
+ * that carries the chunk's index and file offset, followed by an END frame.
+ * Every stream of the download runs this at the same time on its own worker.
+ * @param file - a file opened by offerFile().
+ * @param plan - the chunks shared by every stream of the download.
+ */
+TransferResult DataTransfer::sendChunks(OfferedFile &file, StripePlan &plan) {
+    for (uint64_t index = plan.nextChunk++; index < plan.chunkCount; index = plan.nextChunk++) {
+        off_t offset = file.offset + index * plan.chunkSize;
+        off_t length = std::min(plan.chunkSize, file.offset + file.size - offset);
+
+        this->batch.append(encodeFrameHeader(FRAME_CHUNK, CHUNK_HEADER_SIZE + length));
+        appendUint64(this->batch, index);
+        appendUint64(this->batch, offset);
+
+        if (!this->sendRange(file, offset, length)) {
+            return TRANSFER_FAILED;
+        }
+    }
+
+    return this->sendEnd();
+}
+
+
+
+/**
+ * Sends a file as the changes from the client's old copy of it (see
+ * DeltaEncoder.cpp): the client's SIGNATURES frame is read from the data
+ * connection, and the file is sent back as DATA frames of the bytes the
+ * client doesn't have and COPY frames of the blocks it does, followed by
+ * an END frame. Literal runs are compressed when the client asked for
+ * compression; short ones are collected with the COPY frames around them,
+ * so a file with many small changes still takes few writes.
+ * @param file - a whole file opened by offerFile().
+ * @return TransferResult - TRANSFER_FAILED if the signatures were malformed or the connection failed.
+ */
+TransferResult DataTransfer::sendDelta(OfferedFile &file) {
+    string signatures;
+    DeltaEncoder encoder;
+
+    if (!this->receiveSignatures(signatures) || !encoder.parseSignatures(signatures)) {
+        return TRANSFER_FAILED;
+    }
+    signatures.clear();
+    signatures.shrink_to_fit();
+
+    // the encoder and the short literals read the file into memory of their own (from its
+    // cached contents, or with pread()), never from a shared mapping, which would fault
+    // (SIGBUS) if the file were truncated during the scan. Only the kernel reads the mapping.
+    auto read = [&file](char *buffer, size_t offset, size_t length) {
+        if (file.contents) {
+            memcpy(buffer, file.contents->data() + file.offset + offset, length);
+            return true;
+        }
+        return readFileRange(file.getFd(), buffer, file.offset + offset, length);
+    };
+
+    const bool sent = file.size == 0 || encoder.encode(read, file.size,
+        [this, &file, &read](size_t offset, size_t end) {
+            const off_t length = end - offset;
+
+            if (!this->compressor && length <= MAX_MAPPED_SEND) {
+                this->batch.append(encodeFrameHeader(FRAME_DATA, length));
+                const size_t at = this->batch.size();
+                this->batch.resize(at + length);
+                if (!read(&this->batch[at], offset, length)) {
+                    return false;
+                }
+                return this->batch.size() < BATCH_SIZE || this->flush(true);
+            }
+            return this->sendDataFrames(file, file.offset + offset, file.offset + end);
+        },
+        [this](uint64_t first, uint64_t count) {
+            this->batch.append(encodeFrameHeader(FRAME_COPY, 16));
+            appendUint64(this->batch, first);
+            appendUint64(this->batch, count);
+            return this->batch.size() < BATCH_SIZE || this->flush(true);
+        });
+
+    return sent ? this->sendEnd() : TRANSFER_FAILED;
+}
+
+
+
+/**
+ * Reads the SIGNATURES frame that a delta client sends once it has replied
+ * to the GOOD frame. The data connection's receive timeout bounds the wait.
+ * @param payload - holds the frame's payload.
+ * @return bool - false if the frame didn't arrive, or isn't a SIGNATURES frame of an acceptable size.
+ */
+bool DataTransfer::receiveSignatures(string &payload) {
+    char header[FRAME_HEADER_SIZE];
+    FrameType type;
+    uint64_t length;
+
+    if (!recvAll(this->sock, header, FRAME_HEADER_SIZE) || !decodeFrameHeader(header, type, length) ||
+        type != FRAME_SIGNATURES || length > MAX_SIGNATURES_FRAME) {
+        return false;
+    }
+
+    payload.resize(length);
+    return length == 0 || recvAll(this->sock, &payload[0], length);
+}
+
+
+
+/**
+ * Builds the end of the response: the DONE message in text mode, or an END frame.
+ * @return string - the bytes that end the response.
+ */
+string DataTransfer::endMessage() const {
+    return this->framing ? encodeFrameHeader(FRAME_END, 0) : DONE_MSG + "\n";
+}
+
+
+
+/**
+ * Queues the end of the response.
+ */
+void DataTransfer::queueEnd() {
+    this->batch.append(this->endMessage());
+}
+
+
+
+/**
+ * Ends the response. This is all that is sent when the client cancels a file.
+ */
+TransferResult DataTransfer::sendEnd() {
+    this->queueEnd();
+    return this->flush() ? TRANSFER_OK : TRANSFER_FAILED;
+}
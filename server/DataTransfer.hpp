@@ -0,0 +1,171 @@
+/**
+ * Program Name: FTP Server
+ * File Name: DataTransfer.hpp
+ * Author: Taylor Jones
+ * Last Modified: 10/16/26
+ * Description: DataTransfer.hpp is the class specification
+ *  file for the DataTransfer class. This file contains declarations
+ *  for the member functions of the DataTransfer class.
+ */
+
+
+#ifndef DataTransfer_hpp
+#define DataTransfer_hpp
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <sys/types.h>
+
+#include "Compressor.hpp"
+#include "ContentCache.hpp"
+#include "Framing.hpp"
+#include "HashIndex.hpp"
+#include "IoRing.hpp"
+#include "ListingCache.hpp"
+#include "MappedFileCache.hpp"
+
+using std::string;
+
+
+/**
+ * What a response has written to its data connections so far. A striped
+ * download's workers share one.
+ */
+struct TransferMeter {
+    std::atomic<uint64_t> bytes;        // every byte written, protocol messages and frame headers included
+    std::atomic<int64_t> firstByte;     // when the first byte was written (steady clock, in ns), or 0
+
+    TransferMeter() : bytes(0), firstByte(0) {}
+};
+
+
+/**
+ * The outcome of a data transfer job.
+ */
+enum TransferResult {
+    TRANSFER_OK,            // everything was sent
+    TRANSFER_NOT_FOUND,     // the requested file could not be accessed (and the client was told so)
+    TRANSFER_BAD_RANGE,     // the requested byte range starts past the end of the file (and the client was told so)
+    TRANSFER_FAILED         // the data connection failed part-way
+};
+
+
+/**
+ * A file (or the part of a file) that has been offered to a client.
+ * It stays open between the offer and the transfer, so the file that
+ * was announced is the file that gets sent.
+ */
+struct OfferedFile {
+    int fd;             // the open file, or -1
+    shared_ptr<const MappedFile> mapped;    // the file's cached mapping, sent from instead of fd, or null
+    shared_ptr<const string> contents;      // the file's cached contents, sent instead of fd or the mapping, or null
+    int sidecarFd;      // the file's fresh precompressed copy, sent in place of the file when compressing, or -1
+    off_t sidecarSize;
+    off_t offset;       // the first byte to send
+    off_t size;         // the number of bytes announced to the client
+    bool toEnd;         // true if the client asked for everything from the offset on
+
+    OfferedFile(off_t offset = 0, off_t length = -1);
+    ~OfferedFile();
+
+    int getFd() const;
+    const char *getData() const;
+};
+
+
+/**
+ * How a striped download is split up. The file is cut into chunks of a
+ * fixed size, and the worker for each stream takes the next unsent chunk
+ * whenever it is ready for one, so faster streams end up sending more.
+ */
+struct StripePlan {
+    off_t chunkSize;
+    uint64_t chunkCount;
+    std::atomic<uint64_t> nextChunk;    // the next chunk that no stream has taken
+
+    StripePlan(off_t size, off_t chunkSize);
+};
+
+
+class DataTransfer {
+  // Member Variables
+  private:
+    const string DONE_MSG = "\\done";
+    const string GOOD_MSG = "\\good";
+    const string BAD_MSG = "\\bad";
+
+    const size_t BATCH_SIZE = 64 * 1024;            // how much output to collect before each write
+    const size_t LIST_CHUNK_SIZE = 64 * 1024;       // the default listing buffer (and LIST frame) size
+    const size_t LIST_FLUSH_SIZE = 1024 * 1024;     // the default amount of listing to collect before each write
+    const off_t MAX_DATA_FRAME = 1 << 30;           // the largest file payload sent in one frame
+    const off_t MAX_MAPPED_SEND = 64 * 1024;        // larger ranges of a mapped file are still sent with sendfile()
+    const off_t COMPRESS_BLOCK_SIZE = 256 * 1024;   // the file bytes compressed into each DATA frame
+    const int MAX_INCOMPRESSIBLE_BLOCKS = 4;        // the rest of a file is sent as it is after this many blocks in a row barely shrink
+    const string SIDECAR_SUFFIX = ".gz";            // added to a file's name to find its precompressed copy
+    const uint64_t MAX_SIGNATURES_FRAME = 64 * 1024 * 1024;    // the largest SIGNATURES frame a delta client may send
+
+    int sock;                               // the (blocking) data connection
+    int framing;                            // the framing version in use, or 0 for newline/\done text
+    string batch;                           // output waiting to be written
+    bool failed;                            // true once a write has failed
+    IoRing *ring;                           // the ring files are sent with, or null to send them with sendfile()
+    int ringTimeout;                        // how long (in seconds) a send through the ring may wait on the client
+    int compressionLevel;                   // the zlib level frame payloads are compressed with, or 0 for none
+    std::unique_ptr<Compressor> compressor; // set up with the level, or null when not compressing
+    string packed;                          // the latest compressed payload
+    string unpacked;                        // the latest block read from a file whose contents aren't cached
+    TransferMeter *meter;                   // counts what is written, or null
+
+    size_t listChunkSize;                   // listing buffers are closed once they reach this size
+    size_t listFlushSize;                   // closed listing buffers are written once they add up to this size
+    string listChunk;                       // the listing buffer being filled (framed: after room for its header)
+    ListingBody listChunks;                 // the closed listing buffers that are still needed
+    ListingBody spareChunks;                // written listing buffers, ready to be filled again
+    size_t listUnsent;                      // the first closed buffer that hasn't been written
+    size_t listUnsentBytes;                 // the size of the closed buffers that haven't been written
+    size_t listBytes;                       // the size of every listing buffer closed so far
+    size_t listKeepLimit;                   // the written buffers are kept for the cache while listBytes is within this
+
+  // Member Functions
+  private:
+    void sendLine(const string &line);
+    void sendFrame(FrameType type, const string &payload);
+    void startList(size_t keepLimit);
+    bool finishList();
+    void addListEntry(const string &entry);
+    void closeListChunk();
+    bool flushList(bool more);
+    bool sendBuffers(const ListingBody &buffers, size_t first, int flags);
+    bool flush(bool more = false);
+    bool sendRange(const OfferedFile &file, off_t offset, off_t length);
+    off_t sendCompressed(const OfferedFile &file, off_t offset, off_t end);
+    bool sendDataFrames(const OfferedFile &file, off_t offset, off_t end);
+    bool receiveSignatures(string &payload);
+    void offerSidecar(const string &filename, OfferedFile &file);
+    TransferResult refuseFile(const string &message, TransferResult reason);
+    string endMessage() const;
+    void queueEnd();
+    void countSent(uint64_t bytes);
+
+  public:
+    explicit DataTransfer(int sock, int framing = 0);
+
+    void setListBatching(size_t chunkSize, size_t flushSize);
+    void setIoRing(IoRing *ring, int timeoutSeconds);
+    void setCompression(int level);
+    void setMeter(TransferMeter *meter);
+
+    TransferResult sendDirectoryList(bool showHidden, bool showSize, bool showRecursive, ListingCache *cache = nullptr);
+    TransferResult sendHashes(const string &filename, HashIndex &index);
+    TransferResult offerFile(const string &filename, OfferedFile &file, bool binaryMode, MappedFileCache *cache = nullptr,
+        ContentCache *contents = nullptr);
+    TransferResult sendFile(OfferedFile &file, bool binaryMode);
+    TransferResult sendChunks(OfferedFile &file, StripePlan &plan);
+    TransferResult sendDelta(OfferedFile &file);
+    TransferResult sendEnd();
+};
+
+
+#endif /* DataTransfer_hpp */
@@ -0,0 +1,309 @@
+/**
+ * Program Name: FTP Server
+ * File Name: DeltaEncoder.cpp
+ * Author: Taylor Jones
+ * Last Modified: 10/16/26
+ * Description: DeltaEncoder.cpp is the class implementation
+ *  file for the DeltaEncoder class.
+ *
+ *  A delta download (the delta=1 request option) sends a file as the
+ *  changes from an older copy that the client already has, the way rsync
+ *  does. The client cuts its copy into blocks and sends the signature of
+ *  each one: a weak checksum that can be rolled along a byte at a time,
+ *  and an XXH64 hash. The encoder moves a block-sized window along the
+ *  server's file a byte at a time. Wherever the window's weak checksum
+ *  (and then its hash) matches one of the client's blocks, it reports a
+ *  copy of that block and jumps past it; the bytes in between are reported
+ *  as literals. Copies of consecutive blocks are merged into one, so an
+ *  unchanged stretch of the file costs a single reference however long it is.
+ *
+ *  The file is read into a window of the encoder's own (4 MiB at a time),
+ *  rather than scanned where it lies, so a file that is truncated during the
+ *  scan fails the read instead of faulting on a mapping.
+ *
+ *  Most windows match nothing, so the scan's cost is in ruling them out:
+ *  rolling the checksum is two additions, and a 64 Kbit filter of the
+ *  client's checksums answers most windows without a map lookup. Only the
+ *  last block of the client's copy can be shorter than the block size, and
+ *  it is never matched; the end of the file is sent as literals instead.
+ *
+ *  The signatures come from the client, so they can be chosen to make the
+ *  scan slow: thousands of blocks with one weak checksum (each window that
+ *  has it would be compared with all of them), or a weak checksum that every
+ *  window of a repetitive file has but no hash that matches (each window
+ *  would be hashed in full and then rejected). So only a few blocks are kept
+ *  per weak checksum, and the hashing of windows that turn out to match
+ *  nothing is limited to a few times the file's size; past that, the rest
+ *  of the file is sent as literals, which is still a correct delta.
+ */
+
+
+#include <algorithm>
+#include <cstring>
+
+#include "Framing.hpp"
+#include "Xxh64.hpp"
+#include "DeltaEncoder.hpp"
+
+
+/**
+ * Computes the checksum of a block from scratch.
+ * @param data - the block.
+ * @param length - the block's length.
+ */
+void RollingChecksum::reset(const unsigned char *data, uint32_t length) {
+    this->a = 0;
+    this->b = 0;
+    this->length = length;
+
+    for (uint32_t i = 0; i < length; i++) {
+        this->a += data[i];
+        this->b += (length - i) * data[i];
+    }
+}
+
+
+
+/**
+ * Moves the block along by one byte.
+ * @param out - the byte leaving the block (its first byte).
+ * @param in - the byte joining the block (the byte after its last).
+ */
+void RollingChecksum::roll(unsigned char out, unsigned char in) {
+    this->a += in - out;
+    this->b += this->a - this->length * out;
+}
+
+
+
+/**
+ * @return uint32_t - the checksum: b in the high 16 bits, and a in the low ones.
+ */
+uint32_t RollingChecksum::value() const {
+    return (this->a & 0xffff) | (this->b << 16);
+}
+
+
+
+/**
+ * @return size_t - the filter bit for a weak checksum.
+ */
+static inline size_t filterIndex(uint32_t weak) {
+    return (weak ^ (weak >> 16)) & 0xffff;
+}
+
+
+
+/**
+ * Creates an encoder with no blocks.
+ */
+DeltaEncoder::DeltaEncoder() : weakFilter(FILTER_SIZE, false) {
+    this->blockSize = MIN_BLOCK_SIZE;
+}
+
+
+
+/**
+ * Reads the signatures of the client's copy: the 4-byte block size,
+ * followed by each block's 4-byte weak checksum and 8-byte XXH64 hash.
+ * @param payload - the SIGNATURES frame's payload.
+ * @return bool - false if the signatures are malformed.
+ */
+bool DeltaEncoder::parseSignatures(const string &payload) {
+    if (payload.size() < 4 || (payload.size() - 4) % BLOCK_SIGNATURE_SIZE != 0) {
+        return false;
+    }
+
+    this->blockSize = readUint32(payload.data());
+    if (this->blockSize < MIN_BLOCK_SIZE || this->blockSize > MAX_BLOCK_SIZE) {
+        return false;
+    }
+
+    const size_t count = (payload.size() - 4) / BLOCK_SIGNATURE_SIZE;
+    this->strongHashes.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        const char *signature = payload.data() + 4 + i * BLOCK_SIGNATURE_SIZE;
+        const uint32_t weak = readUint32(signature);
+
+        this->strongHashes[i] = readUint64(signature + 4);
+        vector<uint32_t> &blocks = this->blocksByWeak[weak];
+        if (blocks.size() < MAX_BLOCKS_PER_WEAK) {
+            blocks.push_back(i);
+        }
+        this->weakFilter[filterIndex(weak)] = true;
+    }
+
+    return true;
+}
+
+
+
+/**
+ * Finds a block of the client's copy that a window of the file matches.
+ * @param weak - the window's weak checksum.
+ * @param window - the window.
+ * @param preferred - the block to take if it matches, since it continues the current run of copies.
+ * @param block - holds the matching block.
+ * @param budget - the bytes that may still be hashed for windows that match nothing; once
+ *  it runs out, no more windows are hashed.
+ * @return bool - true if a block matches.
+ */
+bool DeltaEncoder::findBlock(uint32_t weak, const char *window, uint64_t preferred, uint64_t &block,
+                             uint64_t &budget) const {
+    if (!this->weakFilter[filterIndex(weak)] || budget < this->blockSize) {
+        return false;
+    }
+
+    auto found = this->blocksByWeak.find(weak);
+    if (found == this->blocksByWeak.end()) {
+        return false;
+    }
+
+    // the preferred block is checked first, so a run of identical blocks (more of them than
+    // are kept per weak checksum) is still copied as one run.
+    const uint64_t strong = Xxh64::hash(window, this->blockSize);
+    if (preferred < this->strongHashes.size() && this->strongHashes[preferred] == strong) {
+        block = preferred;
+        return true;
+    }
+
+    for (uint32_t candidate : found->second) {
+        if (this->strongHashes[candidate] == strong) {
+            block = candidate;
+            return true;
+        }
+    }
+
+    budget -= this->blockSize;
+    return false;
+}
+
+
+
+/**
+ * Works out the changes from the client's copy to a file, and reports
+ * them in order as literal ranges of the file and copies of runs of the
+ * client's blocks. The file is read a window at a time, into memory of
+ * the encoder's own, so the scan never touches the file's pages directly.
+ * @param read - called to copy a range of the file into the window; returns false if it can't.
+ * @param size - the file's size.
+ * @param literal - called with a range of the file to send as it is; returns false to stop.
+ * @param copy - called with the first block and the number of blocks of a run to copy; returns false to stop.
+ * @return bool - false if a read failed or a callback stopped the encoding.
+ */
+bool DeltaEncoder::encode(const function<bool(char *buffer, size_t offset, size_t length)> &read, size_t size,
+                          const function<bool(size_t offset, size_t end)> &literal,
+                          const function<bool(uint64_t first, uint64_t count)> &copy) const {
+    const size_t blockSize = this->blockSize;
+    size_t position = 0;
+    size_t literalStart = 0;
+    uint64_t runFirst = 0;
+    uint64_t runCount = 0;
+    uint64_t budget = FALSE_MATCH_BUDGET * size;
+    RollingChecksum checksum;
+
+    // the window holds the file from windowStart to windowEnd: at least the block at
+    // the position and the byte after it (that the checksum rolls in), while there is one.
+    vector<char> window;
+    size_t windowStart = 0;
+    size_t windowEnd = 0;
+
+    auto fillWindow = [&]() {
+        if (windowEnd >= std::min(position + blockSize + 1, size)) {
+            return true;
+        }
+
+        const size_t kept = windowEnd - position;
+        memmove(window.data(), window.data() + (position - windowStart), kept);
+        windowStart = position;
+
+        const size_t length = std::min(window.size() - kept, size - (windowStart + kept));
+        if (!read(window.data() + kept, windowStart + kept, length)) {
+            return false;
+        }
+        windowEnd = windowStart + kept + length;
+        return true;
+    };
+
+    if (!this->strongHashes.empty() && size >= blockSize) {
+        window.resize(2 * blockSize > WINDOW_SIZE ? 2 * blockSize : WINDOW_SIZE);
+        if (!fillWindow()) {
+            return false;
+        }
+        checksum.reset((const unsigned char *) window.data(), blockSize);
+
+        while (position + blockSize <= size) {
+            if (!fillWindow()) {
+                return false;
+            }
+            const unsigned char *here = (const unsigned char *) window.data() + (position - windowStart);
+
+            uint64_t block;
+            if (this->findBlock(checksum.value(), (const char *) here, runFirst + runCount, block, budget)) {
+                // the run of copies so far came before the literals, which come before this copy.
+                if (position > literalStart) {
+                    if ((runCount > 0 && !copy(runFirst, runCount)) || !literal(literalStart, position)) {
+                        return false;
+                    }
+                    runCount = 0;
+                }
+
+                if (runCount > 0 && block == runFirst + runCount) {
+                    runCount++;
+                } else {
+                    if (runCount > 0 && !copy(runFirst, runCount)) {
+                        return false;
+                    }
+                    runFirst = block;
+                    runCount = 1;
+                }
+
+                position += blockSize;
+                literalStart = position;
+                if (position + blockSize <= size) {
+                    if (!fillWindow()) {
+                        return false;
+                    }
+                    checksum.reset((const unsigned char *) window.data() + (position - windowStart), blockSize);
+                }
+                continue;
+            }
+
+            if (position + blockSize < size) {
+                checksum.roll(here[0], here[blockSize]);
+            }
+            position++;
+        }
+    }
+
+    if (runCount > 0 && !copy(runFirst, runCount)) {
+        return false;
+    }
+    return size == literalStart || literal(literalStart, size);
+}
+
+
+
+/**
+ * Builds the signatures of a file's blocks, as a client sends them.
+ * @param data - the file's contents.
+ * @param size - the file's size.
+ * @param blockSize - the block size.
+ * @return string - the SIGNATURES frame's payload.
+ */
+string DeltaEncoder::buildSignatures(const char *data, size_t size, uint32_t blockSize) {
+    string payload;
+    payload.reserve(4 + (size / blockSize + 1) * BLOCK_SIGNATURE_SIZE);
+    appendUint32(payload, blockSize);
+
+    for (size_t offset = 0; offset < size; offset += blockSize) {
+        const uint32_t length = size - offset < blockSize ? size - offset : blockSize;
+        RollingChecksum checksum;
+
+        checksum.reset((const unsigned char *) data + offset, length);
+        appendUint32(payload, checksum.value());
+        appendUint64(payload, Xxh64::hash(data + offset, length));
+    }
+
+    return payload;
+}
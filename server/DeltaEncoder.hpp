@@ -0,0 +1,78 @@
+/**
+ * Program Name: FTP Server
+ * File Name: DeltaEncoder.hpp
+ * Author: Taylor Jones
+ * Last Modified: 10/16/26
+ * Description: DeltaEncoder.hpp is the class specification
+ *  file for the DeltaEncoder class (and the RollingChecksum it scans
+ *  with). This file contains declarations for their member functions.
+ */
+
+
+#ifndef DeltaEncoder_hpp
+#define DeltaEncoder_hpp
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using std::function;
+using std::string;
+using std::unordered_map;
+using std::vector;
+
+
+/**
+ * The weak checksum of a block (rsync's), which can be moved along by one
+ * byte in constant time: a is the sum of the bytes, and b the sum of the
+ * running values of a, both modulo 2^16.
+ */
+struct RollingChecksum {
+    uint32_t a;
+    uint32_t b;
+    uint32_t length;
+
+    void reset(const unsigned char *data, uint32_t length);
+    void roll(unsigned char out, unsigned char in);
+    uint32_t value() const;
+};
+
+
+class DeltaEncoder {
+  // Member Variables
+  public:
+    static const uint32_t MIN_BLOCK_SIZE = 64;
+    static const uint32_t MAX_BLOCK_SIZE = 1 << 20;
+    static const size_t BLOCK_SIGNATURE_SIZE = 12;  // a block's 4-byte weak checksum and 8-byte XXH64 hash
+
+  private:
+    static const size_t FILTER_SIZE = 1 << 16;      // one bit per value of a weak checksum's halves, mixed
+    static const size_t MAX_BLOCKS_PER_WEAK = 32;   // blocks kept per weak checksum; the client chooses the checksums
+    static const uint64_t FALSE_MATCH_BUDGET = 4;   // hashing of windows that match nothing, in multiples of the file size
+    static const size_t WINDOW_SIZE = 4 * 1024 * 1024;  // how much of the file is read in for the scan at a time
+
+    uint32_t blockSize;
+    vector<uint64_t> strongHashes;                  // each block's XXH64 hash, by block index
+    unordered_map<uint32_t, vector<uint32_t>> blocksByWeak;
+    vector<bool> weakFilter;                        // rules out most positions without a map lookup
+
+  // Member Functions
+  private:
+    bool findBlock(uint32_t weak, const char *window, uint64_t preferred, uint64_t &block, uint64_t &budget) const;
+
+  public:
+    DeltaEncoder();
+
+    bool parseSignatures(const string &payload);
+    bool encode(const function<bool(char *buffer, size_t offset, size_t length)> &read, size_t size,
+                const function<bool(size_t offset, size_t end)> &literal,
+                const function<bool(uint64_t first, uint64_t count)> &copy) const;
+
+    static string buildSignatures(const char *data, size_t size, uint32_t blockSize);
+};
+
+
+#endif /* DeltaEncoder_hpp */
@@ -0,0 +1,336 @@
+/**
+ * Program Name: FTP Server
+ * File Name: DirectoryWalker.cpp
+ * Author: Taylor Jones
+ * Last Modified: 10/16/26
+ * Description: DirectoryWalker.cpp is the class implementation
+ *  file for the DirectoryWalker class.
+ *
+ *  The walker produces a directory listing (or, for -lr, a listing of the
+ *  whole tree) one item at a time, so the listing can be sent while it is
+ *  still being read. Each directory is opened with openat() relative to its
+ *  parent's descriptor (so no full paths are built and no path length limit
+ *  applies) and read with large getdents64() calls, one buffer at a time.
+ *
+ *  The thread asking for items reads whatever it needs next itself. Helper
+ *  tasks on the caller's ThreadPool read ahead, taking the directory that
+ *  will be listed soonest, but stop once READ_AHEAD_LIMIT bytes are waiting
+ *  to be listed. Helpers that can't make progress end instead of waiting,
+ *  so they never hold a worker that another client's transfer could use;
+ *  the walker starts new ones as the listing catches up. When the client
+ *  reads slowly, the writes block, items stop being taken, and the helpers
+ *  stop, so memory stays bounded however large the tree is: the read-ahead
+ *  limit, plus one buffer's worth of items for each directory being listed.
+ *  Nothing recurses, so deep trees can't overflow the stack.
+ */
+
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <iterator>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "Util.hpp"
+#include "DirectoryWalker.hpp"
+#include "FileMetadata.hpp"
+
+
+/**
+ * The record that getdents64() fills its buffer with.
+ */
+struct LinuxDirent64 {
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[1];     // really as long as the record: the name is null-terminated
+};
+
+
+/**
+ * Closes the directory.
+ */
+DirectoryWalker::DirHandle::~DirHandle() {
+    if (this->fd >= 0) {
+        close(this->fd);
+    }
+}
+
+
+
+/**
+ * Creates a walker, ready to produce the first item.
+ * @param path - the directory to list.
+ * @param recursive - true to list every directory below it as well.
+ * @param withHidden - true to include entries whose names start with ".".
+ * @param withSize - true to show each entry's size.
+ * @param pool - the pool to borrow helper threads from, or null to walk on the calling thread alone.
+ */
+DirectoryWalker::DirectoryWalker(const string &path, bool recursive, bool withHidden, bool withSize, ThreadPool *pool) {
+    this->pool = pool;
+    this->maxHelpers = pool != nullptr ? pool->size() - 1 : 0;
+    this->walk = shared_ptr<Walk>(new Walk());
+    this->walk->recursive = recursive;
+    this->walk->withHidden = withHidden;
+    this->walk->withSize = withSize;
+    this->walk->pool = pool;
+
+    shared_ptr<Node> root(new Node());
+    root->path = path;
+    root->name = path;
+    this->stack.push_back(root);
+}
+
+
+
+/**
+ * Tells any helpers still running that the walk is over.
+ */
+DirectoryWalker::~DirectoryWalker() {
+    std::lock_guard<std::mutex> guard(this->walk->lock);
+    this->walk->finished = true;
+}
+
+
+
+/**
+ * Produces the next item of the listing: each directory's entries in the
+ * order the file system returns them, with every subdirectory's entries
+ * right after the subdirectory itself.
+ * @param item - holds the item.
+ * @return bool - false once every item has been produced.
+ */
+bool DirectoryWalker::next(string &item) {
+    Walk &walk = *this->walk;
+    std::unique_lock<std::mutex> guard(walk.lock);
+
+    while (!this->stack.empty()) {
+        Node &node = *this->stack.back();
+
+        if (node.nextItem < node.items.size()) {
+            Item &next = node.items[node.nextItem++];
+            walk.buffered -= next.line.size();
+            item.swap(next.line);
+
+            if (next.child) {
+                this->stack.push_back(std::move(next.child));
+            }
+            if (this->maxHelpers > 0) {
+                this->startHelpers(guard);
+            }
+            return true;
+        }
+
+        if (node.done) {
+            this->stack.pop_back();
+        } else if (!node.busy) {
+            // nothing has been read ahead: read the next buffer here.
+            node.busy = true;
+            readBuffer(walk, node, guard);
+            node.busy = false;
+            if (!node.done) {
+                enqueue(walk, this->stack.back());
+            }
+        } else {
+            walk.changed.wait(guard);
+        }
+    }
+
+    walk.finished = true;
+    return false;
+}
+
+
+
+/**
+ * Starts helpers to read ahead, if there is room to read ahead into,
+ * something to read, and the pool has workers to spare.
+ * @param guard - holds the walk's lock.
+ */
+void DirectoryWalker::startHelpers(std::unique_lock<std::mutex> &guard) {
+    Walk &walk = *this->walk;
+    size_t starting = 0;
+
+    while (walk.helpers < this->maxHelpers && walk.queue.size() > starting && walk.buffered < READ_AHEAD_LIMIT / 2) {
+        walk.helpers++;
+        starting++;
+    }
+
+    if (starting > 0) {
+        shared_ptr<Walk> shared = this->walk;
+        guard.unlock();
+        for (size_t i = 0; i < starting; i++) {
+            this->pool->submit([shared]() { help(shared); });
+        }
+        guard.lock();
+    }
+}
+
+
+
+/**
+ * Reads ahead, always in the directory that will be listed soonest,
+ * until the read-ahead limit is reached or nothing is left to read.
+ * @param walk - the walk to help with.
+ */
+void DirectoryWalker::help(shared_ptr<Walk> walk) {
+    std::unique_lock<std::mutex> guard(walk->lock);
+
+    while (!walk->finished && walk->buffered < READ_AHEAD_LIMIT && !walk->queue.empty()) {
+        shared_ptr<Node> node = walk->queue.top();
+        walk->queue.pop();
+        node->queued = false;
+
+        if (node->busy || node->done) {
+            continue;
+        }
+
+        node->busy = true;
+        do {
+            readBuffer(*walk, *node, guard);
+        } while (!node->done && !walk->finished && walk->buffered < READ_AHEAD_LIMIT);
+        node->busy = false;
+
+        if (!node->done) {
+            enqueue(*walk, node);
+        }
+        walk->changed.notify_all();
+    }
+
+    walk->helpers--;
+}
+
+
+
+/**
+ * Puts a directory that still has more to read in the queue, unless it is
+ * already there. What's left of a directory that has been read in part is
+ * listed after every subdirectory found so far, so it is queued behind them.
+ * @param walk - the walk the directory belongs to.
+ * @param node - the directory.
+ */
+void DirectoryWalker::enqueue(Walk &walk, const shared_ptr<Node> &node) {
+    if (!node->queued) {
+        node->queued = true;
+        node->queueOrder = node->order;
+        if (node->dir) {
+            node->queueOrder.push_back(node->childCount);
+        }
+        walk.queue.push(node);
+    }
+}
+
+
+
+/**
+ * Reads the next buffer of a directory (opening it first, if needed), adds
+ * its entries to the directory's items, and queues every subdirectory found.
+ * The lock is released while the directory is read.
+ * @param walk - the walk the directory belongs to.
+ * @param node - the directory, which the calling thread has marked busy.
+ * @param guard - holds the walk's lock.
+ */
+void DirectoryWalker::readBuffer(Walk &walk, Node &node, std::unique_lock<std::mutex> &guard) {
+    static thread_local vector<char> buffer(DENTS_BUFFER_SIZE);
+    static thread_local MetadataBatch batch;
+    static thread_local vector<const char *> names;
+    const int flags = O_RDONLY | O_DIRECTORY | O_CLOEXEC | O_NOFOLLOW;
+    vector<Item> items;
+    size_t bytes = 0;
+    long length = 0;
+
+    guard.unlock();
+
+    if (!node.dir) {
+        int fd = openat(node.parent ? node.parent->fd : AT_FDCWD, node.name.c_str(), flags);
+        if (fd < 0 && (errno == EMFILE || errno == ENFILE)) {
+            // too many parents are being held open: fall back to the full path.
+            fd = openat(AT_FDCWD, node.path.c_str(), flags);
+        }
+        if (fd >= 0) {
+            node.dir = shared_ptr<DirHandle>(new DirHandle(fd));
+        }
+        node.parent.reset();
+    }
+
+    if (node.dir) {
+        length = syscall(SYS_getdents64, node.dir->fd, buffer.data(), buffer.size());
+    }
+
+    // gather the entries to list, then look up what their directory entries don't say.
+    batch.clear();
+    names.clear();
+    for (long offset = 0; offset < length; ) {
+        const LinuxDirent64 *entry = (const LinuxDirent64 *) (buffer.data() + offset);
+        offset += entry->d_reclen;
+
+        const char *name = entry->d_name;
+        const bool dots = strcmp(name, ".") == 0 || strcmp(name, "..") == 0;
+        if ((walk.recursive && dots) || (!walk.withHidden && name[0] == '.')) {
+            continue;
+        }
+
+        batch.add(name, entry->d_type);
+        names.push_back(name);
+    }
+    if (node.dir) {
+        // a directory that couldn't be opened has no entries, and is marked done below.
+        batch.fetch(node.dir->fd, walk.withSize ? META_TYPE | META_SIZE : META_TYPE, walk.pool);
+    }
+
+    items.reserve(names.size());
+    for (size_t i = 0; i < names.size(); i++) {
+        const char *name = names[i];
+        const EntryMetadata &metadata = batch.at(i);
+
+        Item item;
+        if (walk.recursive) {
+            item.line = node.path + "/" + coloredListEntry(name, metadata.type);
+        } else {
+            item.line = coloredListEntry(name, metadata.type);
+        }
+        if (walk.withSize) {
+            item.line.append(item.line.size() < SIZE_COLUMN ? SIZE_COLUMN - item.line.size() : 1, ' ');
+            item.line.append(std::to_string(metadata.size));
+        }
+
+        if (walk.recursive && metadata.type == DT_DIR) {
+            item.child = shared_ptr<Node>(new Node());
+            item.child->path = node.path + "/" + name;
+            item.child->order = node.order;
+            item.child->order.push_back(node.childCount++);
+            item.child->parent = node.dir;
+            item.child->name = name;
+        }
+
+        bytes += item.line.size();
+        items.push_back(std::move(item));
+    }
+
+    guard.lock();
+
+    for (auto &item : items) {
+        if (item.child) {
+            enqueue(walk, item.child);
+        }
+    }
+
+    // drop the items that have been listed, and add the new ones.
+    if (node.nextItem == node.items.size()) {
+        node.items.swap(items);
+    } else {
+        node.items.erase(node.items.begin(), node.items.begin() + node.nextItem);
+        std::move(items.begin(), items.end(), std::back_inserter(node.items));
+    }
+    node.nextItem = 0;
+    walk.buffered += bytes;
+
+    if (length <= 0) {
+        node.done = true;
+        node.dir.reset();
+    }
+}
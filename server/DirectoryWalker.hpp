@@ -0,0 +1,125 @@
+/**
+ * Program Name: FTP Server
+ * File Name: DirectoryWalker.hpp
+ * Author: Taylor Jones
+ * Last Modified: 10/16/26
+ * Description: DirectoryWalker.hpp is the class specification
+ *  file for the DirectoryWalker class. This file contains declarations
+ *  for the member functions of the DirectoryWalker class.
+ */
+
+
+#ifndef DirectoryWalker_hpp
+#define DirectoryWalker_hpp
+
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <vector>
+
+#include "ThreadPool.hpp"
+
+using std::shared_ptr;
+using std::string;
+using std::vector;
+
+
+class DirectoryWalker {
+  // Member Variables
+  private:
+    /**
+     * An open directory, kept open until every subdirectory has been opened from it.
+     */
+    struct DirHandle {
+        int fd;
+        explicit DirHandle(int fd) : fd(fd) {}
+        ~DirHandle();
+    };
+
+    struct Node;
+
+    /**
+     * One line of the listing, and (for a subdirectory) the
+     * directory whose listing follows it.
+     */
+    struct Item {
+        string line;
+        shared_ptr<Node> child;
+    };
+
+    /**
+     * A directory of the listing. It is read one getdents64() buffer at a
+     * time, by one thread at a time, and its items wait here until they are
+     * listed. Each subdirectory's own items are listed right after the
+     * subdirectory's item, which keeps the output in the same (pre-)order
+     * no matter which thread read which directory.
+     */
+    struct Node {
+        string path;                        // the directory, as shown in the listing
+        vector<uint32_t> order;             // the directory's position in the listing
+        vector<uint32_t> queueOrder;        // the position of what's left to read, from when it was queued
+        shared_ptr<DirHandle> parent;       // the parent directory, until this one is opened
+        string name;                        // the directory's name within the parent
+        shared_ptr<DirHandle> dir;          // this directory, until it is read to the end
+        uint32_t childCount = 0;            // the subdirectories found so far
+        vector<Item> items;                 // items read, from nextItem on not yet listed
+        size_t nextItem = 0;
+        bool busy = false;                  // true while a thread is reading the directory
+        bool queued = false;                // true while the directory waits in the queue
+        bool done = false;                  // true once the directory has been read to the end
+    };
+
+    /**
+     * Orders the queue so that the directory listed soonest comes first.
+     */
+    struct ListedLater {
+        bool operator()(const shared_ptr<Node> &a, const shared_ptr<Node> &b) const {
+            return a->queueOrder > b->queueOrder;
+        }
+    };
+
+    /**
+     * Everything the walker shares with its helpers. Helpers keep it
+     * alive, since a helper may still be reading after the walker is gone.
+     */
+    struct Walk {
+        bool recursive;
+        bool withHidden;
+        bool withSize;
+        ThreadPool *pool;                   // the pool helpers (and metadata lookups) are shared with, or null
+        std::mutex lock;                    // guards everything below, and every node's items and flags
+        std::condition_variable changed;    // signalled whenever a helper finishes reading a buffer
+        std::priority_queue<shared_ptr<Node>, vector<shared_ptr<Node>>, ListedLater> queue;
+        size_t buffered = 0;                // the bytes of items read but not yet listed
+        size_t helpers = 0;                 // the helpers running
+        bool finished = false;              // true once the walker is done with the walk
+    };
+
+    static const size_t DENTS_BUFFER_SIZE = 256 * 1024;     // how much of a directory each getdents64() reads
+    static const size_t READ_AHEAD_LIMIT = 4 * 1024 * 1024; // the most that helpers read ahead of the listing
+    static const size_t SIZE_COLUMN = 40;                   // where sizes start, when they are shown
+
+    ThreadPool *pool;
+    size_t maxHelpers;
+    shared_ptr<Walk> walk;
+    vector<shared_ptr<Node>> stack;     // the directories being listed, innermost last
+
+  // Member Functions
+  private:
+    static void help(shared_ptr<Walk> walk);
+    static void readBuffer(Walk &walk, Node &node, std::unique_lock<std::mutex> &guard);
+    static void enqueue(Walk &walk, const shared_ptr<Node> &node);
+    void startHelpers(std::unique_lock<std::mutex> &guard);
+
+  public:
+    DirectoryWalker(const string &path, bool recursive, bool withHidden, bool withSize, ThreadPool *pool);
+    ~DirectoryWalker();
+
+    bool next(string &item);
+};
+
+
+#endif /* DirectoryWalker_hpp */
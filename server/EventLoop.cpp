@@ -0,0 +1,252 @@
+/**
+ * Program Name: FTP Server
+ * File Name: EventLoop.cpp
+ * Author: Taylor Jones
+ * Last Modified: 10/16/26
+ * Description: EventLoop.cpp is the class implementation
+ *  file for the EventLoop class. The loop is level-triggered: a handler
+ *  only needs to keep its registered events in sync with what it is
+ *  currently waiting for, and it will be called again for as long as
+ *  that condition holds.
+ */
+
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include "EventLoop.hpp"
+
+
+/**
+ * Creates the epoll instance and the eventfd used to wake it. The server
+ * cannot run without them, so a failure here exits the program.
+ */
+EventLoop::EventLoop() {
+    this->running = false;
+    this->epollFd = epoll_create1(EPOLL_CLOEXEC);
+
+    if (this->epollFd < 0) {
+        perror("Event loop creation failed: epoll_create1()");
+        exit(1);
+    }
+
+    this->wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (this->wakeFd < 0) {
+        perror("Event loop creation failed: eventfd()");
+        exit(1);
+    }
+
+    struct epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.fd = this->wakeFd;
+    epoll_ctl(this->epollFd, EPOLL_CTL_ADD, this->wakeFd, &ev);
+}
+
+
+
+/**
+ * Closes the epoll instance and deletes any handlers still waiting to be retired.
+ */
+EventLoop::~EventLoop() {
+    this->deleteRetired();
+    close(this->wakeFd);
+    close(this->epollFd);
+}
+
+
+
+/**
+ * Starts watching a file descriptor on behalf of a handler.
+ * @param fd - the file descriptor to watch.
+ * @param events - the epoll events to wait for (0 to register without waiting yet).
+ * @param handler - the handler that will receive the events.
+ */
+void EventLoop::watch(int fd, uint32_t events, EventHandler *handler) {
+    Watch watch;
+    watch.handler = handler;
+    watch.events = 0;
+
+    this->watches[fd] = watch;
+    this->applyEvents(fd, this->watches[fd], events);
+}
+
+
+
+/**
+ * Changes the events that a watched file descriptor is waiting for.
+ * Setting the events to 0 removes the descriptor from epoll entirely
+ * (so a hung-up socket can't keep waking the loop), but the handler
+ * stays registered and can start waiting again later.
+ * @param fd - a file descriptor previously passed to watch().
+ * @param events - the epoll events to wait for.
+ */
+void EventLoop::update(int fd, uint32_t events) {
+    auto found = this->watches.find(fd);
+    if (found != this->watches.end()) {
+        this->applyEvents(fd, found->second, events);
+    }
+}
+
+
+
+/**
+ * Stops watching a file descriptor. This must be called before the descriptor is closed.
+ * @param fd - a file descriptor previously passed to watch().
+ */
+void EventLoop::unwatch(int fd) {
+    auto found = this->watches.find(fd);
+    if (found != this->watches.end()) {
+        this->applyEvents(fd, found->second, 0);
+        this->watches.erase(found);
+    }
+}
+
+
+
+/**
+ * Schedules a handler for deletion once the current batch of events
+ * has been dispatched. The handler must have unwatched all of its descriptors.
+ * @param handler - the handler to delete.
+ */
+void EventLoop::retire(EventHandler *handler) {
+    this->retired.push_back(handler);
+}
+
+
+
+/**
+ * Queues a callback to run on the loop's thread. This is the only
+ * member function that may be called from another thread.
+ * @param callback - the callback to run.
+ */
+void EventLoop::post(function<void()> callback) {
+    {
+        std::lock_guard<std::mutex> guard(this->postedLock);
+        this->posted.push_back(std::move(callback));
+    }
+
+    uint64_t one = 1;
+    if (write(this->wakeFd, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+        perror("Waking the event loop failed: write()");
+    }
+}
+
+
+
+/**
+ * Waits for events and dispatches them to their handlers until stop() is called.
+ */
+void EventLoop::run() {
+    const int MAX_EVENTS = 256;
+    struct epoll_event events[MAX_EVENTS];
+    this->running = true;
+
+    while (this->running) {
+        int count = epoll_wait(this->epollFd, events, MAX_EVENTS, -1);
+
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            perror("Waiting for events failed: epoll_wait()");
+            exit(1);
+        }
+
+        for (int i = 0; i < count; i++) {
+            if (events[i].data.fd == this->wakeFd) {
+                this->runPosted();
+                continue;
+            }
+
+            // the descriptor may have been unwatched by an earlier handler in this batch.
+            auto found = this->watches.find(events[i].data.fd);
+            if (found != this->watches.end()) {
+                found->second.handler->handleEvent(events[i].data.fd, events[i].events);
+            }
+        }
+
+        this->deleteRetired();
+    }
+}
+
+
+
+/**
+ * Makes run() return after the current batch of events.
+ */
+void EventLoop::stop() {
+    this->running = false;
+}
+
+
+
+/**
+ * Brings the epoll registration for a descriptor in line with the requested events.
+ * @param fd - the file descriptor.
+ * @param watch - the bookkeeping entry for the descriptor.
+ * @param events - the epoll events to wait for.
+ */
+void EventLoop::applyEvents(int fd, Watch &watch, uint32_t events) {
+    if (watch.events == events) {
+        return;
+    }
+
+    struct epoll_event ev;
+    ev.events = events;
+    ev.data.fd = fd;
+
+    int result;
+    if (events == 0) {
+        result = epoll_ctl(this->epollFd, EPOLL_CTL_DEL, fd, nullptr);
+    } else if (watch.events == 0) {
+        result = epoll_ctl(this->epollFd, EPOLL_CTL_ADD, fd, &ev);
+    } else {
+        result = epoll_ctl(this->epollFd, EPOLL_CTL_MOD, fd, &ev);
+    }
+
+    if (result < 0) {
+        perror("Updating watched socket failed: epoll_ctl()");
+    }
+
+    watch.events = events;
+}
+
+
+
+/**
+ * Runs every callback that other threads have posted so far.
+ */
+void EventLoop::runPosted() {
+    uint64_t count;
+    if (read(this->wakeFd, &count, sizeof(count)) < 0 && errno != EAGAIN) {
+        perror("Clearing the event loop wakeup failed: read()");
+    }
+
+    vector<function<void()>> callbacks;
+    {
+        std::lock_guard<std::mutex> guard(this->postedLock);
+        callbacks.swap(this->posted);
+    }
+
+    for (auto &callback : callbacks) {
+        callback();
+    }
+}
+
+
+
+/**
+ * Deletes every handler that was retired during the last batch of events.
+ */
+void EventLoop::deleteRetired() {
+    for (auto handler : this->retired) {
+        delete handler;
+    }
+
+    this->retired.clear();
+}
@@ -0,0 +1,76 @@
+/**
+ * Program Name: FTP Server
+ * File Name: EventLoop.hpp
+ * Author: Taylor Jones
+ * Last Modified: 10/16/26
+ * Description: EventLoop.hpp is the class specification
+ *  file for the EventLoop class and the EventHandler interface.
+ *  The EventLoop wraps an epoll instance and dispatches readiness
+ *  events for every watched socket to the handler that owns it.
+ *  Other threads hand work back to the loop's thread with post().
+ */
+
+
+#ifndef EventLoop_hpp
+#define EventLoop_hpp
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+using std::function;
+using std::unordered_map;
+using std::vector;
+
+
+/**
+ * Anything that owns a file descriptor watched by the EventLoop.
+ */
+class EventHandler {
+  public:
+    virtual ~EventHandler() {}
+    virtual void handleEvent(int fd, uint32_t events) = 0;
+};
+
+
+class EventLoop {
+  // Member Variables
+  private:
+    struct Watch {
+        EventHandler *handler;    // the owner of the file descriptor
+        uint32_t events;          // the events currently registered with epoll (0 if none)
+    };
+
+    int epollFd;                              // the epoll instance
+    int wakeFd;                               // an eventfd that interrupts epoll_wait() when work is posted
+    bool running;                             // false once stop() has been called
+    unordered_map<int, Watch> watches;        // every watched file descriptor
+    vector<EventHandler*> retired;            // handlers to delete once the current batch is done
+
+    std::mutex postedLock;
+    vector<function<void()>> posted;          // callbacks posted from other threads
+
+  // Member Functions
+  private:
+    void applyEvents(int fd, Watch &watch, uint32_t events);
+    void deleteRetired();
+    void runPosted();
+
+  public:
+    EventLoop();
+    ~EventLoop();
+
+    void watch(int fd, uint32_t events, EventHandler *handler);
+    void update(int fd, uint32_t events);
+    void unwatch(int fd);
+    void retire(EventHandler *handler);
+    void post(function<void()> callback);
+
+    void run();
+    void stop();
+};
+
+
+#endif /* EventLoop_hpp */
@@ -0,0 +1,222 @@
+/**
+ * Program Name: FTP Server
+ * File Name: FileMetadata.cpp
+ * Author: Taylor Jones
+ * Last Modified: 10/16/26
+ * Description: FileMetadata.cpp is the class implementation
+ *  file for the MetadataBatch class.
+ *
+ *  A MetadataBatch looks up the metadata of many entries of one directory
+ *  at once. Every lookup is relative to the directory's open descriptor,
+ *  so the kernel resolves a single name instead of a whole path, and
+ *  statx() is asked for only the fields the listing needs. Entries whose
+ *  directory entry already gives everything wanted aren't looked up at all.
+ *  A large batch is shared out in slices among the caller and any pool
+ *  workers, since each lookup is a system call of its own; a small one (or
+ *  one without a pool to share with) is simply looked up in a loop.
+ */
+
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <dirent.h>
+#include <fcntl.h>
+#include <memory>
+#include <sys/stat.h>
+
+#include "FileMetadata.hpp"
+
+using std::shared_ptr;
+
+
+/**
+ * Adds an entry to look up.
+ * @param name - the entry's name, which must stay valid until fetch().
+ * @param type - the d_type from the directory entry (DT_UNKNOWN if the file system doesn't say).
+ * @return size_t - the lookup's index, for at().
+ */
+size_t MetadataBatch::add(const char *name, unsigned char type) {
+    Lookup lookup;
+    lookup.name = name;
+    lookup.result.found = false;
+    lookup.result.type = type;
+    lookup.result.size = -1;
+    lookup.result.mtime.tv_sec = 0;
+    lookup.result.mtime.tv_nsec = 0;
+
+    this->lookups.push_back(lookup);
+    return this->lookups.size() - 1;
+}
+
+
+
+/**
+ * Looks up every entry that was added.
+ * @param dirFd - the directory that holds the entries.
+ * @param fields - the MetadataField values wanted, or'd together.
+ * @param pool - the pool to share a large batch with, or null to look everything up on the calling thread.
+ */
+void MetadataBatch::fetch(int dirFd, unsigned fields, ThreadPool *pool) {
+    const size_t sliceCount = (this->lookups.size() + SLICE_SIZE - 1) / SLICE_SIZE;
+    const size_t helpers = pool != nullptr && pool->size() > 1 && sliceCount > 1 ? std::min(pool->size() - 1, sliceCount - 1) : 0;
+
+    if (helpers == 0) {
+        for (auto &lookup : this->lookups) {
+            lookUpIfNeeded(dirFd, lookup, fields);
+        }
+        return;
+    }
+
+    shared_ptr<SharedFetch> shared(new SharedFetch());
+    shared->nextSlice = 0;
+    shared->sliceCount = sliceCount;
+    shared->slicesDone = 0;
+
+    // a worker that starts after every slice has been taken finds nothing to do, and never touches the batch.
+    for (size_t i = 0; i < helpers; i++) {
+        pool->submit([this, shared, dirFd, fields]() { this->lookUpSlices(*shared, dirFd, fields); });
+    }
+
+    this->lookUpSlices(*shared, dirFd, fields);
+
+    std::unique_lock<std::mutex> guard(shared->lock);
+    shared->allDone.wait(guard, [&shared]() { return shared->slicesDone == shared->sliceCount; });
+}
+
+
+
+/**
+ * Takes slices of a fetch until none are left.
+ * @param shared - the fetch.
+ * @param dirFd - the directory that holds the entries.
+ * @param fields - the MetadataField values wanted, or'd together.
+ */
+void MetadataBatch::lookUpSlices(SharedFetch &shared, int dirFd, unsigned fields) {
+    for (size_t slice = shared.nextSlice++; slice < shared.sliceCount; slice = shared.nextSlice++) {
+        const size_t end = std::min(this->lookups.size(), (slice + 1) * SLICE_SIZE);
+
+        for (size_t i = slice * SLICE_SIZE; i < end; i++) {
+            lookUpIfNeeded(dirFd, this->lookups[i], fields);
+        }
+
+        std::lock_guard<std::mutex> guard(shared.lock);
+        if (++shared.slicesDone == shared.sliceCount) {
+            shared.allDone.notify_all();
+        }
+    }
+}
+
+
+
+/**
+ * Looks up one entry, unless its directory entry already said everything wanted.
+ * @param dirFd - the directory that holds the entry.
+ * @param lookup - the entry, which holds the result.
+ * @param fields - the MetadataField values wanted, or'd together.
+ */
+void MetadataBatch::lookUpIfNeeded(int dirFd, Lookup &lookup, unsigned fields) {
+    if ((fields & ~META_TYPE) != 0 || lookup.result.type == DT_UNKNOWN) {
+        lookup.result.found = lookUp(dirFd, lookup, fields);
+    } else {
+        lookup.result.found = true;
+    }
+}
+
+
+
+/**
+ * Looks up one entry with statx() (or fstatat(), if the kernel doesn't have statx).
+ * The size of a link whose target is missing is left at -1.
+ * @param dirFd - the directory that holds the entry.
+ * @param lookup - the entry, which holds the result.
+ * @param fields - the MetadataField values wanted, or'd together.
+ * @return bool - false if the entry couldn't be looked up.
+ */
+bool MetadataBatch::lookUp(int dirFd, Lookup &lookup, unsigned fields) {
+    static std::atomic<bool> haveStatx(true);
+    EntryMetadata &result = lookup.result;
+
+    unsigned mask = 0;
+    mask |= (fields & META_SIZE) ? STATX_SIZE : 0;
+    mask |= (fields & META_MTIME) ? STATX_MTIME : 0;
+
+    // only a lookup that doesn't follow symbolic links can tell the type.
+    bool follow = result.type != DT_UNKNOWN;
+    if (!follow) {
+        mask |= STATX_TYPE;
+    }
+
+    for (int pass = 0; pass < 2; pass++) {
+        const int flags = AT_NO_AUTOMOUNT | (follow ? 0 : AT_SYMLINK_NOFOLLOW);
+        struct stat info;
+        struct statx extended;
+        mode_t mode;
+
+        if (haveStatx) {
+            if (statx(dirFd, lookup.name, flags, mask, &extended) != 0) {
+                if (errno != ENOSYS) {
+                    return pass > 0;
+                }
+                haveStatx = false;
+            }
+        }
+        if (!haveStatx) {
+            if (fstatat(dirFd, lookup.name, &info, flags) != 0) {
+                return pass > 0;
+            }
+            mode = info.st_mode;
+            result.size = info.st_size;
+            result.mtime = info.st_mtim;
+        } else {
+            mode = extended.stx_mode;
+            result.size = (extended.stx_mask & STATX_SIZE) ? (off_t) extended.stx_size : -1;
+            result.mtime.tv_sec = extended.stx_mtime.tv_sec;
+            result.mtime.tv_nsec = extended.stx_mtime.tv_nsec;
+        }
+
+        if (!follow) {
+            result.type = IFTODT(mode);
+        }
+
+        // a link's size and time are its target's: look those up on a second pass.
+        if (follow || result.type != DT_LNK || (fields & ~META_TYPE) == 0) {
+            return true;
+        }
+        follow = true;
+        mask &= ~STATX_TYPE;
+        result.size = -1;
+        result.mtime.tv_sec = 0;
+        result.mtime.tv_nsec = 0;
+    }
+
+    return true;
+}
+
+
+
+/**
+ * @param index - the index add() returned.
+ * @return EntryMetadata - the entry's metadata, once fetch() has been called.
+ */
+const EntryMetadata &MetadataBatch::at(size_t index) const {
+    return this->lookups[index].result;
+}
+
+
+
+/**
+ * @return size_t - the number of entries added.
+ */
+size_t MetadataBatch::size() const {
+    return this->lookups.size();
+}
+
+
+
+/**
+ * Removes every entry, so the batch can be used for the next set of entries.
+ */
+void MetadataBatch::clear() {
+    this->lookups.clear();
+}
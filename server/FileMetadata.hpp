@@ -0,0 +1,89 @@
+/**
+ * Program Name: FTP Server
+ * File Name: FileMetadata.hpp
+ * Author: Taylor Jones
+ * Last Modified: 10/16/26
+ * Description: FileMetadata.hpp is the class specification
+ *  file for the MetadataBatch class. This file contains declarations
+ *  for the member functions of the MetadataBatch class.
+ */
+
+
+#ifndef FileMetadata_hpp
+#define FileMetadata_hpp
+
+#include <atomic>
+#include <condition_variable>
+#include <ctime>
+#include <mutex>
+#include <sys/types.h>
+#include <vector>
+
+#include "ThreadPool.hpp"
+
+using std::vector;
+
+
+/**
+ * The fields of an entry's metadata that can be asked for.
+ */
+enum MetadataField {
+    META_TYPE = 1,      // the entry's type (always known once looked up)
+    META_SIZE = 2,      // the entry's size in bytes
+    META_MTIME = 4      // the entry's last modification time
+};
+
+
+/**
+ * The metadata of one directory entry. Symbolic links are followed for
+ * the size and modification time (as stat() does), but not for the type.
+ */
+struct EntryMetadata {
+    bool found;                 // false if the entry couldn't be looked up
+    unsigned char type;         // the entry's d_type (DT_DIR, DT_REG, ...)
+    off_t size;                 // the size, or -1 if it wasn't found
+    struct timespec mtime;      // the modification time, or zero if it wasn't found
+};
+
+
+class MetadataBatch {
+  // Member Variables
+  private:
+    struct Lookup {
+        const char *name;       // the entry's name, which must stay valid until fetch()
+        EntryMetadata result;
+    };
+
+    /**
+     * A fetch that is shared out, a slice at a time, among the caller and
+     * some pool workers. Workers keep it alive, since a worker may only get
+     * to run after every slice is done (and the batch may be gone).
+     */
+    struct SharedFetch {
+        std::atomic<size_t> nextSlice;
+        size_t sliceCount;
+        std::mutex lock;                        // guards slicesDone
+        std::condition_variable allDone;
+        size_t slicesDone;
+    };
+
+    static const size_t SLICE_SIZE = 256;       // how many lookups a thread takes at a time
+
+    vector<Lookup> lookups;
+
+  // Member Functions
+  private:
+    static void lookUpIfNeeded(int dirFd, Lookup &lookup, unsigned fields);
+    static bool lookUp(int dirFd, Lookup &lookup, unsigned fields);
+    void lookUpSlices(SharedFetch &shared, int dirFd, unsigned fields);
+
+  public:
+    size_t add(const char *name, unsigned char type);
+    void fetch(int dirFd, unsigned fields, ThreadPool *pool = nullptr);
+    const EntryMetadata &at(size_t index) const;
+    size_t size() const;
+    void clear();
+};
+
+
+#endif /* FileMetadata_hpp */
@@ -0,0 +1,108 @@
+/**
+ * Program Name: FTP Server
+ * File Name: Framing.cpp
+ * Author: Taylor Jones
+ * Last Modified: 10/16/26
+ * Description: Framing.cpp contains the implementations for
+ *  encoding and decoding frame headers and the big-endian
+ *  integers used inside frames.
+ */
+
+
+#include "Framing.hpp"
+
+
+/**
+ * Builds the header for a frame.
+ * @param type - the frame type.
+ * @param length - the length of the payload that will follow the header.
+ * @param flags - the frame's flags, such as FRAME_COMPRESSED.
+ * @return string - the 12-byte header.
+ */
+string encodeFrameHeader(FrameType type, uint64_t length, uint16_t flags) {
+    string header;
+    header.reserve(FRAME_HEADER_SIZE);
+
+    header.push_back((char) FRAME_VERSION);
+    header.push_back((char) type);
+    header.push_back((char) (flags >> 8));
+    header.push_back((char) (flags & 0xff));
+    appendUint64(header, length);
+
+    return header;
+}
+
+
+
+/**
+ * Reads a frame header.
+ * @param header - the 12 header bytes.
+ * @param type - holds the frame type.
+ * @param length - holds the payload length.
+ * @return bool - false if the header is from an unknown framing version.
+ */
+bool decodeFrameHeader(const char *header, FrameType &type, uint64_t &length) {
+    if ((uint8_t) header[0] != FRAME_VERSION) {
+        return false;
+    }
+
+    type = (FrameType) (uint8_t) header[1];
+    length = readUint64(header + 4);
+    return true;
+}
+
+
+
+/**
+ * Appends a 32-bit integer in network byte order.
+ * @param buffer - the buffer to append to.
+ * @param value - the value to append.
+ */
+void appendUint32(string &buffer, uint32_t value) {
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        buffer.push_back((char) ((value >> shift) & 0xff));
+    }
+}
+
+
+
+/**
+ * Appends a 64-bit integer in network byte order.
+ * @param buffer - the buffer to append to.
+ * @param value - the value to append.
+ */
+void appendUint64(string &buffer, uint64_t value) {
+    for (int shift = 56; shift >= 0; shift -= 8) {
+        buffer.push_back((char) ((value >> shift) & 0xff));
+    }
+}
+
+
+
+/**
+ * Reads a 32-bit integer stored in network byte order.
+ * @param data - the 4 bytes to read.
+ * @return uint32_t - the value.
+ */
+uint32_t readUint32(const char *data) {
+    uint32_t value = 0;
+    for (int i = 0; i < 4; i++) {
+        value = (value << 8) | (uint8_t) data[i];
+    }
+    return value;
+}
+
+
+
+/**
+ * Reads a 64-bit integer stored in network byte order.
+ * @param data - the 8 bytes to read.
+ * @return uint64_t - the value.
+ */
+uint64_t readUint64(const char *data) {
+    uint64_t value = 0;
+    for (int i = 0; i < 8; i++) {
+        value = (value << 8) | (uint8_t) data[i];
+    }
+    return value;
+}
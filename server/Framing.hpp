@@ -0,0 +1,63 @@
+/**
+ * Program Name: FTP Server
+ * File Name: Framing.hpp
+ * Author: Taylor Jones
+ * Last Modified: 10/16/26
+ * Description: Framing.hpp contains the declarations for the
+ *  length-prefixed framing that a client can ask for (with the
+ *  framing=1 request option) in place of the newline/\done text
+ *  framing on the data connection.
+ *
+ *  Every frame starts with a 12-byte header, in network byte order:
+ *    byte  0      the framing version (1)
+ *    byte  1      the frame type
+ *    bytes 2-3    flags (FRAME_COMPRESSED, or 0)
+ *    bytes 4-11   the payload length
+ *  The payload follows immediately, so a receiver always knows how many
+ *  bytes to read and never has to look for a terminator.
+ *
+ *  A DATA or LIST frame with the FRAME_COMPRESSED flag carries its payload
+ *  as a complete zlib (or gzip) stream of its own; the header gives the
+ *  compressed length. Only clients that asked for compression get them.
+ *
+ *  A delta download (delta=1) is the one response that the client sends a
+ *  frame for: once it has replied to the GOOD frame, it sends a SIGNATURES
+ *  frame describing its old copy (see DeltaEncoder.cpp). The file then
+ *  comes back as DATA frames of new bytes and COPY frames of old blocks,
+ *  in file order, followed by the END frame.
+ */
+
+#ifndef Framing_hpp
+#define Framing_hpp
+
+#include <cstdint>
+#include <string>
+
+using std::string;
+
+
+const uint8_t FRAME_VERSION = 1;
+const size_t FRAME_HEADER_SIZE = 12;
+const size_t CHUNK_HEADER_SIZE = 16;
+const uint16_t FRAME_COMPRESSED = 1;   // the payload is compressed
+
+enum FrameType : uint8_t {
+    FRAME_GOOD = 1,     // the request can be served; for -g the payload is the 8-byte file size
+    FRAME_BAD = 2,      // the request can't be served; the payload is the error message
+    FRAME_DATA = 3,     // file contents
+    FRAME_LIST = 4,     // directory entries, each as a 4-byte length followed by the entry
+    FRAME_END = 5,      // the response is complete (replaces \done)
+    FRAME_CHUNK = 6,    // part of a striped file: the 8-byte chunk index and 8-byte file offset, then the contents
+    FRAME_SIGNATURES = 7,   // client to server, for delta=1: the 4-byte block size, then each block's signature
+    FRAME_COPY = 8      // delta=1: the 8-byte index of the client's first block to copy, and the 8-byte number of blocks
+};
+
+string encodeFrameHeader(FrameType type, uint64_t length, uint16_t flags = 0);
+bool decodeFrameHeader(const char *header, FrameType &type, uint64_t &length);
+
+void appendUint32(string &buffer, uint32_t value);
+void appendUint64(string &buffer, uint64_t value);
+uint32_t readUint32(const char *data);
+uint64_t readUint64(const char *data);
+
+#endif /* Framing_hpp */
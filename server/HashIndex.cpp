@@ -0,0 +1,369 @@
+/**
+ * Program Name: FTP Server
+ * File Name: HashIndex.cpp
+ * Author: Taylor Jones
+ * Last Modified: 10/16/26
+ * Description: HashIndex.cpp is the class implementation
+ *  file for the HashIndex class.
+ *
+ *  The index answers the -h and -hr commands with the XXH64 hash of each
+ *  file's contents. Hashes are kept by device and inode, along with the
+ *  size and modification time the file had when it was hashed, so a file
+ *  is only read again once one of those has changed (or it has been
+ *  replaced), and renaming a file doesn't lose its hash.
+ *
+ *  The index outlives the server: every new hash is appended to the index
+ *  file as a line of text ("<device> <inode> <size> <mtime seconds>
+ *  <mtime nanoseconds> <hash>"), and the file is read back when the server
+ *  starts. Later lines replace earlier ones for the same file, so once most
+ *  of the lines are outdated, the file is rewritten with just the current
+ *  ones. A line cut short by a crash is skipped.
+ */
+
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <dirent.h>
+#include <fcntl.h>
+#include <fstream>
+#include <unistd.h>
+#include <vector>
+
+#include "HashIndex.hpp"
+#include "Xxh64.hpp"
+
+using std::vector;
+
+
+/**
+ * Creates an index, reading back the hashes the index file already holds.
+ * @param path - the index file, or an empty string to keep the index in memory only.
+ */
+HashIndex::HashIndex(const string &path) {
+    this->path = path;
+    this->logFd = -1;
+    this->logKey = FileKey(0, 0);
+    this->records = 0;
+    this->stats.hits = 0;
+    this->stats.hashed = 0;
+    this->stats.entries = 0;
+
+    if (!path.empty()) {
+        this->load();
+        if (this->records >= MIN_COMPACT_RECORDS && this->records > 2 * this->entries.size()) {
+            this->compact();
+        }
+        this->openLog();
+    }
+}
+
+
+
+/**
+ * Closes the index file.
+ */
+HashIndex::~HashIndex() {
+    if (this->logFd >= 0) {
+        close(this->logFd);
+    }
+}
+
+
+
+/**
+ * Reads the records of the index file, if there is one.
+ */
+void HashIndex::load() {
+    std::ifstream file(this->path.c_str());
+    string line;
+
+    while (std::getline(file, line)) {
+        unsigned long long device, inode, hash;
+        long long size, seconds;
+        long nanoseconds;
+        int hashStart = 0, hashEnd = 0;
+
+        // a record is only whole if it ends with all 16 digits of the hash.
+        if (sscanf(line.c_str(), "%llu %llu %lld %lld %ld %n%16llx%n", &device, &inode, &size, &seconds, &nanoseconds,
+                   &hashStart, &hash, &hashEnd) != 6 || hashEnd - hashStart != 16 || (size_t) hashEnd != line.size()) {
+            continue;
+        }
+
+        Entry entry;
+        entry.size = size;
+        entry.mtime.tv_sec = seconds;
+        entry.mtime.tv_nsec = nanoseconds;
+        entry.hash = hash;
+        this->entries[FileKey(device, inode)] = entry;
+        this->records++;
+    }
+}
+
+
+
+/**
+ * Rewrites the index file with only the current records. The new file
+ * replaces the old one in a single rename, so a crash part-way through
+ * leaves one or the other.
+ */
+void HashIndex::compact() {
+    const string replacement = this->path + ".tmp";
+    int fd = open(replacement.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return;
+    }
+
+    string contents;
+    for (const auto &entry : this->entries) {
+        contents.append(formatRecord(entry.first, entry.second));
+    }
+
+    size_t done = 0;
+    while (done < contents.size()) {
+        ssize_t count = write(fd, contents.data() + done, contents.size() - done);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            break;
+        }
+        done += count;
+    }
+    const bool written = done == contents.size();
+
+    if (close(fd) == 0 && written && rename(replacement.c_str(), this->path.c_str()) == 0) {
+        this->records = this->entries.size();
+    } else {
+        unlink(replacement.c_str());
+    }
+}
+
+
+
+/**
+ * Opens the index file for appending, creating it if need be.
+ */
+void HashIndex::openLog() {
+    struct stat info;
+    this->logFd = open(this->path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+
+    if (this->logFd < 0) {
+        perror(("Hashes can't be saved to " + this->path + ": open()").c_str());
+    } else if (fstat(this->logFd, &info) == 0) {
+        this->logKey = FileKey(info.st_dev, info.st_ino);
+    }
+}
+
+
+
+/**
+ * Adds a new hash to the index, and to the end of the index file.
+ * The caller must hold the lock.
+ * @param key - the file's device and inode.
+ * @param entry - the file's size, modification time and hash.
+ */
+void HashIndex::record(const FileKey &key, const Entry &entry) {
+    this->entries[key] = entry;
+
+    if (this->logFd >= 0) {
+        // one short write to a file opened for appending lands whole, even with other writers.
+        const string line = formatRecord(key, entry);
+        if (write(this->logFd, line.data(), line.size()) == (ssize_t) line.size()) {
+            this->records++;
+        }
+    }
+}
+
+
+
+/**
+ * @return string - a record of the index file, ending with a newline.
+ */
+string HashIndex::formatRecord(const FileKey &key, const Entry &entry) {
+    char line[128];
+    snprintf(line, sizeof(line), "%llu %llu %lld %lld %ld %016llx\n", (unsigned long long) key.first,
+             (unsigned long long) key.second, (long long) entry.size, (long long) entry.mtime.tv_sec,
+             (long) entry.mtime.tv_nsec, (unsigned long long) entry.hash);
+    return line;
+}
+
+
+
+/**
+ * Reads a whole file and hashes it.
+ * @param fd - the open file.
+ * @param size - the file's size, which sizes the read buffer.
+ * @param hash - holds the hash.
+ * @return bool - false if the file couldn't be read.
+ */
+bool HashIndex::hashContents(int fd, off_t size, uint64_t &hash) {
+    const size_t bufferSize = (size_t) size < READ_BUFFER_SIZE ? (size_t) size : READ_BUFFER_SIZE;
+    vector<char> buffer(std::max((size_t) 1, bufferSize));
+    Xxh64 hasher;
+
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    for (;;) {
+        ssize_t count = read(fd, buffer.data(), buffer.size());
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count < 0) {
+            return false;
+        }
+        if (count == 0) {
+            break;
+        }
+        hasher.update(buffer.data(), count);
+    }
+
+    hash = hasher.digest();
+    return true;
+}
+
+
+
+/**
+ * Gets the hash of a regular file (following symbolic links), reading and
+ * hashing the file only if the index doesn't have it for the file's
+ * current size and modification time. A file that changes while it is
+ * being hashed still gets its hash, but the hash isn't kept.
+ * @param dirFd - the directory the name is relative to, or AT_FDCWD.
+ * @param name - the file's name.
+ * @param hash - holds the hash.
+ * @param size - holds the file's size.
+ * @return bool - false if the file isn't a regular file or couldn't be read.
+ */
+bool HashIndex::hashFile(int dirFd, const char *name, uint64_t &hash, off_t &size) {
+    struct stat info;
+    if (fstatat(dirFd, name, &info, 0) != 0 || !S_ISREG(info.st_mode)) {
+        return false;
+    }
+
+    const FileKey key(info.st_dev, info.st_ino);
+    {
+        std::lock_guard<std::mutex> guard(this->lock);
+        if (key == this->logKey) {
+            return false;
+        }
+
+        auto found = this->entries.find(key);
+        if (found != this->entries.end() && found->second.size == info.st_size &&
+            found->second.mtime.tv_sec == info.st_mtim.tv_sec && found->second.mtime.tv_nsec == info.st_mtim.tv_nsec) {
+            hash = found->second.hash;
+            size = found->second.size;
+            this->stats.hits++;
+            return true;
+        }
+    }
+
+    // hash the file without holding the lock, so other lookups aren't held up by the disk.
+    struct stat before, after;
+    int fd = openat(dirFd, name, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    bool hashed = fstat(fd, &before) == 0 && S_ISREG(before.st_mode) && hashContents(fd, before.st_size, hash) &&
+        fstat(fd, &after) == 0;
+    close(fd);
+    if (!hashed) {
+        return false;
+    }
+    size = after.st_size;
+
+    std::lock_guard<std::mutex> guard(this->lock);
+    this->stats.hashed++;
+    if (before.st_size == after.st_size && before.st_mtim.tv_sec == after.st_mtim.tv_sec &&
+        before.st_mtim.tv_nsec == after.st_mtim.tv_nsec) {
+        Entry entry;
+        entry.size = after.st_size;
+        entry.mtime = after.st_mtim;
+        entry.hash = hash;
+        this->record(FileKey(after.st_dev, after.st_ino), entry);
+    }
+    return true;
+}
+
+
+
+/**
+ * Hashes every regular file in a directory tree (hidden ones too, as -lr
+ * lists them). Each directory's files come in name order, followed by its
+ * subdirectories, also in name order. Symbolic links to files are hashed,
+ * but symbolic links to directories aren't followed, so the walk can't loop.
+ * @param root - the directory to walk.
+ * @param visit - called with each file's path (relative to the root), hash and size;
+ *  returns false to stop the walk.
+ * @return bool - false if the walk was stopped, or the root couldn't be opened.
+ */
+bool HashIndex::hashTree(const string &root, const function<bool(const string &path, uint64_t hash, off_t size)> &visit) {
+    int rootFd = open(root.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (rootFd < 0) {
+        return false;
+    }
+
+    // the directories still to walk, relative to the root, the next one last.
+    vector<string> pending(1, string());
+    bool finished = true;
+
+    while (finished && !pending.empty()) {
+        const string prefix = pending.back();
+        pending.pop_back();
+
+        int fd = prefix.empty() ? dup(rootFd) : openat(rootFd, prefix.c_str(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+        DIR *dir = fd >= 0 ? fdopendir(fd) : nullptr;
+        if (dir == nullptr) {
+            if (fd >= 0) {
+                close(fd);
+            }
+            continue;
+        }
+
+        vector<string> files, subdirectories;
+        while (struct dirent *entry = readdir(dir)) {
+            const string name = entry->d_name;
+            if (name == "." || name == "..") {
+                continue;
+            }
+
+            struct stat info;
+            bool isDirectory = entry->d_type == DT_DIR ||
+                (entry->d_type == DT_UNKNOWN && fstatat(dirfd(dir), entry->d_name, &info, AT_SYMLINK_NOFOLLOW) == 0 &&
+                 S_ISDIR(info.st_mode));
+            (isDirectory ? subdirectories : files).push_back(name);
+        }
+
+        std::sort(files.begin(), files.end());
+        for (const auto &name : files) {
+            uint64_t hash;
+            off_t size;
+            if (this->hashFile(dirfd(dir), name.c_str(), hash, size) && !visit(prefix + name, hash, size)) {
+                finished = false;
+                break;
+            }
+        }
+        closedir(dir);
+
+        std::sort(subdirectories.rbegin(), subdirectories.rend());
+        for (const auto &name : subdirectories) {
+            pending.push_back(prefix + name + "/");
+        }
+    }
+
+    close(rootFd);
+    return finished;
+}
+
+
+
+/**
+ * @return HashIndexStats - the index's counters, and how many files it holds now.
+ */
+HashIndexStats HashIndex::getStats() {
+    std::lock_guard<std::mutex> guard(this->lock);
+    HashIndexStats stats = this->stats;
+
+    stats.entries = this->entries.size();
+    return stats;
+}
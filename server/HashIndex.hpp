@@ -0,0 +1,81 @@
+/**
+ * Program Name: FTP Server
+ * File Name: HashIndex.hpp
+ * Author: Taylor Jones
+ * Last Modified: 10/16/26
+ * Description: HashIndex.hpp is the class specification
+ *  file for the HashIndex class. This file contains declarations
+ *  for the member functions of the HashIndex class.
+ */
+
+
+#ifndef HashIndex_hpp
+#define HashIndex_hpp
+
+#include <cstdint>
+#include <ctime>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <utility>
+
+using std::function;
+using std::map;
+using std::string;
+
+
+/**
+ * How the index has been doing since the server started.
+ */
+struct HashIndexStats {
+    uint64_t hits;          // files whose hash was already known
+    uint64_t hashed;        // files that had to be read and hashed
+    size_t entries;         // the files in the index now
+};
+
+
+class HashIndex {
+  // Member Variables
+  private:
+    typedef std::pair<dev_t, ino_t> FileKey;
+
+    struct Entry {
+        off_t size;                 // the file's size when it was hashed
+        struct timespec mtime;      // the file's modification time when it was hashed
+        uint64_t hash;
+    };
+
+    static const size_t READ_BUFFER_SIZE = 1024 * 1024;    // the most of a file read at a time
+    static const size_t MIN_COMPACT_RECORDS = 1024;         // smaller index files are never rewritten
+
+    std::mutex lock;                // guards everything below; workers share the index
+    string path;                    // the index file, or empty to keep the index in memory only
+    int logFd;                      // the index file, open for appending, or -1
+    FileKey logKey;                 // the index file's device and inode, so it is never hashed itself
+    size_t records;                 // the records in the index file, including outdated ones
+    map<FileKey, Entry> entries;
+    HashIndexStats stats;
+
+  // Member Functions
+  private:
+    void load();
+    void compact();
+    void openLog();
+    void record(const FileKey &key, const Entry &entry);
+    static string formatRecord(const FileKey &key, const Entry &entry);
+    static bool hashContents(int fd, off_t size, uint64_t &hash);
+
+  public:
+    explicit HashIndex(const string &path);
+    ~HashIndex();
+
+    bool hashFile(int dirFd, const char *name, uint64_t &hash, off_t &size);
+    bool hashTree(const string &root, const function<bool(const string &path, uint64_t hash, off_t size)> &visit);
+    HashIndexStats getStats();
+};
+
+
+#endif /* HashIndex_hpp */
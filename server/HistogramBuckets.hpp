@@ -0,0 +1,69 @@
+/**
+ * Program Name: FTP Server
+ * File Name: HistogramBuckets.hpp
+ * Author: Taylor Jones
+ * Last Modified: 10/16/26
+ * Description: HistogramBuckets.hpp is the class specification
+ *  and implementation file for the HistogramBuckets class template.
+ *
+ *  The bucket layout of an HDR-style histogram of times: exact below
+ *  2^SUB_BUCKET_BITS ns, and 2^SUB_BUCKET_BITS log-linear buckets for each
+ *  power of two above, up to 2^MAX_EXPONENT ns. Longer times are counted in
+ *  the last bucket. The server's Metrics and the load generator's
+ *  LatencyHistogram count differently (atomic per-thread shards, and
+ *  plain counters merged at the end), but share this layout.
+ */
+
+
+#ifndef HistogramBuckets_hpp
+#define HistogramBuckets_hpp
+
+#include <cstddef>
+#include <cstdint>
+
+
+template <int SUB_BUCKET_BITS, int MAX_EXPONENT>
+class HistogramBuckets {
+  // Member Variables
+  public:
+    static const size_t SUB_BUCKETS = (size_t) 1 << SUB_BUCKET_BITS;
+    static const size_t COUNT = (MAX_EXPONENT - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+  // Member Functions
+  public:
+    /**
+     * @param nanoseconds - a time.
+     * @return size_t - the bucket the time is counted in, always less than COUNT.
+     */
+    static size_t bucketOf(uint64_t nanoseconds) {
+        if (nanoseconds < SUB_BUCKETS) {
+            return nanoseconds;
+        }
+
+        // exponents from SUB_BUCKET_BITS to MAX_EXPONENT - 1 fill the buckets;
+        // 2^MAX_EXPONENT ns and up would be the first bucket past the end.
+        const int exponent = 63 - __builtin_clzll(nanoseconds);
+        if (exponent >= MAX_EXPONENT) {
+            return COUNT - 1;
+        }
+        const int shift = exponent - SUB_BUCKET_BITS;
+        return (shift + 1) * SUB_BUCKETS + ((nanoseconds >> shift) - SUB_BUCKETS);
+    }
+
+    /**
+     * @param bucket - a bucket.
+     * @return uint64_t - the largest time (in ns) counted in the bucket.
+     */
+    static uint64_t bucketLimit(size_t bucket) {
+        if (bucket < SUB_BUCKETS) {
+            return bucket;
+        }
+
+        const int shift = bucket / SUB_BUCKETS - 1;
+        const uint64_t mantissa = bucket % SUB_BUCKETS + SUB_BUCKETS;
+        return ((mantissa + 1) << shift) - 1;
+    }
+};
+
+
+#endif /* HistogramBuckets_hpp */
@@ -0,0 +1,441 @@
+/**
+ * Program Name: FTP Server
+ * File Name: IoRing.cpp
+ * Author: Taylor Jones
+ * Last Modified: 10/16/26
+ * Description: IoRing.cpp is the class implementation
+ *  file for the IoRing class.
+ *
+ *  An IoRing is an io_uring instance that a worker thread sends files with,
+ *  set up with raw system calls (so no library is needed). Each worker has
+ *  its own ring, with a few registered buffers. A file is sent as chains of
+ *  linked operations: a read of the file into a buffer, then a send of that
+ *  buffer. The chains for every buffer, and any header that has to go first,
+ *  are linked together and submitted with a single system call, so a file of
+ *  up to a megabyte takes one io_uring_enter() instead of a write for the
+ *  header and a sendfile() or more for the file. A larger file also uses the
+ *  file and the socket as fixed files, for the length of the transfer.
+ *
+ *  io_uring ignores the socket's send timeout, so the ring keeps its own:
+ *  if nothing completes for that long, the client has stalled, and whatever
+ *  is still in flight is cancelled. Anything else that breaks a chain
+ *  part-way (a send cut short by a signal, say) is finished with ordinary
+ *  blocking calls, and the chains go on from there.
+ */
+
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "Util.hpp"
+#include "IoRing.hpp"
+
+using std::unique_ptr;
+
+
+/**
+ * Creates a ring. If the kernel doesn't support io_uring (or everything
+ * this class needs from it), the ring isn't ready, and shouldn't be used.
+ */
+IoRing::IoRing() {
+    this->ringFd = -1;
+    this->ringMemory = MAP_FAILED;
+    this->ringMemorySize = 0;
+    this->sqes = (struct io_uring_sqe *) MAP_FAILED;
+    this->sqesSize = 0;
+    this->buffers = (char *) MAP_FAILED;
+    this->buffersRegistered = false;
+    this->filesRegistered = false;
+    this->queued = 0;
+    this->sendTimeout.tv_sec = 0;
+    this->sendTimeout.tv_nsec = 0;
+    std::fill(this->clearedFiles, this->clearedFiles + FILE_SLOTS, -1);
+
+    if (!this->setUp() && this->ringFd >= 0) {
+        close(this->ringFd);
+        this->ringFd = -1;
+    }
+}
+
+
+
+/**
+ * Releases the ring and its buffers.
+ */
+IoRing::~IoRing() {
+    if (this->buffers != MAP_FAILED) {
+        munmap(this->buffers, BUFFER_COUNT * BUFFER_SIZE);
+    }
+    if (this->sqes != MAP_FAILED) {
+        munmap(this->sqes, this->sqesSize);
+    }
+    if (this->ringMemory != MAP_FAILED) {
+        munmap(this->ringMemory, this->ringMemorySize);
+    }
+    if (this->ringFd >= 0) {
+        close(this->ringFd);
+    }
+}
+
+
+
+/**
+ * Sets up the ring, maps it, and registers the buffers and file slots.
+ * Registering is only an optimization: if either fails, the ring still works.
+ * @return bool - false if the ring can't be used.
+ */
+bool IoRing::setUp() {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+
+    this->ringFd = syscall(__NR_io_uring_setup, RING_ENTRIES, &params);
+    if (this->ringFd < 0) {
+        return false;
+    }
+
+    // without fast poll, a send to a full socket would tie up one of the kernel's io_uring workers,
+    // and without the extended argument, waits couldn't time out.
+    const unsigned needed = IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP | IORING_FEAT_FAST_POLL | IORING_FEAT_EXT_ARG;
+    if ((params.features & needed) != needed) {
+        return false;
+    }
+
+    this->ringMemorySize = std::max(params.sq_off.array + params.sq_entries * sizeof(unsigned),
+        params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe));
+    this->ringMemory = mmap(nullptr, this->ringMemorySize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+        this->ringFd, IORING_OFF_SQ_RING);
+    this->sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+    this->sqes = (struct io_uring_sqe *) mmap(nullptr, this->sqesSize, PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE, this->ringFd, IORING_OFF_SQES);
+    this->buffers = (char *) mmap(nullptr, BUFFER_COUNT * BUFFER_SIZE, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (this->ringMemory == MAP_FAILED || this->sqes == MAP_FAILED || this->buffers == MAP_FAILED) {
+        return false;
+    }
+
+    char *ring = (char *) this->ringMemory;
+    this->sqHead = (unsigned *) (ring + params.sq_off.head);
+    this->sqTail = (unsigned *) (ring + params.sq_off.tail);
+    this->sqMask = *(unsigned *) (ring + params.sq_off.ring_mask);
+    this->sqArray = (unsigned *) (ring + params.sq_off.array);
+    this->cqHead = (unsigned *) (ring + params.cq_off.head);
+    this->cqTail = (unsigned *) (ring + params.cq_off.tail);
+    this->cqMask = *(unsigned *) (ring + params.cq_off.ring_mask);
+    this->cqes = (struct io_uring_cqe *) (ring + params.cq_off.cqes);
+
+    struct iovec buffers[BUFFER_COUNT];
+    for (unsigned i = 0; i < BUFFER_COUNT; i++) {
+        buffers[i].iov_base = this->buffers + i * BUFFER_SIZE;
+        buffers[i].iov_len = BUFFER_SIZE;
+    }
+    this->buffersRegistered = syscall(__NR_io_uring_register, this->ringFd, IORING_REGISTER_BUFFERS,
+        buffers, BUFFER_COUNT) == 0;
+    this->filesRegistered = syscall(__NR_io_uring_register, this->ringFd, IORING_REGISTER_FILES,
+        this->clearedFiles, FILE_SLOTS) == 0;
+
+    return true;
+}
+
+
+
+/**
+ * @return bool - true if the ring was set up, and can send files.
+ */
+bool IoRing::isReady() const {
+    return this->ringFd >= 0;
+}
+
+
+
+/**
+ * Gets the calling thread's ring, setting it up on first use.
+ * @return IoRing - the thread's ring, or null if io_uring can't be used.
+ */
+IoRing *IoRing::forThread() {
+    static thread_local unique_ptr<IoRing> ring;
+    static thread_local bool tried = false;
+
+    if (!tried) {
+        tried = true;
+        ring.reset(new IoRing());
+        if (!ring->isReady()) {
+            ring.reset();
+        }
+    }
+
+    return ring.get();
+}
+
+
+
+/**
+ * Sends a range of a file, after a header, with chains of linked reads and sends.
+ * Nothing is sent with MSG_MORE after the last byte of the file, so whatever
+ * the caller sends next goes out on its own.
+ * @param sock - the (blocking) socket to send on.
+ * @param fd - the file to send from.
+ * @param offset - the first byte to send.
+ * @param length - the number of bytes to send.
+ * @param header - bytes to send before the file, which is emptied once they're sent.
+ * @param timeoutSeconds - how long the client may go without taking anything.
+ * @return bool - false if the file couldn't be read, or the send failed or stalled.
+ */
+bool IoRing::sendFile(int sock, int fd, off_t offset, off_t length, string &header, int timeoutSeconds) {
+    const off_t end = offset + length;
+    // registering the files costs a system call, which only pays off over several batches.
+    const bool fixed = this->filesRegistered && length > (off_t) (BUFFER_COUNT * BUFFER_SIZE) && this->setFiles(fd, sock);
+    const int fileRef = fixed ? 0 : fd;
+    const int sockRef = fixed ? 1 : sock;
+    bool released = false;
+    bool ok = true;
+
+    this->sendTimeout.tv_sec = timeoutSeconds;
+    this->sendTimeout.tv_nsec = 0;
+
+    while (ok && (offset < end || !header.empty())) {
+        this->operations.clear();
+
+        if (!header.empty()) {
+            this->prepareSend(sockRef, fixed, header.data(), header.size(), offset, offset < end);
+        }
+
+        off_t batchEnd = offset;
+        for (unsigned i = 0; i < BUFFER_COUNT && batchEnd < end; i++) {
+            const size_t chunk = std::min((off_t) BUFFER_SIZE, end - batchEnd);
+            char *buffer = this->buffers + i * BUFFER_SIZE;
+
+            struct io_uring_sqe *read = this->prepare(this->buffersRegistered ? IORING_OP_READ_FIXED : IORING_OP_READ,
+                fileRef, fixed, buffer, chunk);
+            read->off = batchEnd;
+            read->buf_index = i;
+            batchEnd += chunk;
+
+            this->prepareSend(sockRef, fixed, buffer, chunk, batchEnd, batchEnd < end);
+        }
+
+        // once the file is done with, the fixed files are released at the end of the chain.
+        if (fixed && batchEnd == end) {
+            this->prepare(IORING_OP_FILES_UPDATE, -1, false, (const char *) this->clearedFiles, FILE_SLOTS);
+        }
+        this->sqes[(*this->sqTail - 1) & this->sqMask].flags &= ~IOSQE_IO_LINK;
+
+        ok = this->submitAndWait();
+        header.clear();
+        offset = batchEnd;
+
+        // go through the batch in order: everything before a broken link was done, and everything after it wasn't.
+        for (size_t i = 0; ok && i < this->operations.size(); i++) {
+            const Operation &operation = this->operations[i];
+
+            if (operation.opcode == IORING_OP_FILES_UPDATE) {
+                released = operation.result >= 0;
+            } else if (operation.opcode == IORING_OP_READ_FIXED || operation.opcode == IORING_OP_READ) {
+                // a short read means the file shrank since it was offered.
+                ok = operation.result == (int) operation.length;
+            } else if (operation.opcode == IORING_OP_SEND && operation.result != (int) operation.length) {
+                ok = operation.result >= 0 && this->finishSend(sock, operation);
+                offset = operation.resumeAt;
+                break;
+            }
+        }
+    }
+
+    // if the chain broke before the release, the ring mustn't keep the socket open.
+    if (fixed && !released) {
+        this->setFiles(-1, -1);
+    }
+
+    return ok;
+}
+
+
+
+/**
+ * Adds an operation to the submission ring, linked to the one after it.
+ * @param opcode - the operation.
+ * @param fd - the file descriptor (or fixed file slot) to operate on.
+ * @param fixedFile - true if fd is a fixed file slot.
+ * @param data - the operation's buffer.
+ * @param length - the length of the buffer.
+ * @return io_uring_sqe - the entry, for anything else the operation needs set.
+ */
+struct io_uring_sqe *IoRing::prepare(uint8_t opcode, int fd, bool fixedFile, const char *data, size_t length) {
+    struct io_uring_sqe *sqe = this->nextSqe();
+    sqe->opcode = opcode;
+    sqe->fd = fd;
+    sqe->flags = IOSQE_IO_LINK | (fixedFile ? IOSQE_FIXED_FILE : 0);
+    sqe->addr = (uint64_t) (uintptr_t) data;
+    sqe->len = length;
+    sqe->user_data = this->operations.size();
+
+    Operation operation;
+    operation.opcode = opcode;
+    operation.data = data;
+    operation.length = length;
+    operation.resumeAt = 0;
+    operation.result = -ECANCELED;
+    operation.completed = false;
+    this->operations.push_back(operation);
+    return sqe;
+}
+
+
+
+/**
+ * Adds an empty entry to the submission ring.
+ * @return io_uring_sqe - the entry.
+ */
+struct io_uring_sqe *IoRing::nextSqe() {
+    const unsigned tail = *this->sqTail;
+    const unsigned index = tail & this->sqMask;
+    struct io_uring_sqe *sqe = &this->sqes[index];
+
+    memset(sqe, 0, sizeof(*sqe));
+    this->sqArray[index] = index;
+    __atomic_store_n(this->sqTail, tail + 1, __ATOMIC_RELEASE);
+    this->queued++;
+    return sqe;
+}
+
+
+
+/**
+ * Adds a send that waits until all of its bytes are sent.
+ * @param sock - the socket (or its fixed file slot).
+ * @param fixedFile - true if sock is a fixed file slot.
+ * @param data - the bytes to send.
+ * @param length - the number of bytes.
+ * @param resumeAt - where in the file the next send starts.
+ * @param more - true if more will be sent right after.
+ */
+void IoRing::prepareSend(int sock, bool fixedFile, const char *data, size_t length, off_t resumeAt, bool more) {
+    struct io_uring_sqe *send = this->prepare(IORING_OP_SEND, sock, fixedFile, data, length);
+    send->msg_flags = MSG_NOSIGNAL | MSG_WAITALL | (more ? MSG_MORE : 0);
+    this->operations.back().resumeAt = resumeAt;
+}
+
+
+
+/**
+ * Submits the batch, and waits for every operation in it to complete. If
+ * nothing completes for the send timeout, the client has stalled: whatever
+ * is still in flight is cancelled, and so completes as having failed.
+ * @return bool - false if the ring itself failed, or the client stalled.
+ */
+bool IoRing::submitAndWait() {
+    const auto timeout = std::chrono::seconds(this->sendTimeout.tv_sec);
+    auto lastProgress = std::chrono::steady_clock::now();
+    size_t completed = 0;
+    bool stalled = false;
+
+    while (completed < this->operations.size()) {
+        struct __kernel_timespec remaining;
+        struct io_uring_getevents_arg wait;
+        memset(&wait, 0, sizeof(wait));
+
+        auto left = std::chrono::duration_cast<std::chrono::nanoseconds>(timeout - (std::chrono::steady_clock::now() - lastProgress));
+        if (left.count() <= 0 && !stalled) {
+            stalled = true;
+            this->cancelPending();
+        }
+        remaining.tv_sec = stalled ? 0 : left.count() / 1000000000;
+        remaining.tv_nsec = stalled ? 0 : left.count() % 1000000000;
+        wait.ts = stalled ? 0 : (uint64_t) (uintptr_t) &remaining;
+
+        // once the client has stalled, the cancellations are waited on without a timeout.
+        const unsigned waitFor = this->operations.size() - completed;
+        if (syscall(__NR_io_uring_enter, this->ringFd, this->queued, waitFor,
+                IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &wait, sizeof(wait)) < 0 && errno != ETIME && errno != EINTR) {
+            return false;
+        }
+        this->queued = *this->sqTail - __atomic_load_n(this->sqHead, __ATOMIC_ACQUIRE);
+
+        const size_t reaped = this->reap();
+        if (reaped > 0) {
+            completed += reaped;
+            lastProgress = std::chrono::steady_clock::now();
+        }
+    }
+
+    return !stalled;
+}
+
+
+
+/**
+ * Takes every completion that has come in.
+ * @return size_t - the number of the batch's operations that completed.
+ */
+size_t IoRing::reap() {
+    size_t completed = 0;
+    unsigned head = *this->cqHead;
+    const unsigned tail = __atomic_load_n(this->cqTail, __ATOMIC_ACQUIRE);
+
+    for (; head != tail; head++) {
+        const struct io_uring_cqe &cqe = this->cqes[head & this->cqMask];
+
+        // the cancellations' own completions don't belong to any operation.
+        if (cqe.user_data < this->operations.size()) {
+            this->operations[cqe.user_data].result = cqe.res;
+            this->operations[cqe.user_data].completed = true;
+            completed++;
+        }
+    }
+
+    __atomic_store_n(this->cqHead, head, __ATOMIC_RELEASE);
+    return completed;
+}
+
+
+
+/**
+ * Asks the kernel to cancel every operation of the batch that hasn't completed.
+ */
+void IoRing::cancelPending() {
+    for (size_t i = 0; i < this->operations.size(); i++) {
+        if (!this->operations[i].completed) {
+            struct io_uring_sqe *cancel = this->nextSqe();
+            cancel->opcode = IORING_OP_ASYNC_CANCEL;
+            cancel->fd = -1;
+            cancel->addr = i;
+            cancel->user_data = UINT64_MAX;
+        }
+    }
+}
+
+
+
+/**
+ * Puts a file and a socket in the fixed file slots.
+ * @param file - the file, or -1 to empty its slot.
+ * @param sock - the socket, or -1 to empty its slot.
+ * @return bool - true if both slots were filled.
+ */
+bool IoRing::setFiles(int file, int sock) {
+    int fds[FILE_SLOTS] = { file, sock };
+    struct io_uring_files_update update;
+    memset(&update, 0, sizeof(update));
+    update.fds = (uint64_t) (uintptr_t) fds;
+
+    return syscall(__NR_io_uring_register, this->ringFd, IORING_REGISTER_FILES_UPDATE, &update, FILE_SLOTS) == FILE_SLOTS;
+}
+
+
+
+/**
+ * Sends whatever a send that was cut short didn't, with ordinary blocking sends.
+ * @param sock - the socket.
+ * @param send - the send, with its result.
+ * @return bool - false if the rest couldn't be sent.
+ */
+bool IoRing::finishSend(int sock, const Operation &send) {
+    return sendAll(sock, send.data + send.result, send.length - send.result);
+}
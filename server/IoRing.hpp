@@ -0,0 +1,92 @@
+/**
+ * Program Name: FTP Server
+ * File Name: IoRing.hpp
+ * Author: Taylor Jones
+ * Last Modified: 10/16/26
+ * Description: IoRing.hpp is the class specification
+ *  file for the IoRing class. This file contains declarations
+ *  for the member functions of the IoRing class.
+ */
+
+
+#ifndef IoRing_hpp
+#define IoRing_hpp
+
+#include <cstddef>
+#include <cstdint>
+#include <linux/io_uring.h>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+
+class IoRing {
+  // Member Variables
+  private:
+    /**
+     * One operation of a submitted batch, and how it went.
+     */
+    struct Operation {
+        uint8_t opcode;
+        const char *data;       // the bytes a send sends (or a read reads into)
+        size_t length;          // the bytes it should have moved
+        off_t resumeAt;         // for a send: where in the file to carry on once it is done
+        int result;             // the completion's result, once it has come in
+        bool completed;
+    };
+
+    static const unsigned RING_ENTRIES = 32;                // room for a batch, and a cancellation for each of its operations
+    static const unsigned BUFFER_COUNT = 4;                 // the registered buffers, each read into and sent from in turn
+    static const size_t BUFFER_SIZE = 256 * 1024;
+    static const int FILE_SLOTS = 2;                        // the fixed files: the file being sent, and the socket
+
+    int ringFd;
+    unsigned *sqHead;
+    unsigned *sqTail;
+    unsigned sqMask;
+    unsigned *sqArray;
+    struct io_uring_sqe *sqes;
+    unsigned *cqHead;
+    unsigned *cqTail;
+    unsigned cqMask;
+    struct io_uring_cqe *cqes;
+
+    void *ringMemory;               // the submission and completion rings, mapped together
+    size_t ringMemorySize;
+    size_t sqesSize;
+    char *buffers;                  // BUFFER_COUNT buffers of BUFFER_SIZE bytes
+    bool buffersRegistered;         // true if reads can use the buffers as fixed buffers
+    bool filesRegistered;           // true if the file and socket can be used as fixed files
+
+    vector<Operation> operations;   // the batch being built (or waited on)
+    struct __kernel_timespec sendTimeout;   // how long a batch may go without anything completing
+    int clearedFiles[FILE_SLOTS];   // -1s, for the update that releases the fixed files
+    unsigned queued;                // the entries added to the submission ring but not yet submitted
+
+  // Member Functions
+  private:
+    bool setUp();
+    struct io_uring_sqe *prepare(uint8_t opcode, int fd, bool fixedFile, const char *data, size_t length);
+    struct io_uring_sqe *nextSqe();
+    void prepareSend(int sock, bool fixedFile, const char *data, size_t length, off_t resumeAt, bool more);
+    bool submitAndWait();
+    size_t reap();
+    void cancelPending();
+    bool setFiles(int file, int sock);
+    bool finishSend(int sock, const Operation &send);
+
+  public:
+    IoRing();
+    ~IoRing();
+
+    bool isReady() const;
+    bool sendFile(int sock, int fd, off_t offset, off_t length, string &header, int timeoutSeconds);
+
+    static IoRing *forThread();
+};
+
+
+#endif /* IoRing_hpp */
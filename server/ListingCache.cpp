@@ -0,0 +1,402 @@
+/**
+ * Program Name: FTP Server
+ * File Name: ListingCache.cpp
+ * Author: Taylor Jones
+ * Last Modified: 10/16/26
+ * Description: ListingCache.cpp is the class implementation
+ *  file for the ListingCache class.
+ *
+ *  The cache keeps fully rendered directory listing responses, keyed by
+ *  the listing flags and framing, so a repeated listing is a single send.
+ *  Every directory in the served tree is watched with inotify from the
+ *  start, so a change is never missed: a change to the served directory
+ *  drops its listings, and a change anywhere in the tree drops the
+ *  recursive ones. Changes to a file's contents only drop listings that
+ *  show sizes.
+ *
+ *  Workers fill the cache. A fill remembers the epoch it started in, and
+ *  is thrown away if anything was invalidated while it was being built.
+ *
+ *  Directories that appear later, and the whole tree after a directory is
+ *  moved or events are lost, are watched by a worker, so the event loop
+ *  only ever reads events.
+ */
+
+
+#include <cerrno>
+#include <cstdio>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include "ListingCache.hpp"
+
+
+const uint32_t TREE_EVENTS = IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF;
+const uint32_t CONTENT_EVENTS = IN_MODIFY | IN_ATTRIB;
+
+
+/**
+ * Starts watching the served directory (the working directory) and every
+ * directory below it.
+ * @param pool - the workers that later changes to the tree are watched on.
+ */
+ListingCache::ListingCache(ThreadPool &pool) : pool(pool) {
+    this->treeWatched = true;
+    this->watcherRunning = false;
+    this->rootWd = -1;
+    this->epoch = 0;
+    this->inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+    if (this->inotifyFd < 0) {
+        perror("Listing cache disabled: inotify_init1()");
+        return;
+    }
+
+    this->watchTree(".");
+}
+
+
+
+/**
+ * Waits for the watcher task to finish, and then closes the inotify
+ * instance, which removes every watch.
+ */
+ListingCache::~ListingCache() {
+    {
+        std::unique_lock<std::mutex> guard(this->lock);
+        this->watcherDone.wait(guard, [this]() { return !this->watcherRunning; });
+    }
+
+    if (this->inotifyFd >= 0) {
+        close(this->inotifyFd);
+    }
+}
+
+
+
+/**
+ * Builds the cache key for a listing.
+ * @return string - the key.
+ */
+string ListingCache::keyFor(bool showHidden, bool showSize, bool showRecursive, int framing, int compression) {
+    return string(showHidden ? "a" : "-") + (showSize ? "s" : "-") + (showRecursive ? "r" : "-") + std::to_string(framing) +
+        "z" + std::to_string(compression);
+}
+
+
+
+/**
+ * @return int - the inotify descriptor for the event loop to watch, or -1.
+ */
+int ListingCache::getFd() const {
+    return this->inotifyFd;
+}
+
+
+
+/**
+ * @return size_t - the size of the largest listing that is cached.
+ */
+size_t ListingCache::getMaxEntrySize() const {
+    return MAX_ENTRY_SIZE;
+}
+
+
+
+/**
+ * Watches one directory. Watching a directory that is already watched just
+ * returns its existing watch, whose path is brought up to date.
+ * @param path - the directory to watch.
+ * @return bool - true if the directory is watched.
+ */
+bool ListingCache::watchDirectory(const string &path) {
+    int wd = inotify_add_watch(this->inotifyFd, path.c_str(), TREE_EVENTS | CONTENT_EVENTS | IN_ONLYDIR | IN_DONT_FOLLOW);
+    if (wd < 0) {
+        if (errno != ENOENT) {
+            this->stopTrustingTree("inotify_add_watch()");
+        }
+        return false;
+    }
+
+    std::lock_guard<std::mutex> guard(this->lock);
+    this->watches[wd] = path;
+    if (path == ".") {
+        this->rootWd = wd;
+    }
+    return true;
+}
+
+
+
+/**
+ * Watches a directory and every directory below it. The walk keeps an explicit
+ * stack of open directories, each opened with openat() relative to its parent,
+ * so a deep tree can't overflow the stack and only one descriptor is held per
+ * level. Each directory is watched before it is read, so a directory created
+ * in it while it is being read is either read or reported by an event.
+ * The caller must not hold the lock.
+ * @param path - the directory to watch.
+ */
+void ListingCache::watchTree(const string &path) {
+    struct Frame {
+        DIR *dir;
+        string path;
+    };
+    vector<Frame> stack;
+
+    if (!this->watchDirectory(path)) {
+        return;
+    }
+
+    int fd = open(path.c_str(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+    DIR *dir = fd < 0 ? NULL : fdopendir(fd);
+    if (dir == NULL) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        return;
+    }
+    stack.push_back({dir, path});
+
+    while (!stack.empty()) {
+        struct dirent *entry = readdir(stack.back().dir);
+        if (entry == NULL) {
+            closedir(stack.back().dir);
+            stack.pop_back();
+            continue;
+        }
+
+        const string name = entry->d_name;
+        if (entry->d_type != DT_DIR || name == "." || name == "..") {
+            continue;
+        }
+
+        const string childPath = stack.back().path + "/" + name;
+        if (!this->watchDirectory(childPath)) {
+            continue;
+        }
+
+        int childFd = openat(dirfd(stack.back().dir), name.c_str(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+        DIR *childDir = childFd < 0 ? NULL : fdopendir(childFd);
+        if (childDir == NULL) {
+            if (errno == EMFILE || errno == ENFILE) {
+                // the directories below this one can't be watched.
+                this->stopTrustingTree("openat()");
+            }
+            if (childFd >= 0) {
+                close(childFd);
+            }
+            continue;
+        }
+        stack.push_back({childDir, childPath});
+    }
+}
+
+
+
+/**
+ * Runs on a worker: watches the queued directories until none are left. Recursive
+ * listings aren't cached while it runs, since changes in the directories it hasn't
+ * reached yet would go unnoticed.
+ */
+void ListingCache::watchPending() {
+    std::unique_lock<std::mutex> guard(this->lock);
+
+    while (!this->toWatch.empty()) {
+        vector<string> paths;
+        paths.swap(this->toWatch);
+        guard.unlock();
+
+        for (const auto &path : paths) {
+            this->watchTree(path);
+        }
+
+        guard.lock();
+        // a fill that began during the walk may have missed a change it didn't see an event for.
+        this->invalidate(true, false);
+    }
+
+    this->watcherRunning = false;
+    this->watcherDone.notify_all();
+}
+
+
+
+/**
+ * Queues a directory (and everything below it) to be watched by a worker,
+ * so that walking a large tree never holds up the event loop.
+ * The caller must hold the lock.
+ * @param path - the directory to watch, or "." to watch the whole tree again.
+ */
+void ListingCache::queueWatch(const string &path) {
+    if (path == ".") {
+        this->toWatch.clear();
+    } else {
+        for (const auto &queued : this->toWatch) {
+            if (queued == ".") {
+                return;
+            }
+        }
+    }
+
+    this->toWatch.push_back(path);
+}
+
+
+
+/**
+ * Stops caching recursive listings, since changes below a directory that
+ * couldn't be watched would go unnoticed. The caller must not hold the lock.
+ * @param call - the call that failed, for the message.
+ */
+void ListingCache::stopTrustingTree(const char *call) {
+    const int error = errno;
+    std::lock_guard<std::mutex> guard(this->lock);
+
+    if (this->treeWatched) {
+        errno = error;
+        perror((string("Recursive listings will not be cached: ") + call).c_str());
+        this->treeWatched = false;
+    }
+}
+
+
+
+/**
+ * Reads every pending inotify event and drops the listings it affects.
+ * The caller must hold the lock.
+ */
+void ListingCache::drainEvents() {
+    alignas(struct inotify_event) char buffer[64 * 1024];
+    ssize_t length;
+
+    while ((length = read(this->inotifyFd, buffer, sizeof(buffer))) > 0) {
+        for (char *next = buffer; next < buffer + length; ) {
+            const struct inotify_event *event = (const struct inotify_event *) next;
+            next += sizeof(struct inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                // events were lost, so nothing can be trusted, including the watches.
+                this->invalidate(false, false);
+                this->queueWatch(".");
+                continue;
+            }
+
+            if (event->mask & IN_IGNORED) {
+                this->watches.erase(event->wd);
+                continue;
+            }
+
+            auto watched = this->watches.find(event->wd);
+            if (watched == this->watches.end()) {
+                continue;
+            }
+
+            const bool contentOnly = !(event->mask & TREE_EVENTS);
+            this->invalidate(event->wd != this->rootWd, contentOnly);
+
+            if ((event->mask & IN_ISDIR) && (event->mask & IN_CREATE) && event->len > 0) {
+                this->queueWatch(watched->second + "/" + event->name);
+            } else if ((event->mask & IN_ISDIR) && (event->mask & (IN_MOVED_FROM | IN_MOVED_TO))) {
+                // the watched paths below a moved directory are out of date.
+                this->queueWatch(".");
+            }
+        }
+    }
+
+    if (!this->toWatch.empty() && !this->watcherRunning) {
+        this->watcherRunning = true;
+        this->pool.submit([this]() { this->watchPending(); });
+    }
+}
+
+
+
+/**
+ * Drops cached listings.
+ * @param recursiveOnly - true to keep the listings of the served directory itself.
+ * @param sizesOnly - true to keep the listings that don't show sizes.
+ */
+void ListingCache::invalidate(bool recursiveOnly, bool sizesOnly) {
+    this->epoch++;
+
+    for (auto it = this->entries.begin(); it != this->entries.end(); ) {
+        if ((recursiveOnly && !it->second.recursive) || (sizesOnly && !it->second.sizes)) {
+            ++it;
+        } else {
+            it = this->entries.erase(it);
+        }
+    }
+}
+
+
+
+/**
+ * Looks up a rendered listing.
+ * @param key - the listing's key, from keyFor().
+ * @param fillEpoch - holds the epoch to pass to insert() if the listing isn't cached.
+ * @return shared_ptr<const ListingBody> - the cached response, or null.
+ */
+shared_ptr<const ListingBody> ListingCache::find(const string &key, uint64_t &fillEpoch) {
+    std::lock_guard<std::mutex> guard(this->lock);
+
+    if (this->inotifyFd < 0) {
+        return nullptr;
+    }
+
+    this->drainEvents();
+    fillEpoch = this->epoch;
+
+    auto found = this->entries.find(key);
+    return found == this->entries.end() ? nullptr : found->second.body;
+}
+
+
+
+/**
+ * Caches a rendered listing, unless something changed since the
+ * listing was looked up (in which case it may already be out of date).
+ * @param key - the listing's key, from keyFor().
+ * @param fillEpoch - the epoch that find() returned.
+ * @param body - the complete response.
+ * @param recursive - true if the listing covers the whole tree.
+ * @param sizes - true if the listing shows file sizes.
+ */
+void ListingCache::insert(const string &key, uint64_t fillEpoch, shared_ptr<const ListingBody> body, bool recursive, bool sizes) {
+    size_t size = 0;
+    for (const auto &buffer : *body) {
+        size += buffer.size();
+    }
+
+    std::lock_guard<std::mutex> guard(this->lock);
+
+    if (this->inotifyFd < 0 || size > MAX_ENTRY_SIZE) {
+        return;
+    }
+
+    this->drainEvents();
+    if (this->epoch != fillEpoch || (recursive && (!this->treeWatched || this->watcherRunning))) {
+        return;
+    }
+
+    Entry entry;
+    entry.body = body;
+    entry.recursive = recursive;
+    entry.sizes = sizes;
+    this->entries[key] = entry;
+}
+
+
+
+/**
+ * Reads inotify events as they arrive, so the kernel's queue can't overflow
+ * while no listings are being requested.
+ * @param fd - the inotify descriptor.
+ * @param events - the epoll events that occurred.
+ */
+void ListingCache::handleEvent(int fd, uint32_t events) {
+    std::lock_guard<std::mutex> guard(this->lock);
+    this->drainEvents();
+}
@@ -0,0 +1,88 @@
+/**
+ * Program Name: FTP Server
+ * File Name: ListingCache.hpp
+ * Author: Taylor Jones
+ * Last Modified: 10/16/26
+ * Description: ListingCache.hpp is the class specification
+ *  file for the ListingCache class. This file contains declarations
+ *  for the member functions of the ListingCache class.
+ */
+
+
+#ifndef ListingCache_hpp
+#define ListingCache_hpp
+
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "EventLoop.hpp"
+#include "ThreadPool.hpp"
+
+using std::map;
+using std::shared_ptr;
+using std::string;
+using std::unordered_map;
+using std::vector;
+
+
+/**
+ * A rendered listing response, kept in the buffers it was built in
+ * so that it can be sent with one vectored write.
+ */
+typedef vector<string> ListingBody;
+
+
+class ListingCache : public EventHandler {
+  // Member Variables
+  private:
+    struct Entry {
+        shared_ptr<const ListingBody> body;     // the complete response, ready to send
+        bool recursive;                 // true if the listing covers the whole tree
+        bool sizes;                     // true if the listing shows file sizes
+    };
+
+    const size_t MAX_ENTRY_SIZE = 8 * 1024 * 1024;  // larger listings are rendered every time
+
+    ThreadPool &pool;                   // runs the tree walks, so the event loop never does
+    std::mutex lock;                    // guards everything below; workers share the cache
+    std::condition_variable watcherDone;    // signalled when the watcher task finishes
+    int inotifyFd;                      // -1 if inotify isn't available (nothing is cached)
+    bool treeWatched;                   // false if some directory couldn't be watched (-lr isn't cached)
+    bool watcherRunning;                // true while a worker is watching the paths in toWatch
+    vector<string> toWatch;             // directories (with everything below them) still to be watched
+    int rootWd;                         // the watch on the served directory itself
+    uint64_t epoch;                     // incremented on every invalidation
+    unordered_map<int, string> watches; // watch descriptor -> directory path
+    map<string, Entry> entries;
+
+  // Member Functions
+  private:
+    bool watchDirectory(const string &path);
+    void watchTree(const string &path);
+    void watchPending();
+    void queueWatch(const string &path);
+    void stopTrustingTree(const char *call);
+    void drainEvents();
+    void invalidate(bool recursiveOnly, bool sizesOnly);
+
+  public:
+    explicit ListingCache(ThreadPool &pool);
+    ~ListingCache();
+
+    static string keyFor(bool showHidden, bool showSize, bool showRecursive, int framing, int compression = 0);
+
+    int getFd() const;
+    size_t getMaxEntrySize() const;
+    shared_ptr<const ListingBody> find(const string &key, uint64_t &fillEpoch);
+    void insert(const string &key, uint64_t fillEpoch, shared_ptr<const ListingBody> body, bool recursive, bool sizes);
+    void handleEvent(int fd, uint32_t events) override;
+};
+
+
+#endif /* ListingCache_hpp */
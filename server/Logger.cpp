@@ -0,0 +1,487 @@
+/**
+ * Program Name: FTP Server
+ * File Name: Logger.cpp
+ * Author: Taylor Jones
+ * Last Modified: 10/16/26
+ * Description: Logger.cpp is the class implementation
+ *  file for the Logger class.
+ *
+ *  Logging a message costs the calling thread a clock read and a copy of
+ *  the arguments into a fixed-size record in its own ring buffer, with no
+ *  lock, no allocation and no formatting. A flusher thread wakes every
+ *  FLUSH_INTERVAL_MS (or sooner, once a ring is half full, or when asked
+ *  to flush), takes the records from every ring in the order they were
+ *  logged, formats them, and writes them out with one write() per stream.
+ *
+ *  The console text is what the server has always printed: errors and
+ *  warnings go to stderr and the rest to stdout. If a JSON lines file is
+ *  given, every message is also written there as one JSON object, with its
+ *  time, level, event name and arguments.
+ */
+
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "Logger.hpp"
+
+
+std::atomic<uint64_t> Logger::nextId(1);
+thread_local Logger::Ring *Logger::threadRing = nullptr;
+thread_local uint64_t Logger::threadRingOwner = 0;
+
+
+static const char *LEVEL_NAMES[] = { "debug", "info", "warn", "error", "off" };
+
+static const LogEvent DROPPED_EVENT = {
+    LOG_WARN, "log_dropped", "Log buffer full: {} messages dropped.", { "count" }
+};
+
+
+
+/**
+ * Writes a whole buffer to a file descriptor, ignoring failures
+ * (there is nowhere left to report them).
+ * @param fd - where to write.
+ * @param data - the text.
+ */
+static void writeText(int fd, const string &data) {
+    size_t done = 0;
+    while (done < data.size()) {
+        ssize_t count = write(fd, data.data() + done, data.size() - done);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            return;
+        }
+        done += count;
+    }
+}
+
+
+
+/**
+ * Appends a string to JSON text as a quoted, escaped JSON string.
+ * @param value - the string.
+ * @param out - the JSON text.
+ */
+static void appendJsonString(string_view value, string &out) {
+    out.push_back('"');
+    for (char c : value) {
+        if (c == '"' || c == '\\') {
+            out.push_back('\\');
+            out.push_back(c);
+        } else if (c == '\n') {
+            out.append("\\n");
+        } else if ((unsigned char) c < 0x20) {
+            char escaped[8];
+            snprintf(escaped, sizeof(escaped), "\\u%04x", (unsigned) (unsigned char) c);
+            out.append(escaped);
+        } else {
+            out.push_back(c);
+        }
+    }
+    out.push_back('"');
+}
+
+
+
+/**
+ * Creates a logger and starts its flusher thread.
+ * @param level - the least important messages to log.
+ * @param fullPolicy - what a thread does when its buffer is full.
+ * @param jsonPath - a file to append JSON lines to, or an empty string for none.
+ */
+Logger::Logger(LogLevel level, LogFullPolicy fullPolicy, const string &jsonPath) : dropped(0), running(true) {
+    static_assert(sizeof(Record) == RECORD_SIZE, "a record fills RECORD_SIZE exactly");
+    static_assert(sizeof(LogEvent::fields) / sizeof(LogEvent::fields[0]) == MAX_ARGS, "every argument has a field name");
+
+    this->id = nextId++;
+    this->level = level;
+    this->fullPolicy = fullPolicy;
+    this->jsonFd = -1;
+    this->flushRequests = 0;
+    this->flushesDone = 0;
+    this->droppedReported = 0;
+    this->stopping = false;
+
+    if (!jsonPath.empty()) {
+        this->jsonFd = open(jsonPath.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        if (this->jsonFd < 0) {
+            perror(("Log messages can't be saved to " + jsonPath + ": open()").c_str());
+        }
+    }
+
+    this->flusher = std::thread(&Logger::flusherLoop, this);
+}
+
+
+
+/**
+ * Writes out every message logged so far, and stops the flusher thread.
+ */
+Logger::~Logger() {
+    this->stop();
+
+    if (this->jsonFd >= 0) {
+        close(this->jsonFd);
+    }
+}
+
+
+
+/**
+ * Writes out every message logged so far, and stops the flusher thread.
+ * Messages logged after this are dropped.
+ */
+void Logger::stop() {
+    this->running = false;
+    {
+        std::lock_guard<std::mutex> guard(this->lock);
+        this->stopping = true;
+    }
+    this->wakeup.notify_one();
+
+    if (this->flusher.joinable()) {
+        this->flusher.join();
+    }
+}
+
+
+
+/**
+ * Waits until every message logged so far has been written out.
+ */
+void Logger::flush() {
+    std::unique_lock<std::mutex> guard(this->lock);
+    if (!this->flusher.joinable() || this->stopping) {
+        return;
+    }
+
+    const uint64_t request = ++this->flushRequests;
+    this->wakeup.notify_one();
+    this->flushed.wait(guard, [&]() { return this->flushesDone >= request; });
+}
+
+
+
+/**
+ * @return uint64_t - the messages dropped so far because a buffer was full.
+ */
+uint64_t Logger::getDropped() const {
+    return this->dropped.load(std::memory_order_relaxed);
+}
+
+
+
+/**
+ * @return Ring& - the calling thread's ring, which is created the first time the thread logs.
+ */
+Logger::Ring &Logger::getRing() {
+    if (threadRingOwner != this->id) {
+        std::lock_guard<std::mutex> guard(this->lock);
+        this->rings.push_back(unique_ptr<Ring>(new Ring()));
+        threadRing = this->rings.back().get();
+        threadRingOwner = this->id;
+    }
+
+    return *threadRing;
+}
+
+
+
+/**
+ * Finds room for a record in a ring: the slot after the tail, once the
+ * flusher has written out what was there.
+ * @param ring - the calling thread's ring.
+ * @return Record* - the slot, or null if the message is dropped.
+ */
+Logger::Record *Logger::reserve(Ring &ring) {
+    const size_t tail = ring.tail.load(std::memory_order_relaxed);
+
+    while (tail - ring.head.load(std::memory_order_acquire) >= RING_SIZE) {
+        if (this->fullPolicy == LOG_DROP || !this->running.load(std::memory_order_relaxed)) {
+            this->dropped.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        this->wakeup.notify_one();
+        std::this_thread::yield();
+    }
+
+    return &ring.records[tail % RING_SIZE];
+}
+
+
+
+/**
+ * Hands the record after the tail to the flusher, waking the flusher
+ * early if the ring has just become half full.
+ * @param ring - the calling thread's ring.
+ */
+void Logger::commit(Ring &ring) {
+    const size_t tail = ring.tail.load(std::memory_order_relaxed) + 1;
+    ring.tail.store(tail, std::memory_order_release);
+
+    if (tail - ring.head.load(std::memory_order_relaxed) == RING_SIZE / 2) {
+        this->wakeup.notify_one();
+    }
+}
+
+
+
+/**
+ * Copies a text argument into a record.
+ * @param record - the record being logged.
+ * @param value - the text.
+ */
+void Logger::addArg(Record &record, string_view value) {
+    Arg &arg = record.args[record.argCount++];
+    const size_t length = std::min(value.size(), TEXT_SIZE - record.textUsed);
+
+    arg.type = ARG_TEXT;
+    arg.length = length;
+    arg.value = record.textUsed;
+    memcpy(record.text + record.textUsed, value.data(), length);
+    record.textUsed += length;
+}
+
+
+
+/**
+ * Copies a text argument into a record.
+ * @param record - the record being logged.
+ * @param value - the text, or null for none.
+ */
+void Logger::addArg(Record &record, const char *value) {
+    addArg(record, value != nullptr ? string_view(value) : string_view());
+}
+
+
+
+/**
+ * Adds an errno value to a record.
+ * @param record - the record being logged.
+ * @param value - the errno value.
+ */
+void Logger::addArg(Record &record, LogErrno value) {
+    Arg &arg = record.args[record.argCount++];
+    arg.type = ARG_ERRNO;
+    arg.length = 0;
+    arg.value = value.code;
+}
+
+
+
+/**
+ * Writes out what the threads have logged until the logger is stopped,
+ * and then everything that is left.
+ */
+void Logger::flusherLoop() {
+    std::unique_lock<std::mutex> guard(this->lock);
+
+    for (;;) {
+        if (!this->stopping && this->flushRequests == this->flushesDone) {
+            this->wakeup.wait_for(guard, std::chrono::milliseconds((long) FLUSH_INTERVAL_MS));
+        }
+
+        const bool finishing = this->stopping;
+        const uint64_t requests = this->flushRequests;
+        vector<Ring *> current;
+        for (const auto &ring : this->rings) {
+            current.push_back(ring.get());
+        }
+
+        guard.unlock();
+        this->writeOut(current);
+        guard.lock();
+
+        this->flushesDone = requests;
+        this->flushed.notify_all();
+        if (finishing) {
+            return;
+        }
+    }
+}
+
+
+
+/**
+ * Formats and writes out every record the rings hold, in the order they
+ * were logged, and then frees their slots.
+ * @param current - the rings.
+ */
+void Logger::writeOut(const vector<Ring *> &current) {
+    struct Pending {
+        const Record *record;
+        uint64_t time;
+    };
+
+    vector<Pending> pending;
+    vector<size_t> tails(current.size());
+    for (size_t i = 0; i < current.size(); i++) {
+        Ring &ring = *current[i];
+        tails[i] = ring.tail.load(std::memory_order_acquire);
+
+        for (size_t position = ring.head.load(std::memory_order_relaxed); position < tails[i]; position++) {
+            const Record &record = ring.records[position % RING_SIZE];
+            pending.push_back({ &record, (uint64_t) record.time.tv_sec * 1000000000 + record.time.tv_nsec });
+        }
+    }
+    std::stable_sort(pending.begin(), pending.end(), [](const Pending &a, const Pending &b) { return a.time < b.time; });
+
+    // report any messages dropped since the last pass, after the ones that made it.
+    Record droppedRecord;
+    const uint64_t droppedCount = this->dropped.load(std::memory_order_relaxed) - this->droppedReported;
+    this->droppedReported += droppedCount;
+    if (droppedCount > 0 && this->isEnabled(DROPPED_EVENT.level)) {
+        droppedRecord.event = &DROPPED_EVENT;
+        clock_gettime(CLOCK_REALTIME, &droppedRecord.time);
+        droppedRecord.argCount = 0;
+        droppedRecord.textUsed = 0;
+        addArg(droppedRecord, droppedCount);
+        pending.push_back({ &droppedRecord, 0 });
+    }
+
+    // consecutive messages for the same stream are written together; switching streams
+    // writes out what came before, so stdout and stderr still interleave in order.
+    string text, json;
+    int textFd = STDOUT_FILENO;
+    for (const auto &entry : pending) {
+        const int fd = entry.record->event->level >= LOG_WARN ? STDERR_FILENO : STDOUT_FILENO;
+        if (fd != textFd) {
+            writeText(textFd, text);
+            text.clear();
+            textFd = fd;
+        }
+
+        this->formatText(*entry.record, text);
+        if (this->jsonFd >= 0) {
+            this->formatJson(*entry.record, json);
+        }
+    }
+    writeText(textFd, text);
+    if (this->jsonFd >= 0) {
+        writeText(this->jsonFd, json);
+    }
+
+    for (size_t i = 0; i < current.size(); i++) {
+        current[i]->head.store(tails[i], std::memory_order_release);
+    }
+}
+
+
+
+/**
+ * Appends one of a record's arguments, as text.
+ * @param record - the record.
+ * @param index - the argument.
+ * @param out - the text to append to.
+ */
+void Logger::formatArg(const Record &record, size_t index, string &out) const {
+    const Arg &arg = record.args[index];
+    char digits[24];
+
+    if (arg.type == ARG_TEXT) {
+        out.append(record.text + arg.value, arg.length);
+    } else if (arg.type == ARG_ERRNO) {
+        out.append(strerror((int) arg.value));
+    } else if (arg.type == ARG_UNSIGNED) {
+        out.append(digits, std::to_chars(digits, digits + sizeof(digits), (uint64_t) arg.value).ptr);
+    } else {
+        out.append(digits, std::to_chars(digits, digits + sizeof(digits), arg.value).ptr);
+    }
+}
+
+
+
+/**
+ * Appends a record's console text: its event's format, with each {}
+ * replaced by the next argument, and a newline.
+ * @param record - the record.
+ * @param out - the text to append to.
+ */
+void Logger::formatText(const Record &record, string &out) const {
+    const char *format = record.event->format;
+
+    for (size_t argument = 0; argument < record.argCount; argument++) {
+        const char *placeholder = strstr(format, "{}");
+        if (placeholder == nullptr) {
+            break;
+        }
+        out.append(format, placeholder - format);
+        this->formatArg(record, argument, out);
+        format = placeholder + 2;
+    }
+    out.append(format);
+    out.push_back('\n');
+}
+
+
+
+/**
+ * Appends a record as a line of JSON: its time (UTC, to the microsecond),
+ * level, event name, each argument under its field name, and the console
+ * text as "message".
+ * @param record - the record.
+ * @param out - the JSON text to append to.
+ */
+void Logger::formatJson(const Record &record, string &out) const {
+    char time[64];
+    struct tm parts;
+
+    gmtime_r(&record.time.tv_sec, &parts);
+    size_t length = strftime(time, sizeof(time), "%Y-%m-%dT%H:%M:%S", &parts);
+    snprintf(time + length, sizeof(time) - length, ".%06ldZ", record.time.tv_nsec / 1000);
+
+    out.append("{\"time\":\"").append(time).append("\",\"level\":\"").append(LEVEL_NAMES[record.event->level]);
+    out.append("\",\"event\":\"").append(record.event->name).append("\"");
+
+    for (size_t i = 0; i < record.argCount; i++) {
+        const char *field = record.event->fields[i] != nullptr ? record.event->fields[i] : "arg";
+        out.append(",");
+        appendJsonString(field, out);
+        out.append(":");
+
+        string value;
+        this->formatArg(record, i, value);
+        if (record.args[i].type == ARG_INT || record.args[i].type == ARG_UNSIGNED) {
+            out.append(value);
+        } else {
+            appendJsonString(value, out);
+        }
+    }
+
+    string message;
+    this->formatText(record, message);
+    const size_t start = message.find_first_not_of('\n');
+    const size_t end = message.find_last_not_of('\n');
+    out.append(",\"message\":");
+    appendJsonString(start == string::npos ? string_view() : string_view(message).substr(start, end - start + 1), out);
+    out.append("}\n");
+}
+
+
+
+/**
+ * Reads a level's name.
+ * @param name - "debug", "info", "warn", "error" or "off".
+ * @param level - holds the level.
+ * @return bool - false if the name isn't a level.
+ */
+bool Logger::parseLevel(const string &name, LogLevel &level) {
+    for (int i = LOG_DEBUG; i <= LOG_OFF; i++) {
+        if (name == LEVEL_NAMES[i]) {
+            level = (LogLevel) i;
+            return true;
+        }
+    }
+
+    return false;
+}
@@ -0,0 +1,211 @@
+/**
+ * Program Name: FTP Server
+ * File Name: Logger.hpp
+ * Author: Taylor Jones
+ * Last Modified: 10/16/26
+ * Description: Logger.hpp is the class specification
+ *  file for the Logger class. This file contains declarations
+ *  for the member functions of the Logger class, and the
+ *  events that are logged through it.
+ */
+
+
+#ifndef Logger_hpp
+#define Logger_hpp
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+using std::string;
+using std::string_view;
+using std::unique_ptr;
+using std::vector;
+
+
+/**
+ * How important a message is. Messages below the logger's level are skipped.
+ */
+enum LogLevel {
+    LOG_DEBUG,
+    LOG_INFO,
+    LOG_WARN,
+    LOG_ERROR,
+    LOG_OFF
+};
+
+
+/**
+ * What a thread does when its buffer is full because the flusher has
+ * fallen behind: drop the message (and count it), or wait for room.
+ */
+enum LogFullPolicy {
+    LOG_DROP,
+    LOG_BLOCK
+};
+
+
+/**
+ * A kind of message. Each is declared once, as a constant, and a logged
+ * message only holds which event it is and its arguments. The text isn't
+ * put together until the flusher writes it out.
+ */
+struct LogEvent {
+    LogLevel level;
+    const char *name;           // the event's name in JSON lines
+    const char *format;         // the console text, with a {} for each argument in turn
+    const char *fields[6];      // the arguments' names in JSON lines
+};
+
+
+/**
+ * An errno value, logged as the text strerror() gives for it.
+ */
+struct LogErrno {
+    int code;
+};
+
+
+class Logger {
+  // Member Variables
+  public:
+    static const size_t MAX_ARGS = 6;       // as many as LogEvent has field names
+
+  private:
+    enum ArgType { ARG_INT, ARG_UNSIGNED, ARG_TEXT, ARG_ERRNO };
+
+    struct Arg {
+        uint32_t type;
+        uint32_t length;        // for text, its length; the text itself is in the record
+        int64_t value;          // a number, or the offset of the text in the record
+    };
+
+    static const size_t RECORD_SIZE = 512;
+    static const size_t TEXT_SIZE = RECORD_SIZE - 32 - MAX_ARGS * sizeof(Arg);
+
+    struct Record {
+        const LogEvent *event;
+        struct timespec time;
+        uint32_t argCount;
+        uint32_t textUsed;
+        Arg args[MAX_ARGS];
+        char text[TEXT_SIZE];   // the text arguments, one after another; long ones are cut short
+    };
+
+    static const size_t RING_SIZE = 1024;       // records per thread
+    static const int FLUSH_INTERVAL_MS = 50;
+
+    /**
+     * One thread's records. Only the thread writes records and moves the
+     * tail; only the flusher reads them and moves the head.
+     */
+    struct Ring {
+        alignas(64) std::atomic<size_t> head;
+        alignas(64) std::atomic<size_t> tail;
+        Record records[RING_SIZE];
+
+        Ring() : head(0), tail(0) {}
+    };
+
+    static std::atomic<uint64_t> nextId;
+    static thread_local Ring *threadRing;           // the calling thread's ring...
+    static thread_local uint64_t threadRingOwner;   // ...and the id of the logger it belongs to
+
+    uint64_t id;
+    LogLevel level;
+    LogFullPolicy fullPolicy;
+    int jsonFd;                         // the JSON lines file, or -1 for none
+    std::atomic<uint64_t> dropped;      // messages dropped because a buffer was full
+    uint64_t droppedReported;           // the dropped messages the flusher has reported so far
+    std::atomic<bool> running;
+
+    std::mutex lock;                    // guards everything below
+    std::condition_variable wakeup;     // wakes the flusher
+    std::condition_variable flushed;    // wakes the threads waiting in flush()
+    vector<unique_ptr<Ring>> rings;
+    uint64_t flushRequests;
+    uint64_t flushesDone;
+    bool stopping;
+    std::thread flusher;
+
+  // Member Functions
+  private:
+    Ring &getRing();
+    Record *reserve(Ring &ring);
+    void commit(Ring &ring);
+    void flusherLoop();
+    void writeOut(const vector<Ring *> &current);
+    void formatText(const Record &record, string &out) const;
+    void formatJson(const Record &record, string &out) const;
+    void formatArg(const Record &record, size_t index, string &out) const;
+
+    template <typename T>
+    static typename std::enable_if<std::is_integral<T>::value>::type addArg(Record &record, T value) {
+        Arg &arg = record.args[record.argCount++];
+        arg.type = std::is_signed<T>::value ? ARG_INT : ARG_UNSIGNED;
+        arg.length = 0;
+        arg.value = (int64_t) value;
+    }
+    static void addArg(Record &record, string_view value);
+    static void addArg(Record &record, const char *value);
+    static void addArg(Record &record, LogErrno value);
+
+  public:
+    Logger(LogLevel level, LogFullPolicy fullPolicy, const string &jsonPath);
+    ~Logger();
+
+    /**
+     * @return bool - true if messages of a level are logged.
+     */
+    bool isEnabled(LogLevel level) const {
+        return level >= this->level;
+    }
+
+    template <typename... Args>
+    void log(const LogEvent &event, const Args &... args);
+    void flush();
+    void stop();
+    uint64_t getDropped() const;
+
+    static bool parseLevel(const string &name, LogLevel &level);
+};
+
+
+
+/**
+ * Logs a message. The arguments are copied into the calling thread's
+ * buffer as they are; the flusher thread formats and writes them later.
+ * @param event - the kind of message.
+ * @param args - the message's arguments: integers, strings, or a LogErrno.
+ */
+template <typename... Args>
+void Logger::log(const LogEvent &event, const Args &... args) {
+    static_assert(sizeof...(Args) <= MAX_ARGS, "a log message has at most MAX_ARGS arguments");
+    if (event.level < this->level) {
+        return;
+    }
+
+    Ring &ring = this->getRing();
+    Record *record = this->reserve(ring);
+    if (record == nullptr) {
+        return;
+    }
+
+    record->event = &event;
+    clock_gettime(CLOCK_REALTIME, &record->time);
+    record->argCount = 0;
+    record->textUsed = 0;
+    (addArg(*record, args), ...);
+    this->commit(ring);
+}
+
+
+#endif /* Logger_hpp */
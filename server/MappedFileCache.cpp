@@ -0,0 +1,173 @@
+/**
+ * Program Name: FTP Server
+ * File Name: MappedFileCache.cpp
+ * Author: Taylor Jones
+ * Last Modified: 10/16/26
+ * Description: MappedFileCache.cpp is the class implementation
+ *  file for the MappedFileCache class.
+ *
+ *  The cache keeps popular files memory-mapped, so a repeat download is
+ *  sent straight from the mapping: the caller's one stat() of the requested
+ *  path shows whether the file is still the one that was mapped (the same
+ *  inode, size and modification time), and the open, fstat and read setup
+ *  are skipped.
+ *  Entries are keyed by device and inode, so every path to a file shares
+ *  one mapping, and transfers hold a reference to the mapping they send
+ *  from, so any number of them can share it, and an evicted or replaced
+ *  mapping is only unmapped once the last of them is done. The least
+ *  recently used mappings are evicted to keep the total under the budget.
+ */
+
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "MappedFileCache.hpp"
+
+
+/**
+ * Creates an empty mapping.
+ */
+MappedFile::MappedFile() {
+    this->data = (const char *) MAP_FAILED;
+    this->size = 0;
+    this->fd = -1;
+    this->device = 0;
+    this->inode = 0;
+    this->mtime.tv_sec = 0;
+    this->mtime.tv_nsec = 0;
+}
+
+
+
+/**
+ * Unmaps and closes the file.
+ */
+MappedFile::~MappedFile() {
+    if (this->data != MAP_FAILED) {
+        munmap((void *) this->data, this->size);
+    }
+    if (this->fd >= 0) {
+        close(this->fd);
+    }
+}
+
+
+
+/**
+ * Creates a cache.
+ * @param budget - the most bytes to keep mapped, or 0 to map nothing.
+ */
+MappedFileCache::MappedFileCache(size_t budget) {
+    this->budget = budget;
+    this->mappedBytes = 0;
+}
+
+
+
+/**
+ * Gets the mapping of a file, mapping it if it isn't mapped already (or
+ * has changed since it was). Empty files, files that aren't regular files,
+ * and files larger than the whole budget aren't mapped.
+ * @param path - the file, relative to the served directory.
+ * @param info - what stat() just said about the file.
+ * @return shared_ptr<const MappedFile> - the mapping, or null if the file should be sent some other way.
+ */
+shared_ptr<const MappedFile> MappedFileCache::acquire(const string &path, const struct stat &info) {
+    if (this->budget == 0 || !S_ISREG(info.st_mode) || info.st_size == 0 || (size_t) info.st_size > this->budget) {
+        return nullptr;
+    }
+
+    const FileKey key(info.st_dev, info.st_ino);
+    {
+        std::lock_guard<std::mutex> guard(this->lock);
+        auto found = this->entries.find(key);
+
+        if (found != this->entries.end()) {
+            const MappedFile &file = *found->second.file;
+            if (file.size == info.st_size && file.mtime.tv_sec == info.st_mtim.tv_sec &&
+                file.mtime.tv_nsec == info.st_mtim.tv_nsec) {
+                this->recent.splice(this->recent.begin(), this->recent, found->second.recent);
+                return found->second.file;
+            }
+        }
+    }
+
+    // map the file without holding the lock, so other transfers aren't held up by the disk.
+    shared_ptr<const MappedFile> file = mapFile(path);
+    if (!file) {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> guard(this->lock);
+    const FileKey mappedKey(file->device, file->inode);
+    auto found = this->entries.find(mappedKey);
+
+    if (found != this->entries.end()) {
+        this->mappedBytes -= found->second.file->size;
+        this->recent.erase(found->second.recent);
+        this->entries.erase(found);
+    }
+
+    this->recent.push_front(mappedKey);
+    Entry entry;
+    entry.file = file;
+    entry.recent = this->recent.begin();
+    this->entries[mappedKey] = entry;
+    this->mappedBytes += file->size;
+
+    this->evict(mappedKey);
+    return file;
+}
+
+
+
+/**
+ * Opens and maps a file, and tells the kernel it will be read in order, soon.
+ * @param path - the file.
+ * @return shared_ptr<const MappedFile> - the mapping, or null if the file couldn't be mapped.
+ */
+shared_ptr<const MappedFile> MappedFileCache::mapFile(const string &path) {
+    shared_ptr<MappedFile> file(new MappedFile());
+    struct stat info;
+
+    file->fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (file->fd < 0 || fstat(file->fd, &info) != 0 || !S_ISREG(info.st_mode) || info.st_size == 0) {
+        return nullptr;
+    }
+
+    void *data = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, file->fd, 0);
+    if (data == MAP_FAILED) {
+        return nullptr;
+    }
+
+    file->data = (const char *) data;
+    file->size = info.st_size;
+    file->device = info.st_dev;
+    file->inode = info.st_ino;
+    file->mtime = info.st_mtim;
+    madvise(data, info.st_size, MADV_SEQUENTIAL);
+    madvise(data, info.st_size, MADV_WILLNEED);
+
+    return file;
+}
+
+
+
+/**
+ * Drops the least recently used entries until the cache is within its budget.
+ * Transfers that are still sending from a dropped mapping keep it until they're done.
+ * The caller must hold the lock.
+ * @param keep - the entry that was just added, which is never dropped.
+ */
+void MappedFileCache::evict(const FileKey &keep) {
+    while (this->mappedBytes > this->budget && this->recent.back() != keep) {
+        auto oldest = this->entries.find(this->recent.back());
+        this->mappedBytes -= oldest->second.file->size;
+        this->entries.erase(oldest);
+        this->recent.pop_back();
+    }
+}
+
@@ -0,0 +1,76 @@
+/**
+ * Program Name: FTP Server
+ * File Name: MappedFileCache.hpp
+ * Author: Taylor Jones
+ * Last Modified: 10/16/26
+ * Description: MappedFileCache.hpp is the class specification
+ *  file for the MappedFileCache class. This file contains declarations
+ *  for the member functions of the MappedFileCache class.
+ */
+
+
+#ifndef MappedFileCache_hpp
+#define MappedFileCache_hpp
+
+#include <ctime>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <utility>
+
+using std::list;
+using std::map;
+using std::shared_ptr;
+using std::string;
+
+
+/**
+ * A whole file, mapped read-only. The mapping stays valid for as long as
+ * anyone holds the MappedFile, even after the cache has let go of it.
+ */
+struct MappedFile {
+    const char *data;           // the file's contents
+    off_t size;                 // the file's size when it was mapped
+    int fd;                     // the open file, for reads that mustn't touch the mapping
+    dev_t device;
+    ino_t inode;
+    struct timespec mtime;      // the file's modification time when it was mapped
+
+    MappedFile();
+    ~MappedFile();
+};
+
+
+class MappedFileCache {
+  // Member Variables
+  private:
+    typedef std::pair<dev_t, ino_t> FileKey;
+
+    struct Entry {
+        shared_ptr<const MappedFile> file;
+        list<FileKey>::iterator recent;     // the entry's place in the recently used list
+    };
+
+    std::mutex lock;                // guards everything below; workers share the cache
+    size_t budget;                  // the most bytes kept mapped, or 0 to map nothing
+    size_t mappedBytes;             // the bytes the cache's entries have mapped
+    list<FileKey> recent;           // the entries, most recently used first
+    map<FileKey, Entry> entries;
+
+  // Member Functions
+  private:
+    static shared_ptr<const MappedFile> mapFile(const string &path);
+    void evict(const FileKey &keep);
+
+  public:
+    explicit MappedFileCache(size_t budget);
+
+    shared_ptr<const MappedFile> acquire(const string &path, const struct stat &info);
+};
+
+
+#endif /* MappedFileCache_hpp */
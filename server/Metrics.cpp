@@ -0,0 +1,374 @@
+/**
+ * Program Name: FTP Server
+ * File Name: Metrics.cpp
+ * Author: Taylor Jones
+ * Last Modified: 10/16/26
+ * Description: Metrics.cpp is the class implementation
+ *  file for the Metrics class.
+ *
+ *  The server counts requests, errors and bytes sent, and times each phase
+ *  of each request, into per-thread shards: a thread adds to its own shard
+ *  with plain relaxed loads and stores, so counting costs about as much as
+ *  incrementing a variable and threads never share a cache line. The shards
+ *  are only added up when the metrics are read (by the -stats command, or
+ *  to write the metrics file), into the Prometheus text format.
+ *
+ *  Times are kept in HDR-style histograms: log-linear buckets, exact below
+ *  8 ns and within 12.5% above, from which quantiles are read. They are
+ *  also given as a Prometheus histogram with a fixed set of buckets, where
+ *  each HDR bucket is counted under the first bound at or above its largest
+ *  value.
+ */
+
+
+#include <chrono>
+#include <cstdio>
+
+#include "Metrics.hpp"
+
+
+const char *const Metrics::COMMAND_NAMES[COMMAND_COUNT] = {
+    "-l", "-la", "-ll", "-lr", "-g", "-h", "-hr", "-stats", "invalid"
+};
+
+const char *const Metrics::PHASE_NAMES[PHASE_COUNT] = {
+    "parse", "connect", "first_byte", "complete"
+};
+
+const char *const Metrics::RESULT_NAMES[RESULT_COUNT] = {
+    "ok", "not_found", "bad_range", "failed"
+};
+
+std::atomic<uint64_t> Metrics::nextId(1);
+thread_local Metrics::Shard *Metrics::threadShard = nullptr;
+thread_local uint64_t Metrics::threadShardOwner = 0;
+
+
+static const double BUCKET_BOUNDS[] = {     // the Prometheus histogram's buckets, in seconds
+    0.00001, 0.00005, 0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5,
+    1, 2.5, 5, 10, 30, 60
+};
+static const size_t BOUND_COUNT = sizeof(BUCKET_BOUNDS) / sizeof(BUCKET_BOUNDS[0]);
+
+static const double QUANTILES[] = { 0.5, 0.9, 0.99, 0.999 };
+
+
+
+/**
+ * Appends a metric's HELP and TYPE lines.
+ * @param out - the text to append to.
+ * @param name - the metric's name.
+ * @param type - "counter", "gauge" or "histogram".
+ * @param help - what the metric counts.
+ */
+static void appendHeader(string &out, const char *name, const char *type, const char *help) {
+    out.append("# HELP ").append(name).append(" ").append(help).append("\n");
+    out.append("# TYPE ").append(name).append(" ").append(type).append("\n");
+}
+
+
+
+/**
+ * Appends one sample.
+ * @param out - the text to append to.
+ * @param name - the metric's name.
+ * @param labels - the sample's labels (without the braces), or an empty string for none.
+ * @param value - the sample's value.
+ */
+static void appendSample(string &out, const string &name, const string &labels, double value) {
+    char number[32];
+    snprintf(number, sizeof(number), "%.15g", value);
+
+    out.append(name);
+    if (!labels.empty()) {
+        out.append("{").append(labels).append("}");
+    }
+    out.append(" ").append(number).append("\n");
+}
+
+
+
+/**
+ * Starts the clock the server's uptime is measured with.
+ */
+Metrics::Metrics() {
+    this->id = nextId++;
+    this->startTime = now();
+}
+
+
+
+/**
+ * @return Shard& - the calling thread's shard, which is created the first time the thread counts anything.
+ */
+Metrics::Shard &Metrics::getShard() {
+    if (threadShardOwner != this->id) {
+        std::lock_guard<std::mutex> guard(this->lock);
+        this->shards.push_back(unique_ptr<Shard>(new Shard()));
+        threadShard = this->shards.back().get();
+        threadShardOwner = this->id;
+    }
+
+    return *threadShard;
+}
+
+
+
+/**
+ * Adds to a counter of the calling thread's own shard.
+ * @param counter - the counter.
+ * @param value - the amount to add.
+ */
+void Metrics::add(Counter &counter, uint64_t value) {
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+
+
+/**
+ * Counts a request.
+ * @param command - the request's command (see commandIndex()).
+ */
+void Metrics::countRequest(size_t command) {
+    add(this->getShard().requests[command], 1);
+}
+
+
+
+/**
+ * Counts a request that failed to parse.
+ * @param error - the check it failed.
+ */
+void Metrics::countRequestError(RequestError error) {
+    add(this->getShard().requestErrors[error], 1);
+}
+
+
+
+/**
+ * Counts a response that couldn't be sent as requested.
+ * @param result - the outcome of the transfer.
+ */
+void Metrics::countTransferError(TransferResult result) {
+    add(this->getShard().transferErrors[result], 1);
+}
+
+
+
+/**
+ * Counts the bytes a response wrote to its data connections.
+ * @param command - the request's command.
+ * @param bytes - the number of bytes.
+ */
+void Metrics::countBytesSent(size_t command, uint64_t bytes) {
+    add(this->getShard().bytesSent[command], bytes);
+}
+
+
+
+/**
+ * Counts a client that has connected.
+ */
+void Metrics::countSessionOpened() {
+    add(this->getShard().sessionsOpened, 1);
+}
+
+
+
+/**
+ * Counts a client that has gone.
+ */
+void Metrics::countSessionClosed() {
+    add(this->getShard().sessionsClosed, 1);
+}
+
+
+
+/**
+ * Records how long a request took to reach a phase.
+ * @param command - the request's command.
+ * @param phase - the phase.
+ * @param nanoseconds - the time from the request's arrival to the phase.
+ */
+void Metrics::recordTime(size_t command, MetricPhase phase, int64_t nanoseconds) {
+    Histogram &histogram = this->getShard().latencies[command][phase];
+    const uint64_t time = nanoseconds > 0 ? nanoseconds : 0;
+
+    add(histogram.buckets[Buckets::bucketOf(time)], 1);
+    add(histogram.sum, time);
+}
+
+
+
+/**
+ * Adds up every thread's shard and renders the totals, along with the
+ * content cache's and hash index's counts, in the Prometheus text format.
+ * @param contents - the content cache.
+ * @param hashes - the hash index.
+ * @return string - the metrics.
+ */
+string Metrics::render(ContentCache &contents, HashIndex &hashes) {
+    uint64_t requests[COMMAND_COUNT] = {}, bytesSent[COMMAND_COUNT] = {};
+    uint64_t requestErrors[REQUEST_ERROR_COUNT] = {}, transferErrors[RESULT_COUNT] = {};
+    uint64_t sessionsOpened = 0, sessionsClosed = 0;
+    vector<uint64_t> buckets(COMMAND_COUNT * PHASE_COUNT * BUCKET_COUNT, 0);
+    vector<uint64_t> sums(COMMAND_COUNT * PHASE_COUNT, 0);
+
+    {
+        std::lock_guard<std::mutex> guard(this->lock);
+        for (const auto &shard : this->shards) {
+            for (size_t i = 0; i < COMMAND_COUNT; i++) {
+                requests[i] += shard->requests[i].load(std::memory_order_relaxed);
+                bytesSent[i] += shard->bytesSent[i].load(std::memory_order_relaxed);
+            }
+            for (size_t i = 0; i < REQUEST_ERROR_COUNT; i++) {
+                requestErrors[i] += shard->requestErrors[i].load(std::memory_order_relaxed);
+            }
+            for (size_t i = 0; i < RESULT_COUNT; i++) {
+                transferErrors[i] += shard->transferErrors[i].load(std::memory_order_relaxed);
+            }
+            sessionsOpened += shard->sessionsOpened.load(std::memory_order_relaxed);
+            sessionsClosed += shard->sessionsClosed.load(std::memory_order_relaxed);
+
+            for (size_t series = 0; series < COMMAND_COUNT * PHASE_COUNT; series++) {
+                const Histogram &histogram = shard->latencies[series / PHASE_COUNT][series % PHASE_COUNT];
+                for (size_t bucket = 0; bucket < BUCKET_COUNT; bucket++) {
+                    buckets[series * BUCKET_COUNT + bucket] += histogram.buckets[bucket].load(std::memory_order_relaxed);
+                }
+                sums[series] += histogram.sum.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    string out;
+    appendHeader(out, "ftserver_uptime_seconds", "gauge", "Time since the server started.");
+    appendSample(out, "ftserver_uptime_seconds", "", (now() - this->startTime) / 1e9);
+
+    appendHeader(out, "ftserver_requests_total", "counter", "Requests received, by command.");
+    for (size_t i = 0; i < COMMAND_COUNT; i++) {
+        appendSample(out, "ftserver_requests_total", "command=\"" + string(COMMAND_NAMES[i]) + "\"", requests[i]);
+    }
+
+    appendHeader(out, "ftserver_request_errors_total", "counter", "Requests that failed to parse, by the check they failed.");
+    for (size_t i = REQUEST_OK + 1; i < REQUEST_ERROR_COUNT; i++) {
+        appendSample(out, "ftserver_request_errors_total",
+            "error=\"" + string(ParsedRequest::errorName((RequestError) i)) + "\"", requestErrors[i]);
+    }
+
+    appendHeader(out, "ftserver_transfer_errors_total", "counter", "Responses that couldn't be sent as requested, by outcome.");
+    for (size_t i = TRANSFER_OK + 1; i < RESULT_COUNT; i++) {
+        appendSample(out, "ftserver_transfer_errors_total", "result=\"" + string(RESULT_NAMES[i]) + "\"", transferErrors[i]);
+    }
+
+    appendHeader(out, "ftserver_bytes_sent_total", "counter", "Bytes written to data connections, by command.");
+    for (size_t i = 0; i < COMMAND_COUNT; i++) {
+        appendSample(out, "ftserver_bytes_sent_total", "command=\"" + string(COMMAND_NAMES[i]) + "\"", bytesSent[i]);
+    }
+
+    appendHeader(out, "ftserver_sessions_total", "counter", "Clients that have connected.");
+    appendSample(out, "ftserver_sessions_total", "", sessionsOpened);
+    appendHeader(out, "ftserver_active_sessions", "gauge", "Clients connected now.");
+    appendSample(out, "ftserver_active_sessions", "", sessionsOpened - sessionsClosed);
+
+    // only the command and phase pairs that have happened are listed.
+    appendHeader(out, "ftserver_request_phase_seconds", "histogram", "Time from a request's arrival to each phase, by command.");
+    for (size_t series = 0; series < COMMAND_COUNT * PHASE_COUNT; series++) {
+        const uint64_t *counts = &buckets[series * BUCKET_COUNT];
+        const string labels = "command=\"" + string(COMMAND_NAMES[series / PHASE_COUNT]) + "\",phase=\"" +
+            PHASE_NAMES[series % PHASE_COUNT] + "\"";
+        uint64_t total = 0;
+        for (size_t bucket = 0; bucket < BUCKET_COUNT; bucket++) {
+            total += counts[bucket];
+        }
+        if (total == 0) {
+            continue;
+        }
+
+        uint64_t cumulative = 0;
+        size_t bucket = 0;
+        for (size_t bound = 0; bound < BOUND_COUNT; bound++) {
+            while (bucket < BUCKET_COUNT && Buckets::bucketLimit(bucket) <= BUCKET_BOUNDS[bound] * 1e9) {
+                cumulative += counts[bucket++];
+            }
+            char le[32];
+            snprintf(le, sizeof(le), "%g", BUCKET_BOUNDS[bound]);
+            appendSample(out, "ftserver_request_phase_seconds_bucket", labels + ",le=\"" + le + "\"", cumulative);
+        }
+        appendSample(out, "ftserver_request_phase_seconds_bucket", labels + ",le=\"+Inf\"", total);
+        appendSample(out, "ftserver_request_phase_seconds_sum", labels, sums[series] / 1e9);
+        appendSample(out, "ftserver_request_phase_seconds_count", labels, total);
+    }
+
+    appendHeader(out, "ftserver_request_phase_quantile_seconds", "gauge",
+        "Quantiles of the time from a request's arrival to each phase, by command, to within 12.5%.");
+    for (size_t series = 0; series < COMMAND_COUNT * PHASE_COUNT; series++) {
+        const uint64_t *counts = &buckets[series * BUCKET_COUNT];
+        const string labels = "command=\"" + string(COMMAND_NAMES[series / PHASE_COUNT]) + "\",phase=\"" +
+            PHASE_NAMES[series % PHASE_COUNT] + "\"";
+        uint64_t total = 0;
+        for (size_t bucket = 0; bucket < BUCKET_COUNT; bucket++) {
+            total += counts[bucket];
+        }
+        if (total == 0) {
+            continue;
+        }
+
+        for (double quantile : QUANTILES) {
+            const uint64_t rank = (uint64_t) (quantile * total + 0.999999);
+            uint64_t cumulative = 0;
+            size_t bucket = 0;
+            while (bucket + 1 < BUCKET_COUNT && cumulative + counts[bucket] < rank) {
+                cumulative += counts[bucket++];
+            }
+            char q[16];
+            snprintf(q, sizeof(q), "%g", quantile);
+            appendSample(out, "ftserver_request_phase_quantile_seconds", labels + ",quantile=\"" + q + "\"",
+                Buckets::bucketLimit(bucket) / 1e9);
+        }
+    }
+
+    const ContentCacheStats cache = contents.getStats();
+    appendHeader(out, "ftserver_content_cache_hits_total", "counter", "Downloads answered from the content cache.");
+    appendSample(out, "ftserver_content_cache_hits_total", "", cache.hits);
+    appendHeader(out, "ftserver_content_cache_misses_total", "counter", "Downloads of small files that had to be read.");
+    appendSample(out, "ftserver_content_cache_misses_total", "", cache.misses);
+    appendHeader(out, "ftserver_content_cache_evictions_total", "counter", "Files dropped from the content cache.");
+    appendSample(out, "ftserver_content_cache_evictions_total", "", cache.evictions);
+    appendHeader(out, "ftserver_content_cache_bytes", "gauge", "Bytes in the content cache.");
+    appendSample(out, "ftserver_content_cache_bytes", "", cache.bytes);
+
+    const HashIndexStats index = hashes.getStats();
+    appendHeader(out, "ftserver_hash_index_hits_total", "counter", "Hashes answered from the hash index.");
+    appendSample(out, "ftserver_hash_index_hits_total", "", index.hits);
+    appendHeader(out, "ftserver_hash_index_hashed_total", "counter", "Files read and hashed.");
+    appendSample(out, "ftserver_hash_index_hashed_total", "", index.hashed);
+    appendHeader(out, "ftserver_hash_index_files", "gauge", "Files in the hash index.");
+    appendSample(out, "ftserver_hash_index_files", "", index.entries);
+
+    return out;
+}
+
+
+
+/**
+ * @param command - a parsed request's command.
+ * @return size_t - where the command is counted, or INVALID_COMMAND if it isn't one.
+ */
+size_t Metrics::commandIndex(string_view command) {
+    for (size_t i = 0; i < INVALID_COMMAND; i++) {
+        if (command == COMMAND_NAMES[i]) {
+            return i;
+        }
+    }
+
+    return INVALID_COMMAND;
+}
+
+
+
+/**
+ * @return int64_t - the steady clock's time, in ns.
+ */
+int64_t Metrics::now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
@@ -0,0 +1,123 @@
+/**
+ * Program Name: FTP Server
+ * File Name: Metrics.hpp
+ * Author: Taylor Jones
+ * Last Modified: 10/16/26
+ * Description: Metrics.hpp is the class specification
+ *  file for the Metrics class. This file contains declarations
+ *  for the member functions of the Metrics class.
+ */
+
+
+#ifndef Metrics_hpp
+#define Metrics_hpp
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ContentCache.hpp"
+#include "DataTransfer.hpp"
+#include "HashIndex.hpp"
+#include "HistogramBuckets.hpp"
+#include "ParsedRequest.hpp"
+
+using std::string;
+using std::string_view;
+using std::unique_ptr;
+using std::vector;
+
+
+/**
+ * The points in a request's life that are timed, each from when the
+ * request arrived.
+ */
+enum MetricPhase {
+    PHASE_PARSE,            // the request has been parsed
+    PHASE_CONNECT,          // the data connections are open
+    PHASE_FIRST_BYTE,       // the first byte of the response has been written
+    PHASE_COMPLETE,         // the data connections are closed
+    PHASE_COUNT
+};
+
+
+class Metrics {
+  // Member Variables
+  public:
+    static const size_t COMMAND_COUNT = 9;
+    static const size_t INVALID_COMMAND = COMMAND_COUNT - 1;   // where requests that failed to parse are counted
+
+  private:
+    static const size_t RESULT_COUNT = 4;           // the TransferResult values
+    // 8 buckets per power of two, so a value is known to within 12.5%, for times up to
+    // 2^44 ns (almost 5 hours); longer ones count as that.
+    typedef HistogramBuckets<3, 44> Buckets;
+    static const size_t BUCKET_COUNT = Buckets::COUNT;
+
+    typedef std::atomic<uint64_t> Counter;
+
+    /**
+     * The times of one phase of one command, in log-linear buckets: exact
+     * below 8 ns, and 8 buckets for each power of two above (see HistogramBuckets).
+     */
+    struct Histogram {
+        Counter buckets[BUCKET_COUNT];
+        Counter sum;                    // in ns
+    };
+
+    /**
+     * One thread's counts. Only that thread adds to them, so adding needs
+     * no atomic read-modify-write; they are atomic only so they can be read
+     * while they change.
+     */
+    struct Shard {
+        Counter requests[COMMAND_COUNT];
+        Counter bytesSent[COMMAND_COUNT];
+        Counter requestErrors[REQUEST_ERROR_COUNT];
+        Counter transferErrors[RESULT_COUNT];
+        Counter sessionsOpened;
+        Counter sessionsClosed;
+        Histogram latencies[COMMAND_COUNT][PHASE_COUNT];
+    };
+
+    static const char *const COMMAND_NAMES[COMMAND_COUNT];
+    static const char *const PHASE_NAMES[PHASE_COUNT];
+    static const char *const RESULT_NAMES[RESULT_COUNT];
+
+    static std::atomic<uint64_t> nextId;
+    static thread_local Shard *threadShard;         // the calling thread's shard...
+    static thread_local uint64_t threadShardOwner;  // ...and the id of the Metrics it belongs to
+
+    uint64_t id;
+    int64_t startTime;                  // when the server started (steady clock, in ns)
+    std::mutex lock;                    // guards the list of shards
+    vector<unique_ptr<Shard>> shards;
+
+  // Member Functions
+  private:
+    Shard &getShard();
+    static void add(Counter &counter, uint64_t value);
+
+  public:
+    Metrics();
+
+    void countRequest(size_t command);
+    void countRequestError(RequestError error);
+    void countTransferError(TransferResult result);
+    void countBytesSent(size_t command, uint64_t bytes);
+    void countSessionOpened();
+    void countSessionClosed();
+    void recordTime(size_t command, MetricPhase phase, int64_t nanoseconds);
+
+    string render(ContentCache &contents, HashIndex &hashes);
+
+    static size_t commandIndex(string_view command);
+    static int64_t now();
+};
+
+
+#endif /* Metrics_hpp */
@@ -0,0 +1,107 @@
+/**
+ * Program Name: FTP Server
+ * File Name: OutputBuffer.cpp
+ * Author: Taylor Jones
+ * Last Modified: 10/16/26
+ * Description: OutputBuffer.cpp is the class implementation
+ *  file for the OutputBuffer class. Writes pick up exactly where the
+ *  last (possibly short) write left off.
+ */
+
+
+#include <cerrno>
+#include <sys/types.h>
+#include <sys/socket.h>
+
+#include "OutputBuffer.hpp"
+
+
+/**
+ * Creates an empty buffer.
+ */
+OutputBuffer::OutputBuffer() {
+    this->offset = 0;
+}
+
+
+
+/**
+ * Queues content to be written.
+ * @param content - the bytes to queue.
+ */
+void OutputBuffer::append(const string &content) {
+    this->compact();
+    this->buffer.append(content);
+}
+
+
+
+/**
+ * Queues a single protocol line, appending the newline that completes it.
+ * @param line - the line to queue.
+ */
+void OutputBuffer::appendLine(const string &line) {
+    this->compact();
+    this->buffer.append(line);
+    this->buffer.push_back('\n');
+}
+
+
+
+/**
+ * Drops the already-written front of the buffer once it makes up
+ * at least half of it, so a slow reader can't make the buffer grow forever.
+ */
+void OutputBuffer::compact() {
+    if (this->offset > 0 && this->offset * 2 >= this->buffer.size()) {
+        this->buffer.erase(0, this->offset);
+        this->offset = 0;
+    }
+}
+
+
+
+/**
+ * @return size_t - the number of bytes still waiting to be written.
+ */
+size_t OutputBuffer::size() const {
+    return this->buffer.size() - this->offset;
+}
+
+
+
+/**
+ * @return bool - true if there is nothing left to write.
+ */
+bool OutputBuffer::empty() const {
+    return this->size() == 0;
+}
+
+
+
+/**
+ * Writes as much of the queued content as the socket will currently accept.
+ * @param sock - a non-blocking socket.
+ * @return bool - false if the socket failed, true otherwise (even if some bytes are still queued).
+ */
+bool OutputBuffer::flush(int sock) {
+    while (this->offset < this->buffer.size()) {
+        ssize_t sent = send(sock, this->buffer.data() + this->offset,
+                            this->buffer.size() - this->offset, MSG_NOSIGNAL);
+
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+
+        this->offset += sent;
+    }
+
+    // everything has been written, so start over with an empty buffer.
+    this->buffer.clear();
+    this->offset = 0;
+    return true;
+}
@@ -0,0 +1,42 @@
+/**
+ * Program Name: FTP Server
+ * File Name: OutputBuffer.hpp
+ * Author: Taylor Jones
+ * Last Modified: 10/16/26
+ * Description: OutputBuffer.hpp is the class specification
+ *  file for the OutputBuffer class, which holds bytes waiting to be
+ *  written to a non-blocking socket.
+ */
+
+
+#ifndef OutputBuffer_hpp
+#define OutputBuffer_hpp
+
+#include <string>
+
+using std::string;
+
+
+class OutputBuffer {
+  // Member Variables
+  private:
+    string buffer;      // the queued bytes
+    size_t offset;      // how many of the queued bytes have already been written
+
+  // Member Functions
+  private:
+    void compact();
+
+  public:
+    OutputBuffer();
+
+    void append(const string &content);
+    void appendLine(const string &line);
+
+    size_t size() const;
+    bool empty() const;
+    bool flush(int sock);
+};
+
+
+#endif /* OutputBuffer_hpp */
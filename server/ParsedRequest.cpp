@@ -9,9 +9,16 @@
  *  has the necessary information available. If any of the request 
  *  components are found to be invalid, an error message is stored
  *  and ultimately returned to the FTP client as the server's response.
+ *
+ *  Requests are parsed in place: the components and options are views
+ *  into the request, commands and options are looked up in static tables,
+ *  and numbers are read without copying, so a valid request is parsed
+ *  without allocating anything (once the filename fits in the string a
+ *  reused ParsedRequest already has).
  */
 
 
+#include "Framing.hpp"
 #include "ParsedRequest.hpp"
 #include "Util.hpp"
 
@@ -20,35 +27,89 @@ using std::cout;
 using std::endl;
 
 
+const ParsedRequest::CommandSpec ParsedRequest::COMMANDS[ParsedRequest::COMMAND_COUNT] = {
+    { "-l", 2 },
+    { "-la", 2 },
+    { "-ll", 2 },
+    { "-lr", 2 },
+    { "-g", 3 },
+    { "-h", 3 },
+    { "-hr", 2 },
+    { "-stats", 1 }
+};
+
+const char *const ParsedRequest::ERROR_NAMES[REQUEST_ERROR_COUNT] = {
+    "none", "empty", "argument_count", "unknown_command", "command_mismatch", "no_filename", "bad_data_port",
+    "unknown_option", "bad_option", "option_conflict"
+};
+
+const char *const ParsedRequest::OPTION_NAMES[ParsedRequest::OPTION_COUNT] = {
+    "compress", "delta", "framing", "length", "mode", "offset", "streams"
+};
+
+
 /**
  * Class constructor that sets the default values for all of the member variables
  * and then triggers parsing the request.
  * @param request - the string representation of the command-line request.
  * @param commandPort - the port to establish a FTP control connection with the server.
  */
-ParsedRequest::ParsedRequest(string &request, int commandPort) {
-    // Apply all the default member variable values.
-    this->command = "";
-    this->filename = "";
-    this->dataPort = -1;
-    this->errorFlag = false;
-    this->errorMessage = "";
+ParsedRequest::ParsedRequest(string_view request, int commandPort) {
     this->commandPort = commandPort;
-    
+
     // parse the request
+    this->parse(request);
+}
+
+
+
+/**
+ * Parses another request, replacing everything parsed from the last one.
+ * The filename and error message keep their storage, so a ParsedRequest
+ * that is reused for each request stops allocating once it has seen a long enough filename.
+ * @param request - the string representation of the command-line request.
+ */
+void ParsedRequest::parse(string_view request) {
+    this->reset();
     this->parseRequest(request);
 }
 
 
 
+/**
+ * Applies all the default member variable values.
+ */
+void ParsedRequest::reset() {
+    this->command = string_view();
+    this->filename.clear();
+    this->dataPort = -1;
+    this->passiveMode = false;
+    this->binaryMode = false;
+    this->framingVersion = 0;
+    this->rangeOffset = 0;
+    this->rangeLength = -1;
+    this->streams = 1;
+    this->compressionLevel = 0;
+    this->deltaMode = false;
+    this->errorFlag = false;
+    this->error = REQUEST_OK;
+    this->errorMessage.clear();
+    this->componentCount = 0;
+    this->hasUnknownOption = false;
+    for (size_t i = 0; i < OPTION_COUNT; i++) {
+        this->optionGiven[i] = false;
+    }
+}
 /**
  * Sets the error flag to true and specifies the error message.
+ * @param error - the check that failed.
  * @param message - the value to apply to the error message.
  * @return bool - always false.
  */
-bool ParsedRequest::raiseErrorFlag(const string &message) {
+bool ParsedRequest::raiseErrorFlag(RequestError error, const string &message) {
     this->errorFlag = true;
-    this->errorMessage = "Error: " + message;
+    this->error = error;
+    this->errorMessage.assign("Error: ").append(message);
     return false;
 }
 
@@ -61,15 +122,17 @@ bool ParsedRequest::raiseErrorFlag(const string &message) {
  * @return bool - true if a valid # of request components exist, false if not.
  */
 bool ParsedRequest::componentCountIsValid() {
-    const size_t componentCount = this->components.size();
+    const size_t componentCount = this->componentCount;
     const size_t VALID_MIN = 2;
     const size_t VALID_MAX = 3;
+    const CommandSpec *spec = findCommand(this->components[0]);
     
-    // There should be either 2 or 3 components.
-    if (componentCount < VALID_MIN) {
-        return this->raiseErrorFlag("Too few FTP request arguments were provided.");
+    // There should be either 2 or 3 components, unless the command is one (like -stats) that is answered
+    // on the control connection, and so takes no data port.
+    if (componentCount < VALID_MIN && !(spec != nullptr && spec->componentCount == componentCount)) {
+        return this->raiseErrorFlag(REQUEST_ARGUMENT_COUNT, "Too few FTP request arguments were provided.");
     } else if (componentCount > VALID_MAX) {
-        return this->raiseErrorFlag("Too many FTP request arguments were provided.");
+        return this->raiseErrorFlag(REQUEST_ARGUMENT_COUNT, "Too many FTP request arguments were provided.");
     }
     
     return true;
@@ -85,64 +148,56 @@ bool ParsedRequest::componentCountIsValid() {
  * @return bool - true if valid, false if not.
  */
 bool ParsedRequest::commandIsValid() {
-    const string prospect = this->components[0];
-    const size_t count = this->components.size();
-    const string LIST_CMD = "-l";
-    const string LIST_ALL_CMD = "-la";
-    const string LIST_WITH_SIZE_CMD = "-ll";
-    const string LIST_RECURSIVE_CMD = "-lr";
-    const string GET_CMD = "-g";
+    const string_view prospect = this->components[0];
+    const size_t count = this->componentCount;
+    const CommandSpec *spec = findCommand(prospect);
     
     // check for a valid command/command-count match.
-    if ((count == 2 && prospect == LIST_CMD) ||
-        (count == 2 && prospect == LIST_ALL_CMD) ||
-        (count == 2 && prospect == LIST_WITH_SIZE_CMD) ||
-        (count == 2 && prospect == LIST_RECURSIVE_CMD) ||
-        (count == 3 && prospect == GET_CMD)) {
-        this->command = prospect;
+    if (spec != nullptr && count == spec->componentCount) {
+        this->command = spec->name;
         return true;
     }
     
     // check for an invalid command.
-    if (prospect != LIST_CMD && 
-        prospect != LIST_ALL_CMD && 
-        prospect != LIST_WITH_SIZE_CMD &&
-        prospect != LIST_RECURSIVE_CMD &&
-        prospect != GET_CMD) {
-        return this->raiseErrorFlag("An invalid command was provided. Please use \"" +
-        LIST_CMD + "\", \"" + LIST_ALL_CMD + "\", \"" + LIST_WITH_SIZE_CMD + 
-        "\", \"" + LIST_RECURSIVE_CMD + "\", or \"" + GET_CMD + "\".");
+    if (spec == nullptr) {
+        string message = "An invalid command was provided. Please use ";
+        for (size_t i = 0; i < COMMAND_COUNT; i++) {
+            message += (i == 0 ? "\"" : i + 1 < COMMAND_COUNT ? ", \"" : ", or \"");
+            message += COMMANDS[i].name;
+            message += "\"";
+        }
+        return this->raiseErrorFlag(REQUEST_UNKNOWN_COMMAND, message + ".");
     }
     
     // check for a command/command-count mismatch
     if (count == 2 || count == 3) {
-        return this->raiseErrorFlag("Command mismatch: " + to_string(count) +
-        " arguments were provided with a command of " + prospect + ".");
+        return this->raiseErrorFlag(REQUEST_COMMAND_MISMATCH, "Command mismatch: " + to_string(count) +
+        " arguments were provided with a command of " + string(prospect) + ".");
     }
     
     // fall-through if # of commands is not valid. this should not happen.
-    return this->raiseErrorFlag("Invalid component count: commandIsValid().");
+    return this->raiseErrorFlag(REQUEST_ARGUMENT_COUNT, "Invalid component count: commandIsValid().");
 }
 
 
 
 /**
- * Checks if the filename argument is valid (if the -g command was argued. If not,
+ * Checks if the filename argument is valid (if the -g or -h command was argued. If not,
  * the function will return true, since no filename needs to be validated).
  * @return bool - true if valid, false if not.
  */
 bool ParsedRequest::fileNameIsValid() {
-    // only require validation if it was a -g command.
-    if (this->command == "-g") {
+    // only require validation if it was a -g or -h command.
+    if (this->command == "-g" || this->command == "-h") {
         // the filename should be the second component
-        const string fileName = this->components[1];
+        const string_view fileName = this->components[1];
         
         // make sure the filename component has a value
         if (!hasAnyValue(fileName)) {
-            return this->raiseErrorFlag("No file name was provided. Please provide one");
+            return this->raiseErrorFlag(REQUEST_NO_FILENAME, "No file name was provided. Please provide one");
         }
         
-        this->filename = fileName;
+        this->filename.assign(fileName);
     }
     
     // if all inspections pass or there's not a -g command, return true.
@@ -152,35 +207,47 @@ bool ParsedRequest::fileNameIsValid() {
 
 
 /**
- * Checks if a data port argument is valid, meaning it should:
- * - be a valid port number
- * - not be the same port number as the control connection.
- * If valid, this function with set the object's dataPort value.
+ * Checks if a data port argument is valid, meaning it should either:
+ * - be "pasv", asking the server for a port to connect to (passive mode), or
+ * - be a valid port number that is not the same port number as the control connection.
+ * If valid, this function with set the object's dataPort value (or passiveMode).
  * If invalid, it will raise the appropriate error flag.
  * @return bool - true if the data port is valid, false if not.
  */
 bool ParsedRequest::dataPortIsValid() {
     const int MIN_VALID_PORT = 1024;
     const int MAX_VALID_PORT = 65535;
-    const size_t count = this->components.size();
-    const string portComponent = this->components[count - 1];
+    const size_t count = this->componentCount;
     int dPort;
+
+    // a command answered on the control connection has no data port.
+    if (count == 1) {
+        return true;
+    }
+
+    const string_view portComponent = this->components[count - 1];
+    
+    // In passive mode, the server picks the data port once the request is accepted.
+    if (portComponent == "pasv") {
+        this->passiveMode = true;
+        return true;
+    }
     
     // Make sure the argued data port is numeric.
     if (!isInt(portComponent, dPort)) {
-        return this->raiseErrorFlag("Non-numeric data port argument. Please provide a numeric port in the range: " +
+        return this->raiseErrorFlag(REQUEST_BAD_DATA_PORT, "Non-numeric data port argument. Please provide a numeric port in the range: " +
           to_string(MIN_VALID_PORT) + ".." + to_string(MAX_VALID_PORT));
     }
     
     // Make sure the argued data port is in range.
     if (dPort < MIN_VALID_PORT || dPort > MAX_VALID_PORT) {
-        return this->raiseErrorFlag("Invalid data port argument. Please provide a numeric port in the range: " +
+        return this->raiseErrorFlag(REQUEST_BAD_DATA_PORT, "Invalid data port argument. Please provide a numeric port in the range: " +
           to_string(MIN_VALID_PORT) + ".." + to_string(MAX_VALID_PORT));
     }
     
     // Make sure the argued data port is not the same as the command port
     if (dPort == this->commandPort) {
-        return this->raiseErrorFlag("Invalid data port argument. The data port should not be the same as the command port.");
+        return this->raiseErrorFlag(REQUEST_BAD_DATA_PORT, "Invalid data port argument. The data port should not be the same as the command port.");
     }
     
     // If the data port passes inspection, set it and return true.
@@ -190,6 +257,156 @@ bool ParsedRequest::dataPortIsValid() {
 
 
 
+/**
+ * Checks that every option is one the server understands and has a
+ * valid value for the requested command. The supported options are:
+ * - mode=text|binary (-g only): binary sends the raw file after announcing its size.
+ * - framing=1: send the response as length-prefixed frames (see Framing.hpp).
+ * - offset=<bytes> and length=<bytes> (-g only): send only part of the file.
+ * - streams=<count> (-g only, with framing=1): stripe the file across several data connections.
+ * - compress=<level> (with framing=1): compress the frames' payloads with zlib at that level.
+ * - delta=1 (-g only, with framing=1): send the file as changes from the client's old copy.
+ * Options are checked in name order, and only the last value given for an option
+ * counts; an option the server doesn't understand is reported in its place in that order.
+ * @return bool - true if all of the options are valid, false if not.
+ */
+bool ParsedRequest::optionsAreValid() {
+    for (size_t i = 0; i <= OPTION_COUNT; i++) {
+        if (this->hasUnknownOption && (i == OPTION_COUNT || this->unknownOption < OPTION_NAMES[i])) {
+            return this->raiseErrorFlag(REQUEST_UNKNOWN_OPTION, "Unknown request option: " + string(this->unknownOption) + ".");
+        }
+        if (i < OPTION_COUNT && this->optionGiven[i] && !this->optionIsValid(OPTION_NAMES[i], this->optionValues[i])) {
+            return false;
+        }
+    }
+
+    // striped chunks can only be told apart with framing.
+    if (this->streams > 1 && this->framingVersion == 0) {
+        return this->raiseErrorFlag(REQUEST_OPTION_CONFLICT, "Multiple streams need the framing=" + to_string(FRAME_VERSION) + " option.");
+    }
+
+    // compressed payloads are marked in their frame headers, and chunks are sent as they are.
+    if (this->compressionLevel > 0 && this->framingVersion == 0) {
+        return this->raiseErrorFlag(REQUEST_OPTION_CONFLICT, "Compression needs the framing=" + to_string(FRAME_VERSION) + " option.");
+    }
+    if (this->compressionLevel > 0 && this->streams > 1) {
+        return this->raiseErrorFlag(REQUEST_OPTION_CONFLICT, "Compression can't be used with multiple streams.");
+    }
+
+    // a delta describes the whole file, and the client's signatures and the COPY frames need framing.
+    if (this->deltaMode && this->framingVersion == 0) {
+        return this->raiseErrorFlag(REQUEST_OPTION_CONFLICT, "Delta transfers need the framing=" + to_string(FRAME_VERSION) + " option.");
+    }
+    if (this->deltaMode && (this->streams > 1 || this->rangeOffset > 0 || this->rangeLength >= 0)) {
+        return this->raiseErrorFlag(REQUEST_OPTION_CONFLICT, "Delta transfers can't be used with multiple streams or a byte range.");
+    }
+
+    return true;
+}
+
+
+
+/**
+ * Checks the value of one of the options the server understands, and applies it.
+ * @param name - the option's name.
+ * @param value - the option's value.
+ * @return bool - true if the value is valid, false if not.
+ */
+bool ParsedRequest::optionIsValid(string_view name, string_view value) {
+    if (name == "mode") {
+        if (value != "text" && value != "binary") {
+            return this->raiseErrorFlag(REQUEST_BAD_OPTION, "Invalid transfer mode: " + string(value) + ". Please use \"text\" or \"binary\".");
+        }
+        if (value == "binary" && this->command != "-g") {
+            return this->raiseErrorFlag(REQUEST_BAD_OPTION, "The binary transfer mode can only be used with the -g command.");
+        }
+        this->binaryMode = (value == "binary");
+    } else if (name == "offset" || name == "length") {
+        long long bytes;
+        if (!isInt(value, bytes) || bytes < 0) {
+            return this->raiseErrorFlag(REQUEST_BAD_OPTION, "Invalid byte " + string(name) + ": " + string(value) + ". Please provide a whole number of bytes.");
+        }
+        if (this->command != "-g") {
+            return this->raiseErrorFlag(REQUEST_BAD_OPTION, "A byte " + string(name) + " can only be used with the -g command.");
+        }
+        if (name == "offset") {
+            this->rangeOffset = bytes;
+        } else {
+            this->rangeLength = bytes;
+        }
+    } else if (name == "streams") {
+        if (!isInt(value, this->streams) || this->streams < 1 || this->streams > MAX_STREAMS) {
+            return this->raiseErrorFlag(REQUEST_BAD_OPTION, "Invalid stream count: " + string(value) + ". Please use 1.." + to_string(MAX_STREAMS) + " streams.");
+        }
+        if (this->command != "-g") {
+            return this->raiseErrorFlag(REQUEST_BAD_OPTION, "Multiple streams can only be used with the -g command.");
+        }
+    } else if (name == "compress") {
+        if (!isInt(value, this->compressionLevel) || this->compressionLevel < 1 ||
+            this->compressionLevel > MAX_COMPRESSION_LEVEL) {
+            return this->raiseErrorFlag(REQUEST_BAD_OPTION, "Invalid compression level: " + string(value) + ". Please use 1.." +
+                to_string(MAX_COMPRESSION_LEVEL) + ".");
+        }
+    } else if (name == "delta") {
+        if (value != "0" && value != "1") {
+            return this->raiseErrorFlag(REQUEST_BAD_OPTION, "Invalid delta option: " + string(value) + ". Please use 0 or 1.");
+        }
+        if (this->command != "-g") {
+            return this->raiseErrorFlag(REQUEST_BAD_OPTION, "Delta transfers can only be used with the -g command.");
+        }
+        this->deltaMode = (value == "1");
+    } else if (name == "framing") {
+        if (!isInt(value, this->framingVersion) || this->framingVersion != FRAME_VERSION) {
+            return this->raiseErrorFlag(REQUEST_BAD_OPTION, "Unsupported framing version: " + string(value) + ". This server supports version " + to_string(FRAME_VERSION) + ".");
+        }
+    }
+
+    return true;
+}
+
+
+
+/**
+ * Splits the request into its components, setting aside any name=value
+ * options. Options can only follow the command and its first argument,
+ * so a filename that happens to contain "=" is never mistaken for one.
+ * Nothing is copied: the components and option values point into the request.
+ * @param request - the raw request string.
+ */
+void ParsedRequest::splitRequest(string_view request) {
+    const size_t FIRST_OPTION = 2;
+    size_t position = 0;
+    string_view word;
+
+    for (size_t i = 0; nextWord(request, position, word); i++) {
+        size_t split = word.find('=');
+
+        if (i < FIRST_OPTION || split == string_view::npos) {
+            if (this->componentCount < MAX_COMPONENTS) {
+                this->components[this->componentCount] = word;
+            }
+            this->componentCount++;
+            continue;
+        }
+
+        const string_view name = word.substr(0, split);
+        size_t option = 0;
+        while (option < OPTION_COUNT && name != OPTION_NAMES[option]) {
+            option++;
+        }
+
+        if (option < OPTION_COUNT) {
+            this->optionValues[option] = word.substr(split + 1);
+            this->optionGiven[option] = true;
+        } else if (!this->hasUnknownOption || name < this->unknownOption) {
+            this->unknownOption = name;
+            this->hasUnknownOption = true;
+        }
+    }
+}
+
+
+
 /**
  * Parses the elements of the request and determines if they are valid or not.
  * If found to be invalid, the error flag is raised and an error message is specified.
@@ -197,26 +414,54 @@ bool ParsedRequest::dataPortIsValid() {
  * @param request - the raw request string.
  * @return bool - true if the request was successfully parsed without error, false if not.
  */
-bool ParsedRequest::parseRequest(string &request) {
+bool ParsedRequest::parseRequest(string_view request) {
     // Make sure the request has any real value
     if (!hasAnyValue(request)) {
-        return this->raiseErrorFlag("The FTP request does not appear to have any valid arguments.");
+        return this->raiseErrorFlag(REQUEST_EMPTY, "The FTP request does not appear to have any valid arguments.");
     }
     
-    // Split the request into a vector of strings.
-    this->components = split(request);
+    // Split the request into its components, setting aside any options.
+    this->splitRequest(request);
     
     // validate each of the components, and return true only if all are valid.
     return (
             this->componentCountIsValid() &&
             this->commandIsValid() &&
             this->dataPortIsValid() &&
-            this->fileNameIsValid()
+            this->fileNameIsValid() &&
+            this->optionsAreValid()
         );
 }
 
 
 
+/**
+ * Finds a command in the table of commands.
+ * @param name - the command's name.
+ * @return const CommandSpec* - the command, or null if there is no such command.
+ */
+const ParsedRequest::CommandSpec *ParsedRequest::findCommand(string_view name) {
+    for (size_t i = 0; i < COMMAND_COUNT; i++) {
+        if (name == COMMANDS[i].name) {
+            return &COMMANDS[i];
+        }
+    }
+
+    return nullptr;
+}
+
+
+
+/**
+ * @param error - the check a request failed.
+ * @return const char* - a short name for the check, for counting errors by.
+ */
+const char *ParsedRequest::errorName(RequestError error) {
+    return ERROR_NAMES[error];
+}
+
+
+
 /**
  * Helper function to print the object data to the console.
  */
@@ -226,5 +471,12 @@ void ParsedRequest::printRequestData() {
     cout << "Command:\t" << this->command << endl;
     cout << "FileName:\t" << this->filename << endl;
     cout << "Data Port:\t" << this->dataPort << endl;
+    cout << "Passive Mode:\t" << this->passiveMode << endl;
+    cout << "Binary Mode:\t" << this->binaryMode << endl;
+    cout << "Framing:\t" << this->framingVersion << endl;
+    cout << "Range:\t\t" << this->rangeOffset << " + " << this->rangeLength << endl;
+    cout << "Streams:\t" << this->streams << endl;
+    cout << "Compression:\t" << this->compressionLevel << endl;
+    cout << "Delta:\t\t" << this->deltaMode << endl;
 }
 
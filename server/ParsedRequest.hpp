@@ -12,39 +12,100 @@
 #ifndef ParsedRequest_hpp
 #define ParsedRequest_hpp
 
+#include <cstddef>
 #include <string>
-#include <vector>
+#include <string_view>
+#include <sys/types.h>
 
 using std::string;
-using std::vector;
+using std::string_view;
+
+
+/**
+ * The check a request failed, for counting errors by their cause.
+ */
+enum RequestError {
+    REQUEST_OK,
+    REQUEST_EMPTY,              // the request had no words
+    REQUEST_ARGUMENT_COUNT,     // too few or too many words
+    REQUEST_UNKNOWN_COMMAND,
+    REQUEST_COMMAND_MISMATCH,   // the wrong number of words for the command
+    REQUEST_NO_FILENAME,
+    REQUEST_BAD_DATA_PORT,
+    REQUEST_UNKNOWN_OPTION,
+    REQUEST_BAD_OPTION,         // an option's value is invalid, or the option doesn't go with the command
+    REQUEST_OPTION_CONFLICT,    // the options are valid but can't be used together
+    REQUEST_ERROR_COUNT
+};
 
 
 class ParsedRequest {
   // Member Variables
   private:
+    /**
+     * A command, and the number of request components it takes
+     * (the command itself, a filename if it needs one, and the data port).
+     */
+    struct CommandSpec {
+        const char *name;
+        size_t componentCount;
+    };
+
+    static const size_t COMMAND_COUNT = 8;
+    static const size_t OPTION_COUNT = 7;
+    static const size_t MAX_COMPONENTS = 3;
+    static const CommandSpec COMMANDS[COMMAND_COUNT];       // in the order the error message lists them
+    static const char *const ERROR_NAMES[REQUEST_ERROR_COUNT];
+    static const char *const OPTION_NAMES[OPTION_COUNT];    // in name order, which is the order they're checked in
+
+    const int MAX_STREAMS = 16;   // the most data connections a striped download can use
+    const int MAX_COMPRESSION_LEVEL = 9;
+
     int commandPort;              // the port of the FTP command connection.
-    vector<string> components;    // the request components
+    string_view components[MAX_COMPONENTS];     // the first request components (options aside), viewing the request
+    size_t componentCount;        // the number of request components, even past MAX_COMPONENTS
+    string_view optionValues[OPTION_COUNT];     // the last value given for each option, viewing the request
+    bool optionGiven[OPTION_COUNT];
+    string_view unknownOption;    // the first (in name order) option name the server doesn't understand
+    bool hasUnknownOption;
     
   public:
-    string command;               // the command that the client sent, either -l, -la, or -g
-    string filename;              // the name of the file requested (if -g command was sent)
+    string_view command;          // the command that the client sent, either -l, -la, -ll, -lr, -g, -h, -hr or -stats
+    string filename;              // the name of the file requested (if -g or -h command was sent)
     int dataPort;                 // the port which should be used for the FTP data transfer
+    bool passiveMode;             // if true, the client connects to a server port instead of naming its own
+    bool binaryMode;              // if true (-g only), announce the file size and send the raw bytes without \done
+    int framingVersion;           // the data connection framing the client asked for, or 0 for newline/\done text
+    off_t rangeOffset;            // -g only: the first byte of the file to send
+    off_t rangeLength;            // -g only: the number of bytes to send, or -1 for the rest of the file
+    int streams;                  // -g only: the number of data connections to stripe the file across
+    int compressionLevel;         // the zlib level to compress DATA and LIST frames with, or 0 for none
+    bool deltaMode;               // -g only: if true, send the file as changes from the client's old copy
     bool errorFlag;               // an indicator of an error while validating the request.
+    RequestError error;           // the check that failed (if applicable)
     string errorMessage;          // an message describing the error (if applicable)
     
     
   // Member Functions
   private:
-    bool raiseErrorFlag(const string &message);
+    void reset();
+    bool raiseErrorFlag(RequestError error, const string &message);
     bool componentCountIsValid();
     bool commandIsValid();
     bool fileNameIsValid();
     bool dataPortIsValid();
-    bool parseRequest(string &request);
+    bool optionsAreValid();
+    bool optionIsValid(string_view name, string_view value);
+    void splitRequest(string_view request);
+    bool parseRequest(string_view request);
+    static const CommandSpec *findCommand(string_view name);
     
   public:
-    ParsedRequest(string &request, int commandPort);
+    ParsedRequest(string_view request, int commandPort);
+    void parse(string_view request);
     void printRequestData();
+
+    static const char *errorName(RequestError error);
 };
 
 
@@ -0,0 +1,163 @@
+/**
+ * Program Name: FTP Server
+ * File Name: PassivePortPool.cpp
+ * Author: Taylor Jones
+ * Last Modified: 10/16/26
+ * Description: PassivePortPool.cpp is the class implementation
+ *  file for the PassivePortPool class.
+ *
+ *  In passive mode, the client connects to the server for the data
+ *  connection instead of the other way around. Rather than creating,
+ *  binding and listening on a new socket for every request, the pool
+ *  does that once at startup and leases the listening sockets out: a
+ *  session holds a slot from the moment it announces the port until
+ *  its transfer is done. The pool is only used on the event loop's
+ *  thread, so it needs no locking.
+ */
+
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <netinet/in.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "PassivePortPool.hpp"
+#include "Util.hpp"
+
+
+/**
+ * Binds and starts listening on every port in the pool. Ports that
+ * can't be bound are reported and left out of the pool.
+ * @param firstPort - the first port of a contiguous range, or 0 to let
+ *  the system choose every port.
+ * @param count - the number of ports in the pool.
+ */
+PassivePortPool::PassivePortPool(int firstPort, int count) {
+    for (int i = 0; i < count; i++) {
+        Slot slot;
+        slot.sock = this->getListeningSocket(firstPort > 0 ? firstPort + i : 0, slot.port);
+
+        if (slot.sock >= 0) {
+            this->freeSlots.push_back(this->slots.size());
+            this->slots.push_back(slot);
+        }
+    }
+}
+
+
+
+/**
+ * Closes every listening socket in the pool.
+ */
+PassivePortPool::~PassivePortPool() {
+    for (const auto &slot : this->slots) {
+        close(slot.sock);
+    }
+}
+
+
+
+/**
+ * Creates a non-blocking socket that listens on the given port.
+ * @param port - the port to bind to, or 0 for any free port.
+ * @param boundPort - holds the port the socket was bound to.
+ * @return int - the listening socket, or -1 if it couldn't be created.
+ */
+int PassivePortPool::getListeningSocket(int port, int &boundPort) {
+    struct sockaddr_storage server;
+    socklen_t length;
+    int reuse = 1;
+
+    int sock = getServerSocket(port, server, length);
+    if (sock == -1) {
+        perror("Passive socket creation failed: socket()");
+        return -1;
+    }
+
+    if (setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) < 0 ||
+        bind(sock, (struct sockaddr*) &server, length) < 0 ||
+        listen(sock, SOMAXCONN) < 0 ||
+        getsockname(sock, (struct sockaddr*) &server, &length) < 0) {
+        perror("Passive socket setup failed");
+        close(sock);
+        return -1;
+    }
+
+    boundPort = ntohs(((struct sockaddr_in &) server).sin_port);     // sin6_port is in the same place
+    return sock;
+}
+
+
+
+/**
+ * Closes any connections still waiting on a listening socket,
+ * so they can't be mistaken for the next lease holder's client.
+ * @param sock - a listening socket.
+ */
+void PassivePortPool::drain(int sock) {
+    int stale;
+    while ((stale = accept4(sock, nullptr, nullptr, SOCK_CLOEXEC)) >= 0 || errno == EINTR || errno == ECONNABORTED) {
+        if (stale >= 0) {
+            close(stale);
+        }
+    }
+}
+
+
+
+/**
+ * Leases a port to a session.
+ * @return int - the leased slot, or -1 if every port is in use.
+ */
+int PassivePortPool::acquire() {
+    if (this->freeSlots.empty()) {
+        return -1;
+    }
+
+    int slot = this->freeSlots.back();
+    this->freeSlots.pop_back();
+    return slot;
+}
+
+
+
+/**
+ * Returns a leased port to the pool.
+ * @param slot - a slot returned by acquire().
+ */
+void PassivePortPool::release(int slot) {
+    this->drain(this->slots[slot].sock);
+    this->freeSlots.push_back(slot);
+}
+
+
+
+/**
+ * @param slot - a slot returned by acquire().
+ * @return int - the slot's listening socket.
+ */
+int PassivePortPool::socketAt(int slot) const {
+    return this->slots[slot].sock;
+}
+
+
+
+/**
+ * @param slot - a slot returned by acquire().
+ * @return int - the port the slot listens on.
+ */
+int PassivePortPool::portAt(int slot) const {
+    return this->slots[slot].port;
+}
+
+
+
+/**
+ * @return size_t - the number of ports in the pool.
+ */
+size_t PassivePortPool::size() const {
+    return this->slots.size();
+}
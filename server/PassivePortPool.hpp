@@ -0,0 +1,49 @@
+/**
+ * Program Name: FTP Server
+ * File Name: PassivePortPool.hpp
+ * Author: Taylor Jones
+ * Last Modified: 10/16/26
+ * Description: PassivePortPool.hpp is the class specification
+ *  file for the PassivePortPool class. This file contains declarations
+ *  for the member functions of the PassivePortPool class.
+ */
+
+
+#ifndef PassivePortPool_hpp
+#define PassivePortPool_hpp
+
+#include <cstddef>
+#include <vector>
+
+using std::vector;
+
+
+class PassivePortPool {
+  // Member Variables
+  private:
+    struct Slot {
+        int sock;           // a bound, listening (non-blocking) socket
+        int port;           // the port the socket is bound to
+    };
+
+    vector<Slot> slots;
+    vector<int> freeSlots;  // the slots that are not leased to a session
+
+  // Member Functions
+  private:
+    int getListeningSocket(int port, int &boundPort);
+    void drain(int sock);
+
+  public:
+    PassivePortPool(int firstPort, int count);
+    ~PassivePortPool();
+
+    int acquire();
+    void release(int slot);
+    int socketAt(int slot) const;
+    int portAt(int slot) const;
+    size_t size() const;
+};
+
+
+#endif /* PassivePortPool_hpp */
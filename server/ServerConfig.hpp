@@ -0,0 +1,61 @@
+/**
+ * Program Name: FTP Server
+ * File Name: ServerConfig.hpp
+ * Author: Taylor Jones
+ * Last Modified: 10/16/26
+ * Description: ServerConfig.hpp contains the settings that the
+ *  FTP server is started with. Every setting has a default, and
+ *  main.cpp overrides them from the command-line options.
+ */
+
+
+#ifndef ServerConfig_hpp
+#define ServerConfig_hpp
+
+#include <string>
+#include <thread>
+
+#include "Logger.hpp"
+
+
+struct ServerConfig {
+    int port;               // the port of the FTP control connection
+    unsigned workers;       // the number of threads that run data transfers
+    int passiveBase;        // the first passive data port, or 0 to let the system choose them
+    int passivePorts;       // the number of passive data ports kept listening
+    size_t listChunkSize;   // the size each directory listing buffer (and LIST frame) is filled to
+    size_t listFlushSize;   // how much of a directory listing to collect before each write
+    bool ioUring;           // true to send files through io_uring instead of with sendfile()
+    size_t mapCacheSize;    // the most file data kept memory-mapped for repeat downloads, or 0 for none
+    size_t contentCacheSize;    // the most small-file contents kept in memory, or 0 for none
+    std::string hashIndexPath;  // where file hashes are saved between runs, or empty to keep them in memory only
+    LogLevel logLevel;          // the least important messages to log
+    LogFullPolicy logFullPolicy;    // what a thread does when its log buffer is full
+    std::string logJsonPath;    // a file to also write log messages to as JSON lines, or empty for none
+    std::string metricsPath;    // a file the metrics are written to every metricsInterval seconds, or empty for none
+    int metricsInterval;        // the seconds between writes of the metrics file
+
+    ServerConfig() {
+        this->port = -1;
+        this->workers = std::thread::hardware_concurrency();
+        if (this->workers == 0) {
+            this->workers = 4;
+        }
+        this->passiveBase = 0;
+        this->passivePorts = 16;
+        this->listChunkSize = 64 * 1024;
+        this->listFlushSize = 1024 * 1024;
+        this->ioUring = false;
+        this->mapCacheSize = 256 * 1024 * 1024;
+        this->contentCacheSize = 64 * 1024 * 1024;
+        this->hashIndexPath = "";
+        this->logLevel = LOG_INFO;
+        this->logFullPolicy = LOG_DROP;
+        this->logJsonPath = "";
+        this->metricsPath = "";
+        this->metricsInterval = 10;
+    }
+};
+
+
+#endif /* ServerConfig_hpp */
@@ -0,0 +1,1059 @@
+/**
+ * Program Name: FTP Server
+ * File Name: Session.cpp
+ * Author: Taylor Jones
+ * Last Modified: 10/16/26
+ * Description: Session.cpp is the class implementation
+ *  file for the Session class. This file contains definitions
+ *  for the member functions of the Session class.
+ *
+ *  A Session holds everything the server knows about one FTP client:
+ *  its control connection, its data connection and the response being
+ *  sent. Every socket is non-blocking, so instead of waiting for the
+ *  client, each step of the exchange is a state that the session stays
+ *  in until the EventLoop reports that the client has caught up:
+ *
+ *  request -> \good -> client ready -> data connect -> stream -> \done
+ *
+ *  or, in passive mode, where the client connects to a leased server port:
+ *
+ *  request -> \good <port> -> data accept -> stream -> \done
+ *
+ *  Once a response is done, the session goes back to reading requests,
+ *  so a client can send any number of commands over one control
+ *  connection. Commands are handled strictly in order: a command that
+ *  arrives while a transfer is running waits in the control input until
+ *  the transfer is over. The session ends when the client sends \quit
+ *  or closes its side of the control connection.
+ *
+ *  The data phase (reading the directory or file and sending it) is
+ *  handed to a ThreadPool worker as a DataTransfer job, so the event
+ *  loop's thread only ever accepts clients and dispatches work. While a
+ *  job runs, the worker owns the data connection; the session picks up
+ *  again when the worker posts its result back to the loop.
+ */
+
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include "Util.hpp"
+#include "Session.hpp"
+
+using std::to_string;
+
+
+static const LogEvent REQUEST_RECEIVED = {
+    LOG_DEBUG, "request_received", "Request from {}: {}", { "client", "request" }
+};
+static const LogEvent LIST_REQUESTED = {
+    LOG_INFO, "list_requested", "List directory requested on {}.", { "data_port" }
+};
+static const LogEvent FILE_REQUESTED = {
+    LOG_INFO, "file_requested", "File \"{}\" requested on {}.", { "file", "data_port" }
+};
+static const LogEvent HASH_REQUESTED = {
+    LOG_INFO, "hash_requested", "Hash of \"{}\" requested on {}.", { "file", "data_port" }
+};
+static const LogEvent TREE_HASHES_REQUESTED = {
+    LOG_INFO, "tree_hashes_requested", "Hashes of every file requested on {}.", { "data_port" }
+};
+static const LogEvent DATA_CONNECTION_REFUSED = {
+    LOG_INFO, "data_connection_refused", "Refused data connection from {} on port {}.", { "peer", "data_port" }
+};
+static const LogEvent SENDING_LIST = {
+    LOG_INFO, "sending_list", "Sending directory contents to {}:{}.", { "client", "data_port" }
+};
+static const LogEvent SENDING_HASHES = {
+    LOG_INFO, "sending_hashes", "Sending hashes to {}:{}.", { "client", "data_port" }
+};
+static const LogEvent TRANSFER_CANCELLED = {
+    LOG_INFO, "transfer_cancelled", "Receiver cancelled the file transfer.", {}
+};
+static const LogEvent SENDING_STRIPED_FILE = {
+    LOG_INFO, "sending_file", "Sending \"{}\" to {}:{} over {} streams.", { "file", "client", "data_port", "streams" }
+};
+static const LogEvent SENDING_DELTA = {
+    LOG_INFO, "sending_delta", "Sending changes to \"{}\" to {}:{}.", { "file", "client", "data_port" }
+};
+static const LogEvent SENDING_FILE = {
+    LOG_INFO, "sending_file", "Sending \"{}\" to {}:{}.", { "file", "client", "data_port" }
+};
+static const LogEvent FILE_READY = {
+    LOG_INFO, "file_ready", "File \"{}\" ready to send to {}:{}.", { "file", "client", "data_port" }
+};
+static const LogEvent FILE_NOT_FOUND = {
+    LOG_INFO, "file_not_found", "File \"{}\" not found. Sending error message to {}:{}", { "file", "client", "data_port" }
+};
+static const LogEvent BAD_RANGE = {
+    LOG_INFO, "bad_range", "Requested range of \"{}\" is past the end of the file. Sending error message to {}:{}",
+    { "file", "client", "data_port" }
+};
+static const LogEvent DATA_CONNECTION_LOST = {
+    LOG_INFO, "data_connection_lost", "FTP data connection with {}:{} lost.", { "client", "data_port" }
+};
+static const LogEvent DATA_CONNECTION_CLOSED = {
+    LOG_INFO, "data_connection_closed", "FTP data connection with {}:{} closed.", { "client", "data_port" }
+};
+static const LogEvent TOO_MANY_QUEUED = {
+    LOG_WARN, "too_many_queued", "Closing the session with {}: it sent more than {} bytes of commands ahead.", { "client", "limit" }
+};
+static const LogEvent CONTROL_RECEIVE_FAILED = {
+    LOG_ERROR, "control_receive_failed", "Failed to receive client message.: {}", { "error" }
+};
+static const LogEvent DATA_SOCKET_FAILED = {
+    LOG_ERROR, "data_socket_failed", "Data socket creation failed: socket(): {}", { "error" }
+};
+static const LogEvent DATA_CONNECT_FAILED = {
+    LOG_ERROR, "data_connect_failed", "Data socket connection failed: connect(): {}", { "error" }
+};
+static const LogEvent DATA_ACCEPT_TIMED_OUT = {
+    LOG_INFO, "data_accept_timed_out", "Data connections from {} on port {} did not arrive in time.", { "client", "data_port" }
+};
+static const LogEvent DATA_ACCEPT_FAILED = {
+    LOG_ERROR, "data_accept_failed", "Error accepting data connection: accept(): {}", { "error" }
+};
+static const LogEvent DATA_TIMER_FAILED = {
+    LOG_ERROR, "data_timer_failed", "Data connection timer creation failed: timerfd_create(): {}", { "error" }
+};
+static const LogEvent DATA_SETUP_FAILED = {
+    LOG_ERROR, "data_setup_failed", "Data socket setup failed: setsockopt(): {}", { "error" }
+};
+
+
+
+/**
+ * Describes the data port of a request, as "a passive port" or "port <number>",
+ * without allocating.
+ * @param passive - true if the client connects to a passive port.
+ * @param port - the client's data port otherwise.
+ * @param buffer - holds the text of an active port.
+ * @return string_view - the description.
+ */
+static string_view describePort(bool passive, int port, char (&buffer)[32]) {
+    if (passive) {
+        return "a passive port";
+    }
+
+    memcpy(buffer, "port ", 5);
+    return string_view(buffer, std::to_chars(buffer + 5, buffer + sizeof(buffer), port).ptr - buffer);
+}
+
+
+/**
+ * Creates a session for a newly accepted client and starts
+ * waiting for the client's request.
+ * @param loop - the event loop that watches the session's sockets.
+ * @param pool - the workers that run the session's data transfers.
+ * @param passivePorts - the ports that passive-mode data connections are accepted on.
+ * @param listings - the cache of rendered directory listings.
+ * @param mappedFiles - the cache of mapped files.
+ * @param contents - the cache of small files' contents.
+ * @param hashes - the index of files' hashes.
+ * @param config - the settings the server was started with.
+ * @param log - where the session's messages go.
+ * @param metrics - where the session's requests are counted and timed.
+ * @param controlSock - the (non-blocking) control connection to the client.
+ * @param clientAddress - the (unmapped) address the client connected from.
+ * @param clientHost - the address of the client, as text.
+ * @param commandPort - the port of the FTP control connection.
+ */
+Session::Session(EventLoop &loop, ThreadPool &pool, PassivePortPool &passivePorts, ListingCache &listings,
+                 MappedFileCache &mappedFiles, ContentCache &contents, HashIndex &hashes, const ServerConfig &config,
+                 Logger &log, Metrics &metrics, int controlSock, const struct sockaddr_storage &clientAddress,
+                 string clientHost, int commandPort) :
+    loop(loop), pool(pool), passivePorts(passivePorts), listings(listings), mappedFiles(mappedFiles), contents(contents),
+    hashes(hashes), config(config), log(log), metrics(metrics) {
+    this->state = READING_REQUEST;
+    this->jobsRunning = 0;
+    this->jobsResult = TRANSFER_OK;
+    this->closeRequested = false;
+    this->commandPort = commandPort;
+    this->controlSock = controlSock;
+    this->passiveSlot = -1;
+    this->controlClosed = false;
+    this->controlStart = 0;
+    this->queuedBytes = 0;
+    this->clientAddress = clientAddress;
+    this->clientHost = clientHost;
+    this->connectTimer = -1;
+    this->requestCommand = Metrics::INVALID_COMMAND;
+    this->requestStart = 0;
+
+    this->metrics.countSessionOpened();
+    this->loop.watch(controlSock, EPOLLIN, this);
+}
+
+
+
+/**
+ * Closes any socket the session still has open.
+ */
+Session::~Session() {
+    this->releasePassivePort();
+    this->closeDataSockets();
+
+    if (this->connectTimer >= 0) {
+        this->loop.unwatch(this->connectTimer);
+        close(this->connectTimer);
+    }
+    if (this->controlSock >= 0) {
+        this->loop.unwatch(this->controlSock);
+        close(this->controlSock);
+    }
+    this->metrics.countSessionClosed();
+}
+
+
+
+/**
+ * Reacts to activity on either of the session's sockets, and then
+ * moves the session along as far as it can go.
+ * @param fd - the socket with activity.
+ * @param events - the epoll events that occurred.
+ */
+void Session::handleEvent(int fd, uint32_t events) {
+    if (this->state == CLOSED || this->closeRequested) {
+        return;
+    }
+
+    if (fd == this->controlSock) {
+        if (events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+            this->readControl();
+        }
+
+        if ((events & EPOLLOUT) && !this->controlOut.flush(this->controlSock)) {
+            this->finish();
+            return;
+        }
+    } else if (fd == this->connectTimer) {
+        uint64_t expirations;
+        if (read(this->connectTimer, &expirations, sizeof(expirations)) > 0) {
+            if (this->state == CONNECTING_DATA) {
+                this->log.log(DATA_CONNECT_FAILED, LogErrno{ETIMEDOUT});
+                this->failDataConnect(ETIMEDOUT);
+            } else if (this->state == ACCEPTING_DATA) {
+                this->log.log(DATA_ACCEPT_TIMED_OUT, this->clientHost, this->parsedRequest->dataPort);
+                this->failDataConnect(ETIMEDOUT);
+            }
+        }
+    } else if (this->state == CONNECTING_DATA) {
+        this->finishDataConnect(fd);
+    } else if (this->passiveSlot >= 0 && fd == this->passivePorts.socketAt(this->passiveSlot) && this->state == ACCEPTING_DATA) {
+        this->acceptDataConnection();
+    }
+
+    this->advance();
+}
+
+
+
+/**
+ * Takes the next message from the control input. A message is a newline-terminated
+ * line, so several messages can arrive in one read and a message can be split
+ * across reads. Whatever is left without a newline only counts as a message once
+ * the client has stopped sending (or has filled the input buffer).
+ * The message isn't copied: it points into the control input, and stays
+ * valid until the next read from the control connection.
+ * @param message - holds the message, without its newline.
+ * @return bool - true if a message was taken, false if there is no complete message yet.
+ */
+bool Session::takeMessage(string_view &message) {
+    const string_view input = string_view(this->controlIn).substr(this->controlStart);
+    if (input.empty()) {
+        return false;
+    }
+
+    size_t end = input.find('\n');
+    if (end == string_view::npos) {
+        if (!this->controlClosed && input.size() < MAX_CONTROL_INPUT) {
+            return false;
+        }
+
+        message = input;
+        this->controlStart = this->controlIn.size();
+    } else {
+        message = input.substr(0, end);
+        this->controlStart += end + 1;
+    }
+
+    return true;
+}
+
+
+
+/**
+ * Checks whether a control message is a command (every command starts
+ * with a dash), rather than a reply such as \ready or \cancel.
+ * @param message - a control message.
+ * @return bool - true if the message is a command.
+ */
+bool Session::isRequest(string_view message) {
+    size_t start = message.find_first_not_of(" \t");
+    return start != string_view::npos && message[start] == '-';
+}
+
+
+
+/**
+ * Reads everything that is currently available on the control connection,
+ * after dropping the messages that have already been taken.
+ */
+void Session::readControl() {
+    char buffer[4096];
+
+    this->controlIn.erase(0, this->controlStart);
+    this->controlStart = 0;
+
+    while (!this->controlClosed && this->controlIn.size() < MAX_CONTROL_INPUT) {
+        ssize_t received = recv(this->controlSock, buffer, sizeof(buffer), 0);
+
+        if (received > 0) {
+            this->controlIn.append(buffer, received);
+        } else if (received == 0) {
+            this->controlClosed = true;
+        } else if (errno == EINTR) {
+            continue;
+        } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            break;
+        } else {
+            this->log.log(CONTROL_RECEIVE_FAILED, LogErrno{errno});
+            this->controlClosed = true;
+        }
+    }
+}
+
+
+
+/**
+ * Starts a non-blocking connection to the client's data port, at the address
+ * the client connected from (so there is no host to look up). The connection
+ * is finished by finishDataConnect() once the socket becomes writable.
+ * @param port - the port number the client is listening on.
+ * @return int - the connecting socket, or -1 (with errno set) if the connection could not be started.
+ */
+int Session::getDataSocket(int port) {
+    // Specify the FTP client connection.
+    struct sockaddr_storage address = this->clientAddress;
+    if (address.ss_family == AF_INET6) {
+        ((struct sockaddr_in6 &) address).sin6_port = htons(port);
+    } else {
+        ((struct sockaddr_in &) address).sin_port = htons(port);
+    }
+
+    // Create a data socket
+    int dSock = socket(address.ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (dSock == -1) {
+        int error = errno;
+        this->log.log(DATA_SOCKET_FAILED, LogErrno{error});
+        errno = error;
+        return -1;
+    }
+
+    // Start connecting to the FTP client using the data socket.
+    if (connect(dSock, (struct sockaddr *) &address, addressLength(address)) < 0 && errno != EINPROGRESS) {
+        int error = errno;
+        this->log.log(DATA_CONNECT_FAILED, LogErrno{error});
+        close(dSock);
+        errno = error;
+        return -1;
+    }
+
+    return dSock;
+}
+
+
+
+/**
+ * Checks the outcome of a data connection and, once every data connection
+ * has succeeded, starts the response that the client requested.
+ * @param fd - a data socket that has finished connecting.
+ */
+void Session::finishDataConnect(int fd) {
+    auto found = std::find(this->connectingSocks.begin(), this->connectingSocks.end(), fd);
+    if (found == this->connectingSocks.end()) {
+        return;
+    }
+
+    this->connectingSocks.erase(found);
+    this->dataSocks.push_back(fd);
+    this->loop.update(fd, 0);
+
+    int error = 0;
+    socklen_t length = sizeof(error);
+
+    if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &length) < 0 || error != 0) {
+        error = error ? error : errno;
+        this->log.log(DATA_CONNECT_FAILED, LogErrno{error});
+        this->failDataConnect(error);
+        return;
+    }
+
+    if (this->connectingSocks.empty()) {
+        this->setConnectTimer(0);
+        this->startResponse();
+    }
+}
+
+
+
+/**
+ * Arms or disarms the timer that limits how long the data connections may
+ * take. The timer is created the first time it is needed and then kept for
+ * the rest of the session.
+ * @param seconds - how long from now the timer fires, or 0 to disarm it.
+ */
+void Session::setConnectTimer(int seconds) {
+    struct itimerspec timeout = {};
+    timeout.it_value.tv_sec = seconds;
+
+    if (this->connectTimer < 0) {
+        if (seconds == 0) {
+            return;
+        }
+        this->connectTimer = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        if (this->connectTimer < 0) {
+            // without the timer, the system's own (much longer) connect timeout still applies.
+            this->log.log(DATA_TIMER_FAILED, LogErrno{errno});
+            return;
+        }
+        this->loop.watch(this->connectTimer, EPOLLIN, this);
+    }
+
+    timerfd_settime(this->connectTimer, 0, &timeout, nullptr);
+}
+
+
+
+/**
+ * Gives up on the data connections of the current request (releasing its
+ * passive port, if it leased one) and tells the client why on the control
+ * connection. The session stays open and goes back to reading requests.
+ * @param error - why the connection failed, as an errno value.
+ */
+void Session::failDataConnect(int error) {
+    const bool passive = this->passiveSlot >= 0;
+
+    this->setConnectTimer(0);
+    this->closeDataSockets();
+    this->releasePassivePort();
+    this->metrics.countTransferError(TRANSFER_FAILED);
+    this->recordTransfer();
+
+    this->controlOut.appendLine((passive ? DATA_ACCEPT_FAILED_MSG : DATA_CONNECT_FAILED_MSG) + " " +
+        to_string(this->parsedRequest->dataPort) + ": " + strerror(error) + ".");
+    this->state = READING_REQUEST;
+}
+
+
+
+/**
+ * Accepts the client's data connections on the leased passive port and, once
+ * they have all arrived, starts the response that the client requested. Connections
+ * from any other host are turned away, so a leased port can't be used to read
+ * another client's data.
+ */
+void Session::acceptDataConnection() {
+    int listenSock = this->passivePorts.socketAt(this->passiveSlot);
+
+    while ((int) this->dataSocks.size() < this->parsedRequest->streams) {
+        struct sockaddr_storage peer;
+        socklen_t sizeOfPeer = sizeof(peer);
+
+        int sock = accept4(listenSock, (struct sockaddr*) &peer, &sizeOfPeer, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (sock < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                this->log.log(DATA_ACCEPT_FAILED, LogErrno{errno});
+            }
+            return;
+        }
+
+        unmapAddress(peer);
+        if (!sameHost(peer, this->clientAddress)) {
+            this->log.log(DATA_CONNECTION_REFUSED, addressHost(peer), this->parsedRequest->dataPort);
+            close(sock);
+            continue;
+        }
+
+        this->dataSocks.push_back(sock);
+        this->loop.watch(sock, 0, this);
+    }
+
+    this->loop.update(listenSock, 0);
+    this->setConnectTimer(0);
+    this->startResponse();
+}
+
+
+
+/**
+ * Starts the response that the client requested. From here on the data
+ * connections are only used by workers, so they are switched to blocking mode
+ * with a send timeout that keeps a stalled client from holding a worker forever
+ * (and, for a delta download, the same receive timeout for the client's signatures).
+ */
+void Session::startResponse() {
+    struct timeval timeout;
+    timeout.tv_sec = DATA_TIMEOUT_SECONDS;
+    timeout.tv_usec = 0;
+
+    this->metrics.recordTime(this->requestCommand, PHASE_CONNECT, Metrics::now() - this->requestStart);
+    for (int sock : this->dataSocks) {
+        if (!setBlocking(sock, true) ||
+            setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout)) < 0 ||
+            (this->parsedRequest->deltaMode && setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) < 0)) {
+            this->log.log(DATA_SETUP_FAILED, LogErrno{errno});
+            this->finish();
+            return;
+        }
+    }
+
+    // use the parsedRequest information to determine what to send back to the client.
+    string_view cmd = this->parsedRequest->command;
+    if (cmd == LIST_CMD) {
+        this->sendDirectoryList(false);
+    } else if (cmd == LIST_ALL_CMD) {
+        this->sendDirectoryList(true);
+    } else if (cmd == LIST_WITH_SIZE_CMD) {
+        this->sendDirectoryList(true, true);
+    } else if (cmd == LIST_RECURSIVE_CMD) {
+        this->sendDirectoryList(true, true, true);
+    } else if (cmd == GET_CMD) {
+        this->sendRequestedFile();
+    } else if (cmd == HASH_CMD || cmd == HASH_RECURSIVE_CMD) {
+        this->sendHashes();
+    }
+}
+
+
+
+/**
+ * Parses the request with the session's ParsedRequest (which is reused from
+ * request to request, so parsing doesn't allocate), and then either queues an
+ * error message for the client (if applicable) or tells the client that its request is valid.
+ * A -stats request is answered at once, on the control connection.
+ * @param request - a string representing the request sent from the client.
+ */
+void Session::processClientRequest(string_view request) {
+    this->requestStart = Metrics::now();
+    if (this->parsedRequest) {
+        this->parsedRequest->parse(request);
+    } else {
+        this->parsedRequest.reset(new ParsedRequest(request, this->commandPort));
+    }
+    string_view cmd = this->parsedRequest->command;
+    this->requestCommand = this->parsedRequest->errorFlag ? Metrics::INVALID_COMMAND : Metrics::commandIndex(cmd);
+    this->metrics.countRequest(this->requestCommand);
+    this->metrics.recordTime(this->requestCommand, PHASE_PARSE, Metrics::now() - this->requestStart);
+    char portBuffer[32];
+    string_view port = describePort(this->parsedRequest->passiveMode, this->parsedRequest->dataPort, portBuffer);
+
+    // log a message indicating the information requested from the client.
+    this->log.log(REQUEST_RECEIVED, this->clientHost, request);
+    if (cmd == LIST_CMD || cmd == LIST_ALL_CMD || cmd == LIST_WITH_SIZE_CMD || cmd == LIST_RECURSIVE_CMD) {
+        this->log.log(LIST_REQUESTED, port);
+    } else if (cmd == GET_CMD) {
+        this->log.log(FILE_REQUESTED, this->parsedRequest->filename, port);
+    } else if (cmd == HASH_CMD) {
+        this->log.log(HASH_REQUESTED, this->parsedRequest->filename, port);
+    } else if (cmd == HASH_RECURSIVE_CMD) {
+        this->log.log(TREE_HASHES_REQUESTED, port);
+    }
+
+    // If for an error flag, which indicates an invalid command.
+    // If found, send the error message to the client.
+    if (this->parsedRequest->errorFlag) {
+        this->metrics.countRequestError(this->parsedRequest->error);
+        this->controlOut.appendLine(this->parsedRequest->errorMessage);
+        this->state = READING_REQUEST;
+    } else if (cmd == STATS_CMD) {
+        this->controlOut.append(this->metrics.render(this->contents, this->hashes));
+        this->controlOut.appendLine(DONE_MSG);
+        this->state = READING_REQUEST;
+    } else if (this->parsedRequest->passiveMode) {
+        // Lease a data port and tell the client to connect to it.
+        this->passiveSlot = this->passivePorts.acquire();
+        if (this->passiveSlot < 0) {
+            this->controlOut.appendLine(NO_PASSIVE_PORT_MSG);
+            this->state = READING_REQUEST;
+            return;
+        }
+
+        this->parsedRequest->dataPort = this->passivePorts.portAt(this->passiveSlot);
+        this->loop.watch(this->passivePorts.socketAt(this->passiveSlot), EPOLLIN, this);
+        this->controlOut.appendLine(GOOD_MSG + " " + to_string(this->parsedRequest->dataPort));
+        this->state = ACCEPTING_DATA;
+
+        // a client that never connects (or opens fewer streams than it asked for) can't keep the port.
+        this->setConnectTimer(DATA_CONNECT_TIMEOUT_SECONDS);
+    } else {
+        // The client's request was valid. Wait for the client to be ready for the data response.
+        this->controlOut.appendLine(GOOD_MSG);
+        this->state = AWAITING_CLIENT_READY;
+    }
+}
+
+
+
+/**
+ * Starts the data connections with the client once the client is ready for them
+ * (one connection, or one per stream for a striped download).
+ */
+void Session::processDataResponse() {
+    this->state = CONNECTING_DATA;
+
+    for (int i = 0; i < this->parsedRequest->streams; i++) {
+        int sock = this->getDataSocket(this->parsedRequest->dataPort);
+
+        if (sock < 0) {
+            this->failDataConnect(errno);
+            return;
+        }
+
+        this->connectingSocks.push_back(sock);
+        this->loop.watch(sock, EPOLLOUT, this);
+    }
+
+    this->setConnectTimer(DATA_CONNECT_TIMEOUT_SECONDS);
+}
+
+
+
+/**
+ * Hands the directory listing over to a worker, which
+ * sends it over the data connection.
+ */
+void Session::sendDirectoryList(bool showHidden, bool showSize, bool showRecursive) {
+    this->log.log(SENDING_LIST, this->clientHost, this->parsedRequest->dataPort);
+
+    int sock = this->dataSocks.front();
+    int framing = this->parsedRequest->framingVersion;
+    int compression = this->parsedRequest->compressionLevel;
+    ListingCache *cache = &this->listings;
+    size_t chunkSize = this->config.listChunkSize;
+    size_t flushSize = this->config.listFlushSize;
+    TransferMeter *meter = &this->meter;
+    this->dispatch(STREAMING, [sock, framing, compression, cache, chunkSize, flushSize, showHidden, showSize, showRecursive, meter]() {
+        DataTransfer transfer(sock, framing);
+        transfer.setMeter(meter);
+        transfer.setListBatching(chunkSize, flushSize);
+        transfer.setCompression(compression);
+        return transfer.sendDirectoryList(showHidden, showSize, showRecursive, cache);
+    });
+}
+
+
+
+/**
+ * Hands the requested file over to a worker, which tells the client
+ * whether the file can be sent (or sends an error message if it can't).
+ * For a striped download, the answer goes over the first data connection.
+ */
+void Session::sendRequestedFile() {
+    int sock = this->dataSocks.front();
+    string filename = this->parsedRequest->filename;
+    bool binaryMode = this->parsedRequest->binaryMode;
+    int framing = this->parsedRequest->framingVersion;
+    int compression = this->parsedRequest->compressionLevel;
+    shared_ptr<OfferedFile> file(new OfferedFile(this->parsedRequest->rangeOffset, this->parsedRequest->rangeLength));
+    MappedFileCache *cache = &this->mappedFiles;
+    ContentCache *contents = &this->contents;
+    TransferMeter *meter = &this->meter;
+
+    this->offeredFile = file;
+    this->dispatch(OFFERING_FILE, [sock, framing, compression, filename, file, binaryMode, cache, contents, meter]() {
+        DataTransfer transfer(sock, framing);
+        transfer.setMeter(meter);
+        transfer.setCompression(compression);
+        return transfer.offerFile(filename, *file, binaryMode, cache, contents);
+    });
+}
+
+
+
+/**
+ * Hands the hashing over to a worker, which sends the hash of the requested
+ * file, or of every file in the directory tree, over the data connection.
+ */
+void Session::sendHashes() {
+    this->log.log(SENDING_HASHES, this->clientHost, this->parsedRequest->dataPort);
+
+    int sock = this->dataSocks.front();
+    int framing = this->parsedRequest->framingVersion;
+    int compression = this->parsedRequest->compressionLevel;
+    string filename = this->parsedRequest->command == HASH_CMD ? this->parsedRequest->filename : "";
+    HashIndex *index = &this->hashes;
+    TransferMeter *meter = &this->meter;
+    this->dispatch(STREAMING, [sock, framing, compression, filename, index, meter]() {
+        DataTransfer transfer(sock, framing);
+        transfer.setMeter(meter);
+        transfer.setCompression(compression);
+        return transfer.sendHashes(filename, *index);
+    });
+}
+
+
+
+/**
+ * Handles the client's answer to a file being ready: either
+ * have a worker send the file or, if the client cancelled, finish up.
+ * A striped download is split into chunks that a worker per data
+ * connection takes turns sending, so the chunks arrive out of order.
+ * A delta download waits for the client's signatures and sends only the changes.
+ * @param reply - the client's message.
+ */
+void Session::receiveTransferReply(string_view reply) {
+    int sock = this->dataSocks.front();
+    string filename = this->parsedRequest->filename;
+    bool binaryMode = this->parsedRequest->binaryMode;
+    int framing = this->parsedRequest->framingVersion;
+    int compression = this->parsedRequest->compressionLevel;
+    shared_ptr<OfferedFile> file = this->offeredFile;
+    bool ioUring = this->config.ioUring;
+    int timeout = DATA_TIMEOUT_SECONDS;
+    TransferMeter *meter = &this->meter;
+
+    if (reply.find(CANCEL_MSG) != string_view::npos) {  // indicate if the client cancelled receiving the file.
+        this->log.log(TRANSFER_CANCELLED);
+        for (int stream : this->dataSocks) {
+            this->dispatch(STREAMING, [stream, framing, meter]() {
+                DataTransfer transfer(stream, framing);
+                transfer.setMeter(meter);
+                return transfer.sendEnd();
+            });
+        }
+    } else if (this->dataSocks.size() > 1) {
+        this->log.log(SENDING_STRIPED_FILE, filename, this->clientHost, this->parsedRequest->dataPort, this->dataSocks.size());
+
+        shared_ptr<StripePlan> plan(new StripePlan(file->size, STRIPE_CHUNK_SIZE));
+        for (int stream : this->dataSocks) {
+            this->dispatch(STREAMING, [stream, framing, file, plan, ioUring, timeout, meter]() {
+                DataTransfer transfer(stream, framing);
+                transfer.setMeter(meter);
+                transfer.setIoRing(ioUring ? IoRing::forThread() : nullptr, timeout);
+                return transfer.sendChunks(*file, *plan);
+            });
+        }
+    } else if (this->parsedRequest->deltaMode) {
+        this->log.log(SENDING_DELTA, filename, this->clientHost, this->parsedRequest->dataPort);
+        this->dispatch(STREAMING, [sock, framing, compression, file, ioUring, timeout, meter]() {
+            DataTransfer transfer(sock, framing);
+            transfer.setMeter(meter);
+            transfer.setIoRing(ioUring ? IoRing::forThread() : nullptr, timeout);
+            transfer.setCompression(compression);
+            return transfer.sendDelta(*file);
+        });
+    } else {
+        this->log.log(SENDING_FILE, filename, this->clientHost, this->parsedRequest->dataPort);
+        this->dispatch(STREAMING, [sock, framing, compression, file, binaryMode, ioUring, timeout, meter]() {
+            DataTransfer transfer(sock, framing);
+            transfer.setMeter(meter);
+            transfer.setIoRing(ioUring ? IoRing::forThread() : nullptr, timeout);
+            transfer.setCompression(compression);
+            return transfer.sendFile(*file, binaryMode);
+        });
+    }
+}
+
+
+
+/**
+ * Runs a data transfer job on a worker. When the job is done, its result
+ * is posted back to the event loop, which calls finishTransfer(). Several
+ * jobs (one per stream) can be dispatched for the same step.
+ * @param next - the state to wait in while the job runs.
+ * @param job - the transfer to run.
+ */
+void Session::dispatch(SessionState next, function<TransferResult()> job) {
+    Session *session = this;
+    EventLoop *loop = &this->loop;
+
+    this->state = next;
+    this->jobsRunning++;
+
+    this->pool.submit([session, loop, job]() {
+        TransferResult result = job();
+        loop->post([session, result]() { session->finishTransfer(result); });
+    });
+}
+
+
+
+/**
+ * Picks the session back up after the workers have finished with the data connections.
+ * If one stream of a striped download fails, the others are shut down so
+ * their workers give up right away instead of finishing a useless transfer.
+ * @param result - the outcome of one worker's job.
+ */
+void Session::finishTransfer(TransferResult result) {
+    this->jobsRunning--;
+    if (result == TRANSFER_FAILED && this->jobsResult != TRANSFER_FAILED) {
+        for (int sock : this->dataSocks) {
+            shutdown(sock, SHUT_RDWR);
+        }
+    }
+    if (result != TRANSFER_OK && this->jobsResult != TRANSFER_FAILED) {
+        this->jobsResult = result;
+    }
+
+    if (this->jobsRunning > 0) {
+        return;
+    }
+
+    result = this->jobsResult;
+    this->jobsResult = TRANSFER_OK;
+    int dataPort = this->parsedRequest->dataPort;
+    if (result != TRANSFER_OK) {
+        this->metrics.countTransferError(result);
+    }
+
+    if (result == TRANSFER_FAILED) {
+        this->log.log(DATA_CONNECTION_LOST, this->clientHost, dataPort);
+        this->recordTransfer();
+        this->closeRequested = false;
+        this->finish();
+        return;
+    }
+
+    if (this->closeRequested) {
+        this->closeRequested = false;
+        this->finish();
+        return;
+    }
+
+    if (this->state == OFFERING_FILE && result == TRANSFER_OK) {
+        this->log.log(FILE_READY, this->parsedRequest->filename, this->clientHost, dataPort);
+        this->state = AWAITING_TRANSFER_READY;
+    } else {
+        if (result == TRANSFER_NOT_FOUND) {
+            this->log.log(FILE_NOT_FOUND, this->parsedRequest->filename, this->clientHost, dataPort);
+        } else if (result == TRANSFER_BAD_RANGE) {
+            this->log.log(BAD_RANGE, this->parsedRequest->filename, this->clientHost, dataPort);
+        }
+
+        this->closeDataConnection();
+        this->state = READING_REQUEST;
+    }
+
+    this->advance();
+}
+
+
+
+/**
+ * Closes the data connections once the response has been sent.
+ */
+void Session::closeDataConnection() {
+    this->closeDataSockets();
+    this->offeredFile.reset();
+    this->releasePassivePort();
+    this->recordTransfer();
+
+    this->log.log(DATA_CONNECTION_CLOSED, this->clientHost, this->parsedRequest->dataPort);
+}
+
+
+
+/**
+ * Counts what the workers sent for the request, and when the first byte and
+ * the end of the response went out. Called once the data connections are done with.
+ */
+void Session::recordTransfer() {
+    if (this->requestStart == 0) {
+        return;
+    }
+
+    const int64_t firstByte = this->meter.firstByte.load();
+    this->metrics.countBytesSent(this->requestCommand, this->meter.bytes.load());
+    if (firstByte != 0) {
+        this->metrics.recordTime(this->requestCommand, PHASE_FIRST_BYTE, firstByte - this->requestStart);
+    }
+    this->metrics.recordTime(this->requestCommand, PHASE_COMPLETE, Metrics::now() - this->requestStart);
+
+    this->requestStart = 0;
+    this->meter.bytes = 0;
+    this->meter.firstByte = 0;
+}
+
+
+
+/**
+ * Moves the session through as many states as it can without
+ * waiting on the client, and then updates the events it waits for.
+ */
+void Session::advance() {
+    bool progressed = true;
+    string_view message;
+
+    while (progressed && this->state != CLOSED && !this->closeRequested) {
+        progressed = false;
+
+        switch (this->state) {
+            case READING_REQUEST:
+                // blank lines are leftovers from the client's previous message.
+                if (!this->queuedRequests.empty()) {
+                    this->queuedBytes -= this->queuedRequests.front().size();
+                    this->processClientRequest(this->queuedRequests.front());
+                    this->queuedRequests.pop_front();
+                    progressed = true;
+                } else if (this->takeMessage(message)) {
+                    if (message == QUIT_MSG) {
+                        this->state = CLOSING;
+                    } else if (hasAnyValue(message)) {
+                        this->processClientRequest(message);
+                    }
+                    progressed = true;
+                } else if (this->controlClosed) {
+                    this->state = CLOSING;
+                    progressed = true;
+                }
+                break;
+
+            case AWAITING_CLIENT_READY:
+            case AWAITING_TRANSFER_READY:
+                // blank lines are leftovers from the client's previous message, and
+                // commands are ones the client sent ahead, which wait their turn. They
+                // are copied out of the control input, so they are limited separately.
+                if (this->takeMessage(message)) {
+                    if (this->isRequest(message)) {
+                        this->queuedBytes += message.size();
+                        if (this->queuedBytes > MAX_QUEUED_INPUT) {
+                            this->log.log(TOO_MANY_QUEUED, this->clientHost, MAX_QUEUED_INPUT);
+                            this->finish();
+                            break;
+                        }
+                        this->queuedRequests.push_back(string(message));
+                    } else if (hasAnyValue(message)) {
+                        if (this->state == AWAITING_CLIENT_READY) {
+                            this->processDataResponse();
+                        } else {
+                            this->receiveTransferReply(message);
+                        }
+                    }
+                    progressed = true;
+                } else if (this->controlClosed) {
+                    this->finish();
+                }
+                break;
+
+            case ACCEPTING_DATA:
+                if (this->controlClosed) {
+                    this->finish();
+                }
+                break;
+
+            case CLOSING:
+                if (this->controlOut.empty()) {
+                    this->finish();
+                }
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    if (this->state != CLOSED && !this->closeRequested) {
+        this->updateEvents();
+    }
+}
+
+
+
+/**
+ * Waits for control input whenever more can be buffered, and for
+ * writability whenever output is queued (or a connection is in progress).
+ */
+void Session::updateEvents() {
+    uint32_t controlEvents = 0;
+    if (!this->controlClosed && this->controlIn.size() - this->controlStart < MAX_CONTROL_INPUT) {
+        controlEvents |= EPOLLIN;
+    }
+    if (!this->controlOut.empty()) {
+        controlEvents |= EPOLLOUT;
+    }
+    this->loop.update(this->controlSock, controlEvents);
+
+    for (int sock : this->connectingSocks) {
+        this->loop.update(sock, EPOLLOUT);
+    }
+
+    if (this->passiveSlot >= 0) {
+        this->loop.update(this->passivePorts.socketAt(this->passiveSlot), this->state == ACCEPTING_DATA ? EPOLLIN : 0);
+    }
+}
+
+
+
+/**
+ * Closes every data connection, including any that are still connecting.
+ */
+void Session::closeDataSockets() {
+    for (int sock : this->connectingSocks) {
+        this->loop.unwatch(sock);
+        close(sock);
+    }
+
+    for (int sock : this->dataSocks) {
+        this->loop.unwatch(sock);
+        close(sock);
+    }
+
+    this->connectingSocks.clear();
+    this->dataSocks.clear();
+}
+
+
+
+/**
+ * Returns a leased passive port to the pool, once the data connection
+ * has been accepted from it and the transfer is over.
+ */
+void Session::releasePassivePort() {
+    if (this->passiveSlot >= 0) {
+        this->loop.unwatch(this->passivePorts.socketAt(this->passiveSlot));
+        this->passivePorts.release(this->passiveSlot);
+        this->passiveSlot = -1;
+    }
+}
+
+
+
+/**
+ * Closes both connections and hands the session back to the loop for deletion.
+ * If a worker is still using the data connection, the session stops listening
+ * to the client and closes once the worker is done.
+ */
+void Session::finish() {
+    if (this->state == CLOSED) {
+        return;
+    }
+
+    if (this->jobsRunning > 0) {
+        this->closeRequested = true;
+        this->loop.update(this->controlSock, 0);
+        return;
+    }
+
+    this->closeDataSockets();
+
+    this->releasePassivePort();
+    this->loop.unwatch(this->controlSock);
+    close(this->controlSock);
+    this->controlSock = -1;
+
+    this->state = CLOSED;
+    this->loop.retire(this);
+}
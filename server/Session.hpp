@@ -0,0 +1,166 @@
+/**
+ * Program Name: FTP Server
+ * File Name: Session.hpp
+ * Author: Taylor Jones
+ * Last Modified: 10/16/26
+ * Description: Session.hpp is the class specification
+ *  file for the Session class. This file contains declarations
+ *  for the member functions of the Session class.
+ */
+
+
+#ifndef Session_hpp
+#define Session_hpp
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "DataTransfer.hpp"
+#include "EventLoop.hpp"
+#include "ListingCache.hpp"
+#include "ContentCache.hpp"
+#include "HashIndex.hpp"
+#include "Logger.hpp"
+#include "MappedFileCache.hpp"
+#include "Metrics.hpp"
+#include "OutputBuffer.hpp"
+#include "ParsedRequest.hpp"
+#include "PassivePortPool.hpp"
+#include "ServerConfig.hpp"
+#include "ThreadPool.hpp"
+
+using std::function;
+using std::shared_ptr;
+using std::string;
+using std::string_view;
+using std::unique_ptr;
+using std::vector;
+
+
+/**
+ * The steps a client session moves through, in order.
+ */
+enum SessionState {
+    READING_REQUEST,            // waiting for the client's next request on the control connection
+    AWAITING_CLIENT_READY,      // \good sent, waiting for the client to open its data port
+    CONNECTING_DATA,            // connecting to the client's data port
+    ACCEPTING_DATA,             // passive mode: \good <port> sent, waiting for the client to connect
+    OFFERING_FILE,              // -g only: a worker is telling the client whether the file can be sent
+    AWAITING_TRANSFER_READY,    // -g only: \good sent on the data connection, waiting for \ready or \cancel
+    STREAMING,                  // workers are sending the response (ending with \done) on the data connection(s)
+    CLOSING,                    // the client is done (\quit or EOF): waiting for the control connection to drain
+    CLOSED                      // finished, waiting to be deleted
+};
+
+
+class Session : public EventHandler {
+  // Member Variables
+  private:
+    const string GOOD_MSG = "\\good";
+    const string CANCEL_MSG = "\\cancel";
+    const string DONE_MSG = "\\done";
+    const string QUIT_MSG = "\\quit";
+    const string NO_PASSIVE_PORT_MSG = "No passive data ports are available. Please try again later.";
+    const string DATA_CONNECT_FAILED_MSG = "Could not connect to your data port";
+    const string DATA_ACCEPT_FAILED_MSG = "Your data connections did not all arrive on port";
+
+    const string LIST_CMD = "-l";
+    const string LIST_ALL_CMD = "-la";
+    const string LIST_WITH_SIZE_CMD = "-ll";
+    const string LIST_RECURSIVE_CMD = "-lr";
+    const string GET_CMD = "-g";
+    const string HASH_CMD = "-h";
+    const string HASH_RECURSIVE_CMD = "-hr";
+    const string STATS_CMD = "-stats";
+
+    const size_t MAX_CONTROL_INPUT = 64 * 1024;      // stop reading control input past this point
+    const size_t MAX_QUEUED_INPUT = 64 * 1024;       // close a session whose commands sent ahead take up more than this
+    const int DATA_TIMEOUT_SECONDS = 60;             // how long a worker waits on a stalled client
+    const int DATA_CONNECT_TIMEOUT_SECONDS = 10;     // how long the data connections may take to be made (or, passive, to arrive)
+    const off_t STRIPE_CHUNK_SIZE = 1 << 20;         // the size of each chunk of a striped download
+
+    EventLoop &loop;
+    ThreadPool &pool;
+    PassivePortPool &passivePorts;
+    ListingCache &listings;
+    MappedFileCache &mappedFiles;
+    ContentCache &contents;
+    HashIndex &hashes;
+    const ServerConfig &config;
+    Logger &log;
+    Metrics &metrics;
+    SessionState state;
+    int jobsRunning;                // the number of workers using the data connections
+    TransferResult jobsResult;      // the combined outcome of the jobs that have finished so far
+    bool closeRequested;            // true if the session should close once the worker is done
+
+    int commandPort;
+    int controlSock;
+    vector<int> connectingSocks;    // data connections that are still being made
+    vector<int> dataSocks;          // established data connections (one per stream)
+    int passiveSlot;                // passive mode: the leased port's slot, or -1
+    bool controlClosed;             // true once the client has closed its side of the control connection
+    struct sockaddr_storage clientAddress;  // where the client connected from, and where data connections go
+    string clientHost;              // the client's address, as text for the log
+    int connectTimer;               // fires when the data connections take too long (-1 until first needed)
+
+    string controlIn;               // control input; the part before controlStart has been consumed
+    size_t controlStart;
+    std::deque<string> queuedRequests;      // commands that arrived while a response was being set up
+    size_t queuedBytes;                     // the size of the commands in queuedRequests
+    OutputBuffer controlOut;
+
+    unique_ptr<ParsedRequest> parsedRequest;
+    shared_ptr<OfferedFile> offeredFile;    // -g only: the file, from when it is offered until it is sent
+
+    size_t requestCommand;          // the current request's command, as Metrics counts it
+    int64_t requestStart;           // when the current request arrived, or 0 once its times are recorded
+    TransferMeter meter;            // what the workers have sent for the current request
+
+  // Member Functions
+  private:
+    bool takeMessage(string_view &message);
+    bool isRequest(string_view message);
+    void readControl();
+
+    int getDataSocket(int port);
+    void finishDataConnect(int fd);
+    void setConnectTimer(int seconds);
+    void failDataConnect(int error);
+    void acceptDataConnection();
+    void startResponse();
+    void releasePassivePort();
+
+    void processClientRequest(string_view request);
+    void processDataResponse();
+    void sendDirectoryList(bool showHidden = false, bool showSize = false, bool showRecursive = false);
+    void sendRequestedFile();
+    void sendHashes();
+    void receiveTransferReply(string_view reply);
+
+    void dispatch(SessionState next, function<TransferResult()> job);
+    void finishTransfer(TransferResult result);
+    void closeDataConnection();
+    void recordTransfer();
+    void closeDataSockets();
+    void advance();
+    void updateEvents();
+    void finish();
+
+  public:
+    Session(EventLoop &loop, ThreadPool &pool, PassivePortPool &passivePorts, ListingCache &listings,
+            MappedFileCache &mappedFiles, ContentCache &contents, HashIndex &hashes, const ServerConfig &config,
+            Logger &log, Metrics &metrics, int controlSock, const struct sockaddr_storage &clientAddress,
+            string clientHost, int commandPort);
+    ~Session();
+    void handleEvent(int fd, uint32_t events) override;
+};
+
+
+#endif /* Session_hpp */
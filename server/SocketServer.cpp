@@ -7,85 +7,156 @@
  *  file for the SocketServer class. This file contains definitions
  *  for the member functions of the SocketServer class.
  * 
- *  This class is responsible for implementing the FTP server's response
- *  to a request from an FTP client. 
+ *  This class is responsible for accepting FTP clients and running the
+ *  event loop that drives each client's Session.
  */
 
 
+#include <cerrno>
 #include <cstring>
-#include <iostream>
+#include <fcntl.h>
 #include <arpa/inet.h>
 #include <netinet/in.h>
-#include <netdb.h>
+#include <netinet/tcp.h>
 #include <signal.h>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/timerfd.h>
 #include <unistd.h>
+#include <cstdio>
 #include <exception>
 
 #include "Util.hpp"
-#include "ParsedRequest.hpp"
+#include "Session.hpp"
 #include "SocketServer.hpp"
 
-using std::cout;
-using std::endl;
-using std::ifstream;
 using std::exception;
 
 
+static const LogEvent SERVER_OPEN = {
+    LOG_INFO, "server_open", "Server open on port {}", { "port" }
+};
+static const LogEvent PASSIVE_PORTS_OPEN = {
+    LOG_INFO, "passive_ports_open", "Passive data ports open: {}", { "count" }
+};
+static const LogEvent CLIENT_CONNECTED = {
+    LOG_INFO, "client_connected", "\nConnection from {}.", { "client" }
+};
+static const LogEvent CLIENT_ACCEPT_FAILED = {
+    LOG_ERROR, "client_accept_failed", "Error accepting client connection: accept(): {}", { "error" }
+};
+static const LogEvent CONTENT_CACHE_STATS = {
+    LOG_INFO, "content_cache_stats", "\nContent cache: {} hits, {} misses, {} evictions, {} files ({} bytes) cached.",
+    { "hits", "misses", "evictions", "files", "bytes" }
+};
+static const LogEvent HASH_INDEX_STATS = {
+    LOG_INFO, "hash_index_stats", "Hash index: {} hits, {} files hashed, {} files indexed.", { "hits", "hashed", "files" }
+};
+static const LogEvent METRICS_WRITE_FAILED = {
+    LOG_ERROR, "metrics_write_failed", "Writing the metrics file {} failed: {}", { "path", "error" }
+};
+static const LogEvent SERVER_STOPPED = {
+    LOG_INFO, "server_stopped", "\nFTP Server stopped.\n", {}
+};
+
+
+/**
+ * Constructor that uses the configured port to create a socket connection
+ * which is used to wait for FTP clients, and starts the worker threads
+ * and the passive data ports.
+ */
+SocketServer::SocketServer(const ServerConfig &config) :
+    log(config.logLevel, config.logFullPolicy, config.logJsonPath), config(config), pool(config.workers), passivePorts(config.passiveBase, config.passivePorts),
+    listings(this->pool), mappedFiles(config.mapCacheSize), contents(config.contentCacheSize), hashes(config.hashIndexPath) {
+    this->isRunning = false;
+    this->controlPort = config.port;
+    this->controlSock = getSocket(config.port);
+
+    if (this->passivePorts.size() > 0) {
+        this->log.log(PASSIVE_PORTS_OPEN, this->passivePorts.size());
+    }
+    this->spareFd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+
+    this->metricsTimer = -1;
+    if (!config.metricsPath.empty()) {
+        struct itimerspec interval = {};
+        interval.it_interval.tv_sec = config.metricsInterval;
+        interval.it_value.tv_sec = config.metricsInterval;
+        this->metricsTimer = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        if (this->metricsTimer < 0 || timerfd_settime(this->metricsTimer, 0, &interval, nullptr) < 0) {
+            perror("Metrics timer creation failed: timerfd_create()");
+            exit(1);
+        }
+    }
+
+    const sigset_t signals = stopSignals();
+    this->signalFd = signalfd(-1, &signals, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (this->signalFd < 0) {
+        perror("Signal descriptor creation failed: signalfd()");
+        exit(1);
+    }
+}
+
+
+
+/**
+ * @return sigset_t - the signals that stop the server: SIGINT and SIGTERM.
+ */
+sigset_t SocketServer::stopSignals() {
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    return signals;
+}
+
+
+
 /**
- * Constructor that uses the argued port to create a socket connection
- * which is used to wait for FTP clients.
+ * Blocks the signals that stop the server in the calling thread, so that they
+ * wait to be read from the server's signalfd (on the event loop's thread)
+ * instead of interrupting whatever was running. Threads inherit the mask, so
+ * this must be called before the server, and its threads, are created.
  */
-SocketServer::SocketServer(int port) {
-    this->controlPort = port;
-    this->controlSock = getSocket(port);
+void SocketServer::blockStopSignals() {
+    const sigset_t signals = stopSignals();
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
 }
 
 
 
 /**
  * Sets the FTP server in a state of waiting for connection requests from FTP clients.
- * Once a request is received, the server will trigger processing the request.
+ * Each client that connects gets a Session, and the event loop then moves every
+ * session along whenever its client is ready, so no client has to wait for another.
  */
 void SocketServer::start() {
     this->isRunning = true;
-    string clientHost;
-    
-    // Listen on the specified port for FTP clients.
-    while (true) {
-        int clientSock;
-        struct sockaddr_in client;
-        socklen_t sizeOfClient = sizeof(client);
-        
-        // Accept & validate the client connection
-        if ((clientSock = accept(this->controlSock, (struct sockaddr*) &client, &sizeOfClient)) < 0) {
-            perror("Error accepting client connection: accept()");
-            exit(1);
-        }
-        
-        // Receive client request
-        clientHost = inet_ntoa(client.sin_addr);
-        cout << "\nConnection from " << clientHost << "." << endl;
-        receiveClientRequest(clientSock, clientHost);
+    this->loop.watch(this->controlSock, EPOLLIN, this);
+    if (this->listings.getFd() >= 0) {
+        this->loop.watch(this->listings.getFd(), EPOLLIN, &this->listings);
+    }
+    if (this->metricsTimer >= 0) {
+        this->loop.watch(this->metricsTimer, EPOLLIN, this);
     }
+    this->loop.watch(this->signalFd, EPOLLIN, this);
+    this->loop.run();
 }
 
 
 
 /**
- * Stops the FTP server, attempting to close any open sockets
- * and then exiting the program.
+ * Stops the FTP server, attempting to close any open sockets,
+ * writing out the log and the metrics file, and then exiting the program.
+ * Runs on the event loop's thread (SIGINT is read from the signalfd), since
+ * rendering and writing the metrics takes locks and allocates.
  */
 void SocketServer::disconnect() {
     if (this->isRunning) {
         this->isRunning = false;
-
-        try {
-          close(this->dataSock);
-        } catch (exception& e) {
-          // do nothing
-        }
+        this->loop.stop();
 
         try {
           close(this->controlSock);
@@ -94,31 +165,113 @@ void SocketServer::disconnect() {
         }   
     }
 
+    if (this->metricsTimer >= 0) {
+        this->writeMetrics();
+    }
+    ContentCacheStats stats = this->contents.getStats();
+    this->log.flush();
     clearConsoleLine();
-    cout << "\nFTP Server stopped.\n" << endl;
+    HashIndexStats hashStats = this->hashes.getStats();
+    this->log.log(CONTENT_CACHE_STATS, stats.hits, stats.misses, stats.evictions, stats.entries, stats.bytes);
+    this->log.log(HASH_INDEX_STATS, hashStats.hits, hashStats.hashed, hashStats.entries);
+    this->log.log(SERVER_STOPPED);
+    this->log.stop();
     exit(1);
 }
 
 
 
+/**
+ * Stops the FTP server at once (on SIGTERM), after writing out
+ * the log messages that haven't been written yet. The signal is
+ * raised again, unblocked and with its default action, so the
+ * server still ends as killed by SIGTERM.
+ */
+void SocketServer::terminate() {
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGTERM);
+
+    this->log.stop();
+    signal(SIGTERM, SIG_DFL);
+    raise(SIGTERM);
+    pthread_sigmask(SIG_UNBLOCK, &signals, nullptr);
+}
+
+
+
+/**
+ * Accepts new clients whenever the listening socket is readable, writes
+ * the metrics file whenever its timer fires, and stops the server when
+ * SIGINT or SIGTERM arrives.
+ * @param fd - the listening socket, the metrics timer or the signalfd.
+ * @param events - the epoll events that occurred.
+ */
+void SocketServer::handleEvent(int fd, uint32_t events) {
+    if (fd == this->signalFd) {
+        struct signalfd_siginfo info;
+        if (read(fd, &info, sizeof(info)) == (ssize_t) sizeof(info)) {
+            if (info.ssi_signo == SIGTERM) {
+                this->terminate();
+            } else {
+                this->disconnect();
+            }
+        }
+        return;
+    }
+
+    if (fd == this->metricsTimer) {
+        uint64_t expirations;
+        if (read(fd, &expirations, sizeof(expirations)) == (ssize_t) sizeof(expirations)) {
+            this->writeMetrics();
+        }
+        return;
+    }
+
+    this->acceptClients();
+}
+
+
+
+/**
+ * Writes the metrics to the metrics file. They are written to a temporary
+ * file that is then renamed over it, so a scraper never reads half a file.
+ * Only called on the event loop's thread (by the timer, and by disconnect()
+ * at shutdown), never from a signal handler: Metrics::render() takes the
+ * shards' lock, and fopen() and the rendering allocate.
+ */
+void SocketServer::writeMetrics() {
+    const string &path = this->config.metricsPath;
+    const string temporary = path + ".tmp";
+    const string text = this->metrics.render(this->contents, this->hashes);
+
+    FILE *file = fopen(temporary.c_str(), "w");
+    bool written = file != nullptr && fwrite(text.data(), 1, text.size(), file) == text.size();
+    if (file != nullptr && fclose(file) != 0) {
+        written = false;
+    }
+    if (!written || rename(temporary.c_str(), path.c_str()) < 0) {
+        this->log.log(METRICS_WRITE_FAILED, path, LogErrno{errno});
+        unlink(temporary.c_str());
+    }
+}
+
+
+
 /**
  * Creates and returns a socket file descriptor. If, at any point, an error
  *  occurs, an error message is printed to the terminal & the program exits.
  * @param port - the port number to bind the socket to.
- * @return int - a valid socket connection.
+ * @return int - a valid, non-blocking socket connection.
  */
 int SocketServer::getSocket(int port) {
-    // setup the server
-    struct sockaddr_in server;
+    // setup the server, taking IPv4 and IPv6 clients alike
+    struct sockaddr_storage server;
+    socklen_t sizeOfServer;
     int reuse = 1;
     
-    memset((char*)&server, '\0', sizeof(server));
-    server.sin_family = AF_INET;
-    server.sin_port = htons(port);
-    server.sin_addr.s_addr = INADDR_ANY;
-    
     // setup the socket
-    int sock = socket(AF_INET, SOCK_STREAM, 0);
+    int sock = getServerSocket(port, server, sizeOfServer);
     if (sock == -1) {
         perror("Socket creation failed: socket()");
         exit(1);
@@ -131,253 +284,68 @@ int SocketServer::getSocket(int port) {
     }
     
     // Bind the socket
-    if (bind(sock, (struct sockaddr*) &server, sizeof(server)) < 0) {
+    if (bind(sock, (struct sockaddr*) &server, sizeOfServer) < 0) {
         perror("Socket binding failed: bind()");
         exit(1);
     }
     
-    // Start listening on the bound socket.
-    if (listen(sock, 10) < 0) {
+    // Start listening on the bound socket, with as large a backlog as the system allows.
+    if (listen(sock, SOMAXCONN) < 0) {
         perror("Socket listening failed: listen()");
         exit(1);
     }
     
-    cout << "Server open on port " << port << endl;
+    this->log.log(SERVER_OPEN, port);
     return sock;
 }
 
 
 
 /**
- * Builds and returns a data socket connection to the client.
- * @param host - the host location of the client.
- * @param port - the port number to bind the data socket to.
- * @return int - a valid socket connection.
- */
-int SocketServer::getDataSocket(string host, int port) {
-    // Specify the FTP client connection.
-    struct sockaddr_in clientAddress;
-    struct hostent *he;
-    
-    memset(&clientAddress, '\0', sizeof(clientAddress));
-    clientAddress.sin_family = AF_INET;
-    clientAddress.sin_port = htons(port);
-    he = gethostbyname(host.c_str());
-    
-    if (he == nullptr) {
-        perror("No such host: gethostbyname()");
-        exit(1);
-    }
-    
-    memcpy((char*) &clientAddress.sin_addr.s_addr, (char*) he->h_addr, he->h_length);
-    
-    // Create a data socket
-    int dSock = socket(AF_INET, SOCK_STREAM, 0);
-    if (dSock == -1) {
-        perror("Data socket creation failed: socket()");
-        exit(1);
-    }
-    
-    // Connect to the FTP client using the data socket.
-    if (connect(dSock, (struct sockaddr *) &clientAddress, sizeof(clientAddress)) < 0) {
-        perror("Data socket connection failed: connect()");
-        exit(1);
-    }
-    
-    return dSock;
-}
-
-
-
-/**
- * Converts the string message to a c string and then
- * continuously loops until the entire message has been sent
- * using the socket connection.
- * @param message - the message to send.
- */
-void SocketServer::sendMessage(int sock, string const &message) {
-    string sanitized = message + "\n";  // append a newline to complete the message.
-    char* buffer = (char*)sanitized.c_str();
-    const size_t BUFFER_SIZE = strlen(buffer);
-    size_t sent = 0;
-    
-    while(sent < BUFFER_SIZE) {
-        sent += write(sock, buffer, BUFFER_SIZE);
-    }
-}
-
-
-
-/**
- * Receives the client request and passes it on for processing.
- * @param sock - socket connection with the client from
- *  where the request can be read.
- */
-string SocketServer::receiveMessage(int sock) {
-    const int BUFFER_SIZE = 1024;
-    char buffer[BUFFER_SIZE];
-    memset(buffer, '\0', BUFFER_SIZE);
-    
-    if (recv(sock, buffer, sizeof(buffer), 0) < 0) {
-        perror("Failed to receive client message.\n");
-    }
-    
-    string message = buffer;
-    return message;
-}
-
-
-
-/**
- * Sends a listing of the current files in the directory
- * using a given socket connection.
+ * Accepts every client that is waiting on the listening socket
+ * and creates a Session for each of them.
  */
-void SocketServer::sendDirectoryList(int sock, string clientHost, int dataPort, bool showHidden, bool showSize, bool showRecursive) {
-    cout << "Sending directory contents to " << clientHost << ":" << dataPort << "." << endl;
-    vector<string>items;
-
-    // build a vector of the specified directory items
-    if (!showRecursive) {
-      items = getListItems(".", showHidden, showSize);
-    } else {
-      getListItemsRecursive(".", showHidden, showSize, items);
-    }
-    
-    // send each of the resulting directory items.
-    for (auto i : items) {
-        sendMessage(sock, i);
-    }
-    
-    // send a final message to indicate that the server is finished with the file list.
-    sendMessage(sock, DONE_MSG);
-}
-
+void SocketServer::acceptClients() {
+    while (true) {
+        int clientSock;
+        struct sockaddr_storage client;
+        socklen_t sizeOfClient = sizeof(client);
+        
+        // Accept & validate the client connection
+        clientSock = accept4(this->controlSock, (struct sockaddr*) &client, &sizeOfClient, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (clientSock < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
 
+            if ((errno == EMFILE || errno == ENFILE) && this->spareFd >= 0) {
+                // out of descriptors: use the spare one to accept the client and hang up,
+                // rather than leaving it in the backlog to wake the loop forever.
+                this->log.log(CLIENT_ACCEPT_FAILED, LogErrno{errno});
+                close(this->spareFd);
+                close(accept(this->controlSock, nullptr, nullptr));
+                this->spareFd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+                continue;
+            }
 
-/**
- * Sends the requested file (if it can be accessed).
- * Otherwise, an error message is sent.
- */
-void SocketServer::sendRequestedFile(int clientSock, int dataSock, string clientHost, ParsedRequest &parsedRequest) {
-    int dataPort = parsedRequest.dataPort;
-    string filename = parsedRequest.filename;
-    string line;
-    
-    // first, make sure the file exists. if not, send an error message.
-    if (canAccessFile(filename)) {
-        cout << "File \"" << filename << "\" ready to send to " << clientHost << ":" << dataPort << "." << endl;
-        sendMessage(dataSock, this->GOOD_MSG);
-        
-        // wait for the client to be ready, and make sure the client doesn't cancel.
-        if ((line = receiveMessage(clientSock)).find(this->CANCEL_MSG) == string::npos) {
-            cout << "Sending \"" << filename << "\" to " << clientHost << ":" << dataPort << "." << endl;
-            ifstream ifs(filename);
-            if (ifs.good()) {
-                while (ifs.peek() != EOF) {
-                    getline(ifs, line);
-                    sendMessage(dataSock, line);
-                }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                this->log.log(CLIENT_ACCEPT_FAILED, LogErrno{errno});
             }
-            ifs.close(); // close the file once finished
-            
-        } else {  // indicate if the client cancelled receiving the file.
-            cout << "Receiver cancelled the file transfer." << endl;
+            return;
         }
         
-        sendMessage(dataSock, this->DONE_MSG);  // send the DONE message to finish.
-        
-    } else {
-        // the file couldn't be accessed, so send an error message.
-        cout << "File \"" << filename << "\" not found. Sending error message to " << clientHost << ":" << dataPort << endl;
-        sendMessage(dataSock, this->BAD_MSG);
-        sendMessage(dataSock, "Response: Error - \"" + filename + "\" not found");
-        sendMessage(dataSock, this->DONE_MSG);
+        // The control connection carries short request and reply lines, which Nagle's
+        // algorithm would hold back until the client's delayed ACK.
+        int noDelay = 1;
+        setsockopt(clientSock, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+        // Hand the client over to a new session, which waits for the client request. The session
+        // keeps the client's address to connect back to, so data connections need no lookup.
+        unmapAddress(client);
+        const string clientHost = addressHost(client);
+        this->log.log(CLIENT_CONNECTED, clientHost);
+        new Session(this->loop, this->pool, this->passivePorts, this->listings, this->mappedFiles, this->contents,
+            this->hashes, this->config, this->log, this->metrics,
+            clientSock, client, clientHost, this->controlPort);
     }
 }
-
-
-
-/**
- * Processes the data response after the client's request has been received
- * and validated without error.
- * @param parsedRequest - a ParsedRequest object containing all the client request information.
- */
-void SocketServer::processDataResponse(ParsedRequest &parsedRequest, string clientHost, int clientSock) {
-    // initiate a data connection with the client on the data port.
-    receiveMessage(clientSock); // accept a message to know when the client is ready.
-    int dataPort = parsedRequest.dataPort;
-    int dataSock = getDataSocket(clientHost, dataPort);
-    
-    // use the parsedRequest information to determine what to send back to the client.
-    if (parsedRequest.command == LIST_CMD) {
-        sendDirectoryList(dataSock, clientHost, dataPort, false);
-    } else if (parsedRequest.command == LIST_ALL_CMD) {
-        sendDirectoryList(dataSock, clientHost, dataPort, true);
-    } else if (parsedRequest.command == LIST_WITH_SIZE_CMD) {
-        sendDirectoryList(dataSock, clientHost, dataPort, true, true);
-    } else if (parsedRequest.command == LIST_RECURSIVE_CMD) {
-        sendDirectoryList(dataSock, clientHost, dataPort, true, true, true);
-    } else if (parsedRequest.command == GET_CMD) {
-        sendRequestedFile(clientSock, dataSock, clientHost, parsedRequest);
-    }
-    
-    // once the response has completed, close the data connection.
-    close(dataSock);
-    cout << "FTP data connection with " << clientHost << ":" << dataPort << " closed." << endl;
-}
-
-
-
-/**
- * Declares a ParsedRequest object which handles parsing all the request information,
- * and then either sends an error message to the client (if applicable) or continues
- * processing the client's request if the request is valid.
- * @param request - a string representing the requeste sent from the client.
- * @param clientSock - the socket file descriptor for the control connection to the client.
- */
-void SocketServer::processClientRequest(string request, int clientSock, string clientHost) {
-    ParsedRequest parsedRequest(request, portFromSocket(clientSock));
-    string cmd = parsedRequest.command;
-    
-    // print a message indicating the information requested from the client.
-    if (cmd == LIST_CMD || cmd == LIST_ALL_CMD || cmd == LIST_WITH_SIZE_CMD || cmd == LIST_RECURSIVE_CMD) {
-        cout << "List directory requested on port " << parsedRequest.dataPort << "." << endl;
-    } else if (cmd == GET_CMD) {
-        cout << "File \"" << parsedRequest.filename << "\" requested on port "
-        << parsedRequest.dataPort << "." << endl;
-    }
-    
-    // If for an error flag, which indicates an invalid command.
-    // If found, send the error message to the client.
-    if (parsedRequest.errorFlag) {
-        sendMessage(clientSock, parsedRequest.errorMessage);
-    } else {
-        // The client's request was valid. Begin processing the data response.
-        sendMessage(clientSock, this->GOOD_MSG);
-        processDataResponse(parsedRequest, clientHost, clientSock);
-    }
-}
-
-
-
-/**
- * Receives the client request and passes it on for processing.
- * @param clientSock - socket connection with the client from
- *  where the request can be read.
- */
-void SocketServer::receiveClientRequest(int clientSock, string clientHost) {
-    const int BUFFER_SIZE = 1024;
-    char buffer[BUFFER_SIZE];
-    memset(buffer, '\0', BUFFER_SIZE);
-    
-    if (recv(clientSock, buffer, sizeof(buffer), 0) < 0) {
-        perror("Failed to receive client message.");
-    }
-    
-    // Pass the request on to begin processing.
-    processClientRequest(buffer, clientSock, clientHost);
-}
-
-
-
-
@@ -12,54 +12,58 @@
 #ifndef SocketServer_hpp
 #define SocketServer_hpp
 
+#include <signal.h>
 #include <string>
-#include "ParsedRequest.hpp"
+#include "EventLoop.hpp"
+#include "ListingCache.hpp"
+#include "ContentCache.hpp"
+#include "HashIndex.hpp"
+#include "Logger.hpp"
+#include "MappedFileCache.hpp"
+#include "Metrics.hpp"
+#include "PassivePortPool.hpp"
+#include "ServerConfig.hpp"
+#include "ThreadPool.hpp"
 
 using std::string;
 
 
-class SocketServer {
+class SocketServer : public EventHandler {
  // member variables
   private:
-    const string DONE_MSG = "\\done";
-    const string GOOD_MSG = "\\good";
-    const string BAD_MSG = "\\bad";
-    const string CANCEL_MSG = "\\cancel";
-    const string QUIT_MSG = "\\quit";
-    
-    const string LIST_CMD = "-l";
-    const string LIST_ALL_CMD = "-la";
-    const string LIST_WITH_SIZE_CMD = "-ll";
-    const string LIST_RECURSIVE_CMD = "-lr";
-    const string GET_CMD = "-g";
-    
+    Logger log;             // first, so it is the last to go, after every session that logs to it
+    ServerConfig config;
     int controlPort;
     int controlSock;
-    int dataSock;
-    
-    string clientHost;
+    int spareFd;            // held open so that a connection can still be refused when out of descriptors
     bool isRunning;
+    EventLoop loop;
+    ThreadPool pool;        // runs every data transfer, so the loop only accepts and dispatches
+    PassivePortPool passivePorts;   // the data ports that passive-mode clients connect to
+    ListingCache listings;          // rendered directory listings, shared by every session
+    MappedFileCache mappedFiles;    // the mappings of popular files, shared by every session
+    ContentCache contents;          // the contents of small popular files, shared by every session
+    HashIndex hashes;               // the hashes of files' contents, shared by every session
+    Metrics metrics;                // request counts and times, shared by every session
+    int metricsTimer;               // a timerfd that fires when the metrics file is due, or -1
+    int signalFd;                   // a signalfd that reads SIGINT and SIGTERM, so they are handled on the loop's thread
     
     
  // member functions
   private:
     int getSocket(int port);
-    int getDataSocket(string host, int port);
-    
-    string receiveMessage(int sock);
-    void receiveClientRequest(int clientSock, string clientHost);
-    
-    void sendMessage(int sock, string const &message);
-    void sendDirectoryList(int sock, string clientHost, int dataPort, bool showHidden = false, bool showSize = false, bool showRecursive = false);
-    void sendRequestedFile(int clientSock, int dataSock, string clientHost, ParsedRequest &parsedRequest);
-    
-    void processClientRequest(string request, int clientSock, string clientHost);
-    void processDataResponse(ParsedRequest &parsedRequest, string clientHost, int clientSock);
+    void acceptClients();
+    void writeMetrics();
+    static sigset_t stopSignals();
     
   public:
-    explicit SocketServer(int port);
+    explicit SocketServer(const ServerConfig &config);
     void start();
     void disconnect();
+    void terminate();
+    void handleEvent(int fd, uint32_t events) override;
+
+    static void blockStopSignals();
 };
 
 
@@ -0,0 +1,171 @@
+/**
+ * Program Name: FTP Server
+ * File Name: ThreadPool.cpp
+ * Author: Taylor Jones
+ * Last Modified: 10/16/26
+ * Description: ThreadPool.cpp is the class implementation
+ *  file for the ThreadPool class.
+ *
+ *  Every worker owns a queue. Tasks submitted from outside the pool are
+ *  spread across the queues round-robin, and tasks submitted by a worker
+ *  go onto that worker's own queue. A worker takes its newest task first
+ *  (while its data is still warm), and a worker with nothing to do steals
+ *  the oldest task from another worker's queue, so no core sits idle
+ *  while there is work queued anywhere.
+ */
+
+
+#include "ThreadPool.hpp"
+
+
+thread_local ThreadPool *ThreadPool::currentPool = nullptr;
+thread_local size_t ThreadPool::currentIndex = 0;
+
+
+/**
+ * Starts the worker threads.
+ * @param threadCount - the number of workers (at least 1 is always started).
+ */
+ThreadPool::ThreadPool(size_t threadCount) : nextQueue(0) {
+    this->pending = 0;
+    this->stopping = false;
+
+    if (threadCount == 0) {
+        threadCount = 1;
+    }
+
+    for (size_t i = 0; i < threadCount; i++) {
+        this->queues.push_back(unique_ptr<WorkQueue>(new WorkQueue()));
+    }
+
+    for (size_t i = 0; i < threadCount; i++) {
+        this->threads.push_back(std::thread(&ThreadPool::workerLoop, this, i));
+    }
+}
+
+
+
+/**
+ * Lets the workers finish whatever is queued, and then joins them.
+ */
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> guard(this->idleLock);
+        this->stopping = true;
+    }
+
+    this->wakeup.notify_all();
+    for (auto &thread : this->threads) {
+        thread.join();
+    }
+}
+
+
+
+/**
+ * Queues a task for the next idle worker.
+ * @param task - the task to run.
+ */
+void ThreadPool::submit(function<void()> task) {
+    size_t index;
+    if (currentPool == this) {
+        index = currentIndex;
+    } else {
+        index = this->nextQueue++ % this->queues.size();
+    }
+
+    {
+        // the task is counted before it is published (a worker can only take it under the
+        // queue's lock), so a worker that steals it at once can't take pending below zero.
+        std::lock_guard<std::mutex> guard(this->queues[index]->lock);
+        {
+            std::lock_guard<std::mutex> idleGuard(this->idleLock);
+            this->pending++;
+        }
+        this->queues[index]->tasks.push_back(std::move(task));
+    }
+
+    this->wakeup.notify_one();
+}
+
+
+
+/**
+ * @return size_t - the number of worker threads.
+ */
+size_t ThreadPool::size() const {
+    return this->threads.size();
+}
+
+
+
+/**
+ * @return ThreadPool* - the pool that the calling thread is a worker of,
+ *  or null if it isn't a worker.
+ */
+ThreadPool *ThreadPool::current() {
+    return currentPool;
+}
+
+
+
+/**
+ * Takes the newest task from a worker's own queue or, failing that,
+ * steals the oldest task from one of the other queues.
+ * @param index - the worker's own queue.
+ * @param task - holds the task that was taken.
+ * @return bool - true if a task was taken.
+ */
+bool ThreadPool::takeTask(size_t index, function<void()> &task) {
+    const size_t count = this->queues.size();
+
+    for (size_t i = 0; i < count; i++) {
+        WorkQueue &queue = *this->queues[(index + i) % count];
+        std::lock_guard<std::mutex> guard(queue.lock);
+
+        if (!queue.tasks.empty()) {
+            if (i == 0) {
+                task = std::move(queue.tasks.back());
+                queue.tasks.pop_back();
+            } else {
+                task = std::move(queue.tasks.front());
+                queue.tasks.pop_front();
+            }
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+
+/**
+ * Runs tasks until the pool is stopped, sleeping whenever nothing is queued.
+ * @param index - the worker's own queue.
+ */
+void ThreadPool::workerLoop(size_t index) {
+    currentPool = this;
+    currentIndex = index;
+    function<void()> task;
+
+    while (true) {
+        if (this->takeTask(index, task)) {
+            {
+                std::lock_guard<std::mutex> guard(this->idleLock);
+                this->pending--;
+            }
+
+            task();
+            task = nullptr;
+            continue;
+        }
+
+        std::unique_lock<std::mutex> guard(this->idleLock);
+        if (this->stopping && this->pending == 0) {
+            return;
+        }
+
+        this->wakeup.wait(guard, [this]() { return this->pending > 0 || this->stopping; });
+    }
+}
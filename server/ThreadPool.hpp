@@ -0,0 +1,65 @@
+/**
+ * Program Name: FTP Server
+ * File Name: ThreadPool.hpp
+ * Author: Taylor Jones
+ * Last Modified: 10/16/26
+ * Description: ThreadPool.hpp is the class specification
+ *  file for the ThreadPool class. This file contains declarations
+ *  for the member functions of the ThreadPool class.
+ */
+
+
+#ifndef ThreadPool_hpp
+#define ThreadPool_hpp
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using std::function;
+using std::unique_ptr;
+using std::vector;
+
+
+class ThreadPool {
+  // Member Variables
+  private:
+    struct WorkQueue {
+        std::mutex lock;
+        std::deque<function<void()>> tasks;
+    };
+
+    vector<unique_ptr<WorkQueue>> queues;     // one queue per worker
+    vector<std::thread> threads;
+
+    std::mutex idleLock;                      // guards sleeping, pending and stopping
+    std::condition_variable wakeup;
+    size_t pending;                           // tasks queued but not yet taken
+    bool stopping;
+    std::atomic<size_t> nextQueue;            // where the next outside task goes
+
+    static thread_local ThreadPool *currentPool;    // the pool the calling thread works for
+    static thread_local size_t currentIndex;        // the calling worker's own queue
+
+  // Member Functions
+  private:
+    bool takeTask(size_t index, function<void()> &task);
+    void workerLoop(size_t index);
+
+  public:
+    explicit ThreadPool(size_t threadCount);
+    ~ThreadPool();
+
+    void submit(function<void()> task);
+    size_t size() const;
+
+    static ThreadPool *current();
+};
+
+
+#endif /* ThreadPool_hpp */
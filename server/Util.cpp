@@ -9,16 +9,25 @@
 
 
 #include <arpa/inet.h>
+#include <cerrno>
 #include <dirent.h>
+#include <fcntl.h>
 #include <sstream>
+#include <sys/socket.h>
+#include <sys/resource.h>
+#include <sys/sendfile.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <climits>
 #include <unistd.h>
+#include <algorithm>
 #include <cstring>
 #include "Util.hpp"
+#include "DirectoryWalker.hpp"
 
 
 using std::string;
+using std::string_view;
 using std::ifstream;
 using std::istringstream;
 using std::stringstream;
@@ -30,7 +39,7 @@ using std::endl;
  * Clears the current line in the terminal.
  */
 void clearConsoleLine() {
-    cout << "\33[2K\r";
+    cout << "\33[2K\r" << std::flush;
 }
 
 
@@ -41,8 +50,8 @@ void clearConsoleLine() {
  * @note: This function implementation is adopted from a response to the accepted solution found at:
  * https://stackoverflow.com/questions/6444842/efficient-way-to-check-if-stdstring-has-only-spaces
  */
-bool hasAnyValue(const string &content) {
-    return (content.find_first_not_of(" \t\n\v\f\r") != string::npos);
+bool hasAnyValue(string_view content) {
+    return (content.find_first_not_of(" \t\n\v\f\r") != string_view::npos);
 }
 
 
@@ -84,22 +93,89 @@ bool isInt(string content) {
 }
 
 
+/**
+ * Reads a whole string as a base-10 integer, the way strtoll() does: leading
+ * whitespace and a sign are allowed, and a value too large for a long long
+ * is clamped to the nearest limit. Nothing is copied or allocated.
+ * @param content - the string to read.
+ * @param value - holds the value, if the string is an integer.
+ * @param overflowed - set to true if the value had to be clamped.
+ * @return bool - true if the string is an integer, false if not.
+ */
+static bool parseDecimal(string_view content, long long &value, bool &overflowed) {
+    size_t i = content.find_first_not_of(" \t\n\v\f\r");
+    if (i == string_view::npos) {
+        return false;
+    }
+
+    const bool negative = content[i] == '-';
+    if (content[i] == '-' || content[i] == '+') {
+        i++;
+    }
+    if (i == content.size()) {
+        return false;
+    }
+
+    // accumulate as a negative number, which has room for LLONG_MIN.
+    long long result = 0;
+    overflowed = false;
+    for (; i < content.size(); i++) {
+        if (content[i] < '0' || content[i] > '9') {
+            return false;
+        }
+        const int digit = content[i] - '0';
+        if (result < (LLONG_MIN + digit) / 10) {
+            overflowed = true;
+        } else {
+            result = result * 10 - digit;
+        }
+    }
+
+    if (overflowed) {
+        value = negative ? LLONG_MIN : LLONG_MAX;
+    } else if (!negative && result == LLONG_MIN) {
+        overflowed = true;
+        value = LLONG_MAX;
+    } else {
+        value = negative ? result : -result;
+    }
+    return true;
+}
+
+
+
 /**
  * Overloaded version of isInt that allows for passing an integer
  *  by reference, which will hold the converted integer version of the
- *  content string, if valid, or 0 if not.
+ *  content string, if valid. As with strtol(), a value out of range
+ *  is clamped and then narrowed, rather than refused.
  * @param content - the string to inspect.
  * @param value - an integer reference to hold the converted value.
  * @return bool - true if the string represents and integer, false if not.
  */
-bool isInt(string content, int &value) {
-    if (!hasAnyValue(content)) {
+bool isInt(string_view content, int &value) {
+    long long parsed;
+    bool overflowed;
+
+    if (!parseDecimal(content, parsed, overflowed)) {
         return false;
     }
-    
-    char* nonInt;
-    value = strtol(content.c_str(), &nonInt, 10);
-    return (*nonInt == 0);
+
+    value = (int) parsed;
+    return true;
+}
+
+
+/**
+ * Overloaded version of isInt for values that may not fit in an int,
+ *  such as file sizes and offsets.
+ * @param content - the string to inspect.
+ * @param value - a reference to hold the converted value.
+ * @return bool - true if the string represents an integer in range, false if not.
+ */
+bool isInt(string_view content, long long &value) {
+    bool overflowed;
+    return parseDecimal(content, value, overflowed) && !overflowed;
 }
 
 
@@ -159,6 +235,39 @@ vector<string> split(string &input) {
 
 
 
+/**
+ * Finds the next word of a string, without copying it. Words are separated
+ * by whitespace, as they are for split().
+ * @param input - the string to read words from.
+ * @param position - where to start looking; moved past the word that is found.
+ * @param word - holds the word, which points into the input.
+ * @return bool - false if there are no more words.
+ */
+bool nextWord(string_view input, size_t &position, string_view &word) {
+    // the characters isspace() accepts, which are what split() separates words at.
+    auto isWhitespace = [](char c) { return c == ' ' || (c >= '\t' && c <= '\r'); };
+
+    size_t start = position;
+    while (start < input.size() && isWhitespace(input[start])) {
+        start++;
+    }
+    if (start == input.size()) {
+        position = start;
+        return false;
+    }
+
+    size_t end = start + 1;
+    while (end < input.size() && !isWhitespace(input[end])) {
+        end++;
+    }
+
+    word = input.substr(start, end - start);
+    position = end;
+    return true;
+}
+
+
+
 /**
  * Joins the items in a vector into a single string, delimited by a delimiter.
  * @param items - a vector of string items;
@@ -213,79 +322,360 @@ int portFromSocket(int sock) {
 
 
 /**
- * Creates a concatenated listing of files in a directory.
- * @param path - the relative path of the directory.
- * @return string - a list of the files in the directroy.
- * @note - This function implementation was inspired by a similar
- *  solution found at the following location:
- * https://www.tutorialspoint.com/How-can-I-get-the-list-of-files-in-a-directory-using-C-Cplusplus
+ * Raises the soft limit on open file descriptors to the hard limit, since
+ * every connected client needs a control socket and (usually) a data socket.
  */
-vector<string> getListItems(const string& path, bool includeHidden, bool includeSize) {
-    vector<string> items;
-    struct dirent *entry;
-    string item;
-    int offset;
-    DIR* dir = opendir(path.c_str());
-    
-    if (dir != NULL) {
-        while ((entry = readdir(dir)) != NULL) {
-            if (includeHidden || (entry->d_name[0] != '.')) {
-              item = coloredListEntry(entry);
-              
-              if (includeSize) {
-                offset = 40 - item.length();
-                item = item + string(offset, ' ') + std::to_string(fileSize(entry));
-              }
-
-              items.push_back(item);
+void raiseOpenFileLimit() {
+    struct rlimit limit;
+
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        if (setrlimit(RLIMIT_NOFILE, &limit) < 0) {
+            perror("Failed to raise the open file limit: setrlimit()");
+        }
+    }
+}
+
+
+
+/**
+ * Switches a socket between blocking and non-blocking mode.
+ * @param sock - a socket file descriptor.
+ * @param blocking - true for blocking, false for non-blocking.
+ * @return bool - true if the mode was applied.
+ */
+bool setBlocking(int sock, bool blocking) {
+    int flags = fcntl(sock, F_GETFL, 0);
+    if (flags < 0) {
+        return false;
+    }
+
+    flags = blocking ? (flags & ~O_NONBLOCK) : (flags | O_NONBLOCK);
+    return fcntl(sock, F_SETFL, flags) == 0;
+}
+
+
+
+/**
+ * Creates a non-blocking TCP socket for a server port. The socket is IPv6 with
+ * IPV6_V6ONLY off, so it takes IPv4 clients too (as v4-mapped addresses); on a
+ * system without IPv6 it is a plain IPv4 socket instead.
+ * @param port - the port to bind to, or 0 for any free port.
+ * @param address - holds the wildcard address to bind the socket to.
+ * @param length - holds the length of the address.
+ * @return int - the socket, or -1 if it couldn't be created.
+ */
+int getServerSocket(int port, struct sockaddr_storage &address, socklen_t &length) {
+    int off = 0;
+    memset(&address, '\0', sizeof(address));
+
+    int sock = socket(AF_INET6, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (sock >= 0 && setsockopt(sock, IPPROTO_IPV6, IPV6_V6ONLY, &off, sizeof(off)) == 0) {
+        struct sockaddr_in6 &server = (struct sockaddr_in6 &) address;
+        server.sin6_family = AF_INET6;
+        server.sin6_port = htons(port);
+        server.sin6_addr = in6addr_any;
+        length = sizeof(server);
+        return sock;
+    }
+
+    if (sock >= 0) {
+        close(sock);
+    }
+
+    struct sockaddr_in &server = (struct sockaddr_in &) address;
+    server.sin_family = AF_INET;
+    server.sin_port = htons(port);
+    server.sin_addr.s_addr = INADDR_ANY;
+    length = sizeof(server);
+    return socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+}
+
+
+
+/**
+ * Turns a v4-mapped IPv6 address (how a dual-stack socket sees an IPv4 peer)
+ * back into a plain IPv4 address, so it can be shown and connected to as one.
+ * Any other address is left as it is.
+ * @param address - the address.
+ */
+void unmapAddress(struct sockaddr_storage &address) {
+    const struct sockaddr_in6 &mapped = (const struct sockaddr_in6 &) address;
+    if (address.ss_family != AF_INET6 || !IN6_IS_ADDR_V4MAPPED(&mapped.sin6_addr)) {
+        return;
+    }
+
+    struct sockaddr_in plain;
+    memset(&plain, '\0', sizeof(plain));
+    plain.sin_family = AF_INET;
+    plain.sin_port = mapped.sin6_port;
+    memcpy(&plain.sin_addr, &mapped.sin6_addr.s6_addr[12], sizeof(plain.sin_addr));
+    memcpy(&address, &plain, sizeof(plain));
+}
+
+
+
+/**
+ * @param address - an IPv4 or IPv6 address.
+ * @return socklen_t - the length of the address's sockaddr.
+ */
+socklen_t addressLength(const struct sockaddr_storage &address) {
+    return address.ss_family == AF_INET6 ? sizeof(struct sockaddr_in6) : sizeof(struct sockaddr_in);
+}
+
+
+
+/**
+ * @param address - an IPv4 or IPv6 address.
+ * @return string - the address's host in text form ("127.0.0.1", "::1"), without the port.
+ */
+string addressHost(const struct sockaddr_storage &address) {
+    char host[INET6_ADDRSTRLEN] = "";
+
+    if (address.ss_family == AF_INET6) {
+        inet_ntop(AF_INET6, &((const struct sockaddr_in6 &) address).sin6_addr, host, sizeof(host));
+    } else {
+        inet_ntop(AF_INET, &((const struct sockaddr_in &) address).sin_addr, host, sizeof(host));
+    }
+    return host;
+}
+
+
+
+/**
+ * @param first - an (unmapped) IPv4 or IPv6 address.
+ * @param second - another (unmapped) IPv4 or IPv6 address.
+ * @return bool - true if both addresses are of the same host, whatever their ports.
+ */
+bool sameHost(const struct sockaddr_storage &first, const struct sockaddr_storage &second) {
+    if (first.ss_family != second.ss_family) {
+        return false;
+    }
+
+    if (first.ss_family == AF_INET6) {
+        return memcmp(&((const struct sockaddr_in6 &) first).sin6_addr, &((const struct sockaddr_in6 &) second).sin6_addr,
+            sizeof(struct in6_addr)) == 0;
+    }
+    return ((const struct sockaddr_in &) first).sin_addr.s_addr == ((const struct sockaddr_in &) second).sin_addr.s_addr;
+}
+
+
+
+/**
+ * Continuously writes to a blocking socket until the entire buffer has been
+ * sent, picking up after each short write where the last one stopped.
+ * @param sock - the socket to write to.
+ * @param data - the bytes to send.
+ * @param length - the number of bytes to send.
+ * @param flags - any extra send() flags, such as MSG_MORE.
+ * @return bool - true if everything was sent, false if the socket failed or timed out.
+ */
+bool sendAll(int sock, const char *data, size_t length, int flags) {
+    size_t sent = 0;
+
+    while (sent < length) {
+        ssize_t result = send(sock, data + sent, length - sent, MSG_NOSIGNAL | flags);
+
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
             }
+            return false;
         }
 
-        closedir(dir);
+        sent += result;
     }
-    
-    return items;
+
+    return true;
 }
 
 
 
 /**
- * Recursively populates a vector reference with the directory items.
- * Note: this function implementation drew some inspiration from the following reference:
- * https://www.lemoda.net/c/recursive-directory/
+ * Continuously reads from a blocking socket until the buffer is full.
+ * @param sock - the socket to read from.
+ * @param data - holds the bytes read.
+ * @param length - the number of bytes to read.
+ * @return bool - true if every byte was read, false if the socket failed, timed out or was closed first.
  */
-void getListItemsRecursive(const string& path, bool withHidden, bool withSize, vector<string> &items) {
-    DIR * d = opendir (path.c_str());
+bool recvAll(int sock, char *data, size_t length) {
+    size_t received = 0;
+
+    while (received < length) {
+        ssize_t result = recv(sock, data + received, length - received, 0);
+
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+        if (result <= 0) {
+            return false;
+        }
+
+        received += result;
+    }
+
+    return true;
+}
+
+
+
+/**
+ * Continuously writes several buffers to a blocking socket, as few at a
+ * time as sendmsg() allows, until all of them have been sent.
+ * @param sock - the socket to write to.
+ * @param parts - the buffers to send, in order. They are updated as they are sent.
+ * @param flags - any extra send flags, such as MSG_MORE.
+ * @return bool - true if everything was sent, false if the socket failed or timed out.
+ */
+bool sendAllv(int sock, vector<struct iovec> &parts, int flags) {
+    size_t first = 0;
 
-    if (d != NULL) {
-      while (1) {
-        struct dirent *entry;
-        const char *d_name;
+    while (first < parts.size()) {
+        struct msghdr message;
+        memset(&message, 0, sizeof(message));
+        message.msg_iov = &parts[first];
+        message.msg_iovlen = std::min<size_t>(parts.size() - first, IOV_MAX);
 
-        entry = readdir(d);
-        if (!entry) break;
+        ssize_t result = sendmsg(sock, &message, MSG_NOSIGNAL | flags);
 
-        d_name = entry->d_name;
-        if (entry->d_type != DT_DIR) {
-          items.push_back(path + "/" + coloredListEntry(entry));
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
         }
 
-        if (entry->d_type & DT_DIR) {
-          if (strcmp (d_name, "..") != 0 && strcmp (d_name, ".") != 0) {
-            int path_length;
-            char nest[PATH_MAX];
- 
-            path_length = snprintf (nest, PATH_MAX, "%s/%s", path.c_str(), d_name);
-            items.push_back(path + "/" + coloredListEntry(entry));
-
-            if (path_length >= PATH_MAX) break;
-            getListItemsRecursive((char *)&nest, withHidden, withSize, items);
-          }
+        // skip past everything that was sent, and trim the buffer that was sent in part.
+        size_t sent = result;
+        while (first < parts.size() && sent >= parts[first].iov_len) {
+            sent -= parts[first].iov_len;
+            first++;
+        }
+        if (sent > 0) {
+            parts[first].iov_base = (char *) parts[first].iov_base + sent;
+            parts[first].iov_len -= sent;
         }
-      }
     }
-    
-    closedir(d);
+
+    return true;
+}
+
+
+
+/**
+ * Sends part of a file over a blocking socket. The kernel moves the bytes
+ * straight from the page cache to the socket with sendfile(2), so they are
+ * never copied into the program. If the file system doesn't support that,
+ * the bytes are read and written instead.
+ * @param sock - the socket to write to.
+ * @param fd - the file to send from (its file offset is not used or changed).
+ * @param offset - where in the file to start.
+ * @param length - the number of bytes to send.
+ * @return bool - true if every byte was sent, false if the socket failed or the file ended early.
+ */
+bool sendFileRange(int sock, int fd, off_t offset, off_t length) {
+    const off_t MAX_CHUNK = 1 << 30;
+    const off_t end = offset + length;
+
+    while (offset < end) {
+        ssize_t sent = sendfile(sock, fd, &offset, std::min(end - offset, MAX_CHUNK));
+
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EINVAL || errno == ENOSYS) {
+                break;
+            }
+            return false;
+        }
+
+        if (sent == 0) {
+            return false;
+        }
+    }
+
+    // fall back to copying whatever sendfile() couldn't send.
+    char buffer[64 * 1024];
+    while (offset < end) {
+        ssize_t count = pread(fd, buffer, std::min(end - offset, (off_t) sizeof(buffer)), offset);
+
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0 || !sendAll(sock, buffer, count)) {
+            return false;
+        }
+
+        offset += count;
+    }
+
+    return true;
+}
+
+
+
+/**
+ * Reads part of a file into memory.
+ * @param fd - the file to read from (its file offset is not used or changed).
+ * @param buffer - holds the bytes read.
+ * @param offset - where in the file to start.
+ * @param length - the number of bytes to read.
+ * @return bool - true if every byte was read, false if the read failed or the file ended early.
+ */
+bool readFileRange(int fd, char *buffer, off_t offset, size_t length) {
+    size_t done = 0;
+
+    while (done < length) {
+        ssize_t count = pread(fd, buffer + done, length - done, offset + done);
+
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            return false;
+        }
+        done += count;
+    }
+
+    return true;
+}
+
+
+
+/**
+ * Collects the listing of files in a directory. (Listings that are sent to
+ * a client are streamed from a DirectoryWalker instead of being collected.)
+ * @param path - the relative path of the directory.
+ * @param includeHidden - true to include hidden files.
+ * @param includeSize - true to show the size of each file.
+ * @return vector<string> - a list of the files in the directory.
+ */
+vector<string> getListItems(const string& path, bool includeHidden, bool includeSize) {
+    DirectoryWalker walker(path, false, includeHidden, includeSize, nullptr);
+    vector<string> items;
+    string item;
+
+    while (walker.next(item)) {
+        items.push_back(std::move(item));
+    }
+
+    return items;
+}
+
+
+
+/**
+ * Recursively populates a vector reference with the directory items.
+ * When called from a ThreadPool worker, the pool's other workers help read the tree.
+ */
+void getListItemsRecursive(const string& path, bool withHidden, bool withSize, vector<string> &items) {
+    DirectoryWalker walker(path, true, withHidden, withSize, ThreadPool::current());
+    string item;
+
+    while (walker.next(item)) {
+        items.push_back(std::move(item));
+    }
 }
 
 
@@ -313,21 +703,6 @@ bool fileIsHidden(struct dirent *entry) {
 
 
 
-/**
- * Determines the size of a file (in bytes).
- * @param entry - a dirent struct
- * @return the file size.
- * @note - the implementation of this function uses code from the following stackOverflow solutions:
- * https://stackoverflow.com/questions/8236/how-do-you-determine-the-size-of-a-file-in-c
- * https://stackoverflow.com/questions/5840148/how-can-i-get-a-files-size-in-c
- */
-long fileSize(struct dirent *entry) {
-  struct stat st;
-  long rc = stat(entry->d_name, &st);
-  return rc == 0 ? st.st_size : -1;
-}
-
-
 /**
  * @name inColor
  * @brief returns a string formatted to be displayed in a particular color & style in the terminal
@@ -394,17 +769,27 @@ string inColor(const string content, Color foreGround, Color backGround, ColorFo
  * as an ANSI-colored string.
  */
 string coloredListEntry(struct dirent *entry) {
-  string formatted = entry->d_name;
+  return coloredListEntry(entry->d_name, entry->d_type);
+}
+
 
-  switch (entry->d_type) {
-      case DT_DIR: formatted = inColor(formatted, BLUE); break;
-      case DT_LNK: formatted = inColor(formatted, RED); break;
-      case DT_REG: formatted = inColor(formatted, WHITE); break;
+
+/**
+ * Overloaded version of coloredListEntry for entries that weren't read
+ * into a dirent struct (such as those read with getdents64).
+ * @param name - the entry's name.
+ * @param type - the entry's d_type.
+ */
+string coloredListEntry(const char *name, unsigned char type) {
+  if (name[0] == '.') {
+    return inColor(name, MAGENTA);
   }
 
-  if (fileIsHidden(entry)) {
-    formatted = inColor(entry->d_name, MAGENTA);
+  switch (type) {
+      case DT_DIR: return inColor(name, BLUE);
+      case DT_LNK: return inColor(name, RED);
+      case DT_REG: return inColor(name, WHITE);
   }
 
-  return formatted;
+  return name;
 }
\ No newline at end of file
@@ -13,40 +13,60 @@
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <string_view>
 #include <vector>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/uio.h>
 
 using std::istream;
 using std::string;
+using std::string_view;
 using std::vector;
 
 
 
 void clearConsoleLine();
-bool hasAnyValue(const string &content);
+bool hasAnyValue(string_view content);
 
 bool isInt(char* content);
 bool isInt(string content);
-bool isInt(string content, int &value);
+bool isInt(string_view content, int &value);
+bool isInt(string_view content, long long &value);
 
 bool isInputInt(istream& input, int& value);
 bool isValidInt(istream& input, int& value, int min, int max);
 
 vector<string> split(string &input);
+bool nextWord(string_view input, size_t &position, string_view &word);
 string join(vector<string> items, const string &delimiter);
 string removeLineEnding(string input);
 
 int portFromSocket(int sock);
+void raiseOpenFileLimit();
+bool setBlocking(int sock, bool blocking);
+int getServerSocket(int port, struct sockaddr_storage &address, socklen_t &length);
+void unmapAddress(struct sockaddr_storage &address);
+socklen_t addressLength(const struct sockaddr_storage &address);
+string addressHost(const struct sockaddr_storage &address);
+bool sameHost(const struct sockaddr_storage &first, const struct sockaddr_storage &second);
+bool sendAll(int sock, const char *data, size_t length, int flags = 0);
+bool recvAll(int sock, char *data, size_t length);
+bool sendAllv(int sock, vector<struct iovec> &parts, int flags = 0);
+bool sendFileRange(int sock, int fd, off_t offset, off_t length);
+bool readFileRange(int fd, char *buffer, off_t offset, size_t length);
 
 vector<string> getListItems(const string& path, bool includeHidden = false, bool includeSize = false);
 void getListItemsRecursive(const string& path, bool withHidden, bool withSize, vector<string> &items);
 
 bool canAccessFile(const string& path);
 bool fileIsHidden(struct dirent *entry);
-long fileSize(struct dirent *entry);
 
 enum Color { BLACK, RED, GREEN, YELLOW, BLUE, MAGENTA, CYAN, WHITE, GREY, DEFAULT_COLOR, INVISIBLE };
 enum ColorFormat { DEFAULT_FORMAT, BOLD, DIM, UNDERLINED, BLINK, REVERSE, HIDDEN };
 string inColor(string content = "", Color foreGround = DEFAULT_COLOR, Color backGround = DEFAULT_COLOR, ColorFormat format = DEFAULT_FORMAT);
 string coloredListEntry(struct dirent *entry);
+string coloredListEntry(const char *name, unsigned char type);
 
 #endif //UTIL_HPP
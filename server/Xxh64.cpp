@@ -0,0 +1,235 @@
+/**
+ * Program Name: FTP Server
+ * File Name: Xxh64.cpp
+ * Author: Taylor Jones
+ * Last Modified: 10/16/26
+ * Description: Xxh64.cpp is the class implementation
+ *  file for the Xxh64 class.
+ *
+ *  Xxh64 computes the 64-bit xxHash (XXH64) of data that arrives a piece
+ *  at a time, such as a file read in blocks. The algorithm keeps four
+ *  independent accumulators that each take 8 bytes of every 32-byte
+ *  stripe, so the multiplications of a stripe don't wait on each other
+ *  and the hash runs at several GB/s on a single core without any
+ *  architecture-specific instructions. Its output matches the reference
+ *  implementation (XXH64 from the xxHash library), so clients can check
+ *  the server's hashes with any xxHash tool.
+ */
+
+
+#include <algorithm>
+#include <cstring>
+
+#include "Xxh64.hpp"
+
+
+/**
+ * Reads 8 little-endian bytes.
+ */
+static inline uint64_t readLane(const unsigned char *data) {
+    uint64_t value;
+    memcpy(&value, data, sizeof(value));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    value = __builtin_bswap64(value);
+#endif
+    return value;
+}
+
+
+
+/**
+ * Reads 4 little-endian bytes.
+ */
+static inline uint32_t readHalfLane(const unsigned char *data) {
+    uint32_t value;
+    memcpy(&value, data, sizeof(value));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    value = __builtin_bswap32(value);
+#endif
+    return value;
+}
+
+
+
+/**
+ * Rotates a 64-bit value left.
+ */
+static inline uint64_t rotateLeft(uint64_t value, int bits) {
+    return (value << bits) | (value >> (64 - bits));
+}
+
+
+
+/**
+ * Starts a hash.
+ * @param seed - the seed, which gives an unrelated family of hashes; 0 is the usual one.
+ */
+Xxh64::Xxh64(uint64_t seed) {
+    this->seed = seed;
+    this->lanes[0] = seed + PRIME1 + PRIME2;
+    this->lanes[1] = seed + PRIME2;
+    this->lanes[2] = seed;
+    this->lanes[3] = seed - PRIME1;
+    this->totalLength = 0;
+    this->pendingLength = 0;
+}
+
+
+
+/**
+ * Mixes 8 bytes of input into an accumulator.
+ */
+uint64_t Xxh64::round(uint64_t lane, uint64_t input) {
+    lane += input * PRIME2;
+    lane = rotateLeft(lane, 31);
+    return lane * PRIME1;
+}
+
+
+
+/**
+ * Mixes a finished accumulator into the hash.
+ */
+uint64_t Xxh64::mergeRound(uint64_t hash, uint64_t lane) {
+    hash ^= round(0, lane);
+    return hash * PRIME1 + PRIME4;
+}
+
+
+
+/**
+ * Runs whole stripes through the accumulators.
+ * @param data - the stripes.
+ * @param count - the number of stripes.
+ */
+void Xxh64::consumeStripes(const unsigned char *data, size_t count) {
+    uint64_t lane0 = this->lanes[0];
+    uint64_t lane1 = this->lanes[1];
+    uint64_t lane2 = this->lanes[2];
+    uint64_t lane3 = this->lanes[3];
+
+    for (size_t i = 0; i < count; i++, data += STRIPE_SIZE) {
+        lane0 = round(lane0, readLane(data));
+        lane1 = round(lane1, readLane(data + 8));
+        lane2 = round(lane2, readLane(data + 16));
+        lane3 = round(lane3, readLane(data + 24));
+    }
+
+    this->lanes[0] = lane0;
+    this->lanes[1] = lane1;
+    this->lanes[2] = lane2;
+    this->lanes[3] = lane3;
+}
+
+
+
+/**
+ * Adds the next piece of data to the hash.
+ * @param data - the data.
+ * @param length - the number of bytes of data.
+ */
+void Xxh64::update(const void *data, size_t length) {
+    const unsigned char *input = (const unsigned char *) data;
+    this->totalLength += length;
+
+    // finish the stripe left over from the last piece, if there is one.
+    if (this->pendingLength > 0) {
+        size_t fill = std::min(STRIPE_SIZE - this->pendingLength, length);
+        memcpy(this->pending + this->pendingLength, input, fill);
+        this->pendingLength += fill;
+        input += fill;
+        length -= fill;
+
+        if (this->pendingLength < STRIPE_SIZE) {
+            return;
+        }
+        this->consumeStripes(this->pending, 1);
+        this->pendingLength = 0;
+    }
+
+    size_t stripes = length / STRIPE_SIZE;
+    this->consumeStripes(input, stripes);
+    input += stripes * STRIPE_SIZE;
+    length -= stripes * STRIPE_SIZE;
+
+    memcpy(this->pending, input, length);
+    this->pendingLength = length;
+}
+
+
+
+/**
+ * Finishes the hash (without changing the state, so more data can still be added).
+ * @return uint64_t - the hash of everything added so far.
+ */
+uint64_t Xxh64::digest() const {
+    uint64_t hash;
+
+    if (this->totalLength >= STRIPE_SIZE) {
+        hash = rotateLeft(this->lanes[0], 1) + rotateLeft(this->lanes[1], 7) +
+            rotateLeft(this->lanes[2], 12) + rotateLeft(this->lanes[3], 18);
+        for (int i = 0; i < 4; i++) {
+            hash = mergeRound(hash, this->lanes[i]);
+        }
+    } else {
+        hash = this->seed + PRIME5;
+    }
+    hash += this->totalLength;
+
+    // mix in the bytes that didn't fill a stripe.
+    const unsigned char *tail = this->pending;
+    size_t length = this->pendingLength;
+    for (; length >= 8; tail += 8, length -= 8) {
+        hash ^= round(0, readLane(tail));
+        hash = rotateLeft(hash, 27) * PRIME1 + PRIME4;
+    }
+    if (length >= 4) {
+        hash ^= (uint64_t) readHalfLane(tail) * PRIME1;
+        hash = rotateLeft(hash, 23) * PRIME2 + PRIME3;
+        tail += 4;
+        length -= 4;
+    }
+    for (; length > 0; tail++, length--) {
+        hash ^= *tail * PRIME5;
+        hash = rotateLeft(hash, 11) * PRIME1;
+    }
+
+    // avalanche, so every input bit affects every output bit.
+    hash ^= hash >> 33;
+    hash *= PRIME2;
+    hash ^= hash >> 29;
+    hash *= PRIME3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+
+
+/**
+ * Hashes a block of data in one go.
+ * @param data - the data.
+ * @param length - the number of bytes of data.
+ * @param seed - the seed.
+ * @return uint64_t - the hash.
+ */
+uint64_t Xxh64::hash(const void *data, size_t length, uint64_t seed) {
+    Xxh64 hasher(seed);
+    hasher.update(data, length);
+    return hasher.digest();
+}
+
+
+
+/**
+ * @param hash - a hash.
+ * @return string - the hash as 16 lowercase hex digits, the way xxHash's tools print it.
+ */
+string Xxh64::toHex(uint64_t hash) {
+    const char *DIGITS = "0123456789abcdef";
+    string hex(16, '0');
+
+    for (int i = 15; i >= 0; i--, hash >>= 4) {
+        hex[i] = DIGITS[hash & 0xf];
+    }
+    return hex;
+}
@@ -0,0 +1,55 @@
+/**
+ * Program Name: FTP Server
+ * File Name: Xxh64.hpp
+ * Author: Taylor Jones
+ * Last Modified: 10/16/26
+ * Description: Xxh64.hpp is the class specification
+ *  file for the Xxh64 class. This file contains declarations
+ *  for the member functions of the Xxh64 class.
+ */
+
+
+#ifndef Xxh64_hpp
+#define Xxh64_hpp
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+using std::string;
+
+
+class Xxh64 {
+  // Member Variables
+  private:
+    static const uint64_t PRIME1 = 0x9E3779B185EBCA87ULL;
+    static const uint64_t PRIME2 = 0xC2B2AE3D27D4EB4FULL;
+    static const uint64_t PRIME3 = 0x165667B19E3779F9ULL;
+    static const uint64_t PRIME4 = 0x85EBCA77C2B2AE63ULL;
+    static const uint64_t PRIME5 = 0x27D4EB2F165667C5ULL;
+    static const size_t STRIPE_SIZE = 32;
+
+    uint64_t seed;
+    uint64_t lanes[4];              // the four accumulators, one per 8 bytes of each stripe
+    uint64_t totalLength;
+    unsigned char pending[STRIPE_SIZE];     // the start of a stripe that hasn't been filled yet
+    size_t pendingLength;
+
+  // Member Functions
+  private:
+    static uint64_t round(uint64_t lane, uint64_t input);
+    static uint64_t mergeRound(uint64_t hash, uint64_t lane);
+    void consumeStripes(const unsigned char *data, size_t count);
+
+  public:
+    explicit Xxh64(uint64_t seed = 0);
+
+    void update(const void *data, size_t length);
+    uint64_t digest() const;
+
+    static uint64_t hash(const void *data, size_t length, uint64_t seed = 0);
+    static string toHex(uint64_t hash);
+};
+
+
+#endif /* Xxh64_hpp */
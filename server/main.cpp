@@ -26,11 +26,13 @@
  */
 
 
+#include <cstdint>
 #include <iostream>
-#include <functional>
 #include <signal.h>
 
 #include "Util.hpp"
+#include "IoRing.hpp"
+#include "ServerConfig.hpp"
 #include "SocketServer.hpp"
 
 
@@ -41,22 +43,6 @@ using std::cin;
 using std::endl;
 
 
-/**
- * This function allows for binding c++ class members as
- * c signal handlers. This means we can pass a SIGINT into
- * a SocketServer member function, which will then trigger
- * a disconnect on the FTP server.
- *
- * @note The idea for this concept was found here:
- * http://matetelki.com/blog/?p=636
- */
-std::function<void(int)> signalWrapper;
-void signalHandler(int sig) {
-    signalWrapper(sig);
-}
-
-
-
 /**
  * Ensures a valid port is provided by the user. It first checks for a valid port
  *  argument. If provided, the argued port is returned. Otherwise, it continues to
@@ -75,7 +61,7 @@ int getValidPort(int count, char* args[]) {
     int port = -1;
     
     // check if a port argument was provided.
-    if (count == 2) {
+    if (count >= 2) {
         port = atoi(args[1]);
         
         // if a valid port # was argued, use that.
@@ -95,22 +81,121 @@ int getValidPort(int count, char* args[]) {
 
 
 
+/**
+ * Reads a byte count option, such as a cache size, which may be
+ * larger than an int can hold.
+ * @param content - the option's value.
+ * @param bytes - holds the byte count, if the value is valid.
+ * @return bool - true if the value is a whole number of bytes that fits in a size_t.
+ */
+bool isByteCount(const char *content, size_t &bytes) {
+    long long value;
+    if (!isInt(content, value) || value < 0 || (unsigned long long) value > SIZE_MAX) {
+        return false;
+    }
+
+    bytes = (size_t) value;
+    return true;
+}
+
+
+
+/**
+ * Applies the options that follow the port argument to the server configuration.
+ * If an option is unknown or is missing its value, the usage is printed
+ * and the program exits.
+ * @param count - the # of arguments provided to the "main" function.
+ * @param args - the arguments provided to the "main" function
+ * @param config - the configuration to update.
+ */
+void applyOptions(int count, char* args[], ServerConfig &config) {
+    const string usage = "Usage: ftserver <port> [--workers <count>] [--passive-ports <count>] [--passive-base <port>]"
+        " [--list-chunk <bytes>] [--list-flush <bytes>] [--io-uring] [--map-cache <bytes>]"
+        " [--content-cache <bytes>] [--hash-index <path>] [--log-level <debug|info|warn|error|off>]"
+        " [--log-full <drop|block>] [--log-json <path>] [--metrics-file <path>] [--metrics-interval <seconds>]";
+    int value;
+
+    for (int i = 2; i < count; i++) {
+        const string option = args[i];
+        const bool hasValue = (i + 1 < count) && isInt(string(args[i + 1]), value) && value > 0;
+
+        if (option == "--workers" && hasValue) {
+            config.workers = value;
+            i++;
+        } else if (option == "--passive-ports" && hasValue) {
+            config.passivePorts = value;
+            i++;
+        } else if (option == "--passive-base" && hasValue && value >= 1024 && value <= 65535) {
+            config.passiveBase = value;
+            i++;
+        } else if (option == "--list-chunk" && hasValue) {
+            config.listChunkSize = value;
+            i++;
+        } else if (option == "--list-flush" && hasValue) {
+            config.listFlushSize = value;
+            i++;
+        } else if (option == "--io-uring") {
+            config.ioUring = true;
+        } else if (option == "--map-cache" && i + 1 < count && isByteCount(args[i + 1], config.mapCacheSize)) {
+            i++;
+        } else if (option == "--content-cache" && i + 1 < count && isByteCount(args[i + 1], config.contentCacheSize)) {
+            i++;
+        } else if (option == "--hash-index" && i + 1 < count) {
+            config.hashIndexPath = args[i + 1];
+            i++;
+        } else if (option == "--log-level" && i + 1 < count && Logger::parseLevel(args[i + 1], config.logLevel)) {
+            i++;
+        } else if (option == "--log-full" && i + 1 < count && (string(args[i + 1]) == "drop" || string(args[i + 1]) == "block")) {
+            config.logFullPolicy = string(args[i + 1]) == "drop" ? LOG_DROP : LOG_BLOCK;
+            i++;
+        } else if (option == "--log-json" && i + 1 < count) {
+            config.logJsonPath = args[i + 1];
+            i++;
+        } else if (option == "--metrics-file" && i + 1 < count) {
+            config.metricsPath = args[i + 1];
+            i++;
+        } else if (option == "--metrics-interval" && hasValue) {
+            config.metricsInterval = value;
+            i++;
+        } else {
+            cout << usage << endl;
+            exit(1);
+        }
+    }
+}
+
+
+
 int main(int argc, char* argv[]) {    
-    // make sure the user has provided a valid port
-    int port = getValidPort(argc, argv);
+    ServerConfig config;
 
-    // use the port to create the FTP server.
-    SocketServer socketServer(port);
-    
-    /* Watch for SIGINT. If one occurs, call the signalWrapper
-    to pass the signal into the SockerServer object, which will 
-    trigger the stop() method of the SocketServer object. */
-    signalWrapper = std::bind(&SocketServer::disconnect, &socketServer);
-    struct sigaction sh;
-    sh.sa_handler = signalHandler;
-    sigemptyset(&sh.sa_mask);
-    sh.sa_flags = 0;
-    sigaction(SIGINT, &sh, NULL);
+    // make sure the user has provided a valid port, and apply any other options.
+    config.port = getValidPort(argc, argv);
+    applyOptions(argc, argv, config);
+
+    // fall back to blocking I/O if the kernel can't do what the io_uring backend needs.
+    if (config.ioUring && !IoRing().isReady()) {
+        cout << "io_uring is not available, so files will be sent with sendfile()." << endl;
+        config.ioUring = false;
+    }
+
+    // allow for as many simultaneous clients as the system permits.
+    raiseOpenFileLimit();
+
+    /* Watch for SIGINT and SIGTERM. Rather than being handled in a signal handler,
+    where stopping the server could deadlock on a lock the interrupted code holds,
+    they are blocked here (before the server starts its threads, which inherit the
+    mask) and read by the SocketServer on its event loop: SIGINT triggers the
+    disconnect() method, and SIGTERM still stops the server at once, but not
+    before the log is written out. */
+    SocketServer::blockStopSignals();
+
+    // use the configuration to create the FTP server.
+    SocketServer socketServer(config);
+
+    // a client that hangs up during a download must not take the server down with it:
+    // sendfile() can't be told not to raise SIGPIPE, so the failed write is reported as EPIPE instead.
+    signal(SIGPIPE, SIG_IGN);
     
     
     // start the socket server
@@ -0,0 +1,255 @@
+/**
+ * Program Name: FTP Server
+ * File Name: ContentCacheTest.cpp
+ * Author: Taylor Jones
+ * Last Modified: 10/16/26
+ * Description: ContentCacheTest checks the content cache's S3-FIFO
+ *  eviction on scratch files of 1 KiB. A cached file must be answered with
+ *  the contents it was read with, until it changes; files downloaded more
+ *  than once must survive a single pass over hundreds of others; a file
+ *  read again while its key is remembered must go straight to the main
+ *  queue; and a popular file at the end of the main queue must be given
+ *  another pass while the cold files around it are dropped. The cache must
+ *  never hold more than its budget. Prints each failed check and exits
+ *  with 1 if there were any.
+ *
+ *  Usage: contentcachetest
+ */
+
+
+#include <fcntl.h>
+#include <memory>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+
+#include "../server/ContentCache.hpp"
+#include "TestSupport.hpp"
+
+using std::shared_ptr;
+using std::string;
+using std::to_string;
+using std::vector;
+
+
+const size_t FILE_SIZE = 1024;
+
+
+
+/**
+ * Gets a file from the cache, checking that what it returns is the file
+ * and that the cache is still within its budget.
+ * @param cache - the cache.
+ * @param budget - the cache's budget.
+ * @param path - the file.
+ * @param hit - holds true if the cache already had the file.
+ * @return shared_ptr<const string> - what the cache returned.
+ */
+shared_ptr<const string> acquireFile(ContentCache &cache, size_t budget, const string &path, bool &hit) {
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0) {
+        check(false, path + " is missing");
+        hit = false;
+        return nullptr;
+    }
+
+    const uint64_t hits = cache.getStats().hits;
+    shared_ptr<const string> contents = cache.acquire(path, info);
+    const ContentCacheStats stats = cache.getStats();
+
+    hit = stats.hits > hits;
+    check(contents && (off_t) contents->size() == info.st_size, path + " wasn't returned whole");
+    check(stats.bytes <= budget, "the cache holds " + to_string(stats.bytes) + " bytes, over its budget of " + to_string(budget));
+    return contents;
+}
+
+
+
+/**
+ * Gets a file from the cache, ignoring whether the cache already had it.
+ * @param cache - the cache.
+ * @param budget - the cache's budget.
+ * @param path - the file.
+ */
+void acquireFile(ContentCache &cache, size_t budget, const string &path) {
+    bool hit;
+    acquireFile(cache, budget, path, hit);
+}
+
+
+
+/**
+ * Writes scratch files of FILE_SIZE bytes each.
+ * @param prefix - starts each file's name.
+ * @param count - the number of files.
+ * @return vector<string> - the files' paths.
+ */
+vector<string> writeFiles(const string &prefix, int count) {
+    vector<string> paths;
+    for (int i = 0; i < count; i++) {
+        paths.push_back(writeScratchFile(prefix + "-" + to_string(i) + ".bin", patternedBytes(FILE_SIZE, i)));
+    }
+    return paths;
+}
+
+
+
+/**
+ * Checks that a cached file is answered with what it was read with, that
+ * it is read again once it changes, and that files the cache shouldn't
+ * hold are left for the caller to send some other way.
+ */
+void checkHitsAndChanges() {
+    const size_t BUDGET = 100 * FILE_SIZE;
+    ContentCache cache(BUDGET);
+    const string path = writeScratchFile("changing.bin", patternedBytes(FILE_SIZE, 1));
+    bool hit;
+
+    shared_ptr<const string> first = acquireFile(cache, BUDGET, path, hit);
+    check(!hit, "the first download of a file was a hit");
+    check(first && *first == patternedBytes(FILE_SIZE, 1), "the first download didn't return the file");
+
+    shared_ptr<const string> second = acquireFile(cache, BUDGET, path, hit);
+    check(hit && second == first, "the second download of a file wasn't answered with the cached contents");
+
+    // same size, so only the modification time shows that it changed.
+    writeScratchFile("changing.bin", patternedBytes(FILE_SIZE, 2));
+    struct timespec times[2] = { { 0, UTIME_OMIT }, { 1000000000, 0 } };
+    check(utimensat(AT_FDCWD, path.c_str(), times, 0) == 0, "couldn't set the modification time");
+
+    shared_ptr<const string> changed = acquireFile(cache, BUDGET, path, hit);
+    check(!hit && changed && *changed == patternedBytes(FILE_SIZE, 2), "a changed file was answered with its old contents");
+    check(first && *first == patternedBytes(FILE_SIZE, 1), "the old contents changed while still in use");
+
+    struct stat info;
+    const string empty = writeScratchFile("empty.bin", "");
+    const string large = writeScratchFile("large.bin", patternedBytes(BUDGET / 10 + 1, 3));
+    check(stat(empty.c_str(), &info) == 0 && !cache.acquire(empty, info), "an empty file was cached");
+    check(stat(large.c_str(), &info) == 0 && !cache.acquire(large, info), "a file larger than the small queue was cached");
+
+    const ContentCacheStats stats = cache.getStats();
+    check(stats.entries == 1 && stats.bytes == FILE_SIZE, "the cache doesn't hold just the changed file");
+}
+
+
+
+/**
+ * Checks that files downloaded more than once survive one pass over many
+ * more files than the cache can hold.
+ */
+void checkScanResistance() {
+    const size_t BUDGET = 100 * FILE_SIZE;
+    ContentCache cache(BUDGET);
+    const vector<string> popular = writeFiles("popular", 10);
+    const vector<string> scanned = writeFiles("scanned", 300);
+    bool hit;
+
+    for (const auto &path : popular) {
+        acquireFile(cache, BUDGET, path);
+        acquireFile(cache, BUDGET, path);
+    }
+    for (const auto &path : scanned) {
+        acquireFile(cache, BUDGET, path);
+    }
+
+    for (const auto &path : popular) {
+        acquireFile(cache, BUDGET, path, hit);
+        check(hit, path + " didn't survive a pass over " + to_string(scanned.size()) + " other files");
+    }
+
+    const ContentCacheStats stats = cache.getStats();
+    check(stats.evictions > 0, "the pass over other files didn't evict any");
+}
+
+
+
+/**
+ * Checks that a file read again while its key is still remembered goes
+ * straight to the main queue, where a pass over other files can't drop it.
+ */
+void checkGhosts() {
+    const size_t BUDGET = 100 * FILE_SIZE;
+    ContentCache cache(BUDGET);
+    const string returning = writeScratchFile("returning.bin", patternedBytes(FILE_SIZE, 4));
+    const vector<string> pushing = writeFiles("pushing", 120);
+    const vector<string> scanned = writeFiles("later", 300);
+    bool hit;
+
+    // the small queue takes the whole budget until the main queue holds something.
+    acquireFile(cache, BUDGET, returning);
+    for (const auto &path : pushing) {
+        acquireFile(cache, BUDGET, path);
+    }
+
+    acquireFile(cache, BUDGET, returning, hit);
+    check(!hit, "a file downloaded once wasn't dropped from the small queue");
+
+    for (const auto &path : scanned) {
+        acquireFile(cache, BUDGET, path);
+    }
+
+    acquireFile(cache, BUDGET, returning, hit);
+    check(hit, "a file read again while its key was remembered didn't go to the main queue");
+
+    acquireFile(cache, BUDGET, pushing.front(), hit);
+    check(!hit, "a file downloaded once survived a pass over other files");
+}
+
+
+
+/**
+ * Checks that a file at the end of the main queue that was downloaded
+ * since it got there is given another pass, and the oldest file that
+ * wasn't is dropped.
+ */
+void checkMainEviction() {
+    const size_t BUDGET = 20 * FILE_SIZE;
+    const size_t FILLED = BUDGET / FILE_SIZE - 1;       // the cold files that fill the budget behind the first two
+    ContentCache cache(BUDGET);
+    const string first = writeScratchFile("first.bin", patternedBytes(FILE_SIZE, 5));
+    const string hot = writeScratchFile("hot.bin", patternedBytes(FILE_SIZE, 6));
+    const vector<string> cold = writeFiles("cold", 40);
+    bool hit;
+
+    // every file is downloaded twice, so each moves to the main queue when it leaves the small one.
+    // the small queue takes the whole budget until the cache first overflows, and then all but its
+    // newest files move to the main queue at once, where the first file is dropped to make room.
+    acquireFile(cache, BUDGET, first);
+    acquireFile(cache, BUDGET, first);
+    acquireFile(cache, BUDGET, hot);
+    acquireFile(cache, BUDGET, hot);
+    for (size_t i = 0; i < FILLED; i++) {
+        acquireFile(cache, BUDGET, cold[i]);
+        acquireFile(cache, BUDGET, cold[i]);
+    }
+    check(cache.getStats().evictions == 1, "the first overflow didn't drop exactly one file");
+
+    for (int i = 0; i < 3; i++) {
+        acquireFile(cache, BUDGET, hot, hit);
+        check(hit, "the hot file wasn't moved to the main queue");
+    }
+
+    for (size_t i = FILLED; i < cold.size(); i++) {
+        acquireFile(cache, BUDGET, cold[i]);
+        acquireFile(cache, BUDGET, cold[i]);
+    }
+    check(cache.getStats().evictions > cold.size() - FILLED, "the main queue didn't drop files to make room");
+
+    acquireFile(cache, BUDGET, hot, hit);
+    check(hit, "the hot file was evicted from the main queue");
+
+    acquireFile(cache, BUDGET, cold.front(), hit);
+    check(!hit, "the oldest cold file wasn't evicted from the main queue");
+}
+
+
+
+int main() {
+    checkHitsAndChanges();
+    checkScanResistance();
+    checkGhosts();
+    checkMainEviction();
+
+    removeScratchFiles();
+    return reportChecks("content cache");
+}
@@ -0,0 +1,344 @@
+/**
+ * Program Name: FTP Server
+ * File Name: DeltaTest.cpp
+ * Author: Taylor Jones
+ * Last Modified: 10/16/26
+ * Description: DeltaTest checks delta downloads end to end. Files are
+ *  encoded against older copies of themselves (identical ones, empty ones,
+ *  ones with bytes inserted, deleted and changed, and ones larger than the
+ *  encoder's window), at several block sizes, and rebuilt from the literals
+ *  and the old copy's blocks the way a client would: the result must be the
+ *  file, and unchanged stretches must be sent as copies. Signatures chosen
+ *  to slow the scan down must still give the file, and malformed ones must
+ *  be refused. Deltas are then sent by a DataTransfer, from the open file
+ *  and from cached contents, and a file truncated before its delta is sent
+ *  must fail the transfer. Prints each failed check and exits with 1 if
+ *  there were any.
+ *
+ *  Usage: deltatest
+ */
+
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "../server/ContentCache.hpp"
+#include "../server/DataTransfer.hpp"
+#include "../server/DeltaEncoder.hpp"
+#include "../server/Framing.hpp"
+#include "TestSupport.hpp"
+
+using std::string;
+using std::to_string;
+using std::vector;
+
+
+/**
+ * A file rebuilt from a delta.
+ */
+struct Rebuilt {
+    bool encoded;           // false if the encoder (or the transfer) failed
+    bool valid;             // false if a literal or copy couldn't be applied
+    string data;
+    size_t literalBytes;
+    size_t copies;
+};
+
+
+
+/**
+ * Applies a copy of old blocks to a rebuilt file.
+ * @param rebuilt - the file so far.
+ * @param old - the client's old copy.
+ * @param blockSize - the block size the old copy was signed with.
+ * @param first - the first block copied.
+ * @param count - the number of blocks copied.
+ */
+void applyCopy(Rebuilt &rebuilt, const string &old, uint32_t blockSize, uint64_t first, uint64_t count) {
+    const uint64_t blocks = old.size() / blockSize;
+
+    if (count == 0 || first >= blocks || count > blocks - first) {
+        rebuilt.valid = false;
+        return;
+    }
+    rebuilt.data.append(old, first * blockSize, count * blockSize);
+    rebuilt.copies++;
+}
+
+
+
+/**
+ * Encodes a file against signatures and rebuilds it, as a client would.
+ * @param current - the file.
+ * @param old - the client's old copy, which the copies are taken from.
+ * @param signatures - the signatures the client sent.
+ * @param blockSize - the block size the old copy was signed with.
+ * @return Rebuilt - the rebuilt file.
+ */
+Rebuilt encodeAndApply(const string &current, const string &old, const string &signatures, uint32_t blockSize) {
+    Rebuilt rebuilt = { false, true, "", 0, 0 };
+    DeltaEncoder encoder;
+
+    if (!encoder.parseSignatures(signatures)) {
+        return rebuilt;
+    }
+
+    rebuilt.encoded = encoder.encode(
+        [&current](char *buffer, size_t offset, size_t length) {
+            if (offset > current.size() || length > current.size() - offset) {
+                return false;
+            }
+            memcpy(buffer, current.data() + offset, length);
+            return true;
+        },
+        current.size(),
+        [&current, &rebuilt](size_t offset, size_t end) {
+            // literals must pick up exactly where the file rebuilt so far ends.
+            if (offset != rebuilt.data.size() || end <= offset || end > current.size()) {
+                rebuilt.valid = false;
+                return false;
+            }
+            rebuilt.data.append(current, offset, end - offset);
+            rebuilt.literalBytes += end - offset;
+            return true;
+        },
+        [&old, &rebuilt, blockSize](uint64_t first, uint64_t count) {
+            applyCopy(rebuilt, old, blockSize, first, count);
+            return rebuilt.valid;
+        });
+
+    return rebuilt;
+}
+
+
+
+/**
+ * Makes a newer version of a file: bytes inserted, deleted and changed
+ * through it, and some added to both ends.
+ * @param old - the old version.
+ * @param seed - picks the edits.
+ * @return string - the new version.
+ */
+string editBytes(const string &old, uint32_t seed) {
+    const string inserted = patternedBytes(777, seed);
+    string current = old;
+
+    for (size_t at = current.size() / 7; at < current.size(); at += current.size() / 5 + 1) {
+        current.insert(at, inserted, 0, 1 + at % inserted.size());
+    }
+    for (size_t at = current.size() / 3; at + 5000 < current.size(); at += current.size() / 4 + 1) {
+        current.erase(at, 1 + at % 5000);
+    }
+    for (size_t at = 100; at < current.size(); at += current.size() / 6 + 1) {
+        current[at] = (char) ~current[at];
+    }
+
+    return patternedBytes(31, seed + 1) + current + patternedBytes(45, seed + 2);
+}
+
+
+
+/**
+ * Checks that a file encoded against an old copy rebuilds into the file.
+ * @param name - what the files are, for the report.
+ * @param old - the client's old copy.
+ * @param current - the server's file.
+ * @param blockSize - the block size to sign the old copy with.
+ * @param maxLiteralBytes - the most bytes that should be sent as literals.
+ */
+void checkRoundTrip(const string &name, const string &old, const string &current, uint32_t blockSize, size_t maxLiteralBytes) {
+    const string what = name + " in blocks of " + to_string(blockSize);
+    const string signatures = DeltaEncoder::buildSignatures(old.data(), old.size(), blockSize);
+
+    Rebuilt rebuilt = encodeAndApply(current, old, signatures, blockSize);
+    check(rebuilt.encoded && rebuilt.valid, what + ": the delta couldn't be encoded and applied");
+    check(rebuilt.data == current, what + ": the delta doesn't rebuild the file");
+    check(rebuilt.literalBytes <= maxLiteralBytes, what + ": " + to_string(rebuilt.literalBytes) +
+        " bytes were sent as literals, more than " + to_string(maxLiteralBytes));
+}
+
+
+
+/**
+ * Checks round trips between versions of a file at several block sizes.
+ */
+void checkRoundTrips() {
+    const string old = patternedBytes(1024 * 1024 + 333, 10);
+    const string edited = editBytes(old, 11);
+
+    for (uint32_t blockSize : { (uint32_t) DeltaEncoder::MIN_BLOCK_SIZE, 700u, 4096u, 65536u }) {
+        // only the old copy's short last block can't be copied.
+        checkRoundTrip("an identical file", old, old, blockSize, blockSize);
+        checkRoundTrip("an edited file", old, edited, blockSize, 64 * blockSize + 20000);
+        checkRoundTrip("an unrelated file", old, patternedBytes(old.size(), 12), blockSize, old.size());
+        checkRoundTrip("a file against an empty copy", "", edited, blockSize, edited.size());
+        checkRoundTrip("an empty file", old, "", blockSize, 0);
+        checkRoundTrip("a file shorter than a block", old, old.substr(0, blockSize - 1), blockSize, blockSize);
+        checkRoundTrip("a file with its first block deleted", old, old.substr(blockSize), blockSize, 2 * blockSize);
+    }
+
+    // larger than the encoder's window, with changes on both sides of its edges.
+    const string large = patternedBytes(9 * 1024 * 1024 + 5, 13);
+    string largeEdited = large;
+    largeEdited.insert(4 * 1024 * 1024 - 3, "across the edge of a window");
+    largeEdited.erase(8 * 1024 * 1024 - 100, 300);
+    checkRoundTrip("a file larger than the window", large, largeEdited, 4096, 4 * 4096);
+    checkRoundTrip("a file larger than the window, edited", large, editBytes(large, 14), 4096, 64 * 4096 + 20000);
+}
+
+
+
+/**
+ * Checks that signatures chosen to slow the scan down still give the
+ * file, and that malformed ones are refused.
+ */
+void checkHostileSignatures() {
+    const uint32_t SIGNED_BLOCK_SIZE = 1024;
+    const string repetitive(2 * 1024 * 1024, 'a');
+    RollingChecksum checksum;
+    checksum.reset((const unsigned char *) repetitive.data(), SIGNED_BLOCK_SIZE);
+
+    // thousands of blocks that every window matches the weak checksum of, but none the hash of.
+    string sameWeak;
+    appendUint32(sameWeak, SIGNED_BLOCK_SIZE);
+    for (uint64_t i = 0; i < 10000; i++) {
+        appendUint32(sameWeak, checksum.value());
+        appendUint64(sameWeak, i);
+    }
+
+    Rebuilt rebuilt = encodeAndApply(repetitive, "", sameWeak, SIGNED_BLOCK_SIZE);
+    check(rebuilt.encoded && rebuilt.valid && rebuilt.data == repetitive,
+        "signatures that every window half matches didn't give the file");
+
+    // real blocks hidden among them must still be copied correctly.
+    const string old = patternedBytes(256 * 1024, 15);
+    const string current = editBytes(old, 16);
+    string mixed = DeltaEncoder::buildSignatures(old.data(), old.size(), SIGNED_BLOCK_SIZE);
+    for (uint64_t i = 0; i < 10000; i++) {
+        appendUint32(mixed, checksum.value());
+        appendUint64(mixed, i);
+    }
+    rebuilt = encodeAndApply(current, old, mixed, SIGNED_BLOCK_SIZE);
+    check(rebuilt.encoded && rebuilt.valid && rebuilt.data == current,
+        "real signatures among hostile ones didn't give the file");
+
+    const vector<std::pair<string, string>> malformed = {
+        { "", "no block size" },
+        { string("\x00\x00\x04", 3), "a short block size" },
+        { string("\x00\x00\x00\x3f", 4), "a block size under the minimum" },
+        { string("\x00\x10\x00\x01", 4), "a block size over the maximum" },
+        { string("\x00\x00\x04\x00\x01\x02\x03", 7), "a cut-off signature" }
+    };
+    for (const auto &signatures : malformed) {
+        DeltaEncoder encoder;
+        check(!encoder.parseSignatures(signatures.first), "signatures with " + signatures.second + " were accepted");
+    }
+}
+
+
+
+/**
+ * Sends a file as a delta over a data connection, and rebuilds it from the
+ * frames that arrive, as a client would.
+ * @param path - the server's file.
+ * @param old - the client's old copy.
+ * @param blockSize - the block size to sign the old copy with.
+ * @param contents - a content cache to offer the file from, or null.
+ * @param truncate - the size to cut the file down to after it is offered, or -1 to leave it.
+ * @param result - holds what sendDelta() returned.
+ * @return Rebuilt - the rebuilt file.
+ */
+Rebuilt downloadDelta(const string &path, const string &old, uint32_t blockSize, ContentCache *contents, off_t truncate,
+    TransferResult &result) {
+    Rebuilt rebuilt = { false, true, "", 0, 0 };
+    string received;
+
+    result = TRANSFER_FAILED;
+    runTransfer([&](int sock) {
+            DataTransfer transfer(sock, FRAME_VERSION);
+            OfferedFile file;
+            if (transfer.offerFile(path, file, true, nullptr, contents) != TRANSFER_OK) {
+                return;
+            }
+            if (truncate >= 0 && ::truncate(path.c_str(), truncate) < 0) {
+                return;
+            }
+            result = transfer.sendDelta(file);
+        },
+        [&](int sock) {
+            const string signatures = DeltaEncoder::buildSignatures(old.data(), old.size(), blockSize);
+            sendAll(sock, encodeFrameHeader(FRAME_SIGNATURES, signatures.size()) + signatures);
+            received = receiveAll(sock);
+        });
+
+    vector<ReceivedFrame> frames;
+    if (!parseFrames(received, frames) || frames.size() < 2 || frames.front().type != FRAME_GOOD ||
+        frames.back().type != FRAME_END) {
+        return rebuilt;
+    }
+
+    rebuilt.encoded = true;
+    for (size_t i = 1; i + 1 < frames.size(); i++) {
+        const ReceivedFrame &frame = frames[i];
+        if (frame.type == FRAME_DATA && frame.flags == 0) {
+            rebuilt.data += frame.payload;
+            rebuilt.literalBytes += frame.payload.size();
+        } else if (frame.type == FRAME_COPY && frame.payload.size() == 16) {
+            applyCopy(rebuilt, old, blockSize, readUint64(frame.payload.data()), readUint64(frame.payload.data() + 8));
+        } else {
+            rebuilt.valid = false;
+        }
+    }
+    return rebuilt;
+}
+
+
+
+/**
+ * Checks deltas sent by a DataTransfer, from the open file and from its
+ * cached contents, and that a file cut short before its delta is sent
+ * fails the transfer.
+ */
+void checkTransfers() {
+    const uint32_t SIGNED_BLOCK_SIZE = 2048;
+    ContentCache contents(64 * 1024 * 1024);
+    TransferResult result;
+
+    const string old = patternedBytes(600 * 1024 + 9, 17);
+    const string current = editBytes(old, 18);
+    const string path = writeScratchFile("delta.bin", current);
+
+    for (ContentCache *cache : { (ContentCache *) nullptr, &contents }) {
+        const string source = cache != nullptr ? "cached contents" : "the open file";
+        Rebuilt rebuilt = downloadDelta(path, old, SIGNED_BLOCK_SIZE, cache, -1, result);
+
+        check(result == TRANSFER_OK, source + ": the delta wasn't sent");
+        check(rebuilt.encoded && rebuilt.valid && rebuilt.data == current, source + ": the delta doesn't rebuild the file");
+        check(rebuilt.copies > 0 && rebuilt.literalBytes < current.size() / 4, source + ": the delta didn't copy the unchanged blocks");
+    }
+    check(contents.getStats().entries == 1, "the content cache didn't hold the file");
+
+    Rebuilt rebuilt = downloadDelta(writeScratchFile("empty.bin", ""), old, SIGNED_BLOCK_SIZE, nullptr, -1, result);
+    check(result == TRANSFER_OK && rebuilt.valid && rebuilt.data.empty(), "an empty file's delta isn't empty");
+
+    // the old copy matches what is left of the file, so the encoder scans on into the part that was cut off.
+    const string large = patternedBytes(12 * 1024 * 1024, 19);
+    const string largePath = writeScratchFile("truncated.bin", large);
+    rebuilt = downloadDelta(largePath, large.substr(0, 1024 * 1024), SIGNED_BLOCK_SIZE, nullptr, 1024 * 1024, result);
+    check(result == TRANSFER_FAILED, "a file cut short before its delta was sent didn't fail the transfer");
+    check(!rebuilt.encoded, "a file cut short before its delta was sent was ended as if it were whole");
+}
+
+
+
+int main() {
+    checkRoundTrips();
+    checkHostileSignatures();
+    checkTransfers();
+
+    removeScratchFiles();
+    return reportChecks("delta");
+}
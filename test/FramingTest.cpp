@@ -0,0 +1,249 @@
+/**
+ * Program Name: FTP Server
+ * File Name: FramingTest.cpp
+ * Author: Taylor Jones
+ * Last Modified: 10/16/26
+ * Description: FramingTest checks the length-prefixed framing (framing=1).
+ *  Frame headers are encoded byte for byte as the README describes, decode
+ *  back to what was encoded for every type, length and flag, and refuse
+ *  other framing versions. Framed responses are then sent by a DataTransfer
+ *  and read back: a file (one with a "\done" line and binary bytes, an
+ *  empty one, and one served from the content cache), a missing file, and
+ *  a listing split across many LIST frames. Prints each failed check and
+ *  exits with 1 if there were any.
+ *
+ *  Usage: framingtest
+ */
+
+
+#include <cstdint>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "../server/ContentCache.hpp"
+#include "../server/DataTransfer.hpp"
+#include "../server/Framing.hpp"
+#include "TestSupport.hpp"
+
+using std::string;
+using std::to_string;
+using std::vector;
+
+
+
+/**
+ * Checks that a header is laid out as the README describes.
+ */
+void checkHeaderLayout() {
+    const string header = encodeFrameHeader(FRAME_DATA, 0x0102030405060708ULL, FRAME_COMPRESSED);
+    const string expected("\x01\x03\x00\x01\x01\x02\x03\x04\x05\x06\x07\x08", FRAME_HEADER_SIZE);
+
+    check(header.size() == FRAME_HEADER_SIZE, "a header isn't " + to_string(FRAME_HEADER_SIZE) + " bytes");
+    check(header == expected, "a DATA header isn't laid out as version, type, flags and length, in network byte order");
+
+    string integers;
+    appendUint32(integers, 0x80000001u);
+    appendUint64(integers, 0x8000000000000001ULL);
+    check(integers == string("\x80\x00\x00\x01\x80\x00\x00\x00\x00\x00\x00\x01", 12), "integers aren't appended in network byte order");
+    check(readUint32(integers.data()) == 0x80000001u, "a 32-bit integer with its top bit set isn't read back");
+    check(readUint64(integers.data() + 4) == 0x8000000000000001ULL, "a 64-bit integer with its top bit set isn't read back");
+}
+
+
+
+/**
+ * Checks that every type, length and flag decodes back to what was
+ * encoded, and that headers of other framing versions are refused.
+ */
+void checkHeaderRoundTrip() {
+    const vector<FrameType> types = {
+        FRAME_GOOD, FRAME_BAD, FRAME_DATA, FRAME_LIST, FRAME_END, FRAME_CHUNK, FRAME_SIGNATURES, FRAME_COPY
+    };
+    const vector<uint64_t> lengths = {
+        0, 1, 255, 256, 65535, 65536, 0xffffffffULL, 0x100000000ULL, (uint64_t) 1 << 63, UINT64_MAX
+    };
+
+    for (FrameType type : types) {
+        for (uint64_t length : lengths) {
+            for (uint16_t flags : { (uint16_t) 0, FRAME_COMPRESSED, (uint16_t) 0xffff }) {
+                const string header = encodeFrameHeader(type, length, flags);
+                FrameType decodedType;
+                uint64_t decodedLength;
+
+                const bool decoded = decodeFrameHeader(header.data(), decodedType, decodedLength);
+                check(decoded && decodedType == type && decodedLength == length,
+                    "type " + to_string(type) + " with length " + to_string(length) + " didn't decode back");
+
+                const uint16_t decodedFlags = (uint16_t) (((uint8_t) header[2] << 8) | (uint8_t) header[3]);
+                check(decodedFlags == flags, "type " + to_string(type) + " lost its flags " + to_string(flags));
+            }
+        }
+    }
+
+    for (uint8_t version : { 0, 2, 255 }) {
+        string header = encodeFrameHeader(FRAME_DATA, 5);
+        header[0] = (char) version;
+        FrameType type;
+        uint64_t length;
+        check(!decodeFrameHeader(header.data(), type, length), "a header of framing version " + to_string(version) + " was accepted");
+    }
+}
+
+
+
+/**
+ * Sends a file framed and reads the response back.
+ * @param path - the file.
+ * @param contents - a content cache to offer the file from, or null.
+ * @param result - holds what offerFile() returned.
+ * @return vector<ReceivedFrame> - the frames that arrived, or none if they didn't parse.
+ */
+vector<ReceivedFrame> sendFramed(const string &path, ContentCache *contents, TransferResult &result) {
+    string received;
+
+    runTransfer([&path, contents, &result](int sock) {
+            DataTransfer transfer(sock, FRAME_VERSION);
+            OfferedFile file;
+            result = transfer.offerFile(path, file, false, nullptr, contents);
+            if (result == TRANSFER_OK) {
+                transfer.sendFile(file, false);
+            }
+        },
+        [&received](int sock) { received = receiveAll(sock); });
+
+    vector<ReceivedFrame> frames;
+    if (!parseFrames(received, frames)) {
+        frames.clear();
+    }
+    return frames;
+}
+
+
+
+/**
+ * Checks that a framed file arrives as a GOOD frame with its size, DATA
+ * frames that hold exactly its bytes, and an END frame.
+ * @param name - the file's name, for the report.
+ * @param data - the file's contents.
+ * @param contents - a content cache to offer the file from, or null.
+ */
+void checkFramedFile(const string &name, const string &data, ContentCache *contents) {
+    const string path = writeScratchFile(name, data);
+    TransferResult result;
+
+    vector<ReceivedFrame> frames = sendFramed(path, contents, result);
+
+    check(result == TRANSFER_OK, name + ": wasn't offered");
+    check(frames.size() >= 2, name + ": the response didn't parse into frames");
+    if (frames.size() < 2) {
+        return;
+    }
+
+    check(frames.front().type == FRAME_GOOD && frames.front().payload.size() == 8 &&
+        readUint64(frames.front().payload.data()) == data.size(), name + ": the GOOD frame doesn't carry the file's size");
+    check(frames.back().type == FRAME_END && frames.back().payload.empty(), name + ": the response doesn't end with an END frame");
+
+    string sent;
+    for (size_t i = 1; i + 1 < frames.size(); i++) {
+        check(frames[i].type == FRAME_DATA && frames[i].flags == 0, name + ": frame " + to_string(i) + " isn't an uncompressed DATA frame");
+        sent += frames[i].payload;
+    }
+    check(sent == data, name + ": the DATA frames don't hold the file");
+}
+
+
+
+/**
+ * Checks that a missing file is refused with a BAD frame and an END frame.
+ */
+void checkMissingFile() {
+    TransferResult result;
+    vector<ReceivedFrame> frames = sendFramed(makeScratchDirectory() + "/missing.txt", nullptr, result);
+
+    check(result == TRANSFER_NOT_FOUND, "missing.txt: wasn't reported as not found");
+    check(frames.size() == 2 && frames[0].type == FRAME_BAD && frames[0].payload.find("not found") != string::npos &&
+        frames[1].type == FRAME_END, "missing.txt: wasn't refused with a BAD frame and an END frame");
+}
+
+
+
+/**
+ * Checks that a listing split across many small LIST frames holds every
+ * entry exactly once, each as a 4-byte length followed by the entry.
+ */
+void checkFramedListing() {
+    const int FILES = 200;
+    const string directory = makeScratchDirectory();
+    for (int i = 0; i < FILES; i++) {
+        writeScratchFile("listed-" + to_string(1000 + i) + ".txt", "x");
+    }
+
+    char previous[4096];
+    if (getcwd(previous, sizeof(previous)) == nullptr || chdir(directory.c_str()) < 0) {
+        check(false, "couldn't move into the scratch directory");
+        return;
+    }
+
+    string received;
+    runTransfer([](int sock) {
+            DataTransfer transfer(sock, FRAME_VERSION);
+            transfer.setListBatching(256, 1024);
+            transfer.sendDirectoryList(false, false, false);
+        },
+        [&received](int sock) { received = receiveAll(sock); });
+
+    if (chdir(previous) < 0) {
+        check(false, "couldn't move back out of the scratch directory");
+    }
+
+    vector<ReceivedFrame> frames;
+    check(parseFrames(received, frames) && frames.size() > 2, "the listing didn't arrive as several frames");
+    check(!frames.empty() && frames.back().type == FRAME_END, "the listing doesn't end with an END frame");
+
+    vector<int> seen(FILES, 0);
+    for (size_t i = 0; i + 1 < frames.size(); i++) {
+        const string &payload = frames[i].payload;
+        check(frames[i].type == FRAME_LIST, "listing frame " + to_string(i) + " isn't a LIST frame");
+
+        size_t at = 0;
+        while (at + 4 <= payload.size()) {
+            const uint32_t length = readUint32(payload.data() + at);
+            if (length > payload.size() - at - 4) {
+                break;
+            }
+            const string entry = payload.substr(at + 4, length);
+            const size_t name = entry.find("listed-");
+            if (name != string::npos) {
+                const int index = std::stoi(entry.substr(name + 7, 4)) - 1000;
+                if (index >= 0 && index < FILES) {
+                    seen[index]++;
+                }
+            }
+            at += 4 + length;
+        }
+        check(at == payload.size(), "listing frame " + to_string(i) + " doesn't hold whole entries");
+    }
+
+    for (int i = 0; i < FILES; i++) {
+        check(seen[i] == 1, "listed-" + to_string(1000 + i) + ".txt was listed " + to_string(seen[i]) + " times");
+    }
+}
+
+
+
+int main() {
+    ContentCache contents(16 * 1024 * 1024);
+
+    checkHeaderLayout();
+    checkHeaderRoundTrip();
+    checkFramedFile("text.txt", "first line\n\\done\nlast line without a newline", nullptr);
+    checkFramedFile("binary.bin", patternedBytes(3 * 1024 * 1024 + 17, 4), nullptr);
+    checkFramedFile("empty.txt", "", nullptr);
+    checkFramedFile("cached.bin", patternedBytes(100 * 1024, 5), &contents);
+    checkMissingFile();
+    checkFramedListing();
+
+    removeScratchFiles();
+    return reportChecks("framing");
+}
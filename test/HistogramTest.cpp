@@ -0,0 +1,144 @@
+/**
+ * Program Name: FTP Server
+ * File Name: HistogramTest.cpp
+ * Author: Taylor Jones
+ * Last Modified: 10/16/26
+ * Description: HistogramTest checks the bucket layout that the server's
+ *  Metrics and the load generator's LatencyHistogram use: every time, however long, lands in a bucket
+ *  that exists, and each bucket's limit covers the times counted in it.
+ *  Times of 2^44 ns and longer (about 4.9 hours, e.g. a long download or
+ *  a client idling between \good and \ready) used to index past the
+ *  end of the buckets. Prints each failed check and exits with 1 if
+ *  there were any.
+ *
+ *  Usage: histogramtest
+ */
+
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+#include "../server/ContentCache.hpp"
+#include "../server/HashIndex.hpp"
+#include "../server/HistogramBuckets.hpp"
+#include "../server/Metrics.hpp"
+#include "../loadgen/LatencyHistogram.hpp"
+
+using std::cout;
+using std::endl;
+using std::string;
+
+
+static int failures = 0;
+
+
+
+/**
+ * Reports a check that failed.
+ * @param passed - the outcome of the check.
+ * @param what - what was checked.
+ */
+void check(bool passed, const string &what) {
+    if (!passed) {
+        cout << "FAILED: " << what << endl;
+        failures++;
+    }
+}
+
+
+
+/**
+ * Checks a bucket layout at the small times, around every power of two,
+ * and at and past the longest time it counts.
+ * @param name - the layout's name, for the report.
+ * @param maxExponent - the layout's MAX_EXPONENT.
+ */
+template <typename Buckets>
+void checkBuckets(const string &name, int maxExponent) {
+    for (uint64_t time = 0; time < 4 * Buckets::SUB_BUCKETS; time++) {
+        check(Buckets::bucketOf(time) < Buckets::COUNT && Buckets::bucketLimit(Buckets::bucketOf(time)) >= time,
+            name + ": time " + std::to_string(time));
+    }
+
+    for (int exponent = 0; exponent < 64; exponent++) {
+        const uint64_t power = (uint64_t) 1 << exponent;
+        for (uint64_t time : { power - 1, power, power + 1, power * 2 - 1 }) {
+            const size_t bucket = Buckets::bucketOf(time);
+            check(bucket < Buckets::COUNT, name + ": bucket of " + std::to_string(time) + " is past the end");
+            check(time == 0 || bucket >= Buckets::bucketOf(time - 1), name + ": buckets out of order at " + std::to_string(time));
+            if (exponent < maxExponent) {
+                check(Buckets::bucketLimit(bucket) >= time, name + ": bucket of " + std::to_string(time) + " is too low");
+            }
+        }
+    }
+
+    const uint64_t limit = (uint64_t) 1 << maxExponent;
+    check(Buckets::bucketOf(limit - 1) == Buckets::COUNT - 1, name + ": 2^" + std::to_string(maxExponent) + " - 1 isn't in the last bucket");
+    check(Buckets::bucketOf(limit) == Buckets::COUNT - 1, name + ": 2^" + std::to_string(maxExponent) + " isn't in the last bucket");
+    check(Buckets::bucketOf(UINT64_MAX) == Buckets::COUNT - 1, name + ": UINT64_MAX isn't in the last bucket");
+}
+
+
+
+/**
+ * Records times at and past 2^44 ns in a Metrics and checks that they, and
+ * only they, show up in its histograms (a time counted past the end of its
+ * buckets would turn up in the sum or the next series instead).
+ */
+void checkMetrics() {
+    Metrics metrics;
+    ContentCache contents(0);
+    HashIndex hashes("");
+    const int64_t limit = (int64_t) 1 << 44;
+
+    metrics.recordTime(0, PHASE_COMPLETE, limit);
+    metrics.recordTime(0, PHASE_COMPLETE, limit * 2 - 1);
+    metrics.recordTime(0, PHASE_COMPLETE, INT64_MAX);
+
+    const string text = metrics.render(contents, hashes);
+    size_t series = 0;
+    for (size_t at = 0; (at = text.find("\nftserver_request_phase_seconds_count{", at)) != string::npos; at++) {
+        series++;
+    }
+
+    check(series == 1, "Metrics: long times showed up in " + std::to_string(series) + " series instead of 1");
+    check(text.find("phase=\"complete\",le=\"+Inf\"} 3\n") != string::npos, "Metrics: the long times weren't all counted");
+}
+
+
+
+/**
+ * Records times at and past 2^44 ns in a LatencyHistogram and checks that
+ * it still reads them back.
+ */
+void checkLatencyHistogram() {
+    LatencyHistogram histogram;
+    const uint64_t limit = (uint64_t) 1 << 44;
+
+    histogram.record(1000);
+    histogram.record(limit);
+    histogram.record(limit * 2 - 1);
+    histogram.record(UINT64_MAX);
+
+    check(histogram.getCount() == 4, "LatencyHistogram: the long times weren't all counted");
+    check(histogram.quantile(0.25) <= 1000 * 1.04, "LatencyHistogram: a short time was lost among the long ones");
+    check(histogram.quantile(1) >= limit - 1 && histogram.getMax() == UINT64_MAX,
+        "LatencyHistogram: the longest times weren't read back as at least 2^44 ns");
+}
+
+
+
+int main() {
+    checkBuckets<HistogramBuckets<3, 44>>("HistogramBuckets<3, 44>", 44);
+    checkBuckets<HistogramBuckets<5, 44>>("HistogramBuckets<5, 44>", 44);
+    checkMetrics();
+    checkLatencyHistogram();
+
+    if (failures > 0) {
+        cout << failures << " checks failed" << endl;
+        return 1;
+    }
+    cout << "All histogram checks passed" << endl;
+    return 0;
+}
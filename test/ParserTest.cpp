@@ -0,0 +1,524 @@
+/**
+ * Program Name: FTP Server
+ * File Name: ParserTest.cpp
+ * Author: Taylor Jones
+ * Last Modified: 10/16/26
+ * Description: ParserTest checks the in-place request parser against the
+ *  parser it replaced, which split the request into strings and read its
+ *  numbers with strtol(). A copy of that parser (with the -stats command
+ *  that came after it) is kept here as the reference. Every request, from
+ *  a list of edge cases and from a seeded random mix of commands, ports,
+ *  options and whitespace, must get the same fields and the same error
+ *  message from both, and the error's RequestError code must be the one
+ *  its message belongs to. Prints each failed check and exits with 1 if
+ *  there were any.
+ *
+ *  Usage: parsertest [random-requests]
+ */
+
+
+#include <cerrno>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../server/Framing.hpp"
+#include "../server/ParsedRequest.hpp"
+
+using std::cout;
+using std::endl;
+using std::istringstream;
+using std::map;
+using std::string;
+using std::to_string;
+using std::vector;
+
+
+const int COMMAND_PORT = 30021;
+
+static int failures = 0;
+
+
+
+/**
+ * Reports a check that failed.
+ * @param passed - the outcome of the check.
+ * @param what - what was checked.
+ */
+void check(bool passed, const string &what) {
+    if (!passed) {
+        cout << "FAILED: " << what << endl;
+        failures++;
+    }
+}
+
+
+
+/**
+ * The request parser as it was before requests were parsed in place:
+ * the request is split into strings, the options are collected in a map
+ * (so they're checked in name order, and the last value given counts), and
+ * numbers are read with strtol() and strtoll().
+ */
+class ReferenceRequest {
+  private:
+    const int MAX_STREAMS = 16;
+    const int MAX_COMPRESSION_LEVEL = 9;
+
+    int commandPort;
+    vector<string> components;
+    map<string, string> options;
+
+  public:
+    string command;
+    string filename;
+    int dataPort;
+    bool passiveMode;
+    bool binaryMode;
+    int framingVersion;
+    off_t rangeOffset;
+    off_t rangeLength;
+    int streams;
+    int compressionLevel;
+    bool deltaMode;
+    bool errorFlag;
+    string errorMessage;
+
+  private:
+    static bool hasAnyValue(const string &content) {
+        return content.find_first_not_of(" \t\n\v\f\r") != string::npos;
+    }
+
+    static bool isInt(const string &content, int &value) {
+        if (!hasAnyValue(content)) {
+            return false;
+        }
+        char *nonInt;
+        value = strtol(content.c_str(), &nonInt, 10);
+        return *nonInt == 0;
+    }
+
+    static bool isInt(const string &content, long long &value) {
+        if (!hasAnyValue(content)) {
+            return false;
+        }
+        char *nonInt;
+        errno = 0;
+        value = strtoll(content.c_str(), &nonInt, 10);
+        return *nonInt == 0 && errno != ERANGE;
+    }
+
+    bool raiseErrorFlag(const string &message) {
+        this->errorFlag = true;
+        this->errorMessage = "Error: " + message;
+        return false;
+    }
+
+    bool componentCountIsValid() {
+        const size_t count = this->components.size();
+        if (count < 2 && !(count == 1 && this->components[0] == "-stats")) {
+            return this->raiseErrorFlag("Too few FTP request arguments were provided.");
+        } else if (count > 3) {
+            return this->raiseErrorFlag("Too many FTP request arguments were provided.");
+        }
+        return true;
+    }
+
+    bool commandIsValid() {
+        const string prospect = this->components[0];
+        const size_t count = this->components.size();
+
+        if ((count == 2 && (prospect == "-l" || prospect == "-la" || prospect == "-ll" || prospect == "-lr" || prospect == "-hr")) ||
+            (count == 3 && (prospect == "-g" || prospect == "-h")) ||
+            (count == 1 && prospect == "-stats")) {
+            this->command = prospect;
+            return true;
+        }
+
+        if (prospect != "-l" && prospect != "-la" && prospect != "-ll" && prospect != "-lr" && prospect != "-g" &&
+            prospect != "-h" && prospect != "-hr" && prospect != "-stats") {
+            return this->raiseErrorFlag("An invalid command was provided. Please use \"-l\", \"-la\", \"-ll\", \"-lr\", "
+                "\"-g\", \"-h\", \"-hr\", or \"-stats\".");
+        }
+
+        if (count == 2 || count == 3) {
+            return this->raiseErrorFlag("Command mismatch: " + to_string(count) +
+                " arguments were provided with a command of " + prospect + ".");
+        }
+        return this->raiseErrorFlag("Invalid component count: commandIsValid().");
+    }
+
+    bool fileNameIsValid() {
+        if (this->command == "-g" || this->command == "-h") {
+            if (!hasAnyValue(this->components[1])) {
+                return this->raiseErrorFlag("No file name was provided. Please provide one");
+            }
+            this->filename = this->components[1];
+        }
+        return true;
+    }
+
+    bool dataPortIsValid() {
+        const size_t count = this->components.size();
+        int dPort;
+
+        if (count == 1) {
+            return true;
+        }
+
+        const string portComponent = this->components[count - 1];
+        if (portComponent == "pasv") {
+            this->passiveMode = true;
+            return true;
+        }
+        if (!isInt(portComponent, dPort)) {
+            return this->raiseErrorFlag("Non-numeric data port argument. Please provide a numeric port in the range: 1024..65535");
+        }
+        if (dPort < 1024 || dPort > 65535) {
+            return this->raiseErrorFlag("Invalid data port argument. Please provide a numeric port in the range: 1024..65535");
+        }
+        if (dPort == this->commandPort) {
+            return this->raiseErrorFlag("Invalid data port argument. The data port should not be the same as the command port.");
+        }
+        this->dataPort = dPort;
+        return true;
+    }
+
+    bool optionsAreValid() {
+        for (const auto &option : this->options) {
+            const string &name = option.first;
+            const string &value = option.second;
+
+            if (name == "mode") {
+                if (value != "text" && value != "binary") {
+                    return this->raiseErrorFlag("Invalid transfer mode: " + value + ". Please use \"text\" or \"binary\".");
+                }
+                if (value == "binary" && this->command != "-g") {
+                    return this->raiseErrorFlag("The binary transfer mode can only be used with the -g command.");
+                }
+                this->binaryMode = (value == "binary");
+            } else if (name == "offset" || name == "length") {
+                long long bytes;
+                if (!isInt(value, bytes) || bytes < 0) {
+                    return this->raiseErrorFlag("Invalid byte " + name + ": " + value + ". Please provide a whole number of bytes.");
+                }
+                if (this->command != "-g") {
+                    return this->raiseErrorFlag("A byte " + name + " can only be used with the -g command.");
+                }
+                if (name == "offset") {
+                    this->rangeOffset = bytes;
+                } else {
+                    this->rangeLength = bytes;
+                }
+            } else if (name == "streams") {
+                if (!isInt(value, this->streams) || this->streams < 1 || this->streams > MAX_STREAMS) {
+                    return this->raiseErrorFlag("Invalid stream count: " + value + ". Please use 1.." + to_string(MAX_STREAMS) + " streams.");
+                }
+                if (this->command != "-g") {
+                    return this->raiseErrorFlag("Multiple streams can only be used with the -g command.");
+                }
+            } else if (name == "compress") {
+                if (!isInt(value, this->compressionLevel) || this->compressionLevel < 1 ||
+                    this->compressionLevel > MAX_COMPRESSION_LEVEL) {
+                    return this->raiseErrorFlag("Invalid compression level: " + value + ". Please use 1.." +
+                        to_string(MAX_COMPRESSION_LEVEL) + ".");
+                }
+            } else if (name == "delta") {
+                if (value != "0" && value != "1") {
+                    return this->raiseErrorFlag("Invalid delta option: " + value + ". Please use 0 or 1.");
+                }
+                if (this->command != "-g") {
+                    return this->raiseErrorFlag("Delta transfers can only be used with the -g command.");
+                }
+                this->deltaMode = (value == "1");
+            } else if (name == "framing") {
+                if (!isInt(value, this->framingVersion) || this->framingVersion != FRAME_VERSION) {
+                    return this->raiseErrorFlag("Unsupported framing version: " + value + ". This server supports version " +
+                        to_string(FRAME_VERSION) + ".");
+                }
+            } else {
+                return this->raiseErrorFlag("Unknown request option: " + name + ".");
+            }
+        }
+
+        if (this->streams > 1 && this->framingVersion == 0) {
+            return this->raiseErrorFlag("Multiple streams need the framing=" + to_string(FRAME_VERSION) + " option.");
+        }
+        if (this->compressionLevel > 0 && this->framingVersion == 0) {
+            return this->raiseErrorFlag("Compression needs the framing=" + to_string(FRAME_VERSION) + " option.");
+        }
+        if (this->compressionLevel > 0 && this->streams > 1) {
+            return this->raiseErrorFlag("Compression can't be used with multiple streams.");
+        }
+        if (this->deltaMode && this->framingVersion == 0) {
+            return this->raiseErrorFlag("Delta transfers need the framing=" + to_string(FRAME_VERSION) + " option.");
+        }
+        if (this->deltaMode && (this->streams > 1 || this->rangeOffset > 0 || this->rangeLength >= 0)) {
+            return this->raiseErrorFlag("Delta transfers can't be used with multiple streams or a byte range.");
+        }
+        return true;
+    }
+
+    void extractOptions() {
+        vector<string> remaining;
+        for (size_t i = 0; i < this->components.size(); i++) {
+            const string &component = this->components[i];
+            size_t split = component.find('=');
+
+            if (i >= 2 && split != string::npos) {
+                this->options[component.substr(0, split)] = component.substr(split + 1);
+            } else {
+                remaining.push_back(component);
+            }
+        }
+        this->components = remaining;
+    }
+
+  public:
+    ReferenceRequest(const string &request, int commandPort) : commandPort(commandPort) {
+        this->dataPort = -1;
+        this->passiveMode = false;
+        this->binaryMode = false;
+        this->framingVersion = 0;
+        this->rangeOffset = 0;
+        this->rangeLength = -1;
+        this->streams = 1;
+        this->compressionLevel = 0;
+        this->deltaMode = false;
+        this->errorFlag = false;
+
+        if (!hasAnyValue(request)) {
+            this->raiseErrorFlag("The FTP request does not appear to have any valid arguments.");
+            return;
+        }
+
+        istringstream words(request);
+        string word;
+        while (words >> word) {
+            this->components.push_back(word);
+        }
+        this->extractOptions();
+
+        this->componentCountIsValid() && this->commandIsValid() && this->dataPortIsValid() &&
+            this->fileNameIsValid() && this->optionsAreValid();
+    }
+};
+
+
+
+/**
+ * Works out which RequestError an error message belongs to.
+ * @param message - the error message, as the client gets it.
+ * @return RequestError - the code that the message should come with.
+ */
+RequestError expectedError(const string &message) {
+    const vector<std::pair<string, RequestError>> prefixes = {
+        { "Error: The FTP request does not appear", REQUEST_EMPTY },
+        { "Error: Too few", REQUEST_ARGUMENT_COUNT },
+        { "Error: Too many", REQUEST_ARGUMENT_COUNT },
+        { "Error: An invalid command", REQUEST_UNKNOWN_COMMAND },
+        { "Error: Command mismatch", REQUEST_COMMAND_MISMATCH },
+        { "Error: No file name", REQUEST_NO_FILENAME },
+        { "Error: Non-numeric data port", REQUEST_BAD_DATA_PORT },
+        { "Error: Invalid data port", REQUEST_BAD_DATA_PORT },
+        { "Error: Unknown request option", REQUEST_UNKNOWN_OPTION },
+        { "Error: Multiple streams need", REQUEST_OPTION_CONFLICT },
+        { "Error: Compression needs", REQUEST_OPTION_CONFLICT },
+        { "Error: Compression can't", REQUEST_OPTION_CONFLICT },
+        { "Error: Delta transfers need", REQUEST_OPTION_CONFLICT },
+        { "Error: Delta transfers can't", REQUEST_OPTION_CONFLICT },
+    };
+
+    if (message.empty()) {
+        return REQUEST_OK;
+    }
+    for (const auto &prefix : prefixes) {
+        if (message.compare(0, prefix.first.size(), prefix.first) == 0) {
+            return prefix.second;
+        }
+    }
+    return REQUEST_BAD_OPTION;
+}
+
+
+
+/**
+ * Makes a request printable, with its whitespace spelled out.
+ * @param request - the request.
+ * @return string - the request, quoted.
+ */
+string quoted(const string &request) {
+    string text = "\"";
+    for (char c : request) {
+        switch (c) {
+            case '\t': text += "\\t"; break;
+            case '\n': text += "\\n"; break;
+            case '\r': text += "\\r"; break;
+            case '\v': text += "\\v"; break;
+            case '\f': text += "\\f"; break;
+            default: text += c;
+        }
+    }
+    return text + "\"";
+}
+
+
+
+/**
+ * Parses a request with both parsers, and checks that they agree and that
+ * the new parser's error code goes with its message.
+ * @param parsed - the new parser, reused as the server reuses it.
+ * @param request - the request.
+ */
+void checkRequest(ParsedRequest &parsed, const string &request) {
+    ReferenceRequest reference(request, COMMAND_PORT);
+    parsed.parse(request);
+    const string name = quoted(request);
+
+    check(parsed.errorFlag == reference.errorFlag, name + ": the error flag differs");
+    check(parsed.errorMessage == reference.errorMessage,
+        name + ": \"" + parsed.errorMessage + "\" instead of \"" + reference.errorMessage + "\"");
+    check(parsed.error == expectedError(reference.errorMessage),
+        name + ": the error code " + ParsedRequest::errorName(parsed.error) + " doesn't go with \"" + reference.errorMessage + "\"");
+
+    if (reference.errorFlag) {
+        return;
+    }
+    check(string(parsed.command) == reference.command, name + ": the command differs");
+    check(parsed.filename == reference.filename, name + ": the filename differs");
+    check(parsed.dataPort == reference.dataPort, name + ": the data port is " + to_string(parsed.dataPort) +
+        " instead of " + to_string(reference.dataPort));
+    check(parsed.passiveMode == reference.passiveMode, name + ": passive mode differs");
+    check(parsed.binaryMode == reference.binaryMode, name + ": binary mode differs");
+    check(parsed.framingVersion == reference.framingVersion, name + ": the framing version differs");
+    check(parsed.rangeOffset == reference.rangeOffset && parsed.rangeLength == reference.rangeLength, name + ": the range differs");
+    check(parsed.streams == reference.streams, name + ": the stream count differs");
+    check(parsed.compressionLevel == reference.compressionLevel, name + ": the compression level differs");
+    check(parsed.deltaMode == reference.deltaMode, name + ": delta mode differs");
+}
+
+
+
+/**
+ * Checks a request's outcome directly, so that a change that both
+ * parsers made the same way would still be noticed.
+ * @param request - the request.
+ * @param error - the error it should fail with, or REQUEST_OK.
+ * @param message - the message it should fail with, or empty.
+ */
+void checkOutcome(const string &request, RequestError error, const string &message) {
+    ParsedRequest parsed(request, COMMAND_PORT);
+    check(parsed.error == error && parsed.errorMessage == message,
+        quoted(request) + ": got " + ParsedRequest::errorName(parsed.error) + " \"" + parsed.errorMessage + "\"");
+}
+
+
+
+/**
+ * Checks requests at the edges: empty and blank ones, extra words,
+ * duplicate options, ports out of range and past an int, and every error.
+ */
+void checkEdgeCases() {
+    ParsedRequest parsed("", COMMAND_PORT);
+    const vector<string> requests = {
+        "", " ", "\t\n\v\f\r", "-l", "-stats", " -stats ", "-stats 2000", "-stats pasv framing=1",
+        "-l 2000", "-l\t2000\r\n", "  -la   2000  ", "-ll pasv", "-lr 2000 extra", "-g file.txt 2000 extra words",
+        "-l 2000 3000 4000", "-g file.txt", "-h", "-h file.txt pasv", "-hr 2000", "-x 2000", "l 2000", "-L 2000",
+        "-l 1023", "-l 1024", "-l 65535", "-l 65536", "-l 0", "-l -2000", "-l +2000", "-l 2000x", "-l 0x800",
+        "-l 30021", "-l 4294968320", "-l -4294965248", "-l 99999999999999999999", "-l -99999999999999999999",
+        "-g a=b 2000", "-g file.txt a=b", "-l 2000 framing=1 framing=1", "-l 2000 framing=2 framing=1",
+        "-l 2000 framing=1 framing=2", "-g f 2000 offset=5 offset=-1", "-g f 2000 offset=-1 offset=5",
+        "-g f 2000 zzz=1 aaa=2", "-g f 2000 =1", "-g f 2000 a=b=c", "-g f 2000 mode=", "-g f 2000 framing=",
+        "-g f 2000 framing=1 streams=4294967297", "-g f 2000 framing=1 streams=4294967300",
+        "-g f 2000 framing=1 compress=4294967302", "-g f 2000 framing=4294967297",
+        "-g f 2000 offset=9223372036854775807", "-g f 2000 offset=9223372036854775808", "-g f 2000 length=0",
+        "-g f 2000 framing=1 delta=1 length=0", "-g f 2000 framing=1 delta=1 offset=0", "-l 2000 mode=binary",
+        "-l 2000 framing=1 compress=9 streams=2", "-g f 2000 framing=1 compress=9 streams=2",
+    };
+
+    for (const auto &request : requests) {
+        checkRequest(parsed, request);
+    }
+
+    checkOutcome("", REQUEST_EMPTY, "Error: The FTP request does not appear to have any valid arguments.");
+    checkOutcome("-l", REQUEST_ARGUMENT_COUNT, "Error: Too few FTP request arguments were provided.");
+    checkOutcome("-l 2000 3000 4000", REQUEST_ARGUMENT_COUNT, "Error: Too many FTP request arguments were provided.");
+    checkOutcome("-x 2000", REQUEST_UNKNOWN_COMMAND, "Error: An invalid command was provided. Please use \"-l\", \"-la\", "
+        "\"-ll\", \"-lr\", \"-g\", \"-h\", \"-hr\", or \"-stats\".");
+    checkOutcome("-g 2000", REQUEST_COMMAND_MISMATCH, "Error: Command mismatch: 2 arguments were provided with a command of -g.");
+    checkOutcome("-l 65536", REQUEST_BAD_DATA_PORT,
+        "Error: Invalid data port argument. Please provide a numeric port in the range: 1024..65535");
+    checkOutcome("-l port", REQUEST_BAD_DATA_PORT,
+        "Error: Non-numeric data port argument. Please provide a numeric port in the range: 1024..65535");
+    checkOutcome("-l 30021", REQUEST_BAD_DATA_PORT,
+        "Error: Invalid data port argument. The data port should not be the same as the command port.");
+    checkOutcome("-l 2000 zzz=1", REQUEST_UNKNOWN_OPTION, "Error: Unknown request option: zzz.");
+    checkOutcome("-l 2000 framing=2", REQUEST_BAD_OPTION, "Error: Unsupported framing version: 2. This server supports version 1.");
+    checkOutcome("-l 2000 compress=5", REQUEST_OPTION_CONFLICT, "Error: Compression needs the framing=1 option.");
+    checkOutcome("-l 2000 framing=2 framing=1", REQUEST_OK, "");
+
+    // a port past an int is narrowed, as strtol() into an int narrowed it: 2^32 + 1024 is port 1024.
+    ParsedRequest narrowed("-l 4294968320", COMMAND_PORT);
+    check(!narrowed.errorFlag && narrowed.dataPort == 1024, "\"-l 4294968320\": wasn't narrowed to port 1024");
+}
+
+
+
+/**
+ * Checks a seeded random mix of requests, built from the words most likely
+ * to tell the parsers apart, separated by every kind of whitespace.
+ * @param count - the number of requests.
+ */
+void checkRandomRequests(int count) {
+    const vector<string> commands = { "-l", "-la", "-ll", "-lr", "-g", "-h", "-hr", "-stats", "-x", "-", "" };
+    const vector<string> words = {
+        "file.txt", "a=b", "=", "pasv", "PASV", "2000", "1023", "1024", "65535", "65536", "30021", "-2000", "+2000",
+        "0", "abc", "12ab", "4294968320", "99999999999999999999",
+        "mode=text", "mode=binary", "mode=x", "mode=", "framing=1", "framing=2", "framing=", "framing=+1",
+        "framing=4294967297", "offset=5", "offset=-1", "offset=x", "offset=9223372036854775808", "length=0",
+        "length=7", "streams=1", "streams=4", "streams=17", "streams=0", "streams=4294967297", "compress=1",
+        "compress=9", "compress=0", "compress=10", "delta=0", "delta=1", "delta=2", "bogus=1", "=1", "zzz=", "a=b=c",
+    };
+    const vector<string> spaces = { " ", "  ", "\t", "\n", "\r\n", "\v", "\f" };
+    std::mt19937 random(20261016);
+    ParsedRequest parsed("", COMMAND_PORT);
+
+    for (int i = 0; i < count; i++) {
+        string request;
+        if (random() % 4 == 0) {
+            request += spaces[random() % spaces.size()];
+        }
+        request += commands[random() % commands.size()];
+
+        const int extra = random() % 7;
+        for (int w = 0; w < extra; w++) {
+            request += spaces[random() % spaces.size()];
+            request += words[random() % words.size()];
+        }
+        if (random() % 4 == 0) {
+            request += spaces[random() % spaces.size()];
+        }
+
+        checkRequest(parsed, request);
+    }
+}
+
+
+
+int main(int argc, char *argv[]) {
+    const int randomRequests = argc > 1 ? atoi(argv[1]) : 200000;
+
+    checkEdgeCases();
+    checkRandomRequests(randomRequests);
+
+    if (failures > 0) {
+        cout << failures << " checks failed" << endl;
+        return 1;
+    }
+    cout << "All parser checks passed" << endl;
+    return 0;
+}
@@ -0,0 +1,178 @@
+/**
+ * Program Name: FTP Server
+ * File Name: RangeTest.cpp
+ * Author: Taylor Jones
+ * Last Modified: 10/16/26
+ * Description: RangeTest checks ranged downloads. Offsets and lengths on
+ *  and around the start and end of a file are offered and sent framed, in
+ *  binary mode and in text mode, from the open file, from its cached
+ *  mapping and from its cached contents. Each must announce the requested
+ *  range clamped to the end of the file, and send exactly those bytes; an
+ *  offset past the end must be refused. Prints each failed check and exits
+ *  with 1 if there were any.
+ *
+ *  Usage: rangetest
+ */
+
+
+#include <cstdint>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+
+#include "../server/ContentCache.hpp"
+#include "../server/DataTransfer.hpp"
+#include "../server/Framing.hpp"
+#include "../server/MappedFileCache.hpp"
+#include "TestSupport.hpp"
+
+using std::string;
+using std::to_string;
+using std::vector;
+
+
+/**
+ * Where an offered file is sent from.
+ */
+struct Source {
+    string name;
+    MappedFileCache *cache;
+    ContentCache *contents;
+};
+
+
+/**
+ * How the response is sent.
+ */
+enum Mode { FRAMED, BINARY, TEXT };
+
+
+
+/**
+ * Offers and sends part of a file, and reads the response back.
+ * @param path - the file.
+ * @param offset - the first byte requested.
+ * @param length - the number of bytes requested, or -1 for everything from the offset on.
+ * @param mode - how the response is sent.
+ * @param source - where the file is sent from.
+ * @param result - holds what offerFile() returned.
+ * @return string - the response.
+ */
+string sendRange(const string &path, off_t offset, off_t length, Mode mode, const Source &source, TransferResult &result) {
+    string received;
+
+    runTransfer([&](int sock) {
+            DataTransfer transfer(sock, mode == FRAMED ? FRAME_VERSION : 0);
+            OfferedFile file(offset, length);
+            result = transfer.offerFile(path, file, mode == BINARY, source.cache, source.contents);
+            if (result == TRANSFER_OK) {
+                transfer.sendFile(file, mode == BINARY);
+            }
+        },
+        [&received](int sock) { received = receiveAll(sock); });
+
+    return received;
+}
+
+
+
+/**
+ * Checks one range of a file in every mode.
+ * @param data - the file's contents.
+ * @param path - the file.
+ * @param offset - the first byte requested.
+ * @param length - the number of bytes requested, or -1 for everything from the offset on.
+ * @param source - where the file is sent from.
+ */
+void checkRange(const string &data, const string &path, off_t offset, off_t length, const Source &source) {
+    const string what = source.name + ": offset " + to_string(offset) + ", length " + to_string(length);
+    const off_t fileSize = data.size();
+
+    if (offset > fileSize) {
+        TransferResult result;
+        vector<ReceivedFrame> frames;
+        const string received = sendRange(path, offset, length, FRAMED, source, result);
+
+        check(result == TRANSFER_BAD_RANGE, what + ": wasn't reported as a bad range");
+        check(parseFrames(received, frames) && frames.size() == 2 && frames[0].type == FRAME_BAD &&
+            frames[0].payload.find("past the end") != string::npos && frames[1].type == FRAME_END,
+            what + ": wasn't refused with a BAD frame and an END frame");
+        return;
+    }
+
+    const off_t remaining = fileSize - offset;
+    const off_t size = length < 0 || length > remaining ? remaining : length;
+    const string expected = data.substr(offset, size);
+
+    TransferResult result;
+    vector<ReceivedFrame> frames;
+    string received = sendRange(path, offset, length, FRAMED, source, result);
+
+    check(result == TRANSFER_OK, what + ": framed, wasn't offered");
+    check(parseFrames(received, frames) && frames.size() >= 2, what + ": framed, the response didn't parse into frames");
+    if (frames.size() >= 2) {
+        check(frames.front().type == FRAME_GOOD && frames.front().payload.size() == 8 &&
+            readUint64(frames.front().payload.data()) == (uint64_t) size, what + ": framed, the GOOD frame doesn't carry the range's size");
+        check(frames.back().type == FRAME_END, what + ": framed, the response doesn't end with an END frame");
+
+        string sent;
+        for (size_t i = 1; i + 1 < frames.size(); i++) {
+            check(frames[i].type == FRAME_DATA, what + ": framed, frame " + to_string(i) + " isn't a DATA frame");
+            sent += frames[i].payload;
+        }
+        check(sent == expected, what + ": framed, the DATA frames don't hold the range");
+    }
+
+    received = sendRange(path, offset, length, BINARY, source, result);
+    check(result == TRANSFER_OK && received == "\\good " + to_string(size) + "\n" + expected,
+        what + ": binary mode didn't send the range's size and exactly its bytes");
+
+    received = sendRange(path, offset, length, TEXT, source, result);
+    const string newline = expected.empty() || expected.back() == '\n' ? "" : "\n";
+    check(result == TRANSFER_OK && received == "\\good\n" + expected + newline + "\\done\n",
+        what + ": text mode didn't send the range followed by \\done");
+}
+
+
+
+int main() {
+    MappedFileCache cache(64 * 1024 * 1024);
+    ContentCache contents(16 * 1024 * 1024);
+    const vector<Source> sources = {
+        { "open file", nullptr, nullptr },
+        { "mapping", &cache, nullptr },
+        { "cached contents", nullptr, &contents }
+    };
+
+    // large enough to take several DATA frames, small enough for the content cache.
+    const string data = patternedBytes(300 * 1024 + 7, 7);
+    const string path = writeScratchFile("ranged.bin", data);
+    const off_t size = data.size();
+
+    const vector<off_t> offsets = { 0, 1, 4095, 4096, size / 2, size - 1, size, size + 1, size + 4096 };
+    const vector<off_t> lengths = { -1, 0, 1, 2, 4096, size - 1, size, size + 1 };
+
+    for (const auto &source : sources) {
+        for (off_t offset : offsets) {
+            for (off_t length : lengths) {
+                checkRange(data, path, offset, length, source);
+            }
+        }
+    }
+
+    // every cached source must really have been used.
+    check(contents.getStats().hits > 0, "the content cache never answered");
+
+    const string text = "first line\nsecond line\nno newline";
+    const string textPath = writeScratchFile("ranged.txt", text);
+    for (const auto &source : sources) {
+        for (off_t offset : { (off_t) 0, (off_t) 6, (off_t) 11, (off_t) text.size() }) {
+            for (off_t length : { (off_t) -1, (off_t) 5, (off_t) 11 }) {
+                checkRange(text, textPath, offset, length, source);
+            }
+        }
+    }
+
+    removeScratchFiles();
+    return reportChecks("range");
+}
@@ -0,0 +1,193 @@
+/**
+ * Program Name: FTP Server
+ * File Name: StripeTest.cpp
+ * Author: Taylor Jones
+ * Last Modified: 10/16/26
+ * Description: StripeTest checks striped downloads. A plan must cut a
+ *  file into the right number of chunks on and around chunk boundaries.
+ *  A file (or a range of it) is then sent over several streams at once,
+ *  all sharing one offered file and one plan, as a session sends it:
+ *  every chunk must arrive exactly once, on one stream, with its offset
+ *  and length, every stream must end with an END frame, and the chunks
+ *  put back together must be the file. Prints each failed check and exits
+ *  with 1 if there were any.
+ *
+ *  Usage: stripetest
+ */
+
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "../server/ContentCache.hpp"
+#include "../server/DataTransfer.hpp"
+#include "../server/Framing.hpp"
+#include "TestSupport.hpp"
+
+using std::string;
+using std::to_string;
+using std::vector;
+
+
+
+/**
+ * Checks the number of chunks that files of sizes on and around chunk
+ * boundaries are cut into.
+ */
+void checkChunkCounts() {
+    const off_t CHUNK = 4096;
+    const vector<std::pair<off_t, uint64_t>> expected = {
+        { 0, 0 }, { 1, 1 }, { CHUNK - 1, 1 }, { CHUNK, 1 }, { CHUNK + 1, 2 },
+        { 2 * CHUNK, 2 }, { 1000 * CHUNK + 1, 1001 }, { (off_t) 1 << 40, ((uint64_t) 1 << 40) / CHUNK }
+    };
+
+    for (const auto &size : expected) {
+        StripePlan plan(size.first, CHUNK);
+        check(plan.chunkSize == CHUNK && plan.chunkCount == size.second && plan.nextChunk == 0,
+            "a file of " + to_string(size.first) + " bytes isn't cut into " + to_string(size.second) + " chunks");
+    }
+}
+
+
+
+/**
+ * Sends a file striped over several streams at once, and checks what
+ * each stream received.
+ * @param path - the file.
+ * @param data - the file's contents.
+ * @param offset - the first byte requested.
+ * @param length - the number of bytes requested, or -1 for everything from the offset on.
+ * @param chunkSize - the size of each chunk.
+ * @param streams - the number of streams.
+ * @param contents - a content cache to offer the file from, or null.
+ */
+void checkStriped(const string &path, const string &data, off_t offset, off_t length, off_t chunkSize, int streams,
+    ContentCache *contents) {
+    const string what = path + " from " + to_string(offset) + " over " + to_string(streams) + " streams in chunks of " +
+        to_string(chunkSize);
+
+    // the file is offered on the first stream, before any chunk is sent.
+    OfferedFile file(offset, length);
+    TransferResult offered = TRANSFER_FAILED;
+    runTransfer([&](int sock) {
+            DataTransfer transfer(sock, FRAME_VERSION);
+            offered = transfer.offerFile(path, file, true, nullptr, contents);
+        },
+        [](int sock) { receiveAll(sock); });
+
+    check(offered == TRANSFER_OK, what + ": wasn't offered");
+    if (offered != TRANSFER_OK) {
+        return;
+    }
+
+    StripePlan plan(file.size, chunkSize);
+    vector<int> socks(2 * streams);
+    vector<string> received(streams);
+    vector<TransferResult> results(streams, TRANSFER_FAILED);
+    vector<std::thread> threads;
+
+    for (int i = 0; i < streams; i++) {
+        if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, &socks[2 * i]) < 0) {
+            perror("socketpair");
+            exit(1);
+        }
+    }
+    for (int i = 0; i < streams; i++) {
+        threads.emplace_back([&, i]() {
+            DataTransfer transfer(socks[2 * i], FRAME_VERSION);
+            results[i] = transfer.sendChunks(file, plan);
+            shutdown(socks[2 * i], SHUT_WR);
+        });
+        threads.emplace_back([&, i]() { received[i] = receiveAll(socks[2 * i + 1]); });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    for (int sock : socks) {
+        close(sock);
+    }
+
+    const string expected = data.substr(offset, file.size);
+    string rebuilt(expected.size(), '\0');
+    vector<int> seen(plan.chunkCount, 0);
+
+    for (int i = 0; i < streams; i++) {
+        const string stream = what + ": stream " + to_string(i);
+        vector<ReceivedFrame> frames;
+
+        check(results[i] == TRANSFER_OK, stream + " failed");
+        check(parseFrames(received[i], frames) && !frames.empty(), stream + " didn't parse into frames");
+        check(!frames.empty() && frames.back().type == FRAME_END && frames.back().payload.empty(),
+            stream + " doesn't end with an END frame");
+
+        for (size_t j = 0; j + 1 < frames.size(); j++) {
+            const ReceivedFrame &frame = frames[j];
+            if (frame.type != FRAME_CHUNK || frame.payload.size() < 16) {
+                check(false, stream + ": frame " + to_string(j) + " isn't a CHUNK frame");
+                continue;
+            }
+
+            const uint64_t index = readUint64(frame.payload.data());
+            const uint64_t chunkOffset = readUint64(frame.payload.data() + 8);
+            const string chunk = frame.payload.substr(16);
+            if (index >= plan.chunkCount) {
+                check(false, stream + ": chunk " + to_string(index) + " is past the last chunk");
+                continue;
+            }
+
+            const off_t start = index * chunkSize;
+            const off_t size = std::min(chunkSize, file.size - start);
+            seen[index]++;
+            check(chunkOffset == (uint64_t) (offset + start), stream + ": chunk " + to_string(index) + " has the wrong offset");
+            check((off_t) chunk.size() == size, stream + ": chunk " + to_string(index) + " has the wrong length");
+            if ((off_t) chunk.size() == size) {
+                rebuilt.replace(start, size, chunk);
+            }
+        }
+    }
+
+    for (uint64_t index = 0; index < plan.chunkCount; index++) {
+        check(seen[index] == 1, what + ": chunk " + to_string(index) + " arrived " + to_string(seen[index]) + " times");
+    }
+    check(rebuilt == expected, what + ": the chunks don't put back together into the file");
+}
+
+
+
+int main() {
+    ContentCache contents(16 * 1024 * 1024);
+    const string data = patternedBytes(1024 * 1024 + 123, 8);
+    const off_t size = data.size();
+
+    checkChunkCounts();
+
+    const string path = writeScratchFile("striped.bin", data);
+    const string cached = data.substr(0, 200 * 1024 + 1);
+    const string cachedPath = writeScratchFile("cached.bin", cached);
+
+    for (int streams : { 1, 2, 4, 7 }) {
+        for (off_t chunkSize : { (off_t) 1000, (off_t) 4096, (off_t) 256 * 1024, size, size + 1 }) {
+            checkStriped(path, data, 0, -1, chunkSize, streams, nullptr);
+        }
+    }
+
+    checkStriped(path, data, 12345, -1, 4096, 4, nullptr);
+    checkStriped(path, data, 12345, 100000, 4096, 4, nullptr);
+    checkStriped(path, data, size - 1, -1, 4096, 3, nullptr);
+    checkStriped(path, data, size, -1, 4096, 3, nullptr);
+    checkStriped(writeScratchFile("empty.bin", ""), "", 0, -1, 4096, 3, nullptr);
+    checkStriped(cachedPath, cached, 0, -1, 1000, 5, &contents);
+    checkStriped(cachedPath, cached, 777, 50000, 1000, 5, &contents);
+    check(contents.getStats().hits > 0, "the content cache never answered");
+
+    removeScratchFiles();
+    return reportChecks("stripe");
+}
@@ -0,0 +1,229 @@
+/**
+ * Program Name: FTP Server
+ * File Name: TestSupport.cpp
+ * Author: Taylor Jones
+ * Last Modified: 10/16/26
+ * Description: TestSupport.cpp implements what the transfer checks share.
+ *  A transfer runs over a socketpair: the server side (a DataTransfer) on
+ *  a thread of its own, and the client side on the calling thread, so
+ *  neither can fill the socket's buffer while the other waits for it.
+ */
+
+
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <iostream>
+#include <random>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+#include "TestSupport.hpp"
+
+using std::cout;
+using std::endl;
+
+
+static int failures = 0;
+static string scratchDirectory;
+static vector<string> scratchFiles;
+
+
+
+/**
+ * Reports a check that failed.
+ * @param passed - the outcome of the check.
+ * @param what - what was checked.
+ */
+void check(bool passed, const string &what) {
+    if (!passed) {
+        cout << "FAILED: " << what << endl;
+        failures++;
+    }
+}
+
+
+
+/**
+ * Prints the outcome of every check.
+ * @param suite - what was checked, for the summary line.
+ * @return int - the exit status: 1 if any check failed, 0 if not.
+ */
+int reportChecks(const string &suite) {
+    if (failures > 0) {
+        cout << failures << " checks failed" << endl;
+        return 1;
+    }
+    cout << "All " << suite << " checks passed" << endl;
+    return 0;
+}
+
+
+
+/**
+ * Creates the directory that scratch files are written into, once.
+ * @return string - the directory's path.
+ */
+string makeScratchDirectory() {
+    if (scratchDirectory.empty()) {
+        char path[] = "/tmp/ftservertest.XXXXXX";
+        if (mkdtemp(path) == nullptr) {
+            perror("mkdtemp");
+            exit(1);
+        }
+        scratchDirectory = path;
+    }
+
+    return scratchDirectory;
+}
+
+
+
+/**
+ * Writes a scratch file, replacing it if it exists.
+ * @param name - the file's name in the scratch directory.
+ * @param contents - the file's contents.
+ * @return string - the file's path.
+ */
+string writeScratchFile(const string &name, const string &contents) {
+    const string path = makeScratchDirectory() + "/" + name;
+    int fd = open(path.c_str(), O_CREAT | O_TRUNC | O_WRONLY | O_CLOEXEC, 0644);
+    if (fd < 0 || write(fd, contents.data(), contents.size()) != (ssize_t) contents.size()) {
+        perror(path.c_str());
+        exit(1);
+    }
+    close(fd);
+
+    scratchFiles.push_back(path);
+    return path;
+}
+
+
+
+/**
+ * Removes every scratch file, and then the scratch directory.
+ */
+void removeScratchFiles() {
+    for (const auto &path : scratchFiles) {
+        unlink(path.c_str());
+    }
+    scratchFiles.clear();
+
+    if (!scratchDirectory.empty()) {
+        rmdir(scratchDirectory.c_str());
+        scratchDirectory.clear();
+    }
+}
+
+
+
+/**
+ * Makes bytes that look random but are the same on every run.
+ * @param size - the number of bytes.
+ * @param seed - picks the bytes.
+ * @return string - the bytes.
+ */
+string patternedBytes(size_t size, uint32_t seed) {
+    std::mt19937 random(seed);
+    string bytes(size, '\0');
+
+    for (auto &byte : bytes) {
+        byte = (char) (random() & 0xff);
+    }
+    return bytes;
+}
+
+
+
+/**
+ * Runs a transfer over a fresh connection. The server side's end of the
+ * connection is shut down for writing once it returns, so the client
+ * side sees the end of the response even if the server sent no END.
+ * @param server - writes the response (runs on a thread of its own).
+ * @param client - reads the response.
+ */
+void runTransfer(const function<void(int sock)> &server, const function<void(int sock)> &client) {
+    int socks[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, socks) < 0) {
+        perror("socketpair");
+        exit(1);
+    }
+
+    std::thread serverThread([&server, &socks]() {
+        server(socks[0]);
+        shutdown(socks[0], SHUT_WR);
+    });
+    client(socks[1]);
+    serverThread.join();
+
+    close(socks[0]);
+    close(socks[1]);
+}
+
+
+
+/**
+ * Reads from a connection until the other end stops writing.
+ * @param sock - the connection.
+ * @return string - everything that was read.
+ */
+string receiveAll(int sock) {
+    string received;
+    char buffer[64 * 1024];
+    ssize_t count;
+
+    while ((count = recv(sock, buffer, sizeof(buffer), 0)) > 0) {
+        received.append(buffer, count);
+    }
+    return received;
+}
+
+
+
+/**
+ * Writes all of a buffer to a connection.
+ * @param sock - the connection.
+ * @param data - the bytes to write.
+ * @return bool - false if a write failed.
+ */
+bool sendAll(int sock, const string &data) {
+    for (size_t done = 0; done < data.size(); ) {
+        ssize_t count = send(sock, data.data() + done, data.size() - done, MSG_NOSIGNAL);
+        if (count <= 0) {
+            return false;
+        }
+        done += count;
+    }
+    return true;
+}
+
+
+
+/**
+ * Splits a framed response into its frames.
+ * @param received - the whole response.
+ * @param frames - holds the frames.
+ * @return bool - false if a header is from another framing version, or the last frame is cut short.
+ */
+bool parseFrames(const string &received, vector<ReceivedFrame> &frames) {
+    size_t at = 0;
+
+    while (at < received.size()) {
+        FrameType type;
+        uint64_t length;
+
+        if (received.size() - at < FRAME_HEADER_SIZE || !decodeFrameHeader(received.data() + at, type, length) ||
+            length > received.size() - at - FRAME_HEADER_SIZE) {
+            return false;
+        }
+
+        ReceivedFrame frame;
+        frame.type = type;
+        frame.flags = (uint16_t) (((uint8_t) received[at + 2] << 8) | (uint8_t) received[at + 3]);
+        frame.payload = received.substr(at + FRAME_HEADER_SIZE, length);
+        frames.push_back(frame);
+        at += FRAME_HEADER_SIZE + length;
+    }
+    return true;
+}
@@ -0,0 +1,52 @@
+/**
+ * Program Name: FTP Server
+ * File Name: TestSupport.hpp
+ * Author: Taylor Jones
+ * Last Modified: 10/16/26
+ * Description: TestSupport.hpp declares what the transfer checks share:
+ *  reporting failed checks, scratch files to send, and a data connection
+ *  that a DataTransfer writes its response into while the check reads it
+ *  back as frames.
+ */
+
+
+#ifndef TestSupport_hpp
+#define TestSupport_hpp
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "../server/Framing.hpp"
+
+using std::function;
+using std::string;
+using std::vector;
+
+
+/**
+ * A frame as the client receives it.
+ */
+struct ReceivedFrame {
+    FrameType type;
+    uint16_t flags;
+    string payload;
+};
+
+
+void check(bool passed, const string &what);
+int reportChecks(const string &suite);
+
+string makeScratchDirectory();
+string writeScratchFile(const string &name, const string &contents);
+void removeScratchFiles();
+string patternedBytes(size_t size, uint32_t seed);
+
+void runTransfer(const function<void(int sock)> &server, const function<void(int sock)> &client);
+string receiveAll(int sock);
+bool sendAll(int sock, const string &data);
+bool parseFrames(const string &received, vector<ReceivedFrame> &frames);
+
+
+#endif /* TestSupport_hpp */